@@ -91,11 +91,10 @@ int main(int argc, char **argv){
   TGraphErrors *sigGraph        = att->GetSigmaGraph();
   
   //----- separate channels method
-  att->AttSeparateCh(0);
+  att->AttSeparateCh();
   TGraphErrors *attGraphCh0       = att->GetAttGraph(0);
   std::vector <TH1D*> spectraCh0  = att->GetSpectra(0);
   
-  att->AttSeparateCh(1);
   TGraphErrors *attGraphCh1      = att->GetAttGraph(1);
   std::vector <TH1D*> spectraCh1 = att->GetSpectra(1);
 
@@ -215,7 +214,7 @@ int main(int argc, char **argv){
   attGraphCh0->GetFunction("fexp")->SetLineColor(kPink-8);
   text.SetTextColor(kPink-8);
   text.DrawLatex(0.3, 0.8, Form("L_{att Ch0} = (%.2f +/- %.2f) mm", 
-                 results.fAttCh0, results.fAttCh0Err));
+                 results.fAttCh[0], results.fAttChErr[0]));
   
   attGraphCh1->SetTitle(Form("Series %i channel 1, attenuation curve", seriesNo));
   attGraphCh1->GetYaxis()->SetTitleSize(0.03);
@@ -225,7 +224,7 @@ int main(int argc, char **argv){
   attGraphCh1->GetFunction("fexp")->SetLineColor(kAzure-6);
   text.SetTextColor(kAzure-6);
   text.DrawLatex(0.3, 0.7, Form("L_{att Ch1} = (%.2f +/- %.2f) mm", 
-                 results.fAttCh1, results.fAttCh1Err));
+                 results.fAttCh[1], results.fAttChErr[1]));
   
   double *yCh0 = attGraphCh0->GetY();
   double *yCh1 = attGraphCh1->GetY();
@@ -295,7 +294,7 @@ int main(int argc, char **argv){
   
   //----- writing results to the data base
   TString table = "ATTENUATION_LENGTH";
-  TString query = Form("INSERT OR REPLACE INTO %s (SERIES_ID, RESULTS_FILE, ATT_CH0, ATT_CH0_ERR, ATT_CH1, ATT_CH1_ERR, ATT_COMB, ATT_COMB_ERR, ATT_COMB_POL3, ATT_COMB_POL3_ERR) VALUES (%i, '%s', %f, %f, %f, %f, %f, %f, %f, %f)", table.Data(), seriesNo, fname_full.Data(), results.fAttCh0, results.fAttCh0Err, results.fAttCh1, results.fAttCh1Err, results.fAttCombPol1, results.fAttCombPol1Err, results.fAttCombPol3, results.fAttCombPol3Err);
+  TString query = Form("INSERT OR REPLACE INTO %s (SERIES_ID, RESULTS_FILE, ATT_CH0, ATT_CH0_ERR, ATT_CH1, ATT_CH1_ERR, ATT_COMB, ATT_COMB_ERR, ATT_COMB_POL3, ATT_COMB_POL3_ERR) VALUES (%i, '%s', %f, %f, %f, %f, %f, %f, %f, %f)", table.Data(), seriesNo, fname_full.Data(), results.fAttCh[0], results.fAttChErr[0], results.fAttCh[1], results.fAttChErr[1], results.fAttCombPol1, results.fAttCombPol1Err, results.fAttCombPol3, results.fAttCombPol3Err);
   SFTools::SaveResultsDB(dbname_full, table, query, seriesNo);
 
   delete data;
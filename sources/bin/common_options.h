@@ -4,6 +4,9 @@
 #include <iostream>
 #include <sys/stat.h> 
 #include <CmdLineConfig.hh>
+#include "SFData.hh"
+#include "SFFitParamStore.hh"
+#include "SFTools.hh"
 
 int parse_common_options(int argc, char ** argv, TString & outdir, TString & dbase, Int_t & seriesno)
 {
@@ -14,6 +17,22 @@ int parse_common_options(int argc, char ** argv, TString & outdir, TString & dba
   
   CmdLineOption cmd_dbase("Database", "-db", "Data base name (string), default: ScintFibRes.db", "ScintFibRes.db");
 
+  CmdLineOption cmd_incremental("Incremental", "-inc", "Incremental mode, reuse unchanged per-measurement products stored in given cache directory (string), default: none", "none");
+
+  CmdLineOption cmd_simevents("Simulated events", "-simev", "Number of events per measurement for simulated series (int), default: 100000", 100000);
+
+  CmdLineOption cmd_simseed("Simulation seed", "-seed", "Seed for simulated series (int), default: 4357", 4357);
+
+  CmdLineOption cmd_cutflow("Cut flow", "-cutflow", "Cut-flow accounting, attach cut-flow table to every histogram (int: 0 - off, 1 - on), default: 0", 0);
+
+  CmdLineOption cmd_adaptive("Adaptive binning", "-adaptive", "Adaptive binning of 1D histograms, number of bins per interquartile range (int: 0 - off), default: 0", 0);
+
+  CmdLineOption cmd_masks("Event masks", "-masks", "Evaluate every cut once per measurement into event masks (int: 0 - off, 1 - on), default: 0", 0);
+
+  CmdLineOption cmd_fitstore("Fit store", "-fitstore", "Keep peak fitting parameters in the FIT_PARAMS table of the data base instead of fitconfig.txt files in data directories (int: 0 - off, 1 - on), default: 0", 0);
+
+  CmdLineOption cmd_likelihood("Likelihood", "-likelihood", "Binned Poisson likelihood instead of chi2 in fits of histograms (int: 0 - off, 1 - on), default: 0", 0);
+
   CmdLineArg serno("SeriesNo", "series number", CmdLineArg::kInt);
   
   CmdLineConfig::instance()->ReadCmdLine(argc, argv);
@@ -21,6 +40,28 @@ int parse_common_options(int argc, char ** argv, TString & outdir, TString & dba
   outdir = CmdLineOption::GetStringValue("Output directory");
   dbase = CmdLineOption::GetStringValue("Database");
   seriesno = serno.GetIntValue();
+  
+  TString cachedir = CmdLineOption::GetStringValue("Incremental");
+  if(cachedir!="none")
+    SFData::SetIncremental(cachedir);
+  
+  SFData::SetResultsDatabase(outdir + "/" + dbase);
+  
+  SFData::SetCutFlow(CmdLineOption::GetIntValue("Cut flow")==1);
+  
+  SFData::SetEventMasks(CmdLineOption::GetIntValue("Event masks")==1);
+  
+  if(CmdLineOption::GetIntValue("Fit store")==1)
+    SFFitParamStore::SetDatabase(outdir + "/" + dbase);
+  
+  SFTools::SetLikelihood(CmdLineOption::GetIntValue("Likelihood")==1);
+  
+  int binsPerIQR = CmdLineOption::GetIntValue("Adaptive binning");
+  if(binsPerIQR>0)
+    SFData::SetAdaptiveBinning(true, binsPerIQR);
+  
+  SFSimulation::SetDefaults(CmdLineOption::GetIntValue("Simulated events"),
+                            CmdLineOption::GetIntValue("Simulation seed"));
 
   if(!gSystem->ChangeDirectory(outdir)){
     std::cout << "Creating new directory... " << std::endl;
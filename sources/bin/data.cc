@@ -149,19 +149,19 @@ int main(int argc, char **argv){
   int ID = SFTools::GetMeasurementID(seriesNo, 50.0);
   //int ID = SFTools::GetMeasurementID(seriesNo, 12.0);
   
-  hSigAvCh0[0] = data->GetSignalAverage(0, ID, Form("ch_0.fPE>%f && ch_0.fPE<%f", 
-                                        PE[0]-0.5, PE[0]+0.5), 20, true);
-  hSigAvCh0[1] = data->GetSignalAverage(0, ID, Form("ch_0.fPE>%f && ch_0.fPE<%f", 
-                                        PE[1]-0.5, PE[1]+0.5), 20, true);
-  hSigAvCh0[2] = data->GetSignalAverage(0, ID, Form("ch_0.fPE>%f && ch_0.fPE<%f", 
-                                        PE[2]-0.5, PE[2]+0.5), 20, true); 
-  
-  hSigAvCh1[0] = data->GetSignalAverage(1, ID, Form("ch_1.fPE>%f && ch_1.fPE<%f", 
-                                        PE[0]-0.5, PE[0]+0.5), 20, true);
-  hSigAvCh1[1] = data->GetSignalAverage(1, ID, Form("ch_1.fPE>%f && ch_1.fPE<%f", 
-                                        PE[1]-0.5, PE[1]+0.5), 20, true);
-  hSigAvCh1[2] = data->GetSignalAverage(1, ID, Form("ch_1.fPE>%f && ch_1.fPE<%f", 
-                                        PE[2]-0.5, PE[2]+0.5), 20, true);
+  //----- all averaged signals in a single scan
+  std::vector <SFSignalRequest> requests;
+  for(int i=0; i<nsigav; i++){
+    requests.push_back({0, PE[i]-0.5, PE[i]+0.5, 20});
+    requests.push_back({1, PE[i]-0.5, PE[i]+0.5, 20});
+  }
+  
+  std::vector <TProfile*> hSigAv = data->GetSignalAverages(requests, ID, true);
+  
+  for(int i=0; i<nsigav; i++){
+    hSigAvCh0[i] = hSigAv[2*i];
+    hSigAvCh1[i] = hSigAv[2*i+1];
+  }
   
   //----- drawing spectra
   TCanvas *can_ampl = new TCanvas("data_ampl", "data_ampl", 2000, 1200);
@@ -106,7 +106,7 @@ int main(int argc, char **argv){
   gPad->SetGrid(1,1);
   gEnResCh0->Draw("AP");
   text.DrawLatex(0.2, 0.8, Form("ER = (%.2f +/- %.2f) %%", 
-                 results.fEnergyResCh0, results.fEnergyResCh0Err));
+                 results.fEnergyResCh[0], results.fEnergyResChErr[0]));
 
   //----- channel 1 
   TCanvas *can_ch1 = new TCanvas("er_ch1", "er_ch1", 700, 500);
@@ -114,7 +114,7 @@ int main(int argc, char **argv){
   gPad->SetGrid(1,1);
   gEnResCh1->Draw("AP");
   text.DrawLatex(0.2, 0.8, Form("ER = (%.2f +/- %.2f) %%", 
-                 results.fEnergyResCh1, results.fEnergyResCh1Err));
+                 results.fEnergyResCh[1], results.fEnergyResChErr[1]));
 
   //----- drawing spectra 
   TCanvas *can_spec_ave = new TCanvas("er_spec_ave", "er_spec_ave", 2000, 1200);
@@ -187,7 +187,7 @@ int main(int argc, char **argv){
 
   //----- writing results to the data base
   TString table = "ENERGY_RESOLUTION";
-  TString query = Form("INSERT OR REPLACE INTO %s (SERIES_ID, RESULTS_FILE, ENRES_AV, ENRES_AV_ERR, ENRES_CH0, ENRES_CH0_ERR, ENRES_CH1, ENRES_CH1_ERR) VALUES (%i, '%s', %f, %f, %f, %f, %f, %f)", table.Data(), seriesNo, fname_full.Data(), results.fEnergyResAve, results.fEnergyResAveErr, results.fEnergyResCh0, results.fEnergyResCh0Err, results.fEnergyResCh1, results.fEnergyResCh1Err);
+  TString query = Form("INSERT OR REPLACE INTO %s (SERIES_ID, RESULTS_FILE, ENRES_AV, ENRES_AV_ERR, ENRES_CH0, ENRES_CH0_ERR, ENRES_CH1, ENRES_CH1_ERR) VALUES (%i, '%s', %f, %f, %f, %f, %f, %f)", table.Data(), seriesNo, fname_full.Data(), results.fEnergyResAve, results.fEnergyResAveErr, results.fEnergyResCh[0], results.fEnergyResChErr[0], results.fEnergyResCh[1], results.fEnergyResChErr[1]);
   SFTools::SaveResultsDB(dbname_full, table, query, seriesNo);
 
   delete data;
@@ -87,8 +87,10 @@ int main(int argc, char **argv){
   TCanvas *can = lout->GetInputData();
   
   //----- 
-  lout->CalculateLightOut(0);
-  lout->CalculateLightOut(1);
+  int nchannels = data->GetNchannels();
+  
+  for(int ch=0; ch<nchannels; ch++)
+    lout->CalculateLightOut(ch);
   lout->CalculateLightOut();
   
   TGraphErrors *gLightOutCh0 = lout->GetLightOutputGraph(0);
@@ -99,8 +101,8 @@ int main(int argc, char **argv){
   std::vector <TH1D*>  specCh1 = lout->GetSpectra(1);
   
   //-----
-  lout->CalculateLightCol(0);
-  lout->CalculateLightCol(1);
+  for(int ch=0; ch<nchannels; ch++)
+    lout->CalculateLightCol(ch);
   lout->CalculateLightCol();
   
   TGraphErrors *gLightColCh0 = lout->GetLightColGraph(0);
@@ -124,7 +126,7 @@ int main(int argc, char **argv){
   gLightOutCh0->GetYaxis()->SetLabelSize(0.035);
   gLightOutCh0->GetYaxis()->SetTitleOffset(1.4);
   gLightOutCh0->Draw("AP");
-  text.DrawLatex(0.2, 0.8, Form("LO = (%.2f +/- %.2f) PE/MeV", LOresults.fResCh0, LOresults.fResCh0Err));
+  text.DrawLatex(0.2, 0.8, Form("LO = (%.2f +/- %.2f) PE/MeV", LOresults.fResCh[0], LOresults.fResChErr[0]));
   
   can_lout_ch->cd(2);
   gPad->SetGrid(1,1);
@@ -133,7 +135,7 @@ int main(int argc, char **argv){
   gLightOutCh1->GetYaxis()->SetLabelSize(0.035);
   gLightOutCh1->GetYaxis()->SetTitleOffset(1.4);
   gLightOutCh1->Draw("AP");
-  text.DrawLatex(0.2, 0.8, Form("LO = (%.2f +/- %.2f) PE/MeV", LOresults.fResCh1, LOresults.fResCh1Err));
+  text.DrawLatex(0.2, 0.8, Form("LO = (%.2f +/- %.2f) PE/MeV", LOresults.fResCh[1], LOresults.fResChErr[1]));
   
   //----- light output summed
   TCanvas *can_lout = new TCanvas("lo_lout","lo_lout", 700, 500);
@@ -153,7 +155,7 @@ int main(int argc, char **argv){
   gLightColCh0->GetYaxis()->SetLabelSize(0.035);
   gLightColCh0->GetYaxis()->SetTitleOffset(1.4);
   gLightColCh0->Draw("AP");
-  text.DrawLatex(0.2, 0.8, Form("LO = (%.2f +/- %.2f) PE/MeV", LCresults.fResCh0, LCresults.fResCh0Err));
+  text.DrawLatex(0.2, 0.8, Form("LO = (%.2f +/- %.2f) PE/MeV", LCresults.fResCh[0], LCresults.fResChErr[0]));
   
   can_lcol_ch->cd(2);
   gPad->SetGrid(1,1);
@@ -162,7 +164,7 @@ int main(int argc, char **argv){
   gLightColCh1->GetYaxis()->SetLabelSize(0.035);
   gLightColCh1->GetYaxis()->SetTitleOffset(1.4);
   gLightColCh1->Draw("AP");
-  text.DrawLatex(0.2, 0.8, Form("LO = (%.2f +/- %.2f) PE/MeV", LCresults.fResCh1, LCresults.fResCh1Err));
+  text.DrawLatex(0.2, 0.8, Form("LO = (%.2f +/- %.2f) PE/MeV", LCresults.fResCh[1], LCresults.fResChErr[1]));
   
   //----- light output summed
   TCanvas *can_lcol = new TCanvas("lo_lcol","lo_lcol", 700, 500);
@@ -226,7 +228,7 @@ int main(int argc, char **argv){
   
   //----- writing results to the data base
   TString table = "LIGHT_OUTPUT";
-  TString query = Form("INSERT OR REPLACE INTO %s (SERIES_ID, RESULTS_FILE, LOUT, LOUT_ERR, LOUT_CH0, LOUT_CH0_ERR, LOUT_CH1, LOUT_CH1_ERR, LCOL, LCOL_ERR, LCOL_CH0, LCOL_CH0_ERR, LCOL_CH1, LCOL_CH1_ERR) VALUES (%i, '%s', %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f)", table.Data(), seriesNo, fname_full.Data(), LOresults.fRes, LOresults.fResErr, LOresults.fResCh0, LOresults.fResCh0Err, LOresults.fResCh1, LOresults.fResCh1Err, LCresults.fRes, LCresults.fResErr, LCresults.fResCh0, LCresults.fResCh0Err, LCresults.fResCh1, LCresults.fResCh1Err);
+  TString query = Form("INSERT OR REPLACE INTO %s (SERIES_ID, RESULTS_FILE, LOUT, LOUT_ERR, LOUT_CH0, LOUT_CH0_ERR, LOUT_CH1, LOUT_CH1_ERR, LCOL, LCOL_ERR, LCOL_CH0, LCOL_CH0_ERR, LCOL_CH1, LCOL_CH1_ERR) VALUES (%i, '%s', %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f)", table.Data(), seriesNo, fname_full.Data(), LOresults.fRes, LOresults.fResErr, LOresults.fResCh[0], LOresults.fResChErr[0], LOresults.fResCh[1], LOresults.fResChErr[1], LCresults.fRes, LCresults.fResErr, LCresults.fResCh[0], LCresults.fResChErr[0], LCresults.fResCh[1], LCresults.fResChErr[1]);
   SFTools::SaveResultsDB(dbname_full, table, query, seriesNo);
   
   delete data;
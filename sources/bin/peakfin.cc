@@ -76,14 +76,16 @@ int main(int argc, char **argv){
   ctx.y.max = 1000;
   
   for(int i=0; i<npoints; i++){
-    
     pfCh0.push_back(new SFPeakFinder(hSpecCh0[i], 0, 1));   // verbose = 1, tests = 1
     pfCh1.push_back(new SFPeakFinder(hSpecCh1[i], 0, 1));
     pfAve.push_back(new SFPeakFinder(hSpecAv[i], 0, 1));
-    
-    pfCh0[i]->FindPeakFit();
-    pfCh1[i]->FindPeakFit();
-    pfAve[i]->FindPeakFit();
+  }
+  
+  SFPeakFinder::FindPeakFitsSeries(pfCh0, positions);
+  SFPeakFinder::FindPeakFitsSeries(pfCh1, positions);
+  SFPeakFinder::FindPeakFitsSeries(pfAve, positions);
+  
+  for(int i=0; i<npoints; i++){
     
     pfCh0[i]->SubtractBackground();
     pfCh1[i]->SubtractBackground();
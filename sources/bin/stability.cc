@@ -128,9 +128,9 @@ int main(int argc, char **argv){
   text.SetNDC(true);
   text.SetTextSize(0.04);
   text.SetTextColor(kPink-8);
-  text.DrawLatex(0.2, 0.5, Form("#bar{PP}_{ch0} = %.2f +/- %.2f", results.fCh0Mean, results.fCh0StdDev));
+  text.DrawLatex(0.2, 0.5, Form("#bar{PP}_{ch0} = %.2f +/- %.2f", results.fChMean[0], results.fChStdDev[0]));
   text.SetTextColor(kAzure-6);
-  text.DrawLatex(0.2, 0.4, Form("#bar{PP}_{ch1} = %.2f +/- %.2f", results.fCh1Mean, results.fCh1StdDev));
+  text.DrawLatex(0.2, 0.4, Form("#bar{PP}_{ch1} = %.2f +/- %.2f", results.fChMean[1], results.fChStdDev[1]));
   
   can->cd(0);
   pad_res->Draw();
@@ -199,7 +199,7 @@ int main(int argc, char **argv){
   
   //----- writing results to the data base
   TString table = "STABILITY_MON";
-  TString query = Form("INSERT OR REPLACE INTO %s (SERIES_ID, RESULTS_FILE, CH0_MEAN, CH0_STDDEV, CH1_MEAN, CH1_STDDEV) VALUES (%i, '%s', %f, %f, %f, %f)", table.Data(), seriesNo, fname_full.Data(), results.fCh0Mean, results.fCh0StdDev, results.fCh1Mean, results.fCh1StdDev);
+  TString query = Form("INSERT OR REPLACE INTO %s (SERIES_ID, RESULTS_FILE, CH0_MEAN, CH0_STDDEV, CH1_MEAN, CH1_STDDEV) VALUES (%i, '%s', %f, %f, %f, %f)", table.Data(), seriesNo, fname_full.Data(), results.fChMean[0], results.fChStdDev[0], results.fChMean[1], results.fChStdDev[1]);
   SFTools::SaveResultsDB(dbname_full, table, query, seriesNo);
   
   delete data;
@@ -23,6 +23,14 @@ int main(int argc, char **argv){
   TString dbase;
   int seriesNo = -1;
 
+  CmdLineOption cmd_pescan("PE scan", "-pescan", "Scan of decay constants in PE bins, number of bins (int: 0 - off), default: 0", 0);
+  
+  CmdLineOption cmd_pemin("PE scan min", "-pemin", "Lower edge of the PE scan (double), default: 20", 20.);
+  
+  CmdLineOption cmd_pemax("PE scan max", "-pemax", "Upper edge of the PE scan (double), default: 600", 600.);
+  
+  CmdLineOption cmd_pesig("PE scan signals", "-pesig", "Maximum number of averaged signals per PE bin (int), default: 50", 50);
+
   int ret = parse_common_options(argc, argv, outdir, dbase, seriesNo);
   if(ret != 0) 
     exit(ret);
@@ -52,6 +60,7 @@ int main(int argc, char **argv){
   }
   
   int npoints = data->GetNpoints();
+  int nchannels = data->GetNchannels();
   std::vector <double> positions = data->GetPositions();
   data->Print();
   
@@ -75,8 +84,8 @@ int main(int argc, char **argv){
   int statCh1 = -1;
   
   TimeConstResults results = tconst->GetResults();
-  std::vector <SFFitResults*> resultsCh0 = results.fResultsCh0;
-  std::vector <SFFitResults*> resultsCh1 = results.fResultsCh1;
+  std::vector <SFFitResults*> resultsCh0 = results.fResultsCh[0];
+  std::vector <SFFitResults*> resultsCh1 = results.fResultsCh[1];
   
   TCanvas *canCh0 = new TCanvas("tc_ch0", "tc_ch0", 1500, 1200);
   canCh0->DivideSquare(npoints);
@@ -166,6 +175,31 @@ int main(int argc, char **argv){
   canCh1->cd(1);
   legCh1->Draw();
   
+  //----- PE scan
+  int nbinsPE = CmdLineOption::GetIntValue("PE scan");
+  std::vector <TCanvas*> canScan;
+  
+  if(nbinsPE>0){
+    bool stat = tconst->ScanPE(CmdLineOption::GetDoubleValue("PE scan min"),
+                               CmdLineOption::GetDoubleValue("PE scan max"),
+                               nbinsPE, CmdLineOption::GetIntValue("PE scan signals"));
+    int ncompScan = (ncomp==2) ? 2 : 1;
+    
+    for(int ch=0; stat && ch<nchannels; ch++){
+      TCanvas *can = new TCanvas(Form("tc_pescan_ch%i", ch), Form("tc_pescan_ch%i", ch), 1500, 1200);
+      can->Divide(2, ncompScan);
+      for(int comp=0; comp<ncompScan; comp++){
+        bool fast = (comp==0);
+        can->cd(1+2*comp);
+        gPad->SetGrid(1,1);
+        tconst->GetScanGraph(ch, fast)->Draw("AP");
+        can->cd(2+2*comp);
+        tconst->GetScanMap(ch, fast)->Draw("colz");
+      }
+      canScan.push_back(can);
+    }
+  }
+  
   //----- saving
   TString fname = Form("tconst_series%i.root", seriesNo);  
   TString fname_full = outdir + "/" + fname;
@@ -181,6 +215,8 @@ int main(int argc, char **argv){
   
   canCh0->Write();
   canCh1->Write();
+  for(size_t i=0; i<canScan.size(); i++)
+    canScan[i]->Write();
   file->Close();
   
   //----- writing results to the data base
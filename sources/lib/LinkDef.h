@@ -16,5 +16,15 @@
 #pragma link C++ class SFPositionRes+;
 #pragma link C++ class SFTemperature+;
 #pragma link C++ class SFStabilityMon+;
+#pragma link C++ class SFManifest+;
+#pragma link C++ class SFSimulation+;
+#pragma link C++ class SFCutFlow+;
+#pragma link C++ class SFQuantileSketch+;
+#pragma link C++ class SFEventMask+;
+#pragma link C++ class SFHistPyramid+;
+#pragma link C++ class SFPrefixSum+;
+#pragma link C++ class SFSpectrumMatrix+;
+#pragma link C++ class SFSpectrumInfo+;
+#pragma link C++ class SFFitParamStore+;
 
 #endif
@@ -15,6 +15,7 @@
 #include "TGraphErrors.h"
 #include "SFData.hh"
 #include "SFPeakFinder.hh"
+#include "SFTools.hh"
 #include <iostream>
 
 /// Structure containing numerical results of attenuation
@@ -28,11 +29,8 @@ struct AttenuationResults{
     double fAttCombPol3    = -1;   ///< Attenuation length determined with combined channels method and 3rd degree polynomial fit
     double fAttCombPol3Err = -1;   ///< Uncertainty of fAttCombPol3
     
-    double fAttCh0    = -1;   ///< Attenuation length of channel 0
-    double fAttCh0Err = -1;   ///< Uncertainty of fAttCh0
-    
-    double fAttCh1    = -1;   ///< Attenuation length of channel 1
-    double fAttCh1Err = -1;   ///< Uncertainty of fAttCh1
+    std::vector <double> fAttCh;      ///< Attenuation lengths of separate channels, indexed with channel number
+    std::vector <double> fAttChErr;   ///< Uncertainties of fAttCh
 };
 
 /// Class to determine attenuation length. This class is suitable only for experimental 
@@ -47,16 +45,18 @@ private:
   int                 fSeriesNo;       ///< Number of experimental series to be analyzed
   SFData*             fData;           ///< SFData object of the analyzed series
   
+  int                 fNchannels;      ///< Number of readout channels
+  
   std::vector <TH1D*> fRatios;      ///< Vector containing histograms of ln(M_LR) distributions
-  std::vector <TH1D*> fSpectraCh0;  ///< Vector containing charge spectra from channel 0
-  std::vector <TH1D*> fSpectraCh1;  ///< Vector containing charche spectra from channel 1
-  std::vector <TH1D*> fPeaksCh0;    ///< Vector containing 511 keV peaks, channel 0 [not used at the moment]
-  std::vector <TH1D*> fPeaksCh1;    ///< Vector containing 511 keV peaks, channel 1 [not used at the moment]
+  std::vector <std::vector <TH1D*>> fSpectra;  ///< Charge spectra, indexed with channel number and measurement
+  std::vector <std::vector <TH1D*>> fPeaks;    ///< 511 keV peaks, indexed like fSpectra [not used at the moment]
   
   TGraphErrors *fAttnGraph;         ///< Attenuation graph i.e. ln(M_LR) vs. source position
   TGraphErrors *fSigmaGraph;        ///< Graph sigma of ln(M_LR) vs. source position
-  TGraphErrors *fAttnGraphCh0;      ///< Attenuation graph for channel 0
-  TGraphErrors *fAttnGraphCh1;      ///< Attenuation graph for channel 1
+  std::vector <TGraphErrors*> fAttnGraphCh;  ///< Attenuation graphs for separate channels
+  
+  bool                 CheckChannel(int ch, TString function);
+  bool                 FitSeparateCh(int ch, std::vector <TH1D*> spectra);
   
   AttenuationResults fResults;      ///< Results of attenuation analysis
   
@@ -66,6 +66,7 @@ private:
   
   bool                 AttAveragedCh(void);
   bool                 AttSeparateCh(int ch);
+  bool                 AttSeparateCh(void);
   bool                 Fit3rdOrder(void);
   
   TGraphErrors*        GetAttGraph(void);
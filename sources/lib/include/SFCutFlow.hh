@@ -0,0 +1,70 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *             SFCutFlow.hh              *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#ifndef __SFCutFlow_H_
+#define __SFCutFlow_H_ 1
+#include "TObject.h"
+#include "TString.h"
+#include "TH1.h"
+#include "TList.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+/// Class containing cut-flow table of a single histogram. The cut
+/// (TTree-style) is split into conditions joined with the top-level
+/// "&&", e.g. "ch_0.fT0>0 && ch_0.fT0<590 && ch_0.fPE>0" gives three
+/// conditions. For every condition number of entries passing it together
+/// with all preceding conditions (sequential) and number of entries
+/// passing it alone (independent) is counted. The table is filled by
+/// SFData in the same pass over the data as the histogram and is attached
+/// to the histogram's list of functions, thus it is stored together with
+/// the histogram (see GetCutFlow()).
+
+class SFCutFlow : public TObject{
+
+private:
+  TString                 fCut;          ///< Full cut
+  std::vector <TString>   fConditions;   ///< Conditions of the cut joined with "&&"
+  Long64_t                fTested;       ///< Number of tested entries
+  std::vector <Long64_t>  fSequential;   ///< Number of entries passing all conditions up to the given one
+  std::vector <Long64_t>  fIndependent;  ///< Number of entries passing the given condition
+
+public:
+  SFCutFlow();
+  SFCutFlow(TString cut);
+  ~SFCutFlow();
+
+  static std::vector <TString> SplitCut(TString cut, TString op = "&&");
+  static SFCutFlow*            GetCutFlow(TH1 *hist);
+
+  bool Count(const std::vector <bool> &pass);
+  void Count(Long64_t n);
+  bool Add(const SFCutFlow *flow);
+  void Attach(TH1 *hist);
+  void Print(void);
+
+  /// Returns full cut.
+  TString  GetCut(void) const { return fCut; };
+  /// Returns conditions of the cut.
+  std::vector <TString>  GetConditions(void) const { return fConditions; };
+  /// Returns number of tested entries.
+  Long64_t GetTested(void) const { return fTested; };
+  /// Returns number of entries passing the whole cut.
+  Long64_t GetPassed(void) const { return fSequential.empty() ? fTested : fSequential.back(); };
+  /// Returns numbers of entries passing all conditions up to the given one.
+  std::vector <Long64_t> GetSequential(void) const { return fSequential; };
+  /// Returns numbers of entries passing the given condition alone.
+  std::vector <Long64_t> GetIndependent(void) const { return fIndependent; };
+
+  ClassDef(SFCutFlow,1)
+};
+
+#endif
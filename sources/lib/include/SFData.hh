@@ -19,17 +19,40 @@
 #include "TROOT.h"
 #include "TProfile.h"
 #include "TVectorT.h"
+#include "TTreeFormula.h"
 #include "DDSignal.hh"
 #include "SFDrawCommands.hh"
+#include "SFKernels.hh"
+#include "SFCutFlow.hh"
+#include "SFQuantileSketch.hh"
+#include "SFEventMask.hh"
+#include "SFSpectrumMatrix.hh"
+#include "SFSpectrumInfo.hh"
 #include "SFTools.hh"
+#include "SFManifest.hh"
+#include "SFSimulation.hh"
 #include <iostream>
 #include <iomanip>
 #include <fstream>
 #include <string>
 #include <stdlib.h>
+#include <cmath>
 #include <vector>
+#include <algorithm>
+#include <iterator>
+#include <map>
 #include <sqlite3.h>
 
+/// Request of an averaged signal for GetSignalAverages(): signals of the
+/// channel with PE in the given window are averaged, up to the given number.
+struct SFSignalRequest{
+  
+  int    fChannel;   ///< Channel number
+  double fPEmin;     ///< Lower edge of the PE window
+  double fPEmax;     ///< Upper edge of the PE window
+  int    fNumber;    ///< Number of signals to be averaged
+};
+
 /// Class to access experiemntal data. Information about an experimental 
 /// series and all measurements is loaded from the SQLite3 data base.  
 /// Subsequently requested data is accessed from ROOT files and binary 
@@ -38,6 +61,16 @@
 /// type. All possible selections for histograms are defined in SFDrawCommands
 /// class. Single signals and averaged signals are also possible to access.
 /// Cutting functionality based on ROOT's TTree for all has been implemented.
+///
+/// Quantities combining two ends of the fiber are calculated once per 
+/// measurement and stored in the derived tree "tree_derived", which is
+/// attached as a friend of "tree_ft" whenever selection or cut refers 
+/// to it. For every fiber, i.e. pair of channels (2k, 2k+1), it contains:
+/// - fLnMLR[k] - ln(M_LR) = log(sqrt(ch_2k+1.fPE/ch_2k.fPE))
+/// - fPEAverage[k] - geometric mean PE = sqrt(ch_2k.fPE*ch_2k+1.fPE)
+/// - fT0Diff[k] - T0 difference = ch_2k.fT0-ch_2k+1.fT0
+/// - fPEAttCorr[k] - sum of attenuation-corrected PE of both ends, stored only
+///   if the attenuation length is known (see SetResultsDatabase())
 
 class SFData : public TObject{
     
@@ -56,6 +89,9 @@ private:
   TString          fCoupling;        ///< Coupling type: silicone gel/silicone pads
   TString          fLogFile;         ///< Name of measurment log file
   TString          fTempFile;        ///< Name of temperature log file
+  int              fNchannels;       ///< Number of readout channels
+  int              fRefChannel;      ///< Number of the reference detector channel
+  double           fAttLength;       ///< Attenuation length used for the attenuation-corrected PE [mm]
   sqlite3          *fDB;             ///< SQLite3 data base
   
   std::vector <TString> fNames;      ///< Vector containing names of measurements
@@ -67,11 +103,55 @@ private:
   
   int  gUnique = 0.;                 ///< Unique flag to identify temporary histograms
   
+  SFManifest   *fManifest;           //! Manifest of products, used in the incremental mode
+  SFSimulation *fSimulation;         //! Fiber model, used for the "Simulation" test bench
+  
+  static TString fCacheDir;          ///< Cache directory for the incremental mode
+  static TString fResultsDB;         ///< Results data base, source of the attenuation length
+  static bool    fIncremental;       ///< Flag for the incremental mode
+  static bool    fCutFlow;           ///< Flag for the cut-flow accounting
+  static bool    fAdaptive;          ///< Flag for the adaptive binning
+  static int     fBinsPerIQR;        ///< Target resolution of the adaptive binning: bins per interquartile range
+  static bool    fEventMasks;        ///< Flag for the event masks of cuts
+  static std::map <TString, SFEventMask*> fMasks;  //! Event masks of cuts and their conditions, see GetMaskKey()
+  
   bool      InterpretCut(DDSignal *sig, TString cut);
+  TObject*  GetCachedProduct(TString key, std::vector <TString> inputs, TString params);
+  void      CacheProduct(TString key, std::vector <TString> inputs, TString params, TObject *obj);
   TProfile* GetSignalAverageKrakow(int ch, int ID, TString cut, int number, bool bl);
   TProfile* GetSignalAverageAachen(int ch, int ID, TString cut, int number);
   TH1D*     GetSignalKrakow(int ch, int ID, TString cut, int number, bool bl);
   TH1D*     GetSignalAachen(int ch, int ID, TString cut, int number);
+  TProfile* GetSignalAverageSimulation(int ch, int ID, TString cut, int number, bool bl);
+  TH1D*     GetSignalSimulation(int ch, int ID, TString cut, int number, bool bl);
+  void      FillSignalAverages(int ID, const std::vector <SFSignalRequest> &requests,
+                               const std::vector <TProfile*> &profiles, bool bl);
+  TString   GetResultsFile(int index);
+  TString   GetInputName(int index);
+  TString   GetDerivedFile(int index);
+  void      AttachDerived(TTree *tree, int index, TString expression);
+  static bool UsesDerived(TString expression);
+  void      CheckAttenuation(TString expression);
+  bool      LoadAttenuationLength(void);
+  SFSelection BindSelection(SFSelection desc, int index);
+  void      AttachInfo(TH1 *hist, int index, std::vector <int> channels, 
+                       TString selection, TString cut);
+  void      FillParallel(int index, const std::vector <SFSelection> &sels,
+                         const std::vector <TString> &cuts, const std::vector <TH1*> &hists);
+  void      FillKernel(int index, TString dname, const std::vector <SFSelection> &sels,
+                       const std::vector <TString> &cuts, const std::vector <TH1*> &hists,
+                       const std::vector <SFCutFlow*> &flows, 
+                       const std::vector <SFQuantileSketch*> &sketches,
+                       const std::vector <SFEventMask*> &masks, int chunk, int nchunks);
+  void      AdaptBinning(int index, TString dname, std::vector <SFSelection> &sels,
+                         const std::vector <TString> &cuts, const std::vector <SFEventMask*> &masks);
+  TH1*      FillSingle(int index, SFSelection desc, TString cut, TString hname, TString htitle);
+  static TString NormalizeCut(TString cut);
+  static void    CollectConditions(TString cut, std::vector <TString> &conds);
+  TString      GetMaskKey(int index, TString cut);
+  SFEventMask* GetMask(int index, TString cut);
+  void         EvaluateConditions(int index, const std::vector <TString> &conds);
+  SFEventMask* ComposeMask(int index, TString cut);
   
 public:
   SFData();
@@ -80,22 +160,59 @@ public:
   
   bool                OpenDataBase(TString name);
   bool                SetDetails(int seriesNo);
-  TTree*              GetTree(int ID);
+  TTree*              GetTree(int ID, bool derived = false);
   TH1D*               GetSpectrum(int ch, SFSelectionType sel_type, TString cut, int ID);
   TH1D*               GetCustomHistogram(SFSelectionType sel_type, TString cut, int ID, 
                                          std::vector <double> customNum={});
+  TH1D*               GetCustomHistogram(SFSelectionType sel_type, TString cut, int ID, 
+                                         int chL, int chR, std::vector <double> customNum={});
   TH1D*               GetCustomHistogram(int ch, SFSelectionType sel_type, TString cut, 
                                          int ID, std::vector <double> customNum);
   TH2D*               GetCorrHistogram(SFSelectionType sel_type, TString cut, int ID, int ch = -1);
+  TH2D*               GetCorrHistogram(SFSelectionType sel_type, TString cut, int ID, int chL, int chR);
+  std::vector <TH1D*> GetChannelSpectra(SFSelectionType sel_type, std::vector <TString> cuts, int ID);
+  std::vector <TH1D*> GetSpectrumSlices(int ch, SFSelectionType sel_type, TString cut, int ID, int nslices);
+  std::vector <TH1*>  FillSelections(std::vector <SFSelection> sels, std::vector <TString> cuts, int ID);
+  SFEventMask*        GetEventMask(TString cut, int ID);
   std::vector <TH1D*> GetSpectra(int ch, SFSelectionType sel_type, TString cut);
+  SFSpectrumMatrix*   GetSpectrumMatrix(int ch, SFSelectionType sel_type, TString cut);
   std::vector <TH1D*> GetCustomHistograms(SFSelectionType sel_type, TString cut);
   std::vector <TH2D*> GetCorrHistograms(SFSelectionType sel_type, TString cut, int ch = -1);
   TProfile*           GetSignalAverage(int ch, int ID, TString cut, int number, bool bl);
+  std::vector <TProfile*> GetSignalAverages(std::vector <SFSignalRequest> requests, int ID, bool bl);
   TH1D*               GetSignal(int ch, int ID, TString cut, int number, bool bl);
   void                Print(void);
   
+  static void         SetIncremental(TString cacheDir);
+  static void         SetResultsDatabase(TString database);
+  static void         SetCutFlow(bool cutFlow);
+  /// Returns true if cut-flow accounting is switched on.
+  static bool         IsCutFlow(void){ return fCutFlow; };
+  static void         SetAdaptiveBinning(bool adaptive, int binsPerIQR = 40);
+  /// Returns true if adaptive binning is switched on.
+  static bool         IsAdaptiveBinning(void){ return fAdaptive; };
+  static void         SetEventMasks(bool eventMasks);
+  static void         ClearEventMasks(void);
+  /// Returns true if event masks of cuts are switched on.
+  static bool         IsEventMasks(void){ return fEventMasks; };
+  /// Returns true if incremental mode is switched on.
+  static bool         IsIncremental(void){ return fIncremental; };
+  /// Returns fiber model of this series ("Simulation" test bench only).
+  SFSimulation*       GetSimulation(void){ return fSimulation; };
+  /// Returns manifest of products of this series (incremental mode only).
+  SFManifest*         GetManifest(void){ return fManifest; };
+  
   /// Returns number of measurements in the series.
   int      GetNpoints(void){ return fNpoints; };
+  /// Returns number of readout channels.
+  int      GetNchannels(void){ return fNchannels; };
+  /// Returns number of the reference detector channel.
+  int      GetRefChannel(void){ return fRefChannel; };
+  /// Returns attenuation length used for the attenuation-corrected PE [mm].
+  double   GetAttenuationLength(void){ return fAttLength; };
+  /// Sets attenuation length used for the attenuation-corrected PE [mm],
+  /// overriding the value from the results data base.
+  void     SetAttenuationLength(double attLength){ fAttLength = attLength; };
   /// Returns analysis group number. 
   int      GetAnalysisGroup(void){ return fAnalysisGroup; };
   /// Returns fiber type.
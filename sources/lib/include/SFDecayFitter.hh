@@ -0,0 +1,85 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *           SFDecayFitter.hh            *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#ifndef __SFDecayFitter_H_
+#define __SFDecayFitter_H_ 1
+#include "TProfile.h"
+#include "TF1.h"
+#include "TString.h"
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+/// Least-squares fitter of the falling slope of averaged signals with
+/// the single or double decay model:
+/// \f[
+/// f(t) = \sum_{k} A_k \cdot e^{-\frac{t-t_0}{\tau_k}} + const
+/// \f]
+/// where \f$t_0\f$ and the constant (baseline) are fixed. The amplitudes
+/// \f$A_k\f$ enter linearly, so they are eliminated with variable projection:
+/// for given decay constants they are obtained from the weighted linear
+/// least squares and Levenberg-Marquardt iterations are performed only in
+/// the space of the decay constants (in logarithmic scale, so that they
+/// stay positive), with analytic Jacobian in the Kaufman approximation.
+/// Uncertainties of all fitted parameters are calculated from the full
+/// analytic Jacobian at the minimum, like the errors of TH1::Fit().
+
+class SFDecayFitter{
+
+private:
+  std::vector <double> fX;          ///< Bin centers
+  std::vector <double> fY;          ///< Bin contents, baseline subtracted
+  std::vector <double> fW;          ///< Inverse bin errors
+  double fT0;                       ///< Fixed t0
+
+  std::vector <double> fTau;        ///< Fitted decay constants
+  std::vector <double> fTauErr;     ///< Uncertainties of decay constants
+  std::vector <double> fAmp;        ///< Fitted amplitudes
+  std::vector <double> fAmpErr;     ///< Uncertainties of amplitudes
+  double fChi2;                     ///< Chi2 of the fit
+  int    fNiter;                    ///< Number of Levenberg-Marquardt iterations
+
+  double Project(const std::vector <double> &tau, std::vector <double> &amp,
+                 std::vector <double> &resid, std::vector <double> *jac);
+  bool   Errors(void);
+
+  static bool Solve(int n, double *A, double *b);
+
+public:
+  SFDecayFitter();
+  ~SFDecayFitter();
+
+  int  SetData(TProfile *signal, double xmin, double xmax, double t0, double baseline);
+  int  Fit(std::vector <double> tau);
+
+  TString GetSummary(void);
+
+  static int    FitSignal(TProfile *signal, TF1 *fun, TString *summary = nullptr);
+  static double GetBaseline(TProfile *signal, double xmin, double xmax);
+  static double EstimateDecayTime(TProfile *signal, double xmin, double xmax,
+                                  double baseline, double defaultTau);
+
+  /// Returns fitted decay constants.
+  std::vector <double> GetDecayTimes(void){ return fTau; };
+  /// Returns uncertainties of the fitted decay constants.
+  std::vector <double> GetDecayTimesErr(void){ return fTauErr; };
+  /// Returns fitted amplitudes.
+  std::vector <double> GetAmplitudes(void){ return fAmp; };
+  /// Returns uncertainties of the fitted amplitudes.
+  std::vector <double> GetAmplitudesErr(void){ return fAmpErr; };
+  /// Returns chi2 of the fit.
+  double GetChi2(void){ return fChi2; };
+  /// Returns number of degrees of freedom of the fit.
+  int GetNDF(void){ return (int)fX.size() - 2*(int)fTau.size(); };
+  /// Returns number of Levenberg-Marquardt iterations of the last fit.
+  int GetNiter(void){ return fNiter; };
+};
+
+#endif
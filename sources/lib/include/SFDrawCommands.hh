@@ -13,6 +13,8 @@
 #include "TObject.h"
 #include "TString.h"
 #include <iostream>
+#include <vector>
+#include <map>
 
 /// \file
 /// Enumeration representing different types of selections
@@ -37,14 +39,43 @@ enum class SFSelectionType{
                             ///< for attenuation length: \f$ Q_{ch0}/\exp{\frac{z}{\lambda_{att}}} + Q_{ch1}/\exp{\frac{(L-z)}{\lambda_{att}}}\f$
 };
 
+/// Typed description of the selection. Contains the same information as 
+/// the TTree-style selection string, but as data: channels, binning and
+/// expression. Selections described in this way are evaluated with the 
+/// compiled kernels (see SFKernel), without TTreeFormula.
+struct SFSelection{
+  
+  SFSelectionType      fType;              ///< Selection type
+  std::vector <int>    fChannels;          ///< Channels used in the selection (ch or chL, chR or ch, ref. channel)
+  std::vector <double> fCustomNum;         ///< Values inserted in the selection
+  TString              fExpression = "";   ///< TTree-style expression, e.g. ch_0.fPE
+  int                  fNbinsX = 0;        ///< Number of bins along X axis
+  double               fXmin   = 0;        ///< Lower edge of X axis
+  double               fXmax   = 0;        ///< Upper edge of X axis
+  int                  fNbinsY = 0;        ///< Number of bins along Y axis, 0 for 1D selections
+  double               fYmin   = 0;        ///< Lower edge of Y axis
+  double               fYmax   = 0;        ///< Upper edge of Y axis
+  TString              fCut    = "";       ///< Default cut (syntax like for Draw() method of TTree)
+};
+
 /// Class providing standarized and uniform set of selections for analyzed 
-/// data. Selections are returned as TString and are consistent with 
-/// ROOT's TTree style.
+/// data. Selections are described with SFSelection structures and can be 
+/// returned as TString, consistent with ROOT's TTree style.
+///
+/// Binning and default cuts of the built-in selections can be changed, 
+/// and new named selections can be defined, in the "SFSelections" section 
+/// of the analysis group configuration file .configAG<N>.json (see LoadConfig()).
 
 class SFDrawCommands : public TObject{
     
 private:
+    static std::map <TString, SFSelection> fOverrides;  ///< Configured binning and cuts of built-in selections
+    static std::map <TString, SFSelection> fRegistry;   ///< Named selections defined in the configuration file
+    static TString                         fConfigFile; ///< Name of the loaded configuration file
+    
     static void CheckSelection(TString string);
+    static void ApplyConfig(SFSelection &desc);
+    static bool IsSingleChannel(SFSelectionType selection);
     
 public:
     /// Default constructor.
@@ -52,11 +83,23 @@ public:
     /// Default destructor.
     ~SFDrawCommands() {};
     
-    static TString GetSelectionName(SFSelectionType selection);
+    static TString     GetSelectionName(SFSelectionType selection);
+    static bool        GetSelectionType(TString name, SFSelectionType &selection);
+    static bool        LoadConfig(TString fileName);
+    static SFSelection GetDescriptor(TString name);
+    static bool        IsRegistered(TString name);
+    static std::vector <TString> GetRegisteredNames(void);
+    static SFSelection GetDescriptor(SFSelectionType selection, int ch, 
+                                     std::vector <double> customNum={});
+    static SFSelection GetDescriptor(SFSelectionType selection, int chL, int chR,
+                                     std::vector <double> customNum={});
+    static TString     GetSelection(const SFSelection &descriptor, int unique);
     static TString GetSelection(SFSelectionType selection, int unique, 
                                 int ch, std::vector <double> customNum={});
     static TString GetSelection(SFSelectionType selection, int unique, 
                                 std::vector <double> customNum={});
+    static TString GetSelection(SFSelectionType selection, int unique,
+                                int chL, int chR, std::vector <double> customNum={});
     
     void Print(void);
     
@@ -22,19 +22,16 @@
 /// Structure containing numerical results of energy resolution analysis.
 struct EnergyResResults{
     
-    double fEnergyResCh0    = -1; ///< Energy resolution of channel 0
-    double fEnergyResCh0Err = -1; ///< Uncertainty of energy resolution of channel 0
-    
-    double fEnergyResCh1    = -1; ///< Energy resolution of channel 1
-    double fEnergyResCh1Err = -1; ///< Uncertainty of energy resolution of channel 1
+    std::vector <double> fEnergyResCh;     ///< Energy resolution of separate channels, indexed with channel number
+    std::vector <double> fEnergyResChErr;  ///< Uncertainties of energy resolution of separate channels
     
     double fEnergyResAve    = -1; ///< Energy resolution for averaged channels
     double fEnergyResAveErr = -1; ///< Uncertainty of energy resolution for averaged channels
 };
 
 /// Class performing analysis of energy resolution for requested series. 
-/// Energy resolution is determined separately for channels 0 and 1 as 
-/// well as for the averaged spectra. 
+/// Energy resolution is determined separately for all readout channels 
+/// of the series as well as for the averaged spectra of channels 0 and 1. 
 /// 
 /// Energy resolution for single measurement is calculated as follows:
 /// \f[
@@ -47,8 +44,8 @@ struct EnergyResResults{
 /// \Delta ER = ER \cdot \sqrt{\frac{\Delta \mu_{511}^2}{\mu_{511}^2} + 
 /// \frac{\Delta \sigma_{511}^2}{\sigma_{511}^2}} \cdot 100\%
 /// \f]
-/// Results of calculations are plotted on graphs: fEnergyResGraphCh0, 
-/// fEnergyResCh1 and fEnergyResAve. Each of them is accessible via dedicated 
+/// Results of calculations are plotted on graphs: fEnergyResGraphCh 
+/// (one for each channel) and fEnergyResAve. Each of them is accessible via dedicated 
 /// functions.
 /// 
 /// Final energy resolution values for the series are calculated as mean weighted 
@@ -69,16 +66,15 @@ private:
   int     fSeriesNo; ///< Number of experimental series to be analyzed
   SFData *fData;     ///< SFData object of the analyzed series
   
-  TGraphErrors *fEnergyResGraphCh0;  ///< Energy resolution graph for channel 0
-  TGraphErrors *fEnergyResGraphCh1;  ///< Energy resolution graph for channel 1
+  int     fNchannels; ///< Number of readout channels
+  
+  std::vector <TGraphErrors*> fEnergyResGraphCh;  ///< Energy resolution graphs for separate channels
   TGraphErrors *fEnergyResGraphAve;  ///< Energy resolution graph for averaged spectra
   
-  std::vector <TH1D*> fSpectraCh0;   ///< Vector containing charge spectra from channel 0
-  std::vector <TH1D*> fSpectraCh1;   ///< Vector containing charge spectra from channel 1
+  std::vector <std::vector <TH1D*>> fSpectraCh;  ///< Charge spectra, indexed with channel number and measurement
   std::vector <TH1D*> fSpectraAve;   ///< Vector containing averaged charge spectra
   
-  std::vector <TH1D*> fPeaksCh0;     ///< Vector containing spectra after background subtraction (currently not used)
-  std::vector <TH1D*> fPeaksCh1;     ///< Vector containing spectra after background subtraction (currently not used)
+  std::vector <std::vector <TH1D*>> fPeaksCh;    ///< Spectra after background subtraction, indexed like fSpectraCh (currently not used)
   std::vector <TH1D*> fPeaksAve;     ///< Vector containing spectra after background subtraction (currently not used)
   
   EnergyResResults fResults;         ///< Structure containing numerical results od analysis
@@ -0,0 +1,59 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *            SFEventMask.hh             *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#ifndef __SFEventMask_H_
+#define __SFEventMask_H_ 1
+#include "TObject.h"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+/// Compressed set of tree entries, e.g. entries passing the cut. Entries
+/// are grouped in containers of 2^16 consecutive entries, similarly to
+/// roaring bitmaps. Sparse containers (up to 4096 entries) are stored as
+/// sorted arrays of 16-bit offsets, dense containers as bitmaps of
+/// 1024 64-bit words. Masks can be combined with And() and Or() and
+/// entries can be iterated in increasing order (see GetEntries()).
+
+class SFEventMask : public TObject{
+
+private:
+  Long64_t fNentries;                          ///< Number of entries of the tree
+  std::vector <Long64_t> fKeys;                ///< Container keys, i.e. entry>>16, sorted
+  std::vector <std::vector <UShort_t>>  fArrays;   ///< Sparse containers: sorted offsets (empty for dense containers)
+  std::vector <std::vector <ULong64_t>> fBitmaps;  ///< Dense containers: bitmaps (empty for sparse containers)
+
+  static const int kArrayMax = 4096;           ///< Maximal size of the sparse container
+  static const int kWords    = 1024;           ///< Number of words of the dense container
+
+  int                     FindContainer(Long64_t key) const;
+  std::vector <ULong64_t> GetBitmap(int container) const;
+  void                    AddContainer(Long64_t key, const std::vector <ULong64_t> &bitmap);
+  SFEventMask             Combine(const SFEventMask &mask, bool isAnd) const;
+
+public:
+  SFEventMask(Long64_t nentries = 0);
+  ~SFEventMask();
+
+  void        Add(Long64_t entry);
+  bool        Contains(Long64_t entry) const;
+  Long64_t    GetCount(void) const;
+  SFEventMask And(const SFEventMask &mask) const;
+  SFEventMask Or(const SFEventMask &mask) const;
+  std::vector <Long64_t> GetEntries(Long64_t first, Long64_t last) const;
+  void        Print(void);
+
+  /// Returns number of entries of the tree.
+  Long64_t GetNentries(void) const { return fNentries; };
+
+  ClassDef(SFEventMask,1)
+};
+
+#endif
@@ -0,0 +1,67 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *          SFFitParamStore.hh           *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#ifndef __SFFitParamStore_H_
+#define __SFFitParamStore_H_ 1
+#include "TObject.h"
+#include "TString.h"
+#include "TSystem.h"
+#include <iostream>
+#include <map>
+#include <set>
+#include <ctime>
+#include <sqlite3.h>
+
+/// Store of the peak fitting parameters (FitterFactory entries, i.e. lines
+/// of the fitconfig.txt format) of one experimental series. Entries are
+/// kept in memory for the whole run and persisted in the FIT_PARAMS table
+/// of the results data base, indexed by series number and histogram name.
+/// All entries modified since the last Save() are written in a single
+/// transaction. If the store is enabled (see SetDatabase()) SFPeakFinder
+/// takes initial parameters of the fits from here instead of fitconfig.txt
+/// files in the data directories.
+
+class SFFitParamStore : public TObject{
+
+private:
+  TString fDatabase;                     ///< Results data base
+  int     fSeriesNo;                     ///< Experimental series number
+  int     fNseeded;                      ///< Number of entries created in this session
+  std::map <TString, TString> fEntries;  ///< FitterFactory entries, by histogram name
+  std::set <TString> fModified;          ///< Histograms with entries not saved yet
+
+  static TString fDefaultDatabase;                    ///< Data base used by GetStore()
+  static std::map <int, SFFitParamStore*> fStores;    ///< Stores opened in this session
+
+  bool Load(void);
+
+public:
+  SFFitParamStore(TString database, int seriesNo);
+  ~SFFitParamStore();
+
+  static void             SetDatabase(TString database);
+  static SFFitParamStore* GetStore(int seriesNo);
+
+  TString GetEntry(TString hname);
+  void    SetEntry(TString hname, TString entry, bool seeded = false);
+  bool    Save(void);
+  void    Print(void);
+
+  /// Returns true if the store is enabled, i.e. data base was set.
+  static bool IsEnabled(void){ return fDefaultDatabase!=""; };
+  /// Returns number of entries in the store.
+  int GetNentries(void){ return fEntries.size(); };
+  /// Returns number of entries created (seeded) in this session.
+  int GetNseeded(void){ return fNseeded; };
+
+  ClassDef(SFFitParamStore,1)
+};
+
+#endif
@@ -46,6 +46,7 @@ private:
   double  fFitXmin;        ///< Minimum of the fitting range
   double  fFitXmax;        ///< Maximum of the fitting range
   TString fFormula;        ///< Formula of the fitted function
+  TString fStatMessage;    ///< Reason of the failed validity check, empty if fit is valid
   TString fName;           ///< Name of the SFFitResults object
   TF1     *fFunction;      ///< Fitted function
   std::vector <double> fParameters; ///< Vector containing all parameters
@@ -117,12 +118,15 @@ public:
   double          GetNDF(void)         { return fNDF; };
   ///Returns formula of the fitted function.
   TString         GetFormula(void)     { return fFormula; };
+  ///Returns reason why the fit was found invalid in SetFromFunction(),
+  ///empty string if the fit passed validity checks.
+  TString         GetStatMessage(void) { return fStatMessage; };
   ///Returns name of the SFFitResults class object.
   TString         GetName(void)        { return fName; };
   ///Returns pointer to the fitted function.
   TF1*            GetFunction(void)    { return fFunction; };
   
-  ClassDef(SFFitResults,1)
+  ClassDef(SFFitResults,2)
 };
 
 #endif
@@ -0,0 +1,70 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *           SFHistPyramid.hh            *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#ifndef __SFHistPyramid_H_
+#define __SFHistPyramid_H_ 1
+#include "TObject.h"
+#include "TH1D.h"
+#include "TList.h"
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+/// Multi-resolution view of the 1D histogram. The histogram is filled
+/// once with the finest binning, coarser levels (bins merged by 2, 4 and 8)
+/// are derived from the cumulative sums of the fine bins, so switching
+/// the resolution never refills or copies the data. Bin contents, errors
+/// and integrals of any level are read directly from the cumulative sums
+/// (see GetBinContent(), GetIntegral()). Histograms of the coarser levels,
+/// e.g. for fitting, are built on request and kept (see GetLevel()). They
+/// are equivalent to TH1::Rebin(): leftover fine bins go to the overflow
+/// and statistics (mean, RMS) are taken from the fine histogram.
+/// The pyramid is attached to the list of functions of the fine histogram,
+/// which owns it (see GetPyramid()).
+
+class SFHistPyramid : public TObject{
+
+private:
+  TH1D                 *fFine;      //! Fine histogram, not owned
+  int                   fNbins;     //! Number of fine bins when the sums were calculated
+  std::vector <double>  fSumW;      //! Cumulative contents of the fine bins
+  std::vector <double>  fSumW2;     //! Cumulative squared errors of the fine bins
+  std::vector <TH1D*>   fLevels;    //! Histograms of the coarser levels, owned
+
+  static const int kMaxLevel = 3;   ///< Coarsest level, i.e. bins merged by 2^3
+
+  bool Check(int level, TString function);
+  void Build(void);
+  void DeleteLevels(void);
+
+public:
+  SFHistPyramid();
+  SFHistPyramid(TH1D *fine);
+  ~SFHistPyramid();
+
+  static SFHistPyramid* GetPyramid(TH1D *hist);
+
+  void   Update(void);
+  int    GetNbins(int level);
+  double GetBinContent(int level, int bin);
+  double GetBinError(int level, int bin);
+  double GetIntegral(int level, int binLow, int binHigh);
+  TH1D*  GetLevel(int level);
+  void   Print(void);
+
+  /// Returns fine histogram.
+  TH1D* GetFine(void){ return fFine; };
+  /// Returns coarsest available level.
+  static int GetMaxLevel(void){ return kMaxLevel; };
+
+  ClassDef(SFHistPyramid,1)
+};
+
+#endif
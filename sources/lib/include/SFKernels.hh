@@ -0,0 +1,220 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *             SFKernels.hh              *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#ifndef __SFKernels_H_
+#define __SFKernels_H_ 1
+#include "TH1.h"
+#include "TH2D.h"
+#include "DDSignal.hh"
+#include "SFDrawCommands.hh"
+#include <vector>
+#include <cmath>
+
+/// Quantities of DDSignal stored in the columns of SFEventBlock.
+enum class SFColumn{
+     PE,           ///< calibrated charge
+     Charge,       ///< uncalibrated charge
+     Amplitude,    ///< amplitude
+     T0,           ///< T0
+     TOT,          ///< time over threshold
+     kNcolumns     ///< number of columns
+};
+
+/// Block of consecutive events stored column-wise, i.e. one contiguous
+/// array per quantity and channel. Selection kernels (see SFKernel)
+/// operate on whole blocks, thus their loops can be vectorized
+/// by the compiler.
+struct SFEventBlock{
+
+  static const int kCapacity = 1024;     ///< Maximal number of events in the block
+
+  int fNchannels = 0;                    ///< Number of channels, including reference channel
+  int fSize      = 0;                    ///< Number of events currently stored
+  std::vector <double> fData;            ///< Columns: [quantity][channel][event]
+
+  /// Allocates columns for the given number of channels.
+  void Init(int nchannels){
+    fNchannels = nchannels;
+    fSize = 0;
+    fData.assign((int)SFColumn::kNcolumns*nchannels*kCapacity, 0.);
+  };
+  /// Returns column of the given quantity and channel.
+  double* Column(SFColumn col, int ch){
+    return fData.data() + ((int)col*fNchannels + ch)*kCapacity;
+  };
+  /// Returns column of the given quantity and channel.
+  const double* Column(SFColumn col, int ch) const {
+    return fData.data() + ((int)col*fNchannels + ch)*kCapacity;
+  };
+  /// Stores signal of the given channel as event i of the block.
+  void Set(int i, int ch, DDSignal *sig){
+    Column(SFColumn::PE, ch)[i]        = sig->GetPE();
+    Column(SFColumn::Charge, ch)[i]    = sig->GetCharge();
+    Column(SFColumn::Amplitude, ch)[i] = sig->GetAmplitude();
+    Column(SFColumn::T0, ch)[i]        = sig->GetT0();
+    Column(SFColumn::TOT, ch)[i]       = sig->GetTOT();
+  };
+};
+
+/// Operations with the semantics of TTreeFormula, so that kernels and
+/// the derived tree give the same values as TTree-style expressions also
+/// outside of the physical range, e.g. for events with PE<=0: sqrt() is
+/// taken of the absolute value, log() of non-positive value is 0 and 
+/// division by 0 gives 0.
+namespace SFFormula{
+  /// Square root of the absolute value, like sqrt() in TTreeFormula.
+  inline double Sqrt(double v){ return sqrt(fabs(v)); };
+  /// Natural logarithm, 0 for non-positive values, like log() in TTreeFormula.
+  inline double Log(double v){ return v>0 ? log(v) : 0; };
+  /// Division, 0 if divisor is 0, like a/b in TTreeFormula.
+  inline double Divide(double a, double b){ return b==0 ? 0 : a/b; };
+};
+
+/// Compile-time kernels of the selections defined in SFDrawCommands.
+/// Every selection type has its own specialization, which computes the
+/// selected quantity for the whole SFEventBlock. Formulas are the same
+/// as in TTree-style expressions of SFDrawCommands::GetDescriptor(),
+/// evaluated with the same semantics (see SFFormula).
+/// For 2D selections x and y follow the TTree convention, i.e. expression
+/// "y:x". kDim is the dimension of the histogram filled with the kernel.
+template <SFSelectionType T> struct SFKernel;
+
+/// Kernel of the single-channel selection taking one column as it is.
+template <SFColumn C> struct SFColumnKernel{
+  static const int kDim = 1;
+  static void Compute(const SFSelection &desc, const SFEventBlock &block, double *x, double *y){
+    const double *v = block.Column(C, desc.fChannels[0]);
+    for(int i=0; i<block.fSize; i++) x[i] = v[i];
+  };
+};
+
+/// Kernel of the 2D selection taking two columns as they are.
+template <SFColumn CX, SFColumn CY, int IX, int IY> struct SFCorrKernel{
+  static const int kDim = 2;
+  static void Compute(const SFSelection &desc, const SFEventBlock &block, double *x, double *y){
+    const double *vx = block.Column(CX, desc.fChannels[IX]);
+    const double *vy = block.Column(CY, desc.fChannels[IY]);
+    for(int i=0; i<block.fSize; i++){ x[i] = vx[i]; y[i] = vy[i]; }
+  };
+};
+
+template <> struct SFKernel<SFSelectionType::PE>        : SFColumnKernel<SFColumn::PE> {};
+template <> struct SFKernel<SFSelectionType::Charge>    : SFColumnKernel<SFColumn::Charge> {};
+template <> struct SFKernel<SFSelectionType::Amplitude> : SFColumnKernel<SFColumn::Amplitude> {};
+template <> struct SFKernel<SFSelectionType::T0>        : SFColumnKernel<SFColumn::T0> {};
+template <> struct SFKernel<SFSelectionType::TOT>       : SFColumnKernel<SFColumn::TOT> {};
+
+template <> struct SFKernel<SFSelectionType::PECorrelation>
+  : SFCorrKernel<SFColumn::PE, SFColumn::PE, 1, 0> {};
+template <> struct SFKernel<SFSelectionType::AmplitudeCorrelation>
+  : SFCorrKernel<SFColumn::Amplitude, SFColumn::Amplitude, 1, 0> {};
+template <> struct SFKernel<SFSelectionType::T0Correlation>
+  : SFCorrKernel<SFColumn::T0, SFColumn::T0, 1, 0> {};
+template <> struct SFKernel<SFSelectionType::AmpPECorrelation>
+  : SFCorrKernel<SFColumn::PE, SFColumn::Amplitude, 0, 0> {};
+template <> struct SFKernel<SFSelectionType::PEvsPEch2Correlation>
+  : SFCorrKernel<SFColumn::PE, SFColumn::PE, 1, 0> {};
+
+template <> struct SFKernel<SFSelectionType::LogSqrtPERatio>{
+  static const int kDim = 1;
+  static void Compute(const SFSelection &desc, const SFEventBlock &block, double *x, double *y){
+    const double *l = block.Column(SFColumn::PE, desc.fChannels[0]);
+    const double *r = block.Column(SFColumn::PE, desc.fChannels[1]);
+    for(int i=0; i<block.fSize; i++) x[i] = SFFormula::Log(SFFormula::Sqrt(SFFormula::Divide(r[i], l[i])));
+  };
+};
+
+template <> struct SFKernel<SFSelectionType::T0Difference>{
+  static const int kDim = 1;
+  static void Compute(const SFSelection &desc, const SFEventBlock &block, double *x, double *y){
+    const double *l = block.Column(SFColumn::T0, desc.fChannels[0]);
+    const double *r = block.Column(SFColumn::T0, desc.fChannels[1]);
+    for(int i=0; i<block.fSize; i++) x[i] = l[i] - r[i];
+  };
+};
+
+template <> struct SFKernel<SFSelectionType::PEAverage>{
+  static const int kDim = 1;
+  static void Compute(const SFSelection &desc, const SFEventBlock &block, double *x, double *y){
+    const double *l = block.Column(SFColumn::PE, desc.fChannels[0]);
+    const double *r = block.Column(SFColumn::PE, desc.fChannels[1]);
+    for(int i=0; i<block.fSize; i++) x[i] = SFFormula::Sqrt(l[i]*r[i]);
+  };
+};
+
+template <> struct SFKernel<SFSelectionType::AmplitudeAverage>{
+  static const int kDim = 1;
+  static void Compute(const SFSelection &desc, const SFEventBlock &block, double *x, double *y){
+    const double *l = block.Column(SFColumn::Amplitude, desc.fChannels[0]);
+    const double *r = block.Column(SFColumn::Amplitude, desc.fChannels[1]);
+    for(int i=0; i<block.fSize; i++) x[i] = SFFormula::Sqrt(l[i]*r[i]);
+  };
+};
+
+template <> struct SFKernel<SFSelectionType::PEAttCorrected>{
+  static const int kDim = 1;
+  static void Compute(const SFSelection &desc, const SFEventBlock &block, double *x, double *y){
+    const double *v = block.Column(SFColumn::PE, desc.fChannels[0]);
+    const double corr = exp(desc.fCustomNum[0]/desc.fCustomNum[1]);
+    for(int i=0; i<block.fSize; i++) x[i] = v[i]/corr;
+  };
+};
+
+/// Custom numbers are bound by SFData from the attenuation length of the
+/// series, which is required (see SFData::CheckAttenuation()). Without
+/// them NaN is returned.
+template <> struct SFKernel<SFSelectionType::PEAttCorrectedSum>{
+  static const int kDim = 1;
+  static void Compute(const SFSelection &desc, const SFEventBlock &block, double *x, double *y){
+    const double *l = block.Column(SFColumn::PE, desc.fChannels[0]);
+    const double *r = block.Column(SFColumn::PE, desc.fChannels[1]);
+    const std::vector <double> &num = desc.fCustomNum;
+    const double corrL = num.size()<4 ? NAN : exp(num[0]/num[1]);
+    const double corrR = num.size()<4 ? NAN : exp(num[2]/num[3]);
+    for(int i=0; i<block.fSize; i++) x[i] = l[i]/corrL + r[i]/corrR;
+  };
+};
+
+namespace SFKernels{
+
+  /// Fills histogram of the given dimension with values computed for
+  /// the block. Only events with nonzero pass flag are filled.
+  template <int Dim> void FillBlock(TH1 *hist, const double *x, const double *y,
+                                    const char *pass, int n);
+
+  template <> inline void FillBlock<1>(TH1 *hist, const double *x, const double *y,
+                                       const char *pass, int n){
+    for(int i=0; i<n; i++)
+      if(pass[i]) hist->Fill(x[i]);
+  };
+
+  template <> inline void FillBlock<2>(TH1 *hist, const double *x, const double *y,
+                                       const char *pass, int n){
+    TH2D *h2 = (TH2D*)hist;
+    for(int i=0; i<n; i++)
+      if(pass[i]) h2->Fill(x[i], y[i]);
+  };
+
+  /// Computes selection with its kernel and fills the histogram. If 
+  /// nullptr is passed as histogram only x and y buffers are filled.
+  template <SFSelectionType T> void Run(const SFSelection &desc, const SFEventBlock &block,
+                                        double *x, double *y, const char *pass, TH1 *hist){
+    SFKernel<T>::Compute(desc, block, x, y);
+    if(hist!=nullptr)
+      FillBlock<SFKernel<T>::kDim>(hist, x, y, pass, block.fSize);
+  };
+
+  bool Process(const SFSelection &desc, const SFEventBlock &block,
+               double *x, double *y, const char *pass, TH1 *hist);
+  int  GetDimension(SFSelectionType selection);
+
+};
+
+#endif
@@ -25,14 +25,14 @@
 
 struct LightResults{
     
-    double fRes    = -1;
+    double fRes    = -1;             ///< Summed result of the first fiber (channels 0 and 1)
     double fResErr = -1;
     
-    double fResCh0    = -1;
-    double fResCh0Err = -1;
+    std::vector <double> fResCh;     ///< Results of single channels, indexed with channel number
+    std::vector <double> fResChErr;
     
-    double fResCh1    = -1;
-    double fResCh1Err = -1;
+    std::vector <double> fResFib;    ///< Summed results of fibers, i.e. channels 2k and 2k+1, indexed with k
+    std::vector <double> fResFibErr;
 };
 
 class SFLightOutput : public TObject{
@@ -42,20 +42,20 @@ private:
     double  fPDE;
     double  fCrossTalk;
     
-    TGraphErrors *fLightOutGraph;
-    TGraphErrors *fLightOutCh0Graph;
-    TGraphErrors *fLightOutCh1Graph;
+    int     fNchannels;
     
-    TGraphErrors *fLightColGraph;
-    TGraphErrors *fLightColCh0Graph;
-    TGraphErrors *fLightColCh1Graph;
+    int     fNfibers;
+    
+    std::vector <TGraphErrors*> fLightOutGraph;
+    std::vector <TGraphErrors*> fLightOutChGraph;
+    
+    std::vector <TGraphErrors*> fLightColGraph;
+    std::vector <TGraphErrors*> fLightColChGraph;
     
     TCanvas       *fInputData;
     
-    std::vector <TH1D*> fSpectraCh0;
-    std::vector <TH1D*> fSpectraCh1;
-    std::vector <SFPeakFinder*> fPFCh0;
-    std::vector <SFPeakFinder*> fPFCh1;
+    std::vector <std::vector <TH1D*>> fSpectraCh;
+    std::vector <std::vector <SFPeakFinder*>> fPFCh;
     
     SFData        *fData;
     SFAttenuation *fAtt;
@@ -63,6 +63,9 @@ private:
     LightResults fLightOutResults;
     LightResults fLightColResults;
     
+    TGraphErrors* SumChannels(std::vector <TGraphErrors*> &graphsCh, int fiber, 
+                              TString gname, TString ytitle, double &av, double &avErr);
+    
 public:
   SFLightOutput(int seriesNo);
   ~SFLightOutput();
@@ -73,6 +76,8 @@ public:
   bool CalculateLightCol(void);
   bool CalculateLightCol(int ch);
   
+  /// Returns number of fibers, i.e. pairs of channels (2k, 2k+1).
+  int    GetNfibers(void){ return fNfibers; };
   double GetCrossTalk(void);
   double GetPDE(void);
   
@@ -82,8 +87,10 @@ public:
   
   TGraphErrors*        GetLightOutputGraph(void);
   TGraphErrors*        GetLightOutputGraph(int ch);
+  TGraphErrors*        GetLightOutputFiberGraph(int fiber);
   TGraphErrors*        GetLightColGraph(void);
   TGraphErrors*        GetLightColGraph(int ch);
+  TGraphErrors*        GetLightColFiberGraph(int fiber);
   
   std::vector <TH1D*>  GetSpectra(int ch);
   
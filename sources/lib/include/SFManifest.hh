@@ -0,0 +1,96 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *            SFManifest.hh              *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#ifndef __SFManifest_H_
+#define __SFManifest_H_ 1
+#include "TObject.h"
+#include "TString.h"
+#include "TFile.h"
+#include "TSystem.h"
+#include "TMD5.h"
+#include "TH1.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+
+/// Single entry of the manifest. Describes one per-measurement product
+/// (e.g. spectrum or averaged signal) and the inputs it was built from.
+struct ManifestEntry{
+
+  TString fFingerprint = "";   ///< MD5 checksum of the input files stats and parameters
+  TString fInputs      = "";   ///< List of input files, separated with ';'
+};
+
+/// Class keeping track of the per-measurement products of the analysis.
+/// For every product (spectrum, averaged signal, etc.) the fingerprint of
+/// the input files (size and modification time) and the parameters used
+/// to build it (selection, cut) is recorded in a text manifest. Products
+/// themselves are stored in a ROOT file. If a product is requested again
+/// and its fingerprint has not changed, the stored copy is returned instead
+/// of processing the measurement data again. In this way, if only one
+/// measurement of the series is reprocessed, only products of this
+/// measurement are recalculated. New entries are appended to the manifest,
+/// superseded lines are removed when the manifest is loaded. Fields of the
+/// manifest are escaped, so that keys containing tabulators or new lines
+/// (e.g. in cuts) don't break its syntax. The products file is opened once
+/// per manifest and kept open. Manifest files are kept in the cache 
+/// directory, separately for each experimental series:
+/// - manifest_S<series>.txt - list of products with fingerprints and inputs
+/// - products_S<series>.root - stored products
+
+class SFManifest : public TObject{
+
+private:
+  TString  fDirectory;   ///< Cache directory
+  int      fSeriesNo;    ///< Experimental series number
+  int      fNreused;     ///< Number of products taken from the cache
+  int      fNupdated;    ///< Number of products (re)calculated and stored
+  int      fNlines;      ///< Number of entry lines in the manifest file
+  TFile   *fFile;        //! Products file, opened on first access
+  std::map <TString, ManifestEntry> fEntries;  ///< Products recorded in the manifest
+
+  /// Manifests opened in this session, indexed with cache directory and series number
+  static std::map <std::pair <TString, int>, SFManifest*> fManifests;
+
+  TString GetManifestName(void);
+  TString GetProductsName(void);
+  TString GetObjectName(TString key);
+  TFile*  GetFile(bool create);
+  static TString Escape(TString field);
+  static TString Unescape(std::string field);
+  bool    Load(void);
+  bool    Save(void);
+  bool    Append(TString key);
+
+public:
+  SFManifest(TString directory, int seriesNo);
+  ~SFManifest();
+
+  static SFManifest* GetManifest(TString directory, int seriesNo);
+  static TString     Fingerprint(std::vector <TString> inputs, TString params);
+
+  bool     IsCurrent(TString key, TString fingerprint);
+  TObject* GetProduct(TString key);
+  bool     StoreProduct(TString key, TString fingerprint,
+                        std::vector <TString> inputs, TObject *obj);
+  void     Print(void);
+
+  /// Returns number of products taken from the cache in this session.
+  int GetNreused(void){ return fNreused; };
+  /// Returns number of products calculated and stored in this session.
+  int GetNupdated(void){ return fNupdated; };
+
+  ClassDef(SFManifest,1)
+};
+
+#endif
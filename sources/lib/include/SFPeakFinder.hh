@@ -18,9 +18,16 @@
 #include "TFitResult.h"
 #include "SFData.hh"
 #include "SFTools.hh"
+#include "SFFitParamStore.hh"
+#include "SFPeakModel.hh"
 #include "FitterFactory.h"
 #include <vector>
+#include <map>
+#include <algorithm>
+#include <cmath>
+#include <mutex>
 #include <fstream>
+#include <sstream>
 #include <iostream>
 
 /// Structure containing parameters of 511 keV peak, determined from 
@@ -61,6 +68,16 @@ private:
   bool       fTests;      ///< Flag for testing mode
   PeakParams fParams;     ///< Structure containing parameters of 511 keV peak as determined by the fit
   
+  void       GetMeasurement(int &seriesNo, int &ID, double &position, TString &path);
+  std::map <TString, TString> SeedParams(int seriesNo, double position, int ID);
+  bool       SetFitResults(HistFitParams &histFP);
+  
+  static bool FitBatch(std::vector <SFPeakFinder*> finders, std::vector <double> positions);
+  static bool FitSpectrum(TH1D *spectrum, HistFitParams &histFP);
+  static void PredictParams(TF1 *fun, TF1 *near, TF1 *far, double x, double xNear, double xFar);
+  static void FitWarmStart(std::vector <SFPeakFinder*> &finders, std::vector <double> &positions,
+                           std::vector <HistFitParams> &histFP, bool parallel);
+  
 public:
   SFPeakFinder();
   SFPeakFinder(TH1D *spectrum, bool verbose, bool tests);
@@ -71,6 +88,10 @@ public:
   TString    Init(void);
   bool       FindPeakRange(double &min, double &max);
   bool       FindPeakFit(void);
+  bool       FindPeakEstimate(void);
+  static PeakParams LocatePeak(TH1D *spectrum);
+  static bool FindPeakFits(std::vector <SFPeakFinder*> finders);
+  static bool FindPeakFitsSeries(std::vector <SFPeakFinder*> finders, std::vector <double> positions);
   bool       SubtractBackground(void);
   void       SetSpectrum(TH1D *spectrum);
   void       Print(void);
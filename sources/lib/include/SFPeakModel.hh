@@ -0,0 +1,64 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *            SFPeakModel.hh             *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#ifndef __SFPeakModel_H_
+#define __SFPeakModel_H_ 1
+#include "TH1D.h"
+#include "TF1.h"
+#include "TList.h"
+#include "Math/IParamFunction.h"
+#include "Fit/Fitter.h"
+#include "Fit/BinData.h"
+#include "Fit/FitResult.h"
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+/// Compiled model of the 511 keV peak fitted by SFPeakFinder, i.e. of the
+/// function gaus(0) pol0(3)+[4]*TMath::Exp((x-[5])*[6]):
+/// \f[
+/// f(Q) = p_0 \cdot e^{-\frac{1}{2} \left(\frac{Q-p_1}{p_2}\right)^2} + p_3 + p_4 \cdot e^{(Q-p_5) \cdot p_6}
+/// \f]
+/// with analytic derivatives over the parameters. Fit() performs chi2 fit
+/// with ROOT::Fit::Fitter and Minuit2/Fumili, which uses the derivatives
+/// both for the gradient and for the approximation of the Hessian matrix,
+/// so no numerical differentiation of the model is needed.
+
+class SFPeakModel : public ROOT::Math::IParametricGradFunctionOneDim{
+
+private:
+  std::vector <double> fParams;   ///< Parameters of the model
+
+  double DoEvalPar(double x, const double *p) const;
+  double DoParameterDerivative(double x, const double *p, unsigned int ipar) const;
+
+public:
+  static const int kNpar = 7;     ///< Number of parameters
+
+  SFPeakModel();
+  ~SFPeakModel();
+
+  static double Evaluate(double x, const double *p);
+  static void   Gradient(double x, const double *p, double *grad);
+  static bool   Matches(TF1 *fun);
+  static int    Fit(TH1D *hist, TF1 *fun);
+
+  ROOT::Math::IBaseFunctionOneDim* Clone(void) const;
+  void ParameterGradient(double x, const double *p, double *grad) const;
+
+  /// Returns parameters of the model.
+  const double* Parameters(void) const { return fParams.data(); };
+  /// Sets parameters of the model.
+  void SetParameters(const double *p){ fParams.assign(p, p+kNpar); };
+  /// Returns number of parameters.
+  unsigned int NPar(void) const { return kNpar; };
+};
+
+#endif
@@ -0,0 +1,70 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *            SFPrefixSum.hh             *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#ifndef __SFPrefixSum_H_
+#define __SFPrefixSum_H_ 1
+#include "TObject.h"
+#include "TH1D.h"
+#include "TList.h"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+/// Cumulative-count table of the 1D histogram for fast window queries.
+/// Cumulative sums of the bin contents give integral and mean in any
+/// range of bins in O(1) and quantiles in O(log n). Sparse tables of
+/// maxima and minima give extreme values in any range of bins in O(1),
+/// thus threshold crossings, e.g. half maximum of the peak, are found
+/// with binary search in O(log n) instead of the scan over bins (see
+/// FindCrossing()). Underflow and overflow bins are not included.
+/// The table is attached to the list of functions of the histogram,
+/// which owns it (see GetPrefixSum()). It is rebuilt automatically if
+/// the number of bins or entries of the histogram has changed.
+
+class SFPrefixSum : public TObject{
+
+private:
+  TH1D                  *fHist;      //! Histogram, not owned
+  int                    fNbins;     //! Number of bins when the table was built
+  double                 fEntries;   //! Number of entries when the table was built
+  std::vector <double>   fSum;       //! Cumulative bin contents
+  std::vector <double>   fSumX;      //! Cumulative bin contents weighted with bin centers
+  std::vector <std::vector <double>> fMax;  //! Sparse table of maxima, level k covers 2^k bins
+  std::vector <std::vector <double>> fMin;  //! Sparse table of minima, level k covers 2^k bins
+
+  void   Build(void);
+  bool   Check(TString function);
+  double GetExtreme(int binLow, int binHigh, bool isMax);
+
+public:
+  SFPrefixSum();
+  SFPrefixSum(TH1D *hist);
+  ~SFPrefixSum();
+
+  static SFPrefixSum* GetPrefixSum(TH1D *hist);
+
+  void   Update(void);
+  double GetIntegral(int binLow, int binHigh);
+  double GetIntegral(double xmin, double xmax);
+  double GetMean(int binLow, int binHigh);
+  double GetQuantile(double q);
+  double GetMaximum(int binLow, int binHigh);
+  double GetMinimum(int binLow, int binHigh);
+  int    FindCrossing(double level, int from, int to, bool above);
+  void   Print(void);
+
+  /// Returns histogram.
+  TH1D* GetHistogram(void){ return fHist; };
+
+  ClassDef(SFPrefixSum,1)
+};
+
+#endif
@@ -0,0 +1,55 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *          SFQuantileSketch.hh          *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#ifndef __SFQuantileSketch_H_
+#define __SFQuantileSketch_H_ 1
+#include "TObject.h"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+/// Streaming quantile sketch (KLL type). Values are kept in a hierarchy
+/// of compactors: compactor h holds values representing 2^h entries each.
+/// When the sketch exceeds its capacity the lowest full compactor is
+/// sorted and every second value is promoted to the next level. Memory
+/// usage is O(k log(n/k)) and the rank error is of the order of 1/k.
+/// Sketches are mergeable, thus they can be filled in parallel and
+/// combined. Compaction offset alternates deterministically, so results
+/// don't depend on random numbers. Non-finite values are ignored.
+
+class SFQuantileSketch : public TObject{
+
+private:
+  int      fK;            ///< Accuracy parameter, capacity of the top compactor
+  Long64_t fCount;        ///< Number of values added to the sketch
+  bool     fOffset;       ///< Offset of the next compaction
+  std::vector <std::vector <double>> fCompactors;  ///< Compactors, level h has weight 2^h
+
+  int  GetCapacity(int level);
+  int  GetSize(void);
+  void Compress(void);
+
+public:
+  SFQuantileSketch(int k = 200);
+  ~SFQuantileSketch();
+
+  void   Fill(double value);
+  void   Merge(const SFQuantileSketch &sketch);
+  double GetQuantile(double q);
+  void   Print(void);
+
+  /// Returns number of values added to the sketch.
+  Long64_t GetCount(void){ return fCount; };
+
+  ClassDef(SFQuantileSketch,1)
+};
+
+#endif
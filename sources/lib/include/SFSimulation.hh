@@ -0,0 +1,122 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *           SFSimulation.hh             *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#ifndef __SFSimulation_H_
+#define __SFSimulation_H_ 1
+#include "TObject.h"
+#include "TString.h"
+#include "TFile.h"
+#include "TTree.h"
+#include "TSystem.h"
+#include "TRandom3.h"
+#include "TMD5.h"
+#include "TMath.h"
+#include "DDSignal.hh"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+/// Structure containing parameters of the fiber model used in the simulation.
+struct SimParams{
+
+  double fAttLength    = 300;     ///< Attenuation length [mm]
+  double fLightYield   = 20000;   ///< Light yield [photons/MeV]
+  double fTrapping     = 0.05;    ///< Trapping efficiency of the fiber (for each end)
+  double fPDE          = 0.4;     ///< SiPM photon detection efficiency
+  double fCrosstalk    = 0.1;     ///< SiPM crosstalk probability
+  double fDecayFast    = 60;      ///< Fast decay constant [ns]
+  double fDecaySlow    = 500;     ///< Slow decay constant [ns]
+  double fFastFraction = 0.8;     ///< Fraction of light emitted with the fast component
+  double fRiseTime     = 1;       ///< Scintillation rise time [ns]
+  double fPhotoFraction = 0.3;    ///< Fraction of events in the 511 keV photopeak
+  double fGain         = 200;     ///< Charge per photoelectron [a.u.]
+  double fGainSpread   = 0.1;     ///< Relative spread of SiPM gain
+  double fSPEAmplitude = 1.5;     ///< Amplitude of single photoelectron signal [mV]
+  double fSiPMRise     = 2;       ///< Rise time of single photoelectron signal [ns]
+  double fSiPMFall     = 40;      ///< Fall time of single photoelectron signal [ns]
+  double fNoise        = 0.5;     ///< Electronic noise [mV]
+  double fBaseline     = 0;       ///< Base line level [mV]
+  double fThreshold    = 10;      ///< Threshold for T0 and TOT [mV]
+  double fTrigger      = 60;      ///< Trigger time [ns]
+  double fTimeJitter   = 0.3;     ///< Time jitter of the readout [ns]
+  double fLightSpeed   = 166;     ///< Effective speed of light in the fiber [mm/ns]
+  double fRefPE        = 1000;    ///< Position of 511 keV peak in the reference detector [PE]
+  double fRefSigma     = 50;      ///< Width of 511 keV peak in the reference detector [PE]
+};
+
+/// Class generating synthetic measurements for the test bench of type
+/// "Simulation". Events are generated on the fly from parametric model
+/// of the fiber, including attenuation of light, light yield, SiPM photon
+/// detection efficiency and crosstalk, and scintillation decay constants.
+/// Each event is generated with its own random number generator seeded
+/// with a combination of the global seed, measurement ID and event number,
+/// thus events can be generated lazily, in any order, and results are
+/// reproducible regardless of the number of threads. Spectra filled with
+/// the compiled kernels read events directly from GetEvent(). Where the
+/// whole tree is needed the measurement is stored in the same format as
+/// experimental data, i.e. tree "tree_ft" with branches ch_0, ch_1 (fiber 
+/// ends) and ch_2 (reference detector) containing DDSignal objects (see
+/// GetResultsFile()). Waveforms are generated on demand for the selected
+/// events.
+
+class SFSimulation : public TObject{
+
+private:
+  SimParams fParams;       ///< Parameters of the fiber model
+  TString   fFiber;        ///< Fiber type
+  double    fFiberLength;  ///< Fiber length [mm]
+  int       fSeriesNo;     ///< Series number
+  int       fNevents;      ///< Number of events per measurement
+  unsigned  fSeed;         ///< Global seed
+  TString   fDirectory;    ///< Directory where generated measurements are stored
+
+  static int      fDefaultNevents;  ///< Number of events per measurement for new objects
+  static unsigned fDefaultSeed;     ///< Global seed for new objects
+
+  static unsigned Hash(unsigned seed, int a, int b, int c);
+  TString         GetFingerprint(int ID, double position);
+  void            GenerateEvent(TRandom3 &rand, double position, float *values);
+  void            GetValues(int ID, double position, Long64_t entry, float *values);
+  void            SetValues(TRandom3 &rand, double npe, double t0, float *values);
+
+public:
+  SFSimulation();
+  SFSimulation(TString fiber, double fiberLength, int seriesNo);
+  ~SFSimulation();
+
+  TString               GetResultsFile(int ID, double position);
+  TString               GetFileName(int ID, double position);
+  TString               GetSourceName(int ID, double position);
+  void                  GetEvent(int ID, double position, Long64_t entry, DDSignal **sig);
+  std::vector <double>  GetWaveform(int ID, int event, int ch, double pe,
+                                    double t0, bool bl);
+  void                  Print(void);
+  static void           SetDefaults(int nevents, unsigned seed);
+  static int            GetNchannels(void);
+
+  /// Sets parameters of the fiber model.
+  void      SetParams(SimParams params){ fParams = params; };
+  /// Sets number of events generated for each measurement.
+  void      SetNevents(int nevents){ fNevents = nevents; };
+  /// Sets global seed.
+  void      SetSeed(unsigned seed){ fSeed = seed; };
+  /// Sets directory where generated measurements are stored.
+  void      SetDirectory(TString directory){ fDirectory = directory; };
+  /// Returns parameters of the fiber model.
+  SimParams GetParams(void){ return fParams; };
+  /// Returns number of events generated for each measurement.
+  int       GetNevents(void){ return fNevents; };
+  /// Returns global seed.
+  unsigned  GetSeed(void){ return fSeed; };
+
+  ClassDef(SFSimulation,2)
+};
+
+#endif
@@ -0,0 +1,72 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *           SFSpectrumInfo.hh           *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#ifndef __SFSpectrumInfo_H_
+#define __SFSpectrumInfo_H_ 1
+#include "TObject.h"
+#include "TString.h"
+#include "TH1.h"
+#include "TList.h"
+#include <iostream>
+#include <vector>
+
+/// Metadata record of the histogram returned by SFData: series number,
+/// measurement ID, channels, source position, selection, cut, data path
+/// and collimator of the series. The record is attached to the list of
+/// functions of the histogram, so it travels with the histogram (also
+/// through the incremental mode cache) and can be read with GetInfo()
+/// instead of parsing the histogram name or querying the data base.
+
+class SFSpectrumInfo : public TObject{
+
+private:
+  int                fSeriesNo;    ///< Series number
+  int                fMeasureID;   ///< Measurement ID
+  std::vector <int>  fChannels;    ///< Channels used by the selection
+  double             fPosition;    ///< Source position [mm]
+  TString            fSelection;   ///< Selection name (see SFDrawCommands::GetSelectionName())
+  TString            fCut;         ///< Cut
+  TString            fDataPath;    ///< Directory containing data of the measurement
+  TString            fCollimator;  ///< Collimator type of the series
+
+public:
+  SFSpectrumInfo();
+  SFSpectrumInfo(int seriesNo, int ID, std::vector <int> channels, double position,
+                 TString selection, TString cut, TString dataPath, TString collimator);
+  ~SFSpectrumInfo();
+
+  static SFSpectrumInfo* GetInfo(TH1 *hist);
+
+  void Attach(TH1 *hist);
+  void Print(void);
+
+  /// Returns series number.
+  int     GetSeriesNo(void) const { return fSeriesNo; };
+  /// Returns measurement ID.
+  int     GetMeasurementID(void) const { return fMeasureID; };
+  /// Returns channels used by the selection.
+  std::vector <int> GetChannels(void) const { return fChannels; };
+  /// Returns channel number for single-channel selections, -1 otherwise.
+  int     GetChannel(void) const { return fChannels.size()==1 ? fChannels[0] : -1; };
+  /// Returns source position [mm].
+  double  GetPosition(void) const { return fPosition; };
+  /// Returns selection name.
+  TString GetSelection(void) const { return fSelection; };
+  /// Returns cut.
+  TString GetCut(void) const { return fCut; };
+  /// Returns directory containing data of the measurement.
+  TString GetDataPath(void) const { return fDataPath; };
+  /// Returns collimator type of the series.
+  TString GetCollimator(void) const { return fCollimator; };
+
+  ClassDef(SFSpectrumInfo,1)
+};
+
+#endif
@@ -0,0 +1,94 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *          SFSpectrumMatrix.hh          *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#ifndef __SFSpectrumMatrix_H_
+#define __SFSpectrumMatrix_H_ 1
+#include "TObject.h"
+#include "TString.h"
+#include "TH1D.h"
+#include "TH2D.h"
+#include "TF1.h"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+/// Spectra of the whole series (positions x bins) stored in one contiguous
+/// buffer with common binning. Each row holds bins 0 to nbins+1 (underflow
+/// and overflow included, like TH1) and is padded to a multiple of 8 values.
+/// The buffer is a plain std::vector, so only the usual alignment of double
+/// is guaranteed, not alignment of rows to cache lines. Squared bin errors
+/// are stored in a second buffer of the same layout. Operations on all
+/// positions (normalization, background subtraction, maxima for peak
+/// seeding, drawing) run over the rows of the buffer. Spectra with 
+/// different binning, e.g. with adaptive binning, are resampled to 
+/// a common axis (see FromSpectra()). TH1D histograms of single positions
+/// are copies of the rows, built on request (see GetView()).
+
+class SFSpectrumMatrix : public TObject{
+
+private:
+  TString               fName;        ///< Name of the matrix, prefix of the views names
+  int                   fNpositions;  ///< Number of positions (rows)
+  int                   fNbins;       ///< Number of bins of each spectrum
+  double                fXmin;        ///< Lower edge of the first bin
+  double                fXmax;        ///< Upper edge of the last bin
+  int                   fStride;      ///< Distance between rows in the buffer
+  std::vector <double>  fPositions;   ///< Source positions [mm]
+  std::vector <TString> fTitles;      ///< Titles of the spectra
+  std::vector <double>  fContents;    ///< Bin contents, row by row
+  std::vector <double>  fErrors2;     ///< Squared bin errors, row by row
+  std::vector <TH1D*>   fViews;       //! Views of single positions, owned
+
+  bool CheckPosition(int pos, TString function) const;
+  void DeleteViews(void);
+
+public:
+  SFSpectrumMatrix();
+  SFSpectrumMatrix(TString name, std::vector <double> positions, int nbins,
+                   double xmin, double xmax);
+  ~SFSpectrumMatrix();
+
+  static SFSpectrumMatrix* FromSpectra(TString name, std::vector <TH1D*> spectra,
+                                       std::vector <double> positions);
+
+  bool   SetRow(int pos, TH1D *spectrum);
+  bool   ResampleRow(int pos, TH1D *spectrum);
+  double GetBinCenter(int bin) const;
+  double GetIntegral(int pos) const;
+  void   Normalize(void);
+  void   Scale(int pos, double factor);
+  bool   Subtract(const SFSpectrumMatrix &background, std::vector <double> factors);
+  bool   Subtract(int pos, TF1 *fun);
+  std::vector <int>    GetMaximumBins(double xmin, double xmax) const;
+  std::vector <double> GetMaxima(double xmin, double xmax) const;
+  TH1D*  GetView(int pos);
+  TH2D*  GetHistogram2D(void) const;
+  void   Print(void);
+
+  /// Returns row of bin contents of the position (bins 0 to nbins+1).
+  double* GetRow(int pos){ return fContents.data() + pos*fStride; };
+  /// Returns row of bin contents of the position (bins 0 to nbins+1).
+  const double* GetRow(int pos) const { return fContents.data() + pos*fStride; };
+  /// Returns number of positions.
+  int    GetNpositions(void) const { return fNpositions; };
+  /// Returns number of bins.
+  int    GetNbins(void) const { return fNbins; };
+  /// Returns lower edge of the first bin.
+  double GetXmin(void) const { return fXmin; };
+  /// Returns upper edge of the last bin.
+  double GetXmax(void) const { return fXmax; };
+  /// Returns source positions [mm].
+  std::vector <double> GetPositions(void) const { return fPositions; };
+
+  ClassDef(SFSpectrumMatrix,1)
+};
+
+#endif
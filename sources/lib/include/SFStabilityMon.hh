@@ -22,27 +22,22 @@
 
 struct StabilityResults{
     
-    double fCh0Mean   = -1;
-    double fCh1Mean   = -1;
-    
-    double fCh0StdDev = -1;
-    double fCh1StdDev = -1;    
+    std::vector <double> fChMean;
+    std::vector <double> fChStdDev;
 };
 
 class SFStabilityMon : public TObject{
     
 private:
     int           fSeriesNo;
+    int           fNchannels;
     SFData       *fData;
-    TGraphErrors *fCh0Graph;
-    TGraphErrors *fCh1Graph;
-    TGraphErrors *fCh0ResGraph;
-    TGraphErrors *fCh1ResGraph;
+    std::vector <TGraphErrors*> fChGraph;
+    std::vector <TGraphErrors*> fChResGraph;
     
     StabilityResults fResults;
     
-    std::vector <TH1D*> fSpecCh0;
-    std::vector <TH1D*> fSpecCh1; 
+    std::vector <std::vector <TH1D*>> fSpecCh;
     
 public:
     SFStabilityMon(int seriesNo);
@@ -14,15 +14,18 @@
 #include "SFData.hh"
 #include "SFFitResults.hh"
 #include "SFTools.hh"
+#include "SFDecayFitter.hh"
 #include "TObject.h"
 #include "TString.h"
 #include "TProfile.h"
 #include "TF1.h"
-#include "Math/MinimizerOptions.h"
+#include "TGraphErrors.h"
+#include "TH2D.h"
 
 #include <string>
 #include <iostream>
 #include <stdlib.h>
+#include <cctype>
 
 /// Class for determination of decay time constants from the averaged signals.
 /// The accessed histograms are averaging of maximum of 50 signals. 
@@ -31,9 +34,11 @@
 /// function can be found in the presenation of KR posted on wiki [LINK](http://bragg.if.uj.edu.pl/gccbwiki/images/5/5e/KR_20180604_TimeConstSummary.pdf)
 /// , on slide 15. Double decay mode is assumed, i.e. we determine fast and slow 
 /// decay time constants. Additionally, only falling slope of the signal is fitted, 
-/// i.e. the rise time is not determined. Fitting results are stored in SFFitResults 
+/// i.e. the rise time is not determined. Fits are performed with SFDecayFitter in
+/// a single combined solve per signal. Fitting results are stored in SFFitResults 
 /// class objects. If function FitAllSignals() is called, average values of time constants 
-/// and intensities for the whole series are calculated.
+/// and intensities for the whole series are calculated. ScanPE() determines dependence
+/// of the decay constants on the signal size, in bins of PE.
 
 
 struct TimeConstResults{
@@ -47,8 +52,7 @@ struct TimeConstResults{
     double fIfastAv      = -1;
     double fIslowAv      = -1;  
     
-    std::vector <SFFitResults*> fResultsCh0;
-    std::vector <SFFitResults*> fResultsCh1;
+    std::vector <std::vector <SFFitResults*>> fResultsCh;  ///< Fit results, indexed with channel number and measurement
 };
 
 class SFTimeConst : public TObject{
@@ -59,10 +63,20 @@ private:
   double  fPE;        ///< Value of signals PE
   bool    fVerb;      ///< Verbose level: false - quiet, true - verbose
   
-  std::vector <TProfile*> fSignalsCh0;   ///< Vector containing all signals from channel 0
-  std::vector <TProfile*> fSignalsCh1;   ///< Vector containing all signals from channel 1 
+  int     fNchannels; ///< Number of readout channels
+  
+  std::vector <std::vector <TProfile*>> fSignalsCh;   ///< Averaged signals, indexed with channel number and measurement
   TimeConstResults        fResults;
   
+  std::vector <double>    fScanEdges;                 ///< Edges of PE bins of the scan
+  std::vector <std::vector <std::vector <SFFitResults*>>> fScanResultsCh;  ///< Fit results of the scan, indexed with channel number, measurement and PE bin
+  
+  int                     GetChannel(TProfile *signal);
+  int                     FitSignal(TProfile *signal, SFFitResults *results, bool doubleDecay,
+                                    TString *summary = nullptr);
+  void                    FitSignals(std::vector <int> channels, bool doubleDecay);
+  bool                    GetScanValue(SFFitResults *results, bool fast, double &tau, double &err);
+  
 public:
   SFTimeConst();
   SFTimeConst(int seriesNo, double PE, bool verb);
@@ -75,6 +89,9 @@ public:
   bool                    FitAllSignals(int ch);
   void                    Print(void);
   std::vector <TProfile*> GetSignals(int ch);
+  bool                    ScanPE(double PEmin, double PEmax, int nbins, int number);
+  TGraphErrors*           GetScanGraph(int ch, bool fast);
+  TH2D*                   GetScanMap(int ch, bool fast);
   TimeConstResults        GetResults(void){ return fResults; };
   
   
@@ -14,6 +14,7 @@
 #include "TGraphErrors.h"
 #include "SFData.hh"
 #include "SFPeakFinder.hh"
+#include "SFHistPyramid.hh"
 #include "SFTools.hh"
 #include <iostream>
 
@@ -46,8 +47,7 @@ private:
   SFData *fData;       ///< Experimental series to be analyzed.
 
   std::vector <TH1D*>  fRatios;
-  std::vector <TH1D*>  fSpecCh0;
-  std::vector <TH1D*>  fSpecCh1;
+  std::vector <std::vector <TH1D*>> fSpecCh;  ///< PE spectra of channels 0 and 1, indexed with channel number
   std::vector <TH1D*>  fT0Diff; 
   std::vector <TH1D*>  fT0DiffECut;
   
@@ -16,7 +16,9 @@
 #include "TSystem.h"
 #include "TF1.h"
 #include "SFData.hh"
+#include "SFPrefixSum.hh"
 #include <iostream>
+#include <functional>
 #include <sqlite3.h>
 
 namespace SFTools{
@@ -37,6 +39,14 @@ namespace SFTools{
     double  GetStandardErr(std::vector <double> vec);
     std::vector <double> GetFWHM(TH1D* h);
     TString FindData(TString directory);
+    void    SetNThreads(int nthreads);
+    int     GetNThreads(void);
+    void    ParallelFor(int n, std::function<void(int)> func);
+    void    SetLikelihood(bool likelihood);
+    bool    GetLikelihood(void);
+    double  PoissonNLL(int n, const double *counts, const double *expected);
+    int     FitHistogram(TH1 *h, TF1 *fun, TString opt, 
+                         double xmin = 0, double xmax = 0);
     
 };
 
@@ -17,10 +17,9 @@ ClassImp(SFAttenuation);
 /// \param seriesNo is number of experimental series to be analyzed. 
 SFAttenuation::SFAttenuation(int seriesNo): fSeriesNo(seriesNo),
                                             fData(nullptr),
+                                            fNchannels(2),
                                             fAttnGraph(nullptr),
-                                            fSigmaGraph(nullptr),
-                                            fAttnGraphCh0(nullptr),
-                                            fAttnGraphCh1(nullptr) {
+                                            fSigmaGraph(nullptr) {
   
   try{
     fData = new SFData(fSeriesNo);
@@ -35,6 +34,13 @@ SFAttenuation::SFAttenuation(int seriesNo): fSeriesNo(seriesNo),
     std::cout << "##### Error in SFAttenuation constructor! Non-regular series!" << std::endl;
     throw "##### Exception in SFAttenuation constructor!";
   }
+  
+  fNchannels = fData->GetNchannels();
+  fSpectra.resize(fNchannels);
+  fPeaks.resize(fNchannels);
+  fAttnGraphCh.resize(fNchannels, nullptr);
+  fResults.fAttCh.resize(fNchannels, -1);
+  fResults.fAttChErr.resize(fNchannels, -1);
 }
 //------------------------------------------------------------------
 /// Default destructor.
@@ -59,6 +65,24 @@ bool SFAttenuation::AttAveragedCh(void){
   TString cut =  "ch_0.fPE>0 && ch_1.fPE>0 && ch_0.fT0>0 && ch_1.fT0>0 && ch_0.fT0<590 && ch_1.fT0<590";
   fRatios = fData->GetCustomHistograms(SFSelectionType::LogSqrtPERatio, cut);
   
+  //----- peak seeds of all positions from the series matrix of ratios
+  SFSpectrumMatrix *ratios = SFSpectrumMatrix::FromSpectra(Form("ratios_S%i", fSeriesNo),
+                                                           fRatios, positions);
+  if(ratios==nullptr){
+    std::cerr << "##### Error in SFAttenuation::AttAveragedCh()!" << std::endl;
+    std::cerr << "Ratio histograms couldn't be collected!" << std::endl;
+    return false;
+  }
+  
+  std::vector <int>    maxBins = ratios->GetMaximumBins(ratios->GetXmin(), ratios->GetXmax());
+  std::vector <double> maxima  = ratios->GetMaxima(ratios->GetXmin(), ratios->GetXmax());
+  std::vector <double> centers(npoints);
+  
+  for(int i=0; i<npoints; i++)
+    centers[i] = ratios->GetBinCenter(maxBins[i]);
+  
+  delete ratios;
+  
   double mean, sigma;
   double fit_min, fit_max;
   std::vector <TF1*> fun;
@@ -86,16 +110,16 @@ bool SFAttenuation::AttAveragedCh(void){
     sigma = fRatios[i]->GetRMS();
     if(collimator.Contains("Lead")){
       fun.push_back(new TF1("fun", "gaus(0)+gaus(3)", -1, 1));
-      fun[i]->SetParameter(0, fRatios[i]->GetBinContent(fRatios[i]->GetMaximumBin()));		//thin gauss
-      fun[i]->SetParameter(1, fRatios[i]->GetBinCenter(fRatios[i]->GetMaximumBin()));
+      fun[i]->SetParameter(0, maxima[i]);		//thin gauss
+      fun[i]->SetParameter(1, centers[i]);
       fun[i]->SetParameter(2, 6E-2);
-      fun[i]->SetParameter(3, 0.5*fRatios[i]->GetBinContent(fRatios[i]->GetMaximumBin()));	//thick gauss
+      fun[i]->SetParameter(3, 0.5*maxima[i]);	//thick gauss
       if(i<npoints/2)
-        fun[i]->SetParameter(4, fRatios[i]->GetBinCenter(fRatios[i]->GetMaximumBin())+0.2);
+        fun[i]->SetParameter(4, centers[i]+0.2);
       else
-      fun[i]->SetParameter(4, fRatios[i]->GetBinCenter(fRatios[i]->GetMaximumBin())-0.2);
+      fun[i]->SetParameter(4, centers[i]-0.2);
       fun[i]->SetParameter(5, 2E-1);
-      fRatios[i]->Fit(fun[i],"QR");  
+      SFTools::FitHistogram(fRatios[i], fun[i], "QR");  
       if(fun[i]->GetParameter(0)>fun[i]->GetParameter(3))
           parNo = 1;
       else 
@@ -107,13 +131,13 @@ bool SFAttenuation::AttAveragedCh(void){
       //fit_min = -0.5;
       //fit_max = 0.5;
       fun.push_back(new TF1("fun", "gaus(0)+gaus(3)", fit_min, fit_max));
-      fun[i]->SetParameter(0, fRatios[i]->GetBinContent(fRatios[i]->GetMaximumBin()));
-      fun[i]->SetParameter(1, fRatios[i]->GetBinCenter(fRatios[i]->GetMaximumBin()));
+      fun[i]->SetParameter(0, maxima[i]);
+      fun[i]->SetParameter(1, centers[i]);
       fun[i]->SetParameter(2, 6E-2);
-      fun[i]->SetParameter(3, fRatios[i]->GetBinContent(fRatios[i]->GetMaximumBin())/10.);
-      fun[i]->SetParameter(4, fRatios[i]->GetBinCenter(fRatios[i]->GetMaximumBin()));
+      fun[i]->SetParameter(3, maxima[i]/10.);
+      fun[i]->SetParameter(4, centers[i]);
       fun[i]->SetParameter(5, 6E-1);  
-      fRatios[i]->Fit(fun[i],"QR");  
+      SFTools::FitHistogram(fRatios[i], fun[i], "QR");  
       if(fun[i]->GetParameter(0)>fun[i]->GetParameter(3))
           parNo = 1;
       else 
@@ -123,25 +147,25 @@ bool SFAttenuation::AttAveragedCh(void){
       /*fit_min = mean - 5*sigma;
       fit_max = mean + 5*sigma;
       fun.push_back(new TF1("fun", "gaus(0)+gaus(3)", fit_min, fit_max));
-      fun[i]->SetParameter(0, fRatios[i]->GetBinContent(fRatios[i]->GetMaximumBin()));
+      fun[i]->SetParameter(0, maxima[i]);
       fun[i]->SetParLimits(0, 0, 1E6);
-      fun[i]->SetParameter(1, fRatios[i]->GetBinCenter(fRatios[i]->GetMaximumBin()));
+      fun[i]->SetParameter(1, centers[i]);
       fun[i]->SetParameter(2, 5E-2);
       fun[i]->SetParLimits(2, 0, 50);
-      fun[i]->SetParameter(3, fRatios[i]->GetBinContent(fRatios[i]->GetMaximumBin())/20.);
+      fun[i]->SetParameter(3, maxima[i]/20.);
       fun[i]->SetParLimits(3, 0, 1E6);
-      fun[i]->SetParameter(4, fRatios[i]->GetBinCenter(fRatios[i]->GetMaximumBin()));
+      fun[i]->SetParameter(4, centers[i]);
       fun[i]->SetParameter(5, 1E-1);
       fun[i]->SetParLimits(5, 0, 50);*/
       fit_min = mean - 1*sigma;
       fit_max = mean + 1*sigma;
       fun.push_back(new TF1("fun", "gaus", fit_min, fit_max));
-      fun[i]->SetParameter(0, fRatios[i]->GetBinContent(fRatios[i]->GetMaximumBin()));
+      fun[i]->SetParameter(0, maxima[i]);
       fun[i]->SetParLimits(0, 0, 1E6);
-      fun[i]->SetParameter(1, fRatios[i]->GetBinCenter(fRatios[i]->GetMaximumBin()));
+      fun[i]->SetParameter(1, centers[i]);
       fun[i]->SetParameter(2, 5E-2);
       fun[i]->SetParLimits(2, 0, 50);
-      fRatios[i]->Fit(fun[i],"QR");
+      SFTools::FitHistogram(fRatios[i], fun[i], "QR");
       parNo = 1;
     }
     
@@ -211,12 +235,58 @@ bool SFAttenuation::AttSeparateCh(int ch){
   std::cout << "\n----- Inside SFAttenuation::AttSeparateCh() for series " << fSeriesNo << std::endl;
   std::cout << "----- Analyzing channel " << ch << std::endl;
   
+  if(!CheckChannel(ch, "AttSeparateCh"))
+    return false;
+  
+  TString cut = Form("ch_%i.fT0>0 && ch_%i.fT0<590 && ch_%i.fPE>0", ch, ch, ch);
+  std::vector <TH1D*> spectra = fData->GetSpectra(ch, SFSelectionType::PE, cut);
+  
+  return FitSeparateCh(ch, spectra);
+}
+//------------------------------------------------------------------
+/// Method to determine attenuation length for all readout channels 
+/// independently. Spectra of all channels are filled in parallel 
+/// (see SFData::GetChannelSpectra()), subsequently peak position is
+/// determined for each channel like in AttSeparateCh(int).
+bool SFAttenuation::AttSeparateCh(void){
+  
+  std::cout << "\n----- Inside SFAttenuation::AttSeparateCh() for series " << fSeriesNo << std::endl;
+  std::cout << "----- Analyzing all " << fNchannels << " channels" << std::endl;
+  
+  int npoints = fData->GetNpoints();
+  std::vector <int> measurementsIDs = fData->GetMeasurementsIDs();
+  std::vector <TString> cuts(fNchannels);
+  
+  for(int ch=0; ch<fNchannels; ch++)
+    cuts[ch] = Form("ch_%i.fT0>0 && ch_%i.fT0<590 && ch_%i.fPE>0", ch, ch, ch);
+  
+  std::vector <std::vector <TH1D*>> spectra(fNchannels, std::vector <TH1D*>(npoints));
+  std::vector <TH1D*> tmp;
+  
+  for(int i=0; i<npoints; i++){
+    tmp = fData->GetChannelSpectra(SFSelectionType::PE, cuts, measurementsIDs[i]);
+    for(int ch=0; ch<fNchannels; ch++)
+      spectra[ch][i] = tmp[ch];
+  }
+  
+  bool stat = true;
+  
+  for(int ch=0; ch<fNchannels; ch++)
+    stat = FitSeparateCh(ch, spectra[ch]) && stat;
+  
+  return stat;
+}
+//------------------------------------------------------------------
+/// Private method performing peak fitting for all spectra of the given
+/// channel and determining attenuation length from the exponential fit.
+/// \param ch - channel number
+/// \param spectra - PE spectra of the channel, for all measurements in the series
+bool SFAttenuation::FitSeparateCh(int ch, std::vector <TH1D*> spectra){
+  
   int npoints = fData->GetNpoints();
   TString collimator = fData->GetCollimator();
   TString testBench = fData->GetTestBench();
   std::vector <double> positions = fData->GetPositions();
-  TString cut = Form("ch_%i.fT0>0 && ch_%i.fT0<590 && ch_%i.fPE>0", ch, ch, ch);
-  std::vector <TH1D*> spectra = fData->GetSpectra(ch, SFSelectionType::PE, cut);
   
   TString gname = Form("att_s%i_ch%i", fSeriesNo, ch);
   TGraphErrors *graph = new TGraphErrors(npoints);
@@ -229,16 +299,15 @@ bool SFAttenuation::AttSeparateCh(int ch){
   std::vector <SFPeakFinder*> peakfin;
   PeakParams peakParams;
   
-  //TString fname = Form("/home/kasia/S%ich%i.txt", fSeriesNo, ch);
-  //std::ofstream output(fname);
+  for(int i=0; i<npoints; i++)
+    peakfin.push_back(new SFPeakFinder(spectra[i], false));
+  
+  SFPeakFinder::FindPeakFitsSeries(peakfin, positions);
   
   for(int i=0; i<npoints; i++){
-    peakfin.push_back(new SFPeakFinder(spectra[i], false));
-    peakfin[i]->FindPeakFit();
     peakParams = peakfin[i]->GetParameters();
     graph->SetPoint(i, positions[i], peakParams.fPosition);
     graph->SetPointError(i, SFTools::GetPosError(collimator, testBench), peakParams.fPositionErr);
-    //output << positions[i] << "\t" << peakParams.fPosition << "\t" << SFTools::GetPosError(collimator, testBench) << "\t" << peakParams.fPositionErr << std::endl;
   }
   
   //----- fitting 
@@ -252,17 +321,24 @@ bool SFAttenuation::AttSeparateCh(int ch){
   
   std::cout << "\n\tAttenuation for channel "<< ch << ": " << attenuation << " +/- " << att_error << " mm\n" << std::endl;
   
-  if(ch==0){
-    fResults.fAttCh0    = attenuation;
-    fResults.fAttCh0Err = att_error;
-    fSpectraCh0   = spectra;
-    fAttnGraphCh0 = graph;
-  }
-  else if(ch==1){
-    fResults.fAttCh1    = attenuation;
-    fResults.fAttCh1Err = att_error;
-    fSpectraCh1   = spectra;
-    fAttnGraphCh1 = graph;
+  fResults.fAttCh[ch]    = attenuation;
+  fResults.fAttChErr[ch] = att_error;
+  fSpectra[ch]     = spectra;
+  fAttnGraphCh[ch] = graph;
+  
+  return true;
+}
+//------------------------------------------------------------------
+/// Checks whether channel number is valid for the analyzed series.
+/// \param ch - channel number
+/// \param function - name of the calling function, for error messages
+bool SFAttenuation::CheckChannel(int ch, TString function){
+  
+  if(ch<0 || ch>=fNchannels){
+    std::cerr << "##### Error in SFAttenuation::" << function << "()! Incorrect channel number: " 
+              << ch << std::endl;
+    std::cerr << "Number of channels in series " << fSeriesNo << ": " << fNchannels << std::endl;
+    return false;
   }
   
   return true;
@@ -282,12 +358,11 @@ TGraphErrors* SFAttenuation::GetAttGraph(void){
 ///with separate channels method - AttSeparateCh().
 TGraphErrors* SFAttenuation::GetAttGraph(int ch){
     
-   if((ch==0 && fAttnGraphCh0==nullptr) || (ch==1 && fAttnGraphCh1==nullptr)){
+   if(!CheckChannel(ch, "GetAttGraph") || fAttnGraphCh[ch]==nullptr){
      std::cerr << "##### Error in SFAttenuation::GetAttnGraph(int). Empty pointer!" << std::endl;
      std::abort();
    }
-   if(ch==0) return fAttnGraphCh0;
-   else if(ch==1) return fAttnGraphCh1;
+   return fAttnGraphCh[ch];
 }
 //------------------------------------------------------------------
 TGraphErrors* SFAttenuation::GetSigmaGraph(void){
@@ -304,12 +379,11 @@ TGraphErrors* SFAttenuation::GetSigmaGraph(void){
 ///\param ch - channel number
 std::vector <TH1D*> SFAttenuation::GetSpectra(int ch){
     
-  if((ch==0 && fSpectraCh0.empty()) || (ch==1 && fSpectraCh1.empty())){
+  if(!CheckChannel(ch, "GetSpectra") || fSpectra[ch].empty()){
     std::cerr << "##### Error in SFAttenuation::GetSpectra(). Empty vector!" << std::endl;
     std::abort();
   }
-  if(ch==0) return fSpectraCh0;
-  else if(ch==1) return fSpectraCh1;
+  return fSpectra[ch];
 }
 //------------------------------------------------------------------
 ///Returns vector containing peaks (spectra after background subtraction with 
@@ -318,12 +392,11 @@ std::vector <TH1D*> SFAttenuation::GetSpectra(int ch){
 ///\param ch - channel number.
 std::vector <TH1D*> SFAttenuation::GetPeaks(int ch){
     
-  if((ch==0 && fPeaksCh0.empty()) || (ch==1 && fPeaksCh1.empty())){
+  if(!CheckChannel(ch, "GetPeaks") || fPeaks[ch].empty()){
     std::cerr << "##### Error in SFAttenuation::GetPeaks(). Empty vector!" << std::endl;
     std::abort();
   }
-  if(ch==0) return fPeaksCh0;
-  else if(ch==1) return fPeaksCh1;
+  return fPeaks[ch];
 }
 //------------------------------------------------------------------
 ///Returns vector containing histograms with signal ratios from both channels. 
@@ -0,0 +1,169 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *             SFCutFlow.cc              *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#include "SFCutFlow.hh"
+
+ClassImp(SFCutFlow);
+
+//------------------------------------------------------------------
+/// Default constructor.
+SFCutFlow::SFCutFlow() : fCut(""),
+                         fTested(0) {
+}
+//------------------------------------------------------------------
+/// Standard constructor.
+/// \param cut - cut (syntax like for Draw() method of TTree)
+SFCutFlow::SFCutFlow(TString cut) : fCut(cut),
+                                    fTested(0) {
+
+  fConditions = SplitCut(cut);
+  fSequential.resize(fConditions.size(), 0);
+  fIndependent.resize(fConditions.size(), 0);
+}
+//------------------------------------------------------------------
+/// Default destructor.
+SFCutFlow::~SFCutFlow(){
+}
+//------------------------------------------------------------------
+/// Splits cut into conditions joined with "&&" (or "||") outside of the 
+/// parentheses. Surrounding white spaces are removed. Empty cut gives no 
+/// conditions.
+/// \param cut - cut (syntax like for Draw() method of TTree)
+/// \param op - logical operator joining the conditions, "&&" or "||"
+std::vector <TString> SFCutFlow::SplitCut(TString cut, TString op){
+
+  std::vector <TString> conditions;
+  int depth = 0;
+  int start = 0;
+  int length = cut.Length();
+
+  for(int i=0; i<=length; i++){
+    if(i<length && cut[i]=='(') depth++;
+    if(i<length && cut[i]==')') depth--;
+    if(i==length || (depth==0 && i+1<length && cut[i]==op[0] && cut[i+1]==op[1])){
+      TString condition = cut(start, i-start);
+      condition = condition.Strip(TString::kBoth);
+      if(condition!="") conditions.push_back(condition);
+      start = i+2;
+      i++;
+    }
+  }
+
+  return conditions;
+}
+//------------------------------------------------------------------
+/// Counts single entry.
+/// \param pass - results of the conditions for the entry, in the order of
+/// GetConditions().
+bool SFCutFlow::Count(const std::vector <bool> &pass){
+
+  if(pass.size()!=fConditions.size()){
+    std::cerr << "##### Error in SFCutFlow::Count()!" << std::endl;
+    std::cerr << "Number of results doesn't match number of conditions!" << std::endl;
+    return false;
+  }
+
+  fTested++;
+  bool all = true;
+
+  for(size_t i=0; i<pass.size(); i++){
+    all = all && pass[i];
+    if(all) fSequential[i]++;
+    if(pass[i]) fIndependent[i]++;
+  }
+
+  return true;
+}
+//------------------------------------------------------------------
+/// Counts entries which passed all conditions, e.g. when histogram is 
+/// filled without cut.
+/// \param n - number of entries
+void SFCutFlow::Count(Long64_t n){
+
+  fTested += n;
+
+  for(size_t i=0; i<fConditions.size(); i++){
+    fSequential[i]  += n;
+    fIndependent[i] += n;
+  }
+
+  return;
+}
+//------------------------------------------------------------------
+/// Adds counts of another cut-flow table of the same cut, e.g. filled
+/// for another chunk of entries.
+/// \param flow - cut-flow table to be added
+bool SFCutFlow::Add(const SFCutFlow *flow){
+
+  if(flow->fConditions!=fConditions){
+    std::cerr << "##### Error in SFCutFlow::Add()!" << std::endl;
+    std::cerr << "Cut-flow tables of different cuts can't be added!" << std::endl;
+    return false;
+  }
+
+  fTested += flow->fTested;
+
+  for(size_t i=0; i<fConditions.size(); i++){
+    fSequential[i]  += flow->fSequential[i];
+    fIndependent[i] += flow->fIndependent[i];
+  }
+
+  return true;
+}
+//------------------------------------------------------------------
+/// Attaches the table to the histogram. Table previously attached to
+/// this histogram is replaced. Histogram takes ownership of the table.
+/// The table is found by its class name (see GetCutFlow()).
+/// \param hist - histogram
+void SFCutFlow::Attach(TH1 *hist){
+
+  SFCutFlow *old = GetCutFlow(hist);
+
+  if(old!=nullptr){
+    hist->GetListOfFunctions()->Remove(old);
+    delete old;
+  }
+
+  hist->GetListOfFunctions()->Add(this);
+
+  return;
+}
+//------------------------------------------------------------------
+/// Returns cut-flow table attached to the histogram or nullptr if there
+/// is none (see SFData::SetCutFlow()).
+/// \param hist - histogram
+SFCutFlow* SFCutFlow::GetCutFlow(TH1 *hist){
+
+  if(hist==nullptr)
+    return nullptr;
+
+  return (SFCutFlow*)hist->GetListOfFunctions()->FindObject("SFCutFlow");
+}
+//------------------------------------------------------------------
+/// Prints cut-flow table.
+void SFCutFlow::Print(void){
+  std::cout << "\n-------------------------------------------" << std::endl;
+  std::cout << "This is Print() for SFCutFlow class object" << std::endl;
+  std::cout << "Cut: " << fCut << std::endl;
+  std::cout << "Tested entries: " << fTested << std::endl;
+  std::cout << std::setw(14) << "sequential" << std::setw(9) << "[%]"
+            << std::setw(14) << "independent" << std::setw(9) << "[%]"
+            << "   condition" << std::endl;
+  for(size_t i=0; i<fConditions.size(); i++){
+    std::cout << std::setw(14) << fSequential[i]
+              << std::setw(9) << std::fixed << std::setprecision(2)
+              << (fTested>0 ? 100.*fSequential[i]/fTested : 0.)
+              << std::setw(14) << fIndependent[i]
+              << std::setw(9) << (fTested>0 ? 100.*fIndependent[i]/fTested : 0.)
+              << "   " << fConditions[i] << std::endl;
+  }
+  std::cout << "-------------------------------------------\n" << std::endl;
+}
+//------------------------------------------------------------------
@@ -17,6 +17,20 @@ ClassImp(SFData);
 static const char  *gPath = getenv("SFDATA");  // path to the experimental data and data base
 static const int    gBaselineMax = 50;         // number of samples for base line determination
 static const double gmV          = 4.096;      // coefficient to calibrate ADC channels to mV
+static const int    gNclusters   = 320;        // number of clusters of entries for the adaptive binning pre-pass
+static const int    gNsampled    = 32;         // number of sampled clusters (every 10th)
+static const int    gMinSampled  = 100;        // minimal number of sampled values to adapt binning
+static const int    gMinBins     = 20;         // minimal number of bins of adapted histograms
+static const int    gMaxBins     = 5000;       // maximal number of bins of adapted histograms
+//------------------------------------------------------------------
+TString SFData::fCacheDir    = "";
+TString SFData::fResultsDB   = "";
+bool    SFData::fIncremental = false;
+bool    SFData::fCutFlow     = false;
+bool    SFData::fAdaptive    = false;
+int     SFData::fBinsPerIQR  = 40;
+bool    SFData::fEventMasks  = false;
+std::map <TString, SFEventMask*> SFData::fMasks;
 //------------------------------------------------------------------
 /// Default constructor. If this constructor is used the series 
 /// number should be set via SetDetails(int seriesNo) function.
@@ -32,7 +46,12 @@ SFData::SFData(): fSeriesNo(-1),
                   fSiPM("dummy"),
                   fOvervoltage(-1),
                   fCoupling("dummy"),
-                  fTempFile("dummy") {
+                  fTempFile("dummy"),
+                  fNchannels(2),
+                  fRefChannel(2),
+                  fAttLength(-1),
+                  fManifest(nullptr),
+                  fSimulation(nullptr) {
                       
  std::cout << "##### Warning in SFData constructor!" << std::endl;
  std::cout << "You are using the default constructor. Set the series number & open data base!" << std::endl;
@@ -52,7 +71,12 @@ SFData::SFData(int seriesNo): fSeriesNo(seriesNo),
                               fSiPM("dummy"),
                               fOvervoltage(-1),
                               fCoupling("dummy"),
-                              fTempFile("dummy") {
+                              fTempFile("dummy"),
+                              fNchannels(2),
+                              fRefChannel(2),
+                              fAttLength(-1),
+                              fManifest(nullptr),
+                              fSimulation(nullptr) {
                                   
  bool db_stat  = OpenDataBase("ScintFib_2.db");
  bool set_stat = SetDetails(seriesNo);
@@ -64,6 +88,9 @@ SFData::SFData(int seriesNo): fSeriesNo(seriesNo),
 /// Default destructor.
 SFData::~SFData(){
     
+ if(fSimulation!=nullptr)
+   delete fSimulation;
+ 
  int status = sqlite3_close(fDB);
  if(status!=0) 
    std::cerr << "In SFData destructor. Data base corrupted!" << std::endl;
@@ -172,6 +199,60 @@ bool SFData::SetDetails(int seriesNo){
   sqlite3_finalize(statement);
   //-----
   
+  //----- Setting number of channels
+  ///- number of readout channels (NO_CHANNELS column, if present in the 
+  ///  data base, otherwise 2 - both ends of the single fiber)
+  ///- number of the reference detector channel (first channel after readout channels)
+  bool hasChannels = false;
+  query = "PRAGMA table_info(SERIES)";
+  status = sqlite3_prepare_v2(fDB, query, -1, &statement, nullptr);
+  
+  SFTools::CheckDBStatus(status, fDB);
+  
+  while((status=sqlite3_step(statement)) == SQLITE_ROW){
+    const unsigned char *column = sqlite3_column_text(statement, 1);
+    if(TString(reinterpret_cast<const char*>(column))=="NO_CHANNELS") 
+      hasChannels = true;
+  }
+  
+  SFTools::CheckDBStatus(status, fDB);
+  
+  sqlite3_finalize(statement);
+  
+  fNchannels = 2;
+  
+  if(hasChannels){
+    query = Form("SELECT NO_CHANNELS FROM SERIES WHERE SERIES_ID = %i", fSeriesNo);
+    status = sqlite3_prepare_v2(fDB, query, -1, &statement, nullptr);
+    
+    SFTools::CheckDBStatus(status, fDB);
+    
+    while((status=sqlite3_step(statement)) == SQLITE_ROW){
+      if(sqlite3_column_type(statement, 0)!=SQLITE_NULL)
+        fNchannels = sqlite3_column_int(statement, 0);
+    }
+    
+    SFTools::CheckDBStatus(status, fDB);
+    
+    sqlite3_finalize(statement);
+  }
+  
+  if(fNchannels<1){
+    std::cerr << "##### Error in SFData::SetDetails()! Incorrect number of channels: "
+              << fNchannels << std::endl;
+    return false;
+  }
+  
+  fRefChannel = fNchannels;
+  //-----
+  
+  //----- Setting attenuation length 
+  ///- attenuation length of the series, if it was already determined and 
+  ///  stored in the results data base (see SetResultsDatabase()), otherwise -1
+  if(!LoadAttenuationLength())
+    return false;
+  //-----
+  
   //----- Setting measurements attributes
   ///- list of measurements names
   ///- list of measurements duration times
@@ -197,10 +278,232 @@ bool SFData::SetDetails(int seriesNo){
   SFTools::CheckDBStatus(status, fDB);
   
   sqlite3_finalize(statement);
+  //-----
+  
+  //----- Setting up simulation
+  ///- fiber model for simulated series (only for the "Simulation" test bench)
+  if(fTestBench=="Simulation" && fSimulation==nullptr){
+    fSimulation = new SFSimulation(fFiber, fFiberLength, fSeriesNo);
+  }
+  //-----
+  
+  //----- Loading selection configuration
+  ///- binning and cuts of selections from the analysis group configuration 
+  ///  file .configAG<N>.json, if present (see SFDrawCommands::LoadConfig())
+  TString config = Form(".configAG%i.json", fAnalysisGroup);
+  if(!gSystem->AccessPathName(config) && !SFDrawCommands::LoadConfig(config)){
+    std::cerr << "##### Error in SFData::SetDetails()! Incorrect selection configuration!" << std::endl;
+    return false;
+  }
+  //-----
+  
+  //----- Opening manifest of products
+  ///- manifest of products (only in the incremental mode, see SetIncremental())
+  if(fIncremental && fManifest==nullptr){
+    try{
+      fManifest = SFManifest::GetManifest(fCacheDir, fSeriesNo);
+    }
+    catch(const char *message){
+      std::cerr << message << std::endl;
+      std::cerr << "##### Error in SFData::SetDetails()! Cannot open manifest!" << std::endl;
+      return false;
+    }
+  }
+  //-----
    
   return true;
 }
 //------------------------------------------------------------------
+/// Switches on the incremental mode for all SFData objects created 
+/// afterwards. In this mode every per-measurement product (spectra, 
+/// custom and correlation histograms, averaged signals) is stored in 
+/// the cache directory together with the fingerprint of its inputs 
+/// and parameters (see SFManifest class). When the product is requested 
+/// again it is recalculated only if the input files have changed, e.g.
+/// when the measurement was reprocessed. Series-level results are 
+/// always recalculated.
+/// \param cacheDir - cache directory. If empty string is passed 
+/// incremental mode is switched off.
+void SFData::SetIncremental(TString cacheDir){
+  fCacheDir = cacheDir;
+  fIncremental = !cacheDir.IsNull();
+}
+//------------------------------------------------------------------
+/// Sets results data base for all SFData objects created afterwards.
+/// Attenuation length of the series, used for the attenuation-corrected
+/// PE, is read from its ATTENUATION_LENGTH table (filled by attenuation).
+/// \param database - path to the results data base
+void SFData::SetResultsDatabase(TString database){
+  fResultsDB = database;
+}
+//------------------------------------------------------------------
+/// Reads attenuation length (ATT_COMB) of the series from the results 
+/// data base. If the data base is not set or doesn't exist yet, or the
+/// attenuation analysis of the series wasn't done, attenuation length 
+/// is set to -1 and attenuation-corrected quantities are not available
+/// (see CheckAttenuation()). Returns false on data base errors.
+bool SFData::LoadAttenuationLength(void){
+  
+  fAttLength = -1;
+  
+  if(fResultsDB=="" || gSystem->AccessPathName(fResultsDB))
+    return true;
+  
+  sqlite3 *database;
+  sqlite3_stmt *statement;
+  
+  int status = sqlite3_open_v2(fResultsDB, &database, SQLITE_OPEN_READONLY, nullptr);
+  
+  if(status!=SQLITE_OK){
+    std::cerr << "##### Error in SFData::LoadAttenuationLength()! Cannot open data base!" << std::endl;
+    std::cerr << fResultsDB << std::endl;
+    sqlite3_close_v2(database);
+    return false;
+  }
+  
+  bool hasAttenuation = false;
+  TString query = "SELECT name FROM sqlite_master WHERE type='table' AND name='ATTENUATION_LENGTH'";
+  status = sqlite3_prepare_v2(database, query, -1, &statement, nullptr);
+  
+  SFTools::CheckDBStatus(status, database);
+  
+  while((status=sqlite3_step(statement)) == SQLITE_ROW){
+    hasAttenuation = true;
+  }
+  
+  SFTools::CheckDBStatus(status, database);
+  
+  sqlite3_finalize(statement);
+  
+  if(hasAttenuation){
+    query = Form("SELECT ATT_COMB FROM ATTENUATION_LENGTH WHERE SERIES_ID = %i", fSeriesNo);
+    status = sqlite3_prepare_v2(database, query, -1, &statement, nullptr);
+    
+    SFTools::CheckDBStatus(status, database);
+    
+    while((status=sqlite3_step(statement)) == SQLITE_ROW){
+      if(sqlite3_column_type(statement, 0)!=SQLITE_NULL)
+        fAttLength = sqlite3_column_double(statement, 0);
+    }
+    
+    SFTools::CheckDBStatus(status, database);
+    
+    sqlite3_finalize(statement);
+  }
+  
+  status = sqlite3_close_v2(database);
+  SFTools::CheckDBStatus(status, database);
+  
+  return true;
+}
+//------------------------------------------------------------------
+/// Switches on/off cut-flow accounting for all SFData objects. If it is 
+/// switched on, histograms are filled with the compiled kernels (see 
+/// FillKernel()) and every histogram gets its cut-flow table, counted in 
+/// the same pass over the data (see SFCutFlow class). The table is attached
+/// to the histogram and can be accessed with SFCutFlow::GetCutFlow(). 
+/// In the incremental mode histograms with and without cut-flow tables 
+/// are cached separately.
+/// \param cutFlow - flag switching cut-flow accounting on/off
+void SFData::SetCutFlow(bool cutFlow){
+  fCutFlow = cutFlow;
+}
+//------------------------------------------------------------------
+/// Switches on/off adaptive binning for all SFData objects. If it is
+/// switched on, range and binning of 1D histograms are chosen from the
+/// data instead of fixed values of SFDrawCommands. Before filling, every 
+/// 10th cluster of entries is summarized with streaming quantile sketch 
+/// (see SFQuantileSketch and AdaptBinning()). Histograms are then filled 
+/// with the compiled kernels (see FillKernel()). In the incremental mode 
+/// histograms with adapted binning are cached separately.
+/// \param adaptive - flag switching adaptive binning on/off
+/// \param binsPerIQR - target resolution, i.e. number of bins in the 
+/// interquartile range of the distribution
+void SFData::SetAdaptiveBinning(bool adaptive, int binsPerIQR){
+  fAdaptive = adaptive;
+  fBinsPerIQR = std::max(binsPerIQR, 1);
+}
+//------------------------------------------------------------------
+/// Switches on/off event masks of cuts for all SFData objects. If they
+/// are switched on, histograms are filled with the compiled kernels (see 
+/// FillKernel()) and every distinct cut is evaluated only once per 
+/// measurement into the event mask (see SFEventMask class and GetEventMask()). 
+/// Masks are kept for the whole run and shared by all SFData objects, 
+/// thus cuts repeated by different analysis classes are not evaluated again.
+/// Filling of histograms reads only entries which passed the cut. Masks 
+/// are not used when cut-flow accounting is on, since it needs every 
+/// condition evaluated for every entry.
+/// \param eventMasks - flag switching event masks on/off
+void SFData::SetEventMasks(bool eventMasks){
+  fEventMasks = eventMasks;
+}
+//------------------------------------------------------------------
+/// Deletes all stored event masks, e.g. to release memory after the
+/// analysis of the series.
+void SFData::ClearEventMasks(void){
+  for(auto it=fMasks.begin(); it!=fMasks.end(); ++it)
+    delete it->second;
+  fMasks.clear();
+}
+//------------------------------------------------------------------
+/// Returns copy of the requested product stored in the incremental mode 
+/// cache. If the incremental mode is off, product hasn't been stored yet 
+/// or the inputs have changed since, nullptr is returned.
+/// \param key - product key, i.e. histogram name and cut
+/// \param inputs - list of input files of the product
+/// \param params - parameters of the product (selection, cut, etc.)
+TObject* SFData::GetCachedProduct(TString key, std::vector <TString> inputs, TString params){
+  
+  if(fManifest==nullptr) 
+    return nullptr;
+  
+  if(UsesDerived(params)) 
+    params += Form(" att=%.6f", fAttLength);
+  
+  if(fCutFlow)
+    params += " cutflow";
+  
+  if(fAdaptive)
+    params += Form(" adaptive %i", fBinsPerIQR);
+  
+  TString fingerprint = SFManifest::Fingerprint(inputs, params);
+  key += " | " + params;
+  if(!fManifest->IsCurrent(key, fingerprint)) 
+    return nullptr;
+  
+  return fManifest->GetProduct(key);
+}
+//------------------------------------------------------------------
+/// Stores product in the incremental mode cache. If the incremental mode 
+/// is off nothing is done.
+/// \param key - product key, i.e. histogram name and cut
+/// \param inputs - list of input files of the product
+/// \param params - parameters of the product (selection, cut, etc.)
+/// \param obj - product to be stored
+void SFData::CacheProduct(TString key, std::vector <TString> inputs, TString params, TObject *obj){
+  
+  if(fManifest==nullptr)
+    return;
+  
+  if(UsesDerived(params)) 
+    params += Form(" att=%.6f", fAttLength);
+  
+  if(fCutFlow)
+    params += " cutflow";
+  
+  if(fAdaptive)
+    params += Form(" adaptive %i", fBinsPerIQR);
+  
+  TString fingerprint = SFManifest::Fingerprint(inputs, params);
+  key += " | " + params;
+  bool stat = fManifest->StoreProduct(key, fingerprint, inputs, obj);
+  
+  if(!stat){
+    std::cerr << "##### Warning in SFData::CacheProduct()! Product not stored!" << std::endl;
+    std::cerr << key << std::endl;
+  }
+}
+//------------------------------------------------------------------
 /// Parses given cut and checks if signal fulfills conditions specified by it. 
 /// \param sig - currently analyzed signal, as read from the tree
 /// \param cut - a logic cut to select specific signals.
@@ -341,11 +644,13 @@ bool SFData::InterpretCut(DDSignal *sig, TString cut){
 /// Accesses ROOT file and returns tree containing measured data for 
 /// the requested measurement.
 /// \param ID - measurement ID
-TTree* SFData::GetTree(int ID){
+/// \param derived - if true, tree containing derived quantities is attached
+/// as a friend (see GetDerivedFile())
+TTree* SFData::GetTree(int ID, bool derived){
     
   int index = SFTools::GetIndex(fMeasureID, ID);
-  TString fname = SFTools::FindData(fNames[index]);
-  TFile *file = new TFile(fname+"/results.root", "READ");
+  TString fname = GetResultsFile(index);
+  TFile *file = new TFile(fname, "READ");
   TString tname = std::string("tree_ft");
   TTree *tree = (TTree*)file->Get(tname);
   
@@ -355,6 +660,9 @@ TTree* SFData::GetTree(int ID){
     std::abort();
   }
   
+  if(derived)
+    tree->AddFriend("tree_derived", GetDerivedFile(index));
+  
   return tree;
 }
 //------------------------------------------------------------------
@@ -370,20 +678,37 @@ TH1D* SFData::GetSpectrum(int ch, SFSelectionType sel_type, TString cut, int ID)
 
   int index = SFTools::GetIndex(fMeasureID, ID);
   double position = fPositions[index];
-  TString fname = SFTools::FindData(fNames[index]);  
-  TFile *file = new TFile(fname+"/results.root", "READ");
+  TString fname = GetInputName(index);  
+  TString hname = Form("S%i_ch%i_pos%.1f_ID%i_", fSeriesNo, ch, position, ID)+SFDrawCommands::GetSelectionName(sel_type);
+  TString htitle = hname + " " + cut;
+  
+  std::vector <TString> inputs = {fname};
+  TString params = SFDrawCommands::GetSelection(sel_type, 0, ch) + " " + cut;
+  TH1D *spec = (TH1D*)GetCachedProduct(htitle, inputs, params);
+  if(spec!=nullptr) return spec;
+  
+  if(fCutFlow || fAdaptive || fEventMasks || fSimulation!=nullptr){
+    spec = (TH1D*)FillSingle(index, SFDrawCommands::GetDescriptor(sel_type, ch), cut, hname, htitle);
+    AttachInfo(spec, index, {ch}, SFDrawCommands::GetSelectionName(sel_type), cut);
+    CacheProduct(htitle, inputs, params, spec);
+    return spec;
+  }
+  
+  TFile *file = new TFile(GetResultsFile(index), "READ");
   TString tname = std::string("tree_ft");
   TTree *tree = (TTree*)file->Get(tname);
   
   gUnique+=1;
   TString selection = SFDrawCommands::GetSelection(sel_type, gUnique, ch);
+  AttachDerived(tree, index, selection + " " + cut);
   tree->Draw(selection, cut);
-  TH1D *spec = (TH1D*)gROOT->FindObjectAny(Form("htemp%i", gUnique));
-  TString hname = Form("S%i_ch%i_pos%.1f_ID%i_", fSeriesNo, ch, position, ID)+SFDrawCommands::GetSelectionName(sel_type);
-  TString htitle = hname + " " + cut;
+  spec = (TH1D*)gROOT->FindObjectAny(Form("htemp%i", gUnique));
   spec->SetName(hname);
   spec->SetTitle(htitle);
   
+  AttachInfo(spec, index, {ch}, SFDrawCommands::GetSelectionName(sel_type), cut);
+  CacheProduct(htitle, inputs, params, spec);
+  
   return spec;
 }
 //------------------------------------------------------------------
@@ -403,154 +728,1248 @@ std::vector <TH1D*> SFData::GetSpectra(int ch, SFSelectionType sel_type, TString
   return spectra;
 }
 //------------------------------------------------------------------
-/// Returns single requested custom 1D histogram.
-/// \param sel_type - predefined selection type (see SFDrawCommands)
-/// \param cut - cut for drawn events. Also TTree-style syntax
-/// \param ID - ID of requested measurement 
-/// \param customNumbers - vector containing set of numbers necessary for 
-/// the selection of events to be drawn on the histogram
-TH1D* SFData::GetCustomHistogram(SFSelectionType sel_type, TString cut, int ID, 
-                                std::vector <double> customNumbers){
+/// Returns spectra of requested type for all measurements of the series
+/// as a matrix: positions x bins in one contiguous buffer with common 
+/// binning (see SFSpectrumMatrix class). Spectra are obtained like in 
+/// GetSpectra() and copied into the matrix, with adaptive binning they 
+/// are resampled to a common axis. Matrix is owned by the caller. If
+/// the matrix can't be created nullptr is returned.
+/// \param ch - channel number
+/// \param sel_type - type of spectra (see SFDrawCommands)
+/// \param cut - logic cut for drawn events (syntax like for Draw() method of TTree)
+SFSpectrumMatrix* SFData::GetSpectrumMatrix(int ch, SFSelectionType sel_type, TString cut){
   
-  int index = SFTools::GetIndex(fMeasureID, ID);
-  double position = fPositions[index];
-  TString fname = SFTools::FindData(fNames[index]);
-  TFile *file = new TFile(fname+"/results.root", "READ");
-  TString tname = "tree_ft";
-  TTree *tree = (TTree*)file->Get(tname);
+  std::vector <TH1D*> spectra = GetSpectra(ch, sel_type, cut);
+  TString name = Form("S%i_ch%i_", fSeriesNo, ch) + SFDrawCommands::GetSelectionName(sel_type);
   
-  gUnique+=1;
-  TString selection; 
-  selection = SFDrawCommands::GetSelection(sel_type, gUnique, customNumbers);
-  tree->Draw(selection, cut);
-  TH1D* hist = (TH1D*)gROOT->FindObjectAny(Form("htemp%i", gUnique));
-  TString hname = Form("S%i_pos%.1f_ID%i_", fSeriesNo, position, ID) + SFDrawCommands::GetSelectionName(sel_type);
-  TString htitle = hname + " " + cut;
-  hist->SetName(hname);
-  hist->SetTitle(htitle);
+  SFSpectrumMatrix *matrix = SFSpectrumMatrix::FromSpectra(name, spectra, fPositions);
   
-  return hist;
-}
-//------------------------------------------------------------------
-/// Returns a vector of requested custom 1D histograms for all measurements in this series.
-/// \param sel_type - predefined selection type (see SFDrawCommands)
-/// \param cut - cut for drawn events. Also TTree-style syntax. If empty string is passed here 
-/// all events will be drawn.
-std::vector <TH1D*> SFData::GetCustomHistograms(SFSelectionType sel_type, TString cut){
+  for(size_t i=0; i<spectra.size(); i++)
+    delete spectra[i];
   
-  std::vector <TH1D*> hists;
-  for(int i=0; i<fNpoints; i++){
-    hists.push_back(GetCustomHistogram(sel_type, cut, fMeasureID[i]));
+  if(matrix==nullptr){
+    std::cerr << "##### Error in SFData::GetSpectrumMatrix()!" << std::endl;
+    std::cerr << "Matrix of spectra couldn't be created!" << std::endl;
   }
   
-  return hists;
+  return matrix;
 }
 //------------------------------------------------------------------
-/// Returns single requested custom 1D histogram.
-/// \param ch - channel number
-/// \param sel_type - predefined selection type (see SFDrawCommands)
-/// \param cut - cut for drawn events. Also TTree-style syntax
+/// Returns spectra of requested type for all readout channels of the 
+/// chosen measurement. Spectra of all channels are filled in one pass 
+/// over the data (see FillKernel()), the pass is split into chunks of 
+/// entries processed in parallel (see SFTools::ParallelFor()). Only 
+/// selections for single channel can be used here (see SFDrawCommands).
+/// \param sel_type - type of the spectra
+/// \param cuts - logic cuts for drawn events, one per channel (syntax like 
+/// for Draw() method of TTree). If one cut is passed it is used for all channels.
 /// \param ID - ID of requested measurement
-/// \param customNumbers - vector containing set of numbers necessary for 
-/// the selection of events to be drawn on the histogram.
-TH1D* SFData::GetCustomHistogram(int ch, SFSelectionType sel_type, TString cut, int ID, 
-                                 std::vector <double> customNumbers){
-    
+std::vector <TH1D*> SFData::GetChannelSpectra(SFSelectionType sel_type, 
+                                              std::vector <TString> cuts, int ID){
+  
+  if(cuts.empty()) 
+    cuts.push_back("");
+  
+  if(cuts.size()!=1 && (int)cuts.size()!=fNchannels){
+    std::cerr << "##### Error in SFData::GetChannelSpectra()!" << std::endl;
+    std::cerr << "Number of cuts doesn't match number of channels!" << std::endl;
+    std::abort();
+  }
+  
+  if(cuts.size()==1) 
+    cuts.resize(fNchannels, cuts[0]);
+  
   int index = SFTools::GetIndex(fMeasureID, ID);
   double position = fPositions[index];
-  TString fname = SFTools::FindData(fNames[index]);
-  TFile *file = new TFile(fname+"/results.root", "READ");
-  TString tname = "tree_ft";
-  TTree *tree = (TTree*)file->Get(tname);
+  TString fname = GetInputName(index);
+  std::vector <TString> inputs = {fname};
+  
+  std::vector <TH1D*>       spectra(fNchannels, nullptr);
+  std::vector <TString>     params(fNchannels);
+  std::vector <SFSelection> sels;
+  std::vector <TString>     selCuts;
+  std::vector <TH1*>        hists;
+  
+  //----- taking spectra from the cache and booking remaining ones
+  for(int ch=0; ch<fNchannels; ch++){
+    SFSelection desc = SFDrawCommands::GetDescriptor(sel_type, ch);
+    
+    if(desc.fNbinsY>0){
+      std::cerr << "##### Error in SFData::GetChannelSpectra()!" << std::endl;
+      std::cerr << "Selection not suitable for single channel spectra: " << desc.fExpression << std::endl;
+      std::abort();
+    }
+    
+    TString hname = Form("S%i_ch%i_pos%.1f_ID%i_", fSeriesNo, ch, position, ID)+SFDrawCommands::GetSelectionName(sel_type);
+    TString htitle = hname + " " + cuts[ch];
+    params[ch] = SFDrawCommands::GetSelection(desc, 0) + " " + cuts[ch];
+    spectra[ch] = (TH1D*)GetCachedProduct(htitle, inputs, params[ch]);
+    if(spectra[ch]!=nullptr) continue;
+    
+    spectra[ch] = new TH1D(hname, htitle, desc.fNbinsX, desc.fXmin, desc.fXmax);
+    spectra[ch]->SetDirectory(nullptr);
+    sels.push_back(desc);
+    selCuts.push_back(cuts[ch]);
+    hists.push_back(spectra[ch]);
+  }
   
-  gUnique+=1;
-  TString selection;
-  if(customNumbers.empty())
-    selection = SFDrawCommands::GetSelection(sel_type, gUnique, ch);
-  else 
-    selection = SFDrawCommands::GetSelection(sel_type, gUnique, ch, customNumbers);
-  tree->Draw(selection, cut);
-  TH1D* hist = (TH1D*)gROOT->FindObjectAny(Form("htemp%i", gUnique));
-  TString hname = Form("S%i_pos%.1f_ID%i_", fSeriesNo, position, ID)+ SFDrawCommands::GetSelectionName(sel_type);
-  TString htitle = hname + " " + cut;
-  hist->SetName(hname);
-  hist->SetTitle(htitle);
+  FillParallel(index, sels, selCuts, hists);
   
-  return hist;
-    
+  for(int ch=0; ch<fNchannels; ch++){
+    if(std::find(hists.begin(), hists.end(), spectra[ch])==hists.end()) continue;
+    AttachInfo(spectra[ch], index, {ch}, SFDrawCommands::GetSelectionName(sel_type), cuts[ch]);
+    CacheProduct(spectra[ch]->GetTitle(), inputs, params[ch], spectra[ch]);
+  }
+  
+  return spectra;
 }
 //------------------------------------------------------------------
-/// Returns single requested 2D correlation histogram.
-/// \param sel_type - predefined selection type (see SFDrawCommands)
-/// \param cut - cut for drawn events. Also TTree-style syntax
+/// Returns spectra of the requested type for consecutive slices of 
+/// the measurement. Entries of the tree are divided into nslices 
+/// slices of equal size, in the order in which they were recorded. 
+/// Since events are not time-stamped, time range of each slice is 
+/// estimated from the starting and stopping time of the measurement, 
+/// assuming constant rate, and is given in the histogram title 
+/// (in seconds from the start of the measurement). All slices are
+/// filled in one pass over the data: slices are processed in parallel,
+/// each of them reading only its own range of entries.
+/// \param ch - channel number
+/// \param sel_type - type of the spectrum, as defined in SFDrawCommands class
+/// \param cut - logic cut for drawn events (syntax like for Draw() method of TTree)
 /// \param ID - ID of requested measurement
-TH2D* SFData::GetCorrHistogram(SFSelectionType sel_type, TString cut, int ID, int ch){
+/// \param nslices - number of slices
+std::vector <TH1D*> SFData::GetSpectrumSlices(int ch, SFSelectionType sel_type, 
+                                              TString cut, int ID, int nslices){
+  
+  if(nslices<1){
+    std::cerr << "##### Error in SFData::GetSpectrumSlices()!" << std::endl;
+    std::cerr << "Incorrect number of slices: " << nslices << std::endl;
+    std::abort();
+  }
   
   int index = SFTools::GetIndex(fMeasureID, ID);
   double position = fPositions[index];
-  TString fname = SFTools::FindData(fNames[index]);
-  TFile *file = new TFile(fname+"/results.root", "READ");
-  TString tname = std::string("tree_ft");
-  TTree *tree = (TTree*)file->Get(tname);
+  double duration = fStop[index] - fStart[index];
+  TString fname = GetInputName(index);
+  std::vector <TString> inputs = {fname};
   
-  gUnique+=1;
-  TString selection;
-  if(ch==-1)
-      selection = SFDrawCommands::GetSelection(sel_type, gUnique);
-  else 
-      selection = SFDrawCommands::GetSelection(sel_type, gUnique, ch);
-  tree->Draw(selection, cut, "colz");
-  TH2D* hist = (TH2D*)gROOT->FindObjectAny(Form("htemp%.i", gUnique));
-  TString hname = Form("S%i_pos%.1f_ID%i_", fSeriesNo, position, ID) + SFDrawCommands::GetSelectionName(sel_type);
-  TString htitle = hname + " " + cut;
-  hist->SetName(hname);
-  hist->SetTitle(htitle);
+  SFSelection desc = SFDrawCommands::GetDescriptor(sel_type, ch);
   
-  return hist;
-}
-//------------------------------------------------------------------
-/// Returns a vector of requested 2D correlation histograms for all measurements in 
-/// this series.
-/// \param sel_type - predefined selection type (see SFDrawCommands)
-/// \param cut - cut for drawn events. Also TTree-style syntax.
-std::vector <TH2D*> SFData::GetCorrHistograms(SFSelectionType sel_type, TString cut, int ch){
+  if(desc.fNbinsY>0){
+    std::cerr << "##### Error in SFData::GetSpectrumSlices()!" << std::endl;
+    std::cerr << "Selection not suitable for single channel spectra: " << desc.fExpression << std::endl;
+    std::abort();
+  }
   
-    std::vector <TH2D*> hists;
-  for(int i=0; i<fNpoints; i++){
-    hists.push_back(GetCorrHistogram(sel_type, cut, fMeasureID[i], ch));
+  TString selection = SFDrawCommands::GetSelection(desc, 0);
+  
+  std::vector <TH1D*>   spectra(nslices, nullptr);
+  std::vector <TString> params(nslices);
+  std::vector <int>     missing;
+  
+  //----- taking slices from the cache and booking remaining ones
+  for(int i=0; i<nslices; i++){
+    TString hname = Form("S%i_ch%i_pos%.1f_ID%i_", fSeriesNo, ch, position, ID) + 
+                    SFDrawCommands::GetSelectionName(sel_type) + Form("_slice%i_of%i", i, nslices);
+    TString htitle = hname + Form(" [%.0f s, %.0f s] ", duration*i/nslices, duration*(i+1)/nslices) + cut;
+    params[i] = selection + " " + cut + Form(" slice %i/%i", i, nslices);
+    spectra[i] = (TH1D*)GetCachedProduct(htitle, inputs, params[i]);
+    if(spectra[i]!=nullptr) continue;
+    spectra[i] = new TH1D(hname, htitle, desc.fNbinsX, desc.fXmin, desc.fXmax);
+    spectra[i]->SetDirectory(nullptr);
+    missing.push_back(i);
   }
   
-  return hists;
+  if(missing.empty())
+    return spectra;
+  
+  std::vector <SFSelection> sels = {BindSelection(desc, index)};
+  std::vector <TString>     cuts = {cut};
+  CheckAttenuation(cut);
+  TString dname = UsesDerived(cut) ? GetDerivedFile(index) : TString("");
+  
+  std::vector <SFEventMask*> masks;
+  if(fEventMasks && !fCutFlow)
+    masks.push_back(GetMask(index, cut));
+  
+  //----- filling missing slices in parallel
+  if(fAdaptive){
+    AdaptBinning(index, dname, sels, cuts, masks);
+    for(size_t i=0; i<missing.size(); i++)
+      spectra[missing[i]]->SetBins(sels[0].fNbinsX, sels[0].fXmin, sels[0].fXmax);
+  }
+  
+  std::vector <SFCutFlow*> flows(nslices, nullptr);
+  
+  SFTools::ParallelFor(missing.size(), [&](int i){
+    int slice = missing[i];
+    std::vector <SFCutFlow*> flow;
+    if(fCutFlow){
+      flows[slice] = new SFCutFlow(cut);
+      flow.push_back(flows[slice]);
+    }
+    FillKernel(index, dname, sels, cuts, {spectra[slice]}, flow, {}, masks, slice, nslices);
+  });
+  
+  for(size_t i=0; i<missing.size(); i++){
+    int slice = missing[i];
+    if(flows[slice]!=nullptr) flows[slice]->Attach(spectra[slice]);
+    AttachInfo(spectra[slice], index, {ch}, SFDrawCommands::GetSelectionName(sel_type), cut);
+    CacheProduct(spectra[slice]->GetTitle(), inputs, params[slice], spectra[slice]);
+  }
+  
+  return spectra;
 }
 //------------------------------------------------------------------
-/// Returns averaged signal.
-/// \param ch - channel number 
+/// Returns histograms for several selections of the chosen measurement,
+/// filled in one pass over the data. Selections are evaluated with 
+/// compiled kernels (see SFKernels::Process()), only cuts are 
+/// interpreted by TTreeFormula, each distinct cut once per event. 
+/// 1D selections give TH1D histograms, correlations give TH2D histograms.
+/// \param sels - typed selection descriptors (see SFDrawCommands::GetDescriptor())
+/// \param cuts - logic cuts for drawn events, one per selection (syntax like 
+/// for Draw() method of TTree). If one cut is passed it is used for all selections.
+/// If no cuts are passed default cuts of the selections are used (see SFSelection).
 /// \param ID - ID of requested measurement
-/// \param cut - logic cut to choose signals. Syntax of this cut is explained 
-/// in InterpretCut() function
-/// \param number - number of signals to be averaged
-/// \param bl - flag for base line subtraction. If true - base line will be subtracted, 
-/// if false - it won't
-///
-/// If no cut is required pass an empty string.
-/// This function calls separate methods to access binary files depending on the test bench type.
-TProfile* SFData::GetSignalAverage(int ch, int ID, TString cut, int number, bool bl){
-
-  TProfile *sig = nullptr;
+std::vector <TH1*> SFData::FillSelections(std::vector <SFSelection> sels, 
+                                          std::vector <TString> cuts, int ID){
   
-  if(fTestBench=="PL"){
-    sig = GetSignalAverageKrakow(ch, ID, cut, number, bl);
+  if(cuts.empty()){
+    for(size_t i=0; i<sels.size(); i++)
+      cuts.push_back(sels[i].fCut);
   }
-  else if(fTestBench=="DE"){
-    sig = GetSignalAverageAachen(ch, ID, cut, number);    
+  
+  if(cuts.size()!=1 && cuts.size()!=sels.size()){
+    std::cerr << "##### Error in SFData::FillSelections()!" << std::endl;
+    std::cerr << "Number of cuts doesn't match number of selections!" << std::endl;
+    std::abort();
   }
-  else{
-    std::cerr << "##### Error in SFData::GetSignalAverage()!" << std::endl;
+  
+  if(cuts.size()==1)
+    cuts.resize(sels.size(), cuts[0]);
+  
+  int index = SFTools::GetIndex(fMeasureID, ID);
+  double position = fPositions[index];
+  TString fname = GetInputName(index);
+  std::vector <TString> inputs = {fname};
+  
+  std::vector <TH1*>        hists(sels.size(), nullptr);
+  std::vector <TString>     params(sels.size());
+  std::vector <SFSelection> missingSels;
+  std::vector <TString>     missingCuts;
+  std::vector <TH1*>        missingHists;
+  
+  //----- taking histograms from the cache and booking remaining ones
+  for(size_t i=0; i<sels.size(); i++){
+    TString hname = Form("S%i", fSeriesNo);
+    for(size_t c=0; c<sels[i].fChannels.size(); c++)
+      hname += Form("_ch%i", sels[i].fChannels[c]);
+    hname += Form("_pos%.1f_ID%i_", position, ID) + SFDrawCommands::GetSelectionName(sels[i].fType);
+    TString htitle = hname + " " + cuts[i];
+    params[i] = SFDrawCommands::GetSelection(sels[i], 0) + " " + cuts[i];
+    hists[i] = (TH1*)GetCachedProduct(htitle, inputs, params[i]);
+    if(hists[i]!=nullptr) continue;
+    
+    if(sels[i].fNbinsY>0)
+      hists[i] = new TH2D(hname, htitle, sels[i].fNbinsX, sels[i].fXmin, sels[i].fXmax,
+                          sels[i].fNbinsY, sels[i].fYmin, sels[i].fYmax);
+    else
+      hists[i] = new TH1D(hname, htitle, sels[i].fNbinsX, sels[i].fXmin, sels[i].fXmax);
+    hists[i]->SetDirectory(nullptr);
+    missingSels.push_back(sels[i]);
+    missingCuts.push_back(cuts[i]);
+    missingHists.push_back(hists[i]);
+  }
+  
+  FillParallel(index, missingSels, missingCuts, missingHists);
+  
+  for(size_t i=0; i<sels.size(); i++){
+    if(std::find(missingHists.begin(), missingHists.end(), hists[i])==missingHists.end()) continue;
+    AttachInfo(hists[i], index, sels[i].fChannels, SFDrawCommands::GetSelectionName(sels[i].fType), cuts[i]);
+    CacheProduct(hists[i]->GetTitle(), inputs, params[i], hists[i]);
+  }
+  
+  return hists;
+}
+//------------------------------------------------------------------
+/// Completes selection descriptor with the values known only for the 
+/// measurement. If PEAttCorrectedSum is requested without custom numbers,
+/// attenuation length of the series and source position are inserted, 
+/// consistently with fPEAttCorr of the derived tree.
+/// \param desc - typed selection descriptor
+/// \param index - index of the measurement in the series
+SFSelection SFData::BindSelection(SFSelection desc, int index){
+  
+  if(desc.fType==SFSelectionType::PEAttCorrectedSum && desc.fCustomNum.empty()){
+    CheckAttenuation("fPEAttCorr");
+    desc.fCustomNum = {-fPositions[index], fAttLength,
+                       -(fFiberLength-fPositions[index]), fAttLength};
+  }
+  
+  return desc;
+}
+//------------------------------------------------------------------
+/// Books histogram for the selection and fills it with the compiled 
+/// kernels (see FillParallel()). Used instead of TTree::Draw() when 
+/// cut-flow accounting, adaptive binning or event masks are on.
+/// \param index - index of the measurement in the series
+/// \param desc - typed selection descriptor
+/// \param cut - logic cut (syntax like for Draw() method of TTree)
+/// \param hname - histogram name
+/// \param htitle - histogram title
+TH1* SFData::FillSingle(int index, SFSelection desc, TString cut, TString hname, TString htitle){
+  
+  TH1 *hist = nullptr;
+  
+  if(desc.fNbinsY>0)
+    hist = new TH2D(hname, htitle, desc.fNbinsX, desc.fXmin, desc.fXmax,
+                    desc.fNbinsY, desc.fYmin, desc.fYmax);
+  else
+    hist = new TH1D(hname, htitle, desc.fNbinsX, desc.fXmin, desc.fXmax);
+  
+  hist->SetDirectory(nullptr);
+  FillParallel(index, {desc}, {cut}, {hist});
+  
+  return hist;
+}
+//------------------------------------------------------------------
+/// Chooses range and binning of 1D selections from the data. Every 10th 
+/// of the clusters of consecutive entries is read and values passing 
+/// the cuts are summarized with quantile sketches, filled in parallel
+/// and merged (see SFQuantileSketch). Range covers quantiles 0.001-0.999 
+/// extended by 10% on both sides, bin width is the interquartile range 
+/// divided by the target resolution (see SetAdaptiveBinning()). Number 
+/// of bins is kept between gMinBins and gMaxBins. If too few values 
+/// are sampled, binning of the selection is not changed.
+/// \param index - index of the measurement in the series
+/// \param dname - name of the derived tree file, empty if cuts don't use it
+/// \param sels - typed selection descriptors, binning is updated
+/// \param cuts - logic cuts, one per selection
+/// \param masks - event masks of the cuts or empty vector (see FillKernel())
+void SFData::AdaptBinning(int index, TString dname, std::vector <SFSelection> &sels,
+                          const std::vector <TString> &cuts, const std::vector <SFEventMask*> &masks){
+  
+  std::vector <std::vector <SFQuantileSketch*>> sketches(gNsampled);
+  
+  for(int c=0; c<gNsampled; c++){
+    for(size_t i=0; i<sels.size(); i++)
+      sketches[c].push_back(sels[i].fNbinsY>0 ? nullptr : new SFQuantileSketch());
+  }
+  
+  SFTools::ParallelFor(gNsampled, [&](int c){
+    FillKernel(index, dname, sels, cuts, {}, {}, sketches[c], masks,
+               c*(gNclusters/gNsampled), gNclusters);
+  });
+  
+  for(size_t i=0; i<sels.size(); i++){
+    
+    if(sketches[0][i]==nullptr) continue;
+    
+    for(int c=1; c<gNsampled; c++){
+      sketches[0][i]->Merge(*sketches[c][i]);
+      delete sketches[c][i];
+    }
+    
+    SFQuantileSketch *sketch = sketches[0][i];
+    
+    if(sketch->GetCount()<gMinSampled){
+      std::cerr << "##### Warning in SFData::AdaptBinning()! Too few entries sampled!" << std::endl;
+      std::cerr << "Binning of the selection " << sels[i].fExpression << " not changed." << std::endl;
+      delete sketch;
+      continue;
+    }
+    
+    double low    = sketch->GetQuantile(0.001);
+    double high   = sketch->GetQuantile(0.999);
+    double iqr    = sketch->GetQuantile(0.75) - sketch->GetQuantile(0.25);
+    double margin = 0.1*(high-low);
+    
+    if(high<=low){
+      margin = std::max(fabs(low)*0.1, 1.);
+    }
+    
+    double xmin  = low - margin;
+    double xmax  = high + margin;
+    double width = iqr>0 ? iqr/fBinsPerIQR : (xmax-xmin)/gMinBins;
+    int    nbins = std::min(std::max((int)ceil((xmax-xmin)/width), gMinBins), gMaxBins);
+    
+    sels[i].fNbinsX = nbins;
+    sels[i].fXmin   = xmin;
+    sels[i].fXmax   = xmax;
+    
+    delete sketch;
+  }
+  
+  return;
+}
+//------------------------------------------------------------------
+/// Fills histograms for the given selections of the measurement in parallel.
+/// Entries are divided into chunks, one per thread, each chunk is filled 
+/// into its own copies of the histograms, which are merged at the end
+/// in a fixed order. If cut-flow accounting is on (see SetCutFlow()), 
+/// cut-flow tables are merged in the same way and attached to the histograms.
+/// If adaptive binning is on (see SetAdaptiveBinning()), 1D histograms are 
+/// rebooked with the binning chosen in the pre-pass. If event masks are on
+/// (see SetEventMasks()), cuts are taken from the event masks.
+/// \param index - index of the measurement in the series
+/// \param sels - typed selection descriptors
+/// \param cuts - logic cuts, one per selection
+/// \param hists - booked histograms, one per selection
+void SFData::FillParallel(int index, const std::vector <SFSelection> &sels,
+                          const std::vector <TString> &cuts, const std::vector <TH1*> &hists){
+  
+  if(sels.empty())
+    return;
+  
+  TString dname = "";
+  std::vector <SFSelection> bound(sels.size());
+  
+  for(size_t i=0; i<sels.size(); i++){
+    bound[i] = BindSelection(sels[i], index);
+    CheckAttenuation(cuts[i]);
+    if(dname=="" && UsesDerived(cuts[i]))
+      dname = GetDerivedFile(index);
+  }
+  
+  //----- event masks of the cuts, evaluated once per measurement
+  std::vector <SFEventMask*> masks;
+  for(size_t i=0; i<cuts.size() && fEventMasks && !fCutFlow; i++)
+    masks.push_back(GetMask(index, cuts[i]));
+  
+  if(fAdaptive){
+    AdaptBinning(index, dname, bound, cuts, masks);
+    for(size_t i=0; i<hists.size(); i++){
+      if(bound[i].fNbinsY>0) continue;
+      hists[i]->SetBins(bound[i].fNbinsX, bound[i].fXmin, bound[i].fXmax);
+    }
+  }
+  
+  int nchunks = SFTools::GetNThreads();
+  std::vector <std::vector <TH1*>> partial(nchunks);
+  partial[0] = hists;
+  
+  for(int c=1; c<nchunks; c++){
+    for(size_t i=0; i<hists.size(); i++){
+      TH1 *h = (TH1*)hists[i]->Clone(Form("%s_chunk%i", hists[i]->GetName(), c));
+      h->SetDirectory(nullptr);
+      h->Reset();
+      partial[c].push_back(h);
+    }
+  }
+  
+  std::vector <std::vector <SFCutFlow*>> flows(nchunks);
+  
+  for(int c=0; c<nchunks && fCutFlow; c++){
+    for(size_t i=0; i<hists.size(); i++)
+      flows[c].push_back(new SFCutFlow(cuts[i]));
+  }
+  
+  SFTools::ParallelFor(nchunks, [&](int c){
+    FillKernel(index, dname, bound, cuts, partial[c], flows[c], {}, masks, c, nchunks);
+  });
+  
+  for(int c=1; c<nchunks; c++){
+    for(size_t i=0; i<hists.size(); i++){
+      hists[i]->Add(partial[c][i]);
+      delete partial[c][i];
+      if(!fCutFlow) continue;
+      flows[0][i]->Add(flows[c][i]);
+      delete flows[c][i];
+    }
+  }
+  
+  for(size_t i=0; i<flows[0].size(); i++)
+    flows[0][i]->Attach(hists[i]);
+  
+  return;
+}
+//------------------------------------------------------------------
+/// Fills histograms for the given selections in a single loop over one 
+/// chunk of entries of the tree. Only branches of channels used by 
+/// the selections are read. If event masks of the cuts are given, only 
+/// entries in the masks are read, otherwise each distinct cut is evaluated 
+/// once per event with TTreeFormula. Events which passed any cut are collected column-wise
+/// in blocks (see SFEventBlock) and selections are computed for the whole 
+/// block with the compile-time kernels (see SFKernels::Process()).
+/// \param index - index of the measurement in the series
+/// \param dname - name of the derived tree file, empty if cuts don't use it
+/// \param sels - typed selection descriptors
+/// \param cuts - logic cuts, one per selection
+/// \param hists - histograms to be filled, one per selection
+/// \param flows - cut-flow tables, one per selection, or empty vector if 
+/// cut-flow accounting is off. In the former case each condition of the cut
+/// is evaluated with its own TTreeFormula (see SFCutFlow::SplitCut()).
+/// \param sketches - quantile sketches, one per selection (nullptr for 2D 
+/// selections), or empty vector. In the former case values are added to 
+/// the sketches instead of being filled into histograms (see AdaptBinning()).
+/// \param masks - event masks of the cuts, one per selection (nullptr for 
+/// selections without cut), or empty vector (see GetEventMask()).
+/// \param chunk - number of the chunk of entries
+/// \param nchunks - total number of chunks
+void SFData::FillKernel(int index, TString dname, const std::vector <SFSelection> &sels,
+                        const std::vector <TString> &cuts, const std::vector <TH1*> &hists,
+                        const std::vector <SFCutFlow*> &flows, 
+                        const std::vector <SFQuantileSketch*> &sketches,
+                        const std::vector <SFEventMask*> &masks, int chunk, int nchunks){
+  
+  bool useMasks = !masks.empty();
+  bool lazy = fSimulation!=nullptr && dname=="" && !useMasks;
+  TFile *file = nullptr;
+  TTree *tree = nullptr;
+  std::vector <DDSignal*> signals(fNchannels+1, nullptr);
+  
+  if(lazy){
+    ///- simulated events are generated per entry (see SFSimulation::GetEvent())
+    ///  into a memory-resident tree holding one block of entries at a time
+    signals.resize(std::max(fNchannels+1, SFSimulation::GetNchannels()), nullptr);
+    tree = new TTree("tree_ft", "tree_ft");
+    tree->SetDirectory(nullptr);
+    for(size_t ch=0; ch<signals.size(); ch++){
+      signals[ch] = new DDSignal();
+      tree->Branch(Form("ch_%i", (int)ch), &signals[ch]);
+    }
+  }
+  else{
+    file = new TFile(GetResultsFile(index), "READ");
+    tree = (TTree*)file->Get("tree_ft");
+  }
+  
+  if(tree==nullptr){
+    std::cerr << "##### Error in SFData::FillKernel()!" << std::endl;
+    std::cerr << "Requested tree doesn't exist!" << std::endl;
+    std::abort();
+  }
+  
+  if(dname!="" && !useMasks) tree->AddFriend("tree_derived", dname);
+  
+  //----- connecting branches of used channels
+  std::vector <TBranch*>  branches(fNchannels+1, nullptr);
+  
+  for(size_t i=0; i<sels.size(); i++){
+    for(size_t c=0; c<sels[i].fChannels.size(); c++){
+      int ch = sels[i].fChannels[c];
+      if(ch<0 || ch>fNchannels){
+        std::cerr << "##### Error in SFData::FillKernel()!" << std::endl;
+        std::cerr << "Incorrect channel number: " << ch << std::endl;
+        std::abort();
+      }
+      if(branches[ch]!=nullptr) continue;
+      if(lazy){
+        branches[ch] = tree->GetBranch(Form("ch_%i", ch));
+        continue;
+      }
+      signals[ch] = new DDSignal();
+      tree->SetBranchAddress(Form("ch_%i", ch), &signals[ch], &branches[ch]);
+    }
+  }
+  
+  //----- one formula or event mask per distinct cut
+  std::vector <TString>       distinct;
+  std::vector <TTreeFormula*> formulas;
+  std::vector <SFEventMask*>  distinctMasks;
+  std::vector <int>           cutIndex(sels.size(), -1);
+  
+  for(size_t i=0; i<sels.size(); i++){
+    if(cuts[i]=="" || cuts[i]==" " || (useMasks && masks[i]==nullptr)) continue;
+    auto it = std::find(distinct.begin(), distinct.end(), cuts[i]);
+    if(it!=distinct.end()){
+      cutIndex[i] = it - distinct.begin();
+      continue;
+    }
+    cutIndex[i] = distinct.size();
+    distinct.push_back(cuts[i]);
+    if(useMasks)
+      distinctMasks.push_back(masks[i]);
+    else
+      formulas.push_back(new TTreeFormula(Form("cut_%i_%i", chunk, cutIndex[i]), cuts[i], tree));
+  }
+  
+  //----- cut-flow: one formula per condition of each distinct cut
+  bool countFlow = !flows.empty();
+  std::vector <SFCutFlow>                   counted;
+  std::vector <std::vector <TTreeFormula*>> conditions(distinct.size());
+  std::vector <std::vector <bool>>          passCond(distinct.size());
+  
+  for(size_t d=0; d<distinct.size() && countFlow; d++){
+    counted.push_back(SFCutFlow(distinct[d]));
+    std::vector <TString> cond = counted[d].GetConditions();
+    for(size_t k=0; k<cond.size(); k++)
+      conditions[d].push_back(new TTreeFormula(Form("cond_%i_%i_%i", chunk, (int)d, (int)k), 
+                                               cond[k], tree));
+    passCond[d].resize(cond.size());
+  }
+  
+  std::vector <bool> pass(distinct.size());
+  bool uncut = std::count(cutIndex.begin(), cutIndex.end(), -1)>0;
+  Long64_t nentries = lazy ? fSimulation->GetNevents() : tree->GetEntries();
+  Long64_t first = nentries*chunk/nchunks;
+  Long64_t last  = nentries*(chunk+1)/nchunks;
+  
+  //----- loading entry; simulated block is regenerated when entry leaves it
+  Long64_t loaded = -1;
+  auto load = [&](Long64_t entry) -> Long64_t {
+    if(!lazy) 
+      return tree->LoadTree(entry);
+    if(loaded<0 || entry<loaded || entry>=loaded+SFEventBlock::kCapacity){
+      loaded = entry;
+      tree->Reset();
+      Long64_t stop = std::min(entry+SFEventBlock::kCapacity, last);
+      for(Long64_t e=entry; e<stop; e++){
+        fSimulation->GetEvent(fMeasureID[index], fPositions[index], e, signals.data());
+        tree->Fill();
+      }
+    }
+    return tree->LoadTree(entry-loaded);
+  };
+  
+  //----- with masks only entries passing any cut are visited
+  std::vector <std::vector <Long64_t>> maskEntries(distinctMasks.size());
+  std::vector <size_t> maskPos(distinctMasks.size(), 0);
+  std::vector <Long64_t> visit;
+  
+  for(size_t d=0; d<distinctMasks.size(); d++){
+    maskEntries[d] = distinctMasks[d]->GetEntries(first, last);
+    if(uncut) continue;
+    std::vector <Long64_t> merged;
+    std::set_union(visit.begin(), visit.end(), maskEntries[d].begin(), 
+                   maskEntries[d].end(), std::back_inserter(merged));
+    visit.swap(merged);
+  }
+  
+  Long64_t nvisit = (useMasks && !uncut) ? (Long64_t)visit.size() : last-first;
+  
+  SFEventBlock block;
+  block.Init(fNchannels+1);
+  std::vector <double> x(SFEventBlock::kCapacity), y(SFEventBlock::kCapacity);
+  std::vector <std::vector <char>> passSel(sels.size(), std::vector <char>(SFEventBlock::kCapacity));
+  
+  auto flush = [&](){
+    for(size_t i=0; i<sels.size(); i++){
+      if(sketches.empty()){
+        SFKernels::Process(sels[i], block, x.data(), y.data(), passSel[i].data(), hists[i]);
+        continue;
+      }
+      if(sketches[i]==nullptr) continue;
+      SFKernels::Process(sels[i], block, x.data(), y.data(), passSel[i].data(), nullptr);
+      for(int k=0; k<block.fSize; k++)
+        if(passSel[i][k]) sketches[i]->Fill(x[k]);
+    }
+    block.fSize = 0;
+  };
+  
+  for(Long64_t n=0; n<nvisit; n++){
+    Long64_t entry = (useMasks && !uncut) ? visit[n] : first+n;
+    Long64_t local = load(entry);
+    
+    bool any = uncut;
+    for(size_t d=0; d<distinctMasks.size(); d++){
+      pass[d] = maskPos[d]<maskEntries[d].size() && maskEntries[d][maskPos[d]]==entry;
+      if(pass[d]) maskPos[d]++;
+      any = any || pass[d];
+    }
+    for(size_t f=0; f<formulas.size(); f++){
+      if(countFlow){
+        pass[f] = true;
+        for(size_t k=0; k<conditions[f].size(); k++){
+          conditions[f][k]->GetNdata();
+          passCond[f][k] = conditions[f][k]->EvalInstance()!=0;
+          pass[f] = pass[f] && passCond[f][k];
+        }
+        counted[f].Count(passCond[f]);
+      }
+      else{
+        formulas[f]->GetNdata();
+        pass[f] = formulas[f]->EvalInstance()!=0;
+      }
+      any = any || pass[f];
+    }
+    if(!any) continue;
+    
+    int k = block.fSize;
+    for(size_t ch=0; ch<branches.size(); ch++){
+      if(branches[ch]==nullptr) continue;
+      branches[ch]->GetEntry(local);
+      block.Set(k, ch, signals[ch]);
+    }
+    
+    for(size_t i=0; i<sels.size(); i++)
+      passSel[i][k] = (cutIndex[i]<0 || pass[cutIndex[i]]);
+    
+    block.fSize++;
+    if(block.fSize==SFEventBlock::kCapacity) flush();
+  }
+  
+  if(block.fSize>0) flush();
+  
+  //----- cut-flow tables of selections; without cut all entries pass
+  for(size_t i=0; i<flows.size(); i++){
+    if(cutIndex[i]>=0){
+      flows[i]->Add(&counted[cutIndex[i]]);
+    }
+    else{
+      flows[i]->Count(last-first);
+    }
+  }
+  
+  for(size_t f=0; f<formulas.size(); f++){
+    delete formulas[f];
+    for(size_t k=0; k<conditions[f].size(); k++)
+      delete conditions[f][k];
+  }
+  
+  tree->ResetBranchAddresses();
+  
+  if(lazy){
+    delete tree;
+  }
+  else{
+    file->Close();
+    delete file;
+  }
+  
+  for(size_t ch=0; ch<signals.size(); ch++)
+    delete signals[ch];
+  
+  return;
+}
+//------------------------------------------------------------------
+/// Returns single requested custom 1D histogram. Channels 0 and 1 are
+/// combined.
+/// \param sel_type - predefined selection type (see SFDrawCommands)
+/// \param cut - cut for drawn events. Also TTree-style syntax
+/// \param ID - ID of requested measurement 
+/// \param customNumbers - vector containing set of numbers necessary for 
+/// the selection of events to be drawn on the histogram
+TH1D* SFData::GetCustomHistogram(SFSelectionType sel_type, TString cut, int ID, 
+                                std::vector <double> customNumbers){
+  
+  return GetCustomHistogram(sel_type, cut, ID, 0, 1, customNumbers);
+}
+//------------------------------------------------------------------
+/// Returns single requested custom 1D histogram for the chosen pair
+/// of channels, e.g. two ends of one fiber in the fiber array.
+/// \param sel_type - predefined selection type (see SFDrawCommands)
+/// \param cut - cut for drawn events. Also TTree-style syntax
+/// \param ID - ID of requested measurement 
+/// \param chL - channel number of the left end of the fiber
+/// \param chR - channel number of the right end of the fiber
+/// \param customNumbers - vector containing set of numbers necessary for 
+/// the selection of events to be drawn on the histogram
+TH1D* SFData::GetCustomHistogram(SFSelectionType sel_type, TString cut, int ID, 
+                                 int chL, int chR, std::vector <double> customNumbers){
+  
+  int index = SFTools::GetIndex(fMeasureID, ID);
+  double position = fPositions[index];
+  TString fname = GetInputName(index);
+  TString hname = Form("S%i_pos%.1f_ID%i_", fSeriesNo, position, ID) + SFDrawCommands::GetSelectionName(sel_type);
+  if(chL!=0 || chR!=1) hname += Form("_ch%i_ch%i", chL, chR);
+  TString htitle = hname + " " + cut;
+  
+  std::vector <TString> inputs = {fname};
+  TString params = SFDrawCommands::GetSelection(sel_type, 0, chL, chR, customNumbers) + " " + cut;
+  TH1D *hist = (TH1D*)GetCachedProduct(htitle, inputs, params);
+  if(hist!=nullptr) return hist;
+  
+  if(fCutFlow || fAdaptive || fEventMasks || fSimulation!=nullptr){
+    hist = (TH1D*)FillSingle(index, SFDrawCommands::GetDescriptor(sel_type, chL, chR, customNumbers), cut, hname, htitle);
+    AttachInfo(hist, index, {chL, chR}, SFDrawCommands::GetSelectionName(sel_type), cut);
+    CacheProduct(htitle, inputs, params, hist);
+    return hist;
+  }
+  
+  TFile *file = new TFile(GetResultsFile(index), "READ");
+  TString tname = "tree_ft";
+  TTree *tree = (TTree*)file->Get(tname);
+  
+  gUnique+=1;
+  TString selection; 
+  selection = SFDrawCommands::GetSelection(sel_type, gUnique, chL, chR, customNumbers);
+  AttachDerived(tree, index, selection + " " + cut);
+  tree->Draw(selection, cut);
+  hist = (TH1D*)gROOT->FindObjectAny(Form("htemp%i", gUnique));
+  hist->SetName(hname);
+  hist->SetTitle(htitle);
+  
+  AttachInfo(hist, index, {chL, chR}, SFDrawCommands::GetSelectionName(sel_type), cut);
+  CacheProduct(htitle, inputs, params, hist);
+  
+  return hist;
+}
+//------------------------------------------------------------------
+/// Returns a vector of requested custom 1D histograms for all measurements in this series.
+/// \param sel_type - predefined selection type (see SFDrawCommands)
+/// \param cut - cut for drawn events. Also TTree-style syntax. If empty string is passed here 
+/// all events will be drawn.
+std::vector <TH1D*> SFData::GetCustomHistograms(SFSelectionType sel_type, TString cut){
+  
+  std::vector <TH1D*> hists;
+  for(int i=0; i<fNpoints; i++){
+    hists.push_back(GetCustomHistogram(sel_type, cut, fMeasureID[i]));
+  }
+  
+  return hists;
+}
+//------------------------------------------------------------------
+/// Returns single requested custom 1D histogram.
+/// \param ch - channel number
+/// \param sel_type - predefined selection type (see SFDrawCommands)
+/// \param cut - cut for drawn events. Also TTree-style syntax
+/// \param ID - ID of requested measurement
+/// \param customNumbers - vector containing set of numbers necessary for 
+/// the selection of events to be drawn on the histogram.
+TH1D* SFData::GetCustomHistogram(int ch, SFSelectionType sel_type, TString cut, int ID, 
+                                 std::vector <double> customNumbers){
+    
+  int index = SFTools::GetIndex(fMeasureID, ID);
+  double position = fPositions[index];
+  TString fname = GetInputName(index);
+  TString hname = Form("S%i_pos%.1f_ID%i_", fSeriesNo, position, ID)+ SFDrawCommands::GetSelectionName(sel_type);
+  TString htitle = hname + " " + cut;
+  
+  std::vector <TString> inputs = {fname};
+  TString params;
+  if(customNumbers.empty())
+    params = SFDrawCommands::GetSelection(sel_type, 0, ch);
+  else
+    params = SFDrawCommands::GetSelection(sel_type, 0, ch, customNumbers);
+  params += " " + cut;
+  TH1D *hist = (TH1D*)GetCachedProduct(htitle, inputs, params);
+  if(hist!=nullptr) return hist;
+  
+  if(fCutFlow || fAdaptive || fEventMasks || fSimulation!=nullptr){
+    hist = (TH1D*)FillSingle(index, SFDrawCommands::GetDescriptor(sel_type, ch, customNumbers), cut, hname, htitle);
+    AttachInfo(hist, index, {ch}, SFDrawCommands::GetSelectionName(sel_type), cut);
+    CacheProduct(htitle, inputs, params, hist);
+    return hist;
+  }
+  
+  TFile *file = new TFile(GetResultsFile(index), "READ");
+  TString tname = "tree_ft";
+  TTree *tree = (TTree*)file->Get(tname);
+  
+  gUnique+=1;
+  TString selection;
+  if(customNumbers.empty())
+    selection = SFDrawCommands::GetSelection(sel_type, gUnique, ch);
+  else 
+    selection = SFDrawCommands::GetSelection(sel_type, gUnique, ch, customNumbers);
+  AttachDerived(tree, index, selection + " " + cut);
+  tree->Draw(selection, cut);
+  hist = (TH1D*)gROOT->FindObjectAny(Form("htemp%i", gUnique));
+  hist->SetName(hname);
+  hist->SetTitle(htitle);
+  
+  AttachInfo(hist, index, {ch}, SFDrawCommands::GetSelectionName(sel_type), cut);
+  CacheProduct(htitle, inputs, params, hist);
+  
+  return hist;
+    
+}
+//------------------------------------------------------------------
+/// Returns single requested 2D correlation histogram.
+/// \param sel_type - predefined selection type (see SFDrawCommands)
+/// \param cut - cut for drawn events. Also TTree-style syntax
+/// \param ID - ID of requested measurement
+/// \param ch - channel number for single-channel correlations. If -1 is passed
+/// channels 0 and 1 are correlated.
+TH2D* SFData::GetCorrHistogram(SFSelectionType sel_type, TString cut, int ID, int ch){
+  
+  if(ch==-1)
+    return GetCorrHistogram(sel_type, cut, ID, 0, 1);
+  
+  int index = SFTools::GetIndex(fMeasureID, ID);
+  double position = fPositions[index];
+  TString fname = GetInputName(index);
+  TString hname = Form("S%i_pos%.1f_ID%i_", fSeriesNo, position, ID) + SFDrawCommands::GetSelectionName(sel_type);
+  TString htitle = hname + " " + cut;
+  std::vector <double> refChannel = {(double)fRefChannel};
+  
+  std::vector <TString> inputs = {fname};
+  TString params = SFDrawCommands::GetSelection(sel_type, 0, ch, refChannel) + " " + cut;
+  TH2D *hist = (TH2D*)GetCachedProduct(htitle, inputs, params);
+  if(hist!=nullptr) return hist;
+  
+  if(fCutFlow || fAdaptive || fEventMasks || fSimulation!=nullptr){
+    hist = (TH2D*)FillSingle(index, SFDrawCommands::GetDescriptor(sel_type, ch, refChannel), cut, hname, htitle);
+    AttachInfo(hist, index, {ch, fRefChannel}, SFDrawCommands::GetSelectionName(sel_type), cut);
+    CacheProduct(htitle, inputs, params, hist);
+    return hist;
+  }
+  
+  TFile *file = new TFile(GetResultsFile(index), "READ");
+  TString tname = std::string("tree_ft");
+  TTree *tree = (TTree*)file->Get(tname);
+  
+  gUnique+=1;
+  TString selection = SFDrawCommands::GetSelection(sel_type, gUnique, ch, refChannel);
+  AttachDerived(tree, index, selection + " " + cut);
+  tree->Draw(selection, cut, "colz");
+  hist = (TH2D*)gROOT->FindObjectAny(Form("htemp%.i", gUnique));
+  hist->SetName(hname);
+  hist->SetTitle(htitle);
+  
+  AttachInfo(hist, index, {ch, fRefChannel}, SFDrawCommands::GetSelectionName(sel_type), cut);
+  CacheProduct(htitle, inputs, params, hist);
+  
+  return hist;
+}
+//------------------------------------------------------------------
+/// Returns single requested 2D correlation histogram for the chosen 
+/// pair of channels.
+/// \param sel_type - predefined selection type (see SFDrawCommands)
+/// \param cut - cut for drawn events. Also TTree-style syntax
+/// \param ID - ID of requested measurement
+/// \param chL - channel number of the left end of the fiber
+/// \param chR - channel number of the right end of the fiber
+TH2D* SFData::GetCorrHistogram(SFSelectionType sel_type, TString cut, int ID, int chL, int chR){
+  
+  int index = SFTools::GetIndex(fMeasureID, ID);
+  double position = fPositions[index];
+  TString fname = GetInputName(index);
+  TString hname = Form("S%i_pos%.1f_ID%i_", fSeriesNo, position, ID) + SFDrawCommands::GetSelectionName(sel_type);
+  if(chL!=0 || chR!=1) hname += Form("_ch%i_ch%i", chL, chR);
+  TString htitle = hname + " " + cut;
+  
+  std::vector <TString> inputs = {fname};
+  TString params = SFDrawCommands::GetSelection(sel_type, 0, chL, chR) + " " + cut;
+  TH2D *hist = (TH2D*)GetCachedProduct(htitle, inputs, params);
+  if(hist!=nullptr) return hist;
+  
+  if(fCutFlow || fAdaptive || fEventMasks || fSimulation!=nullptr){
+    hist = (TH2D*)FillSingle(index, SFDrawCommands::GetDescriptor(sel_type, chL, chR), cut, hname, htitle);
+    AttachInfo(hist, index, {chL, chR}, SFDrawCommands::GetSelectionName(sel_type), cut);
+    CacheProduct(htitle, inputs, params, hist);
+    return hist;
+  }
+  
+  TFile *file = new TFile(GetResultsFile(index), "READ");
+  TString tname = std::string("tree_ft");
+  TTree *tree = (TTree*)file->Get(tname);
+  
+  gUnique+=1;
+  TString selection = SFDrawCommands::GetSelection(sel_type, gUnique, chL, chR);
+  AttachDerived(tree, index, selection + " " + cut);
+  tree->Draw(selection, cut, "colz");
+  hist = (TH2D*)gROOT->FindObjectAny(Form("htemp%.i", gUnique));
+  hist->SetName(hname);
+  hist->SetTitle(htitle);
+  
+  AttachInfo(hist, index, {chL, chR}, SFDrawCommands::GetSelectionName(sel_type), cut);
+  CacheProduct(htitle, inputs, params, hist);
+  
+  return hist;
+}
+//------------------------------------------------------------------
+/// Returns a vector of requested 2D correlation histograms for all measurements in 
+/// this series.
+/// \param sel_type - predefined selection type (see SFDrawCommands)
+/// \param cut - cut for drawn events. Also TTree-style syntax.
+std::vector <TH2D*> SFData::GetCorrHistograms(SFSelectionType sel_type, TString cut, int ch){
+  
+    std::vector <TH2D*> hists;
+  for(int i=0; i<fNpoints; i++){
+    hists.push_back(GetCorrHistogram(sel_type, cut, fMeasureID[i], ch));
+  }
+  
+  return hists;
+}
+//------------------------------------------------------------------
+/// Returns averaged signal.
+/// \param ch - channel number 
+/// \param ID - ID of requested measurement
+/// \param cut - logic cut to choose signals. Syntax of this cut is explained 
+/// in InterpretCut() function
+/// \param number - number of signals to be averaged
+/// \param bl - flag for base line subtraction. If true - base line will be subtracted, 
+/// if false - it won't
+///
+/// If no cut is required pass an empty string.
+/// This function calls separate methods to access binary files depending on the test bench type.
+TProfile* SFData::GetSignalAverage(int ch, int ID, TString cut, int number, bool bl){
+
+  TProfile *sig = nullptr;
+  
+  int index = SFTools::GetIndex(fMeasureID, ID);
+  TString fname = GetResultsFile(index);
+  TString key = Form("S%i_ch%i_ID%i_sig_average_num_%i_bl%i", fSeriesNo, ch, ID, number, bl) + TString(" ") + cut;
+  std::vector <TString> inputs = {fname};
+  
+  if(fTestBench=="PL")
+    inputs.push_back(gSystem->DirName(fname) + Form("/wave_%i.dat", ch));
+  else if(fTestBench=="DE")
+    inputs.push_back(gSystem->DirName(fname) + TString("/waves.root"));
+  
+  sig = (TProfile*)GetCachedProduct(key, inputs, key);
+  if(sig!=nullptr) return sig;
+  
+  if(fTestBench=="PL"){
+    sig = GetSignalAverageKrakow(ch, ID, cut, number, bl);
+  }
+  else if(fTestBench=="DE"){
+    sig = GetSignalAverageAachen(ch, ID, cut, number);    
+  }
+  else if(fTestBench=="Simulation"){
+    sig = GetSignalAverageSimulation(ch, ID, cut, number, bl);
+  }
+  else{
+    std::cerr << "##### Error in SFData::GetSignalAverage()!" << std::endl;
+    std::cerr << "Unknown data format!" << std::endl;
+    std::abort();
+  }
+  
+  AttachInfo(sig, index, {ch}, "SignalAverage", cut);
+  CacheProduct(key, inputs, key, sig);
+
+  return sig;
+}
+//------------------------------------------------------------------
+/// Returns averaged signals for a set of requests, each defined by channel,
+/// PE window and number of signals (see SFSignalRequest). All requests of 
+/// the measurement are served by a single scan of the tree (see 
+/// FillSignalAverages()), instead of one scan per GetSignalAverage() call.
+/// Selection of the signals and naming of the returned histograms are the
+/// same as in GetSignalAverage() with cut "ch_N.fPE>min && ch_N.fPE<max".
+/// Window edges are written in the cut with full precision (%.17g), so that
+/// the cut, title and cache key of the incremental mode always match the
+/// selection, also for very narrow windows.
+/// \param requests - requested averaged signals
+/// \param ID - ID of requested measurement
+/// \param bl - flag for base line subtraction. If true - base line will be subtracted, 
+/// if false - it won't
+std::vector <TProfile*> SFData::GetSignalAverages(std::vector <SFSignalRequest> requests, 
+                                                  int ID, bool bl){
+  
+  if(fTestBench!="PL" && fTestBench!="DE" && fTestBench!="Simulation"){
+    std::cerr << "##### Error in SFData::GetSignalAverages()!" << std::endl;
     std::cerr << "Unknown data format!" << std::endl;
     std::abort();
   }
-
-  return sig;
+  
+  int index = SFTools::GetIndex(fMeasureID, ID);
+  TString fname = GetResultsFile(index);
+  
+  int nreq = requests.size();
+  std::vector <TProfile*>        profiles(nreq, nullptr);
+  std::vector <TString>          cuts(nreq);
+  std::vector <TString>          keys(nreq);
+  std::vector <std::vector <TString>> inputs(nreq);
+  std::vector <SFSignalRequest>  missingRequests;
+  std::vector <TProfile*>        missingProfiles;
+  
+  //----- taking signals from the cache and booking remaining ones
+  for(int r=0; r<nreq; r++){
+    int ch = requests[r].fChannel;
+    cuts[r] = Form("ch_%i.fPE>%.17g && ch_%i.fPE<%.17g", ch, requests[r].fPEmin, 
+                   ch, requests[r].fPEmax);
+    keys[r] = Form("S%i_ch%i_ID%i_sig_average_num_%i_bl%i", fSeriesNo, ch, ID, 
+                   requests[r].fNumber, bl) + TString(" ") + cuts[r];
+    inputs[r] = {fname};
+    
+    if(fTestBench=="PL")
+      inputs[r].push_back(gSystem->DirName(fname) + Form("/wave_%i.dat", ch));
+    else if(fTestBench=="DE")
+      inputs[r].push_back(gSystem->DirName(fname) + TString("/waves.root"));
+    
+    profiles[r] = (TProfile*)GetCachedProduct(keys[r], inputs[r], keys[r]);
+    if(profiles[r]!=nullptr) continue;
+    
+    profiles[r] = new TProfile(Form("sig_profile_%i", r), "sig_profile", 1024, 0, 1024, "");
+    profiles[r]->SetDirectory(nullptr);
+    missingRequests.push_back(requests[r]);
+    missingProfiles.push_back(profiles[r]);
+  }
+  
+  if(missingRequests.empty())
+    return profiles;
+  
+  FillSignalAverages(ID, missingRequests, missingProfiles, bl);
+  
+  for(int r=0; r<nreq; r++){
+    if(std::find(missingProfiles.begin(), missingProfiles.end(), profiles[r])==missingProfiles.end()) continue;
+    TString hname = profiles[r]->GetName();
+    profiles[r]->SetTitle(hname + " " + cuts[r]);
+    AttachInfo(profiles[r], index, {requests[r].fChannel}, "SignalAverage", cuts[r]);
+    CacheProduct(keys[r], inputs[r], keys[r], profiles[r]);
+  }
+  
+  return profiles;
+}
+//------------------------------------------------------------------
+/// Fills averaged signals of all requests in a single scan of the tree.
+/// In every entry PE of each requested channel is checked against windows
+/// of all its unfinished requests and the waveform is read at most once, 
+/// then it is filled in all profiles it was accepted for. Like in 
+/// GetSignalAverage(), only signals with T0 within 1 ns from T0 of the
+/// first accepted signal are averaged. Scan stops when all requests are
+/// completed. Profiles are renamed with the number of averaged signals.
+/// \param ID - measurement ID
+/// \param requests - requested averaged signals
+/// \param profiles - booked profiles, one per request
+/// \param bl - flag for base line subtraction (not used for the Aachen 
+/// test bench, like in GetSignalAverage())
+void SFData::FillSignalAverages(int ID, const std::vector <SFSignalRequest> &requests,
+                                const std::vector <TProfile*> &profiles, bool bl){
+  
+  int index = SFTools::GetIndex(fMeasureID, ID);
+  double position = fPositions[index];
+  const int ipoints = 1024;
+  float x;
+  
+  //----- requests grouped by channel
+  std::vector <int> channels;
+  std::vector <std::vector <int>> requestsCh;
+  
+  for(size_t r=0; r<requests.size(); r++){
+    int ch = requests[r].fChannel;
+    int c = std::find(channels.begin(), channels.end(), ch) - channels.begin();
+    if(c==(int)channels.size()){
+      channels.push_back(ch);
+      requestsCh.push_back({});
+    }
+    requestsCh[c].push_back(r);
+  }
+  
+  int nch = channels.size();
+  
+  //----- signal tree and waveform sources
+  TTree *tree = GetTree(ID);
+  std::vector <DDSignal*> sig(nch);
+  
+  for(int c=0; c<nch; c++){
+    sig[c] = new DDSignal();
+    tree->SetBranchAddress(Form("ch_%i", channels[c]), &sig[c]);
+  }
+  
+  TString dname = gSystem->DirName(GetResultsFile(index));
+  std::vector <std::ifstream*> input(nch, nullptr);
+  TFile *iFile = nullptr;
+  TTree *iTree = nullptr;
+  std::vector <TVectorT<float>*> iVolt(nch, nullptr);
+  
+  if(fTestBench=="PL"){
+    for(int c=0; c<nch; c++){
+      TString iname = dname + Form("/wave_%i.dat", channels[c]);
+      input[c] = new std::ifstream(iname, std::ios::binary);
+      if(! input[c]->is_open()){ 
+        std::cerr << "##### Error in SFData::FillSignalAverages()! Cannot open binary file!" << std::endl;
+        std::cerr << iname << std::endl;
+        std::abort();
+      }
+    }
+  }
+  else if(fTestBench=="DE"){
+    iFile = new TFile(dname + "/waves.root", "READ");
+    iTree = (TTree*)iFile->Get("wavetree");
+    iTree->SetBranchStatus("*", 0);
+    for(int c=0; c<nch; c++){
+      TString bname = Form("voltages_ch_%i", channels[c]);
+      iVolt[c] = new TVectorT<float>(ipoints);
+      iTree->SetBranchStatus(bname, 1);
+      iTree->SetBranchAddress(bname, &iVolt[c]);
+    }
+  }
+  
+  //----- single scan
+  int nreq = requests.size();
+  std::vector <int>    counter(nreq, 0);
+  std::vector <bool>   done(nreq, false);
+  std::vector <double> firstT0(nreq, 0.);
+  std::vector <int>    accepted;
+  std::vector <double> waveform(ipoints);
+  int nentries = tree->GetEntries();
+  int ndone = 0;
+  bool waveLoaded = false;
+  
+  for(int i=0; i<nentries && ndone<nreq; i++){
+    tree->GetEntry(i);
+    waveLoaded = false;
+    
+    for(int c=0; c<nch; c++){
+      double pe = sig[c]->GetPE();
+      double t0 = sig[c]->GetT0();
+      accepted.clear();
+      
+      for(int r : requestsCh[c]){
+        if(done[r] || pe<=requests[r].fPEmin || pe>=requests[r].fPEmax) continue;
+        if(fabs(firstT0[r])<1E-10) firstT0[r] = t0;
+        if(fabs(t0-firstT0[r])<1) accepted.push_back(r);
+      }
+      
+      if(accepted.empty()) continue;
+      
+      //----- reading waveform once for all accepting requests
+      if(fTestBench=="PL"){
+        long long infile = (long long)sizeof(x)*ipoints*i;
+        double baseline = 0.;
+        input[c]->seekg(infile);
+        for(int ii=0; ii<ipoints; ii++){
+          input[c]->read(reinterpret_cast<char*>(&x), sizeof(float));
+          waveform[ii] = x/gmV;
+          if(ii<gBaselineMax) baseline += waveform[ii];
+        }
+        if(bl){
+          baseline = baseline/gBaselineMax;
+          for(int ii=0; ii<ipoints; ii++)
+            waveform[ii] -= baseline;
+        }
+      }
+      else if(fTestBench=="DE"){
+        if(!waveLoaded){
+          iTree->GetEntry(i);
+          waveLoaded = true;
+        }
+        for(int ii=0; ii<ipoints; ii++)
+          waveform[ii] = (*iVolt[c])[ii];
+      }
+      else{
+        waveform = fSimulation->GetWaveform(ID, i, channels[c], pe, t0, bl);
+      }
+      
+      int offset = (fTestBench=="DE") ? 1 : 0;
+      
+      for(int r : accepted){
+        for(int ii=0; ii<ipoints; ii++)
+          profiles[r]->Fill(ii+offset, waveform[ii]);
+        if(counter[r]<requests[r].fNumber) counter[r]++;
+        else{ 
+          done[r] = true;
+          ndone++;
+        }
+      }
+    }
+  }
+  
+  //----- naming and clean up
+  for(int r=0; r<nreq; r++){
+    int ch = requests[r].fChannel;
+    profiles[r]->SetName(Form("S%i_ch%i_pos_%.1f_ID%i_sig_num_%i", fSeriesNo, ch, position, ID, counter[r]));
+    
+    if(counter[r]<requests[r].fNumber){ 
+      std::cout << "##### Warning in SFData::GetSignalAverages()! " << counter[r]
+                << " out of " << requests[r].fNumber << " plotted." << std::endl;
+      std::cout << "Position: " << position << "\t channel: " << ch << std::endl; 
+    }
+  }
+  
+  tree->ResetBranchAddresses();
+  
+  for(int c=0; c<nch; c++){
+    delete sig[c];
+    if(input[c]!=nullptr){
+      input[c]->close();
+      delete input[c];
+    }
+  }
+  
+  if(iFile!=nullptr){
+    iTree->ResetBranchAddresses();
+    for(int c=0; c<nch; c++)
+      delete iVolt[c];
+    iFile->Close();
+    delete iFile;
+  }
+  
+  return;
 }
 //------------------------------------------------------------------
 /// This private function allows to access averaged signals recorded 
@@ -727,6 +2146,9 @@ TH1D* SFData::GetSignal(int ch, int ID, TString cut, int number, bool bl){
   else if(fTestBench=="DE"){
     sig = GetSignalAachen(ch, ID, cut, number);
   }
+  else if(fTestBench=="Simulation"){
+    sig = GetSignalSimulation(ch, ID, cut, number, bl);
+  }
   else{
     std::cerr << "##### Error in SFData::GetSignal()" << std::endl;
     std::cerr << "Unknown data format!" << std::endl;
@@ -866,6 +2288,539 @@ TH1D* SFData::GetSignalAachen(int ch, int ID, TString cut, int number){
   return hsig;
 }
 //------------------------------------------------------------------
+/// This private function allows to access averaged signals generated
+/// for the "Simulation" test bench. Signals are selected like for the 
+/// experimental data, based on the simulated tree. Waveforms of the 
+/// selected signals are generated on demand (see SFSimulation class).
+/// \param ch - channel number
+/// \param ID - measuement ID
+/// \param cut - logic cut to choose signals (syntax explained in InterpretCutt()
+/// \param number - number of signals to be averaged
+/// \param bl - flag for base line subtraction - if true baseline will be 
+/// subtracted, if false - it will not.
+TProfile* SFData::GetSignalAverageSimulation(int ch, int ID, TString cut, int number, bool bl){
+  
+  int index = SFTools::GetIndex(fMeasureID, ID);
+  double position = fPositions[index];
+  const int ipoints = 1024;
+  
+  TTree *tree = GetTree(ID);
+  DDSignal *sig = new DDSignal();
+  tree->SetBranchAddress(Form("ch_%i", ch), &sig);
+  
+  TString hname = "sig_profile";
+  TString htitle = "sig_profile";
+  TProfile *psig = new TProfile(hname, htitle, ipoints, 0, ipoints, "");
+  
+  int nentries = tree->GetEntries();
+  int counter = 0;
+  bool condition = true;
+  double firstT0 = 0.;
+  std::vector <double> waveform;
+  
+  for(int i=0; i<nentries; i++){
+   tree->GetEntry(i);
+   condition = InterpretCut(sig, cut);
+   if(condition && fabs(firstT0)<1E-10) firstT0 = sig->GetT0();
+   if(condition && fabs(sig->GetT0()-firstT0)<1){
+     waveform = fSimulation->GetWaveform(ID, i, ch, sig->GetPE(), sig->GetT0(), bl);
+     for(int ii=0; ii<ipoints; ii++){
+       psig->Fill(ii, waveform[ii]);
+     }
+     if(counter<number) counter++;
+     else break;
+    }
+  }
+  
+  hname = Form("S%i_ch%i_pos_%.1f_ID%i_sig_num_%i", fSeriesNo, ch, position, ID, counter);
+  htitle = hname + " " + cut;
+  psig->SetName(hname);
+  psig->SetTitle(htitle);
+  
+  if(counter<number){ 
+    std::cout << "##### Warning in SFData::GetSignalAverage()! " << counter 
+              << " out of " << number << " plotted." << std::endl;
+    std::cout << "Position: " << position << "\t channel: " << ch << std::endl; 
+  }
+  
+  return psig;
+}
+//------------------------------------------------------------------
+/// This private function allows to access single signals generated 
+/// for the "Simulation" test bench (see SFSimulation class).
+/// \param ch - channel number
+/// \param ID - measuement ID
+/// \param cut - logic cut to choose signals (syntax explained in InterpretCutt()
+/// \param number - number of the signal to be drawn
+/// \param bl - flag for base line subtraction - if true baseline will be 
+/// subtracted, if false - it will not.
+TH1D* SFData::GetSignalSimulation(int ch, int ID, TString cut, int number, bool bl){
+  
+  int index = SFTools::GetIndex(fMeasureID, ID);
+  double position = fPositions[index];
+  const int ipoints = 1024;
+  
+  TTree *tree = GetTree(ID);
+  DDSignal *sig = new DDSignal();
+  tree->SetBranchAddress(Form("ch_%i", ch), &sig);
+  
+  TString hname = Form("S%i_ch%i_pos_%.1f_ID%i_sig_no%i", fSeriesNo, ch, position, ID, number);
+  TString htitle = hname + " " + cut;
+  
+  TH1D *hsig = new TH1D(hname, htitle, ipoints, 0, ipoints);
+  
+  int nentries = tree->GetEntries();
+  int counter = 0;
+  bool condition = true;
+  std::vector <double> waveform;
+  
+  for(int i=0; i<nentries; i++){
+    tree->GetEntry(i);
+    condition = InterpretCut(sig, cut);
+    if(condition){
+      counter++;
+      if(counter!=number) continue;
+      waveform = fSimulation->GetWaveform(ID, i, ch, sig->GetPE(), sig->GetT0(), bl);
+      for(int ii=0; ii<ipoints; ii++){
+        hsig->SetBinContent(ii+1, waveform[ii]);
+      }
+      break;
+    }
+  }
+  
+  return hsig;
+}
+//------------------------------------------------------------------
+/// Returns path to the ROOT file containing tree with the data of 
+/// the requested measurement. For the "Simulation" test bench file
+/// with simulated data is returned, it is generated if necessary.
+/// \param index - index of the measurement in the series
+TString SFData::GetResultsFile(int index){
+  
+  if(fSimulation!=nullptr)
+    return fSimulation->GetResultsFile(fMeasureID[index], fPositions[index]);
+  
+  return SFTools::FindData(fNames[index]) + "/results.root";
+}
+//------------------------------------------------------------------
+/// Returns name identifying data of the requested measurement, used as
+/// input of cached products (see GetCachedProduct()). It is the same
+/// as GetResultsFile(), except for the "Simulation" test bench, where
+/// the simulated measurement is identified without generating the file
+/// (see SFSimulation::GetSourceName()).
+/// \param index - index of the measurement in the series
+TString SFData::GetInputName(int index){
+  
+  if(fSimulation!=nullptr)
+    return fSimulation->GetSourceName(fMeasureID[index], fPositions[index]);
+  
+  return GetResultsFile(index);
+}
+//------------------------------------------------------------------
+/// Returns name of the ROOT file containing tree "tree_derived" for the 
+/// requested measurement. The tree has the same number of entries as 
+/// "tree_ft" and contains quantities combining both ends of every fiber 
+/// (see class description), calculated once per measurement. The file
+/// is created in the cache directory (or in the temporary directory if
+/// the incremental mode is off) if it doesn't exist yet. Its name contains 
+/// fingerprint of the input file, source position, fiber length and 
+/// attenuation length, so that it is recreated whenever any of them changes.
+/// Quantities are calculated with the semantics of TTree formulas (see 
+/// SFFormula), e.g. logarithm of the non-positive number is stored as 0.
+/// Attenuation-corrected PE is stored only if the attenuation length of
+/// the series is known.
+/// Derived quantities are defined only for pairs of channels, so for 
+/// series with less than two channels error is printed and execution aborted.
+/// \param index - index of the measurement in the series
+TString SFData::GetDerivedFile(int index){
+  
+  int npairs = fNchannels/2;
+  
+  if(npairs<1){
+    std::cerr << "##### Error in SFData::GetDerivedFile()!" << std::endl;
+    std::cerr << "Derived quantities require pair of channels, series " << fSeriesNo 
+              << " has " << fNchannels << " channel(s)!" << std::endl;
+    std::abort();
+  }
+  
+  TString fname = GetResultsFile(index);
+  TString params = Form("derived v2 %i %.3f %.3f %.6f", fNchannels, fPositions[index], 
+                        fFiberLength, fAttLength);
+  TString fingerprint = SFManifest::Fingerprint({fname}, params);
+  TString directory = fIncremental ? fCacheDir : TString(gSystem->TempDirectory());
+  TString dname = directory + Form("/derived_S%i_ID%i_", fSeriesNo, fMeasureID[index]) 
+                  + fingerprint + ".root";
+  
+  if(!gSystem->AccessPathName(dname))
+    return dname;
+  
+  TDirectory *dir = gDirectory;
+  
+  TFile *file = new TFile(fname, "READ");
+  TTree *tree = (TTree*)file->Get("tree_ft");
+  
+  if(tree==nullptr){
+    std::cerr << "##### Error in SFData::GetDerivedFile()!" << std::endl;
+    std::cerr << "Requested tree doesn't exist!" << std::endl;
+    std::abort();
+  }
+  
+  std::vector <DDSignal*> sig(2*npairs, nullptr);
+  
+  for(int ch=0; ch<2*npairs; ch++){
+    sig[ch] = new DDSignal();
+    tree->SetBranchAddress(Form("ch_%i", ch), &sig[ch]);
+  }
+  
+  TString tmpname = dname + Form(".%i.tmp", gSystem->GetPid());
+  TFile *dfile = new TFile(tmpname, "RECREATE");
+  
+  if(!dfile->IsOpen() || dfile->IsZombie()){
+    std::cerr << "##### Error in SFData::GetDerivedFile()! Cannot create file!" << std::endl;
+    std::cerr << tmpname << std::endl;
+    std::abort();
+  }
+  
+  std::vector <double> lnMLR(npairs), peAverage(npairs), t0Diff(npairs), peAttCorr(npairs);
+  
+  TTree *dtree = new TTree("tree_derived", "tree_derived");
+  dtree->Branch("fLnMLR", lnMLR.data(), Form("fLnMLR[%i]/D", npairs));
+  dtree->Branch("fPEAverage", peAverage.data(), Form("fPEAverage[%i]/D", npairs));
+  dtree->Branch("fT0Diff", t0Diff.data(), Form("fT0Diff[%i]/D", npairs));
+  if(fAttLength>0)
+    dtree->Branch("fPEAttCorr", peAttCorr.data(), Form("fPEAttCorr[%i]/D", npairs));
+  
+  double corrL = fAttLength>0 ? exp(fPositions[index]/fAttLength) : 0;
+  double corrR = fAttLength>0 ? exp((fFiberLength-fPositions[index])/fAttLength) : 0;
+  double peL, peR;
+  
+  Long64_t nentries = tree->GetEntries();
+  
+  for(Long64_t i=0; i<nentries; i++){
+    tree->GetEntry(i);
+    for(int k=0; k<npairs; k++){
+      peL = sig[2*k]->GetPE();
+      peR = sig[2*k+1]->GetPE();
+      lnMLR[k]     = SFFormula::Log(SFFormula::Sqrt(SFFormula::Divide(peR, peL)));
+      peAverage[k] = SFFormula::Sqrt(peL*peR);
+      t0Diff[k]    = sig[2*k]->GetT0() - sig[2*k+1]->GetT0();
+      peAttCorr[k] = peL*corrL + peR*corrR;
+    }
+    dtree->Fill();
+  }
+  
+  dfile->cd();
+  dtree->Write();
+  dfile->Close();
+  delete dfile;
+  
+  file->Close();
+  delete file;
+  
+  for(int ch=0; ch<2*npairs; ch++)
+    delete sig[ch];
+  
+  dir->cd();
+  
+  gSystem->Rename(tmpname, dname);
+  
+  return dname;
+}
+//------------------------------------------------------------------
+/// Attaches metadata record to the histogram of the measurement (see 
+/// SFSpectrumInfo class), so it can be consumed without parsing the 
+/// histogram name or opening the data base.
+/// \param hist - histogram
+/// \param index - index of the measurement in the series
+/// \param channels - channels used by the selection
+/// \param selection - selection name
+/// \param cut - cut
+void SFData::AttachInfo(TH1 *hist, int index, std::vector <int> channels, 
+                        TString selection, TString cut){
+  
+  if(hist==nullptr)
+    return;
+  
+  TString fname = fSimulation!=nullptr ? 
+                  fSimulation->GetFileName(fMeasureID[index], fPositions[index]) :
+                  GetResultsFile(index);
+  
+  SFSpectrumInfo *info = new SFSpectrumInfo(fSeriesNo, fMeasureID[index], channels, 
+                                            fPositions[index], selection, cut,
+                                            gSystem->DirName(fname), fCollimator);
+  info->Attach(hist);
+  
+  return;
+}
+//------------------------------------------------------------------
+/// Checks whether selection or cut refers to quantities stored in the 
+/// derived tree.
+/// \param expression - selection and/or cut
+bool SFData::UsesDerived(TString expression){
+  
+  return expression.Contains("fLnMLR") || expression.Contains("fPEAverage") ||
+         expression.Contains("fT0Diff") || expression.Contains("fPEAttCorr");
+}
+//------------------------------------------------------------------
+/// Checks whether attenuation length needed by the expression is known.
+/// If the expression refers to the attenuation-corrected PE and the 
+/// attenuation length is not set, error is printed and execution aborted
+/// (see SetResultsDatabase() and SetAttenuationLength()).
+/// \param expression - selection and/or cut
+void SFData::CheckAttenuation(TString expression){
+  
+  if(!expression.Contains("fPEAttCorr") || fAttLength>0)
+    return;
+  
+  std::cerr << "##### Error in SFData::CheckAttenuation()!" << std::endl;
+  std::cerr << "Attenuation length of series " << fSeriesNo << " is unknown!" << std::endl;
+  std::cerr << "Run attenuation analysis first or set it with SetAttenuationLength()!" << std::endl;
+  std::abort();
+}
+//------------------------------------------------------------------
+/// Attaches derived tree as a friend of the given tree, if the expression
+/// refers to derived quantities.
+/// \param tree - tree "tree_ft" of the measurement
+/// \param index - index of the measurement in the series
+/// \param expression - selection and/or cut
+void SFData::AttachDerived(TTree *tree, int index, TString expression){
+  
+  if(!UsesDerived(expression))
+    return;
+  
+  CheckAttenuation(expression);
+  
+  tree->AddFriend("tree_derived", GetDerivedFile(index));
+}
+//------------------------------------------------------------------
+/// Returns event mask of the cut for the requested measurement, i.e. set 
+/// of entries passing the cut (see SFEventMask class). Cut is split into 
+/// conditions joined with top-level "||" and "&&". Conditions not evaluated 
+/// yet are evaluated in one parallel pass over the data, each with its own 
+/// TTreeFormula, and masks of the cut and of its parts are composed with 
+/// And() and Or(). Masks are identified by normalized cuts, i.e. without 
+/// white spaces and enclosing parentheses, thus the same cut written 
+/// differently is evaluated only once. In the incremental mode masks of 
+/// the conditions are cached. Returned mask is owned by SFData and must 
+/// not be deleted (see ClearEventMasks()). For empty cut nullptr is returned.
+/// \param cut - logic cut (syntax like for Draw() method of TTree)
+/// \param ID - ID of requested measurement
+SFEventMask* SFData::GetEventMask(TString cut, int ID){
+  
+  int index = SFTools::GetIndex(fMeasureID, ID);
+  return GetMask(index, cut);
+}
+//------------------------------------------------------------------
+/// Returns cut without white spaces and without parentheses enclosing
+/// the whole cut.
+/// \param cut - logic cut
+TString SFData::NormalizeCut(TString cut){
+  
+  cut.ReplaceAll(" ", "");
+  cut.ReplaceAll("\t", "");
+  
+  while(cut.BeginsWith("(") && cut.EndsWith(")")){
+    int  depth = 0;
+    bool enclosing = true;
+    for(int i=0; i<cut.Length()-1; i++){
+      if(cut[i]=='(') depth++;
+      if(cut[i]==')') depth--;
+      if(depth==0){
+        enclosing = false;
+        break;
+      }
+    }
+    if(!enclosing) break;
+    cut = cut(1, cut.Length()-2);
+  }
+  
+  return cut;
+}
+//------------------------------------------------------------------
+/// Collects distinct atomic conditions of the cut, i.e. parts which can't
+/// be split further with top-level "||" and "&&".
+/// \param cut - logic cut
+/// \param conds - vector of collected conditions
+void SFData::CollectConditions(TString cut, std::vector <TString> &conds){
+  
+  cut = NormalizeCut(cut);
+  
+  std::vector <TString> parts = SFCutFlow::SplitCut(cut, "||");
+  if(parts.size()<2)
+    parts = SFCutFlow::SplitCut(cut, "&&");
+  
+  if(parts.size()>1){
+    for(size_t i=0; i<parts.size(); i++)
+      CollectConditions(parts[i], conds);
+    return;
+  }
+  
+  if(cut!="" && std::find(conds.begin(), conds.end(), cut)==conds.end())
+    conds.push_back(cut);
+  
+  return;
+}
+//------------------------------------------------------------------
+/// Returns key of the event mask: results file of the measurement and 
+/// normalized cut. If the cut uses derived quantities attenuation length
+/// is added, like for the cached products.
+/// \param index - index of the measurement in the series
+/// \param cut - normalized cut
+TString SFData::GetMaskKey(int index, TString cut){
+  
+  TString key = GetResultsFile(index) + " | " + cut;
+  
+  if(UsesDerived(cut))
+    key += Form(" att=%.6f", fAttLength);
+  
+  return key;
+}
+//------------------------------------------------------------------
+/// Returns event mask of the cut, evaluating its missing conditions
+/// (see GetEventMask()).
+/// \param index - index of the measurement in the series
+/// \param cut - logic cut
+SFEventMask* SFData::GetMask(int index, TString cut){
+  
+  cut = NormalizeCut(cut);
+  
+  if(cut=="")
+    return nullptr;
+  
+  auto it = fMasks.find(GetMaskKey(index, cut));
+  if(it!=fMasks.end())
+    return it->second;
+  
+  std::vector <TString> conds;
+  CollectConditions(cut, conds);
+  EvaluateConditions(index, conds);
+  
+  return ComposeMask(index, cut);
+}
+//------------------------------------------------------------------
+/// Evaluates masks of the atomic conditions, which are neither stored
+/// nor cached yet. Entries are divided into chunks processed in parallel,
+/// each chunk evaluates all conditions in one loop and fills its own masks,
+/// which are merged at the end.
+/// \param index - index of the measurement in the series
+/// \param conds - normalized atomic conditions
+void SFData::EvaluateConditions(int index, const std::vector <TString> &conds){
+  
+  TString fname = GetResultsFile(index);
+  TString key = Form("S%i_ID%i_mask", fSeriesNo, fMeasureID[index]);
+  std::vector <TString> inputs = {fname};
+  std::vector <TString> missing;
+  TString dname = "";
+  
+  for(size_t k=0; k<conds.size(); k++){
+    if(fMasks.find(GetMaskKey(index, conds[k]))!=fMasks.end()) continue;
+    SFEventMask *mask = (SFEventMask*)GetCachedProduct(key, inputs, conds[k]);
+    if(mask!=nullptr){
+      fMasks[GetMaskKey(index, conds[k])] = mask;
+      continue;
+    }
+    missing.push_back(conds[k]);
+    CheckAttenuation(conds[k]);
+    if(dname=="" && UsesDerived(conds[k]))
+      dname = GetDerivedFile(index);
+  }
+  
+  if(missing.empty())
+    return;
+  
+  int nchunks = SFTools::GetNThreads();
+  std::vector <std::vector <SFEventMask*>> partial(nchunks);
+  
+  SFTools::ParallelFor(nchunks, [&](int c){
+    
+    TFile file(fname, "READ");
+    TTree *tree = (TTree*)file.Get("tree_ft");
+    
+    if(tree==nullptr){
+      std::cerr << "##### Error in SFData::EvaluateConditions()!" << std::endl;
+      std::cerr << "Requested tree doesn't exist!" << std::endl;
+      std::abort();
+    }
+    
+    if(dname!="") tree->AddFriend("tree_derived", dname);
+    
+    Long64_t nentries = tree->GetEntries();
+    Long64_t first = nentries*c/nchunks;
+    Long64_t last  = nentries*(c+1)/nchunks;
+    std::vector <TTreeFormula*> formulas;
+    
+    for(size_t k=0; k<missing.size(); k++){
+      formulas.push_back(new TTreeFormula(Form("mask_%i_%i", c, (int)k), missing[k], tree));
+      partial[c].push_back(new SFEventMask(nentries));
+    }
+    
+    for(Long64_t entry=first; entry<last; entry++){
+      tree->LoadTree(entry);
+      for(size_t k=0; k<formulas.size(); k++){
+        formulas[k]->GetNdata();
+        if(formulas[k]->EvalInstance()!=0) partial[c][k]->Add(entry);
+      }
+    }
+    
+    for(size_t k=0; k<formulas.size(); k++)
+      delete formulas[k];
+    
+    file.Close();
+  });
+  
+  for(size_t k=0; k<missing.size(); k++){
+    SFEventMask *mask = partial[0][k];
+    for(int c=1; c<nchunks; c++){
+      *mask = mask->Or(*partial[c][k]);
+      delete partial[c][k];
+    }
+    fMasks[GetMaskKey(index, missing[k])] = mask;
+    CacheProduct(key, inputs, missing[k], mask);
+  }
+  
+  return;
+}
+//------------------------------------------------------------------
+/// Composes event mask of the cut from the masks of its parts with 
+/// Or() and And(), following top-level "||" and "&&" of the cut. Masks of
+/// composed parts are stored too, so they can be reused by other cuts.
+/// \param index - index of the measurement in the series
+/// \param cut - logic cut, its atomic conditions must be evaluated already
+SFEventMask* SFData::ComposeMask(int index, TString cut){
+  
+  cut = NormalizeCut(cut);
+  TString key = GetMaskKey(index, cut);
+  
+  auto it = fMasks.find(key);
+  if(it!=fMasks.end())
+    return it->second;
+  
+  bool isOr = true;
+  std::vector <TString> parts = SFCutFlow::SplitCut(cut, "||");
+  
+  if(parts.size()<2){
+    isOr = false;
+    parts = SFCutFlow::SplitCut(cut, "&&");
+  }
+  
+  if(parts.size()<2){
+    std::cerr << "##### Error in SFData::ComposeMask()!" << std::endl;
+    std::cerr << "Condition not evaluated: " << cut << std::endl;
+    std::abort();
+  }
+  
+  SFEventMask *mask = new SFEventMask(*ComposeMask(index, parts[0]));
+  
+  for(size_t i=1; i<parts.size(); i++){
+    SFEventMask *part = ComposeMask(index, parts[i]);
+    *mask = isOr ? mask->Or(*part) : mask->And(*part);
+  }
+  
+  fMasks[key] = mask;
+  
+  return mask;
+}
+//------------------------------------------------------------------
 /// Prints details of currently analyzed experimental series.
 void SFData::Print(void){
  std::cout << "\n\n------------------------------------------------" << std::endl;
@@ -875,6 +2830,9 @@ void SFData::Print(void){
  std::cout << "Collimator: " << fCollimator << std::endl;
  std::cout << "Test bench: " << fTestBench << std::endl;
  std::cout << "Number of measurements in this series: " << fNpoints << std::endl;
+ std::cout << "Number of readout channels: " << fNchannels << std::endl;
+ if(fAttLength>0)
+   std::cout << "Attenuation length: " << fAttLength << " mm" << std::endl;
  std::cout << "Fiber: " << fFiber << std::endl;
  std::cout << "Fiber length: " << fFiberLength << " mm" << std::endl;
  std::cout << "Coupling: " << fCoupling << std::endl;
@@ -889,6 +2847,10 @@ void SFData::Print(void){
             << "\t\t" << Form("%i s", fTimes[i]) << "\t\t" << fStart[i]
             << "\t\t" << fStop[i] << "\t\t" << fMeasureID[i] << std::endl; 
  }
+ if(fSimulation!=nullptr)
+  fSimulation->Print();
+ if(fManifest!=nullptr)
+  std::cout << "Incremental mode on, cache directory: " << fCacheDir << std::endl;
  std::cout << "\n" << std::endl;
 }
 //------------------------------------------------------------------
@@ -0,0 +1,489 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *           SFDecayFitter.cc            *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#include "SFDecayFitter.hh"
+
+//------------------------------------------------------------------
+/// Default constructor.
+SFDecayFitter::SFDecayFitter() : fT0(0),
+                                 fChi2(-1),
+                                 fNiter(0) {
+}
+//------------------------------------------------------------------
+/// Default destructor.
+SFDecayFitter::~SFDecayFitter(){
+}
+//------------------------------------------------------------------
+/// Sets data points of the fit, i.e. bins of the signal with centers
+/// in the given range. Empty bins (with zero error) are skipped, like
+/// in TH1::Fit(). Returns number of data points.
+/// \param signal - averaged signal
+/// \param xmin - lower limit of the fitting range
+/// \param xmax - upper limit of the fitting range
+/// \param t0 - fixed t0 of the model
+/// \param baseline - fixed constant of the model
+int SFDecayFitter::SetData(TProfile *signal, double xmin, double xmax,
+                           double t0, double baseline){
+
+  fX.clear();
+  fY.clear();
+  fW.clear();
+  fT0 = t0;
+
+  int nbins = signal->GetNbinsX();
+
+  for(int i=1; i<=nbins; i++){
+    double x = signal->GetBinCenter(i);
+    double err = signal->GetBinError(i);
+    if(x<xmin || x>xmax || err<=0) continue;
+    fX.push_back(x);
+    fY.push_back(signal->GetBinContent(i)-baseline);
+    fW.push_back(1./err);
+  }
+
+  return fX.size();
+}
+//------------------------------------------------------------------
+/// Solves linear system A*x = b with Gaussian elimination with partial
+/// pivoting. Solution is returned in b, A is overwritten. Returns false
+/// if the matrix is singular.
+/// \param n - size of the system
+/// \param A - matrix, n*n elements, row-major
+/// \param b - right hand side, n elements
+bool SFDecayFitter::Solve(int n, double *A, double *b){
+
+  double scale = 0;
+  for(int i=0; i<n*n; i++)
+    scale = std::max(scale, std::fabs(A[i]));
+
+  if(scale==0 || !std::isfinite(scale))
+    return false;
+
+  for(int col=0; col<n; col++){
+    int pivot = col;
+    for(int row=col+1; row<n; row++){
+      if(std::fabs(A[row*n+col]) > std::fabs(A[pivot*n+col]))
+        pivot = row;
+    }
+
+    if(std::fabs(A[pivot*n+col]) <= 1E-14*scale)
+      return false;
+
+    if(pivot!=col){
+      for(int k=0; k<n; k++)
+        std::swap(A[col*n+k], A[pivot*n+k]);
+      std::swap(b[col], b[pivot]);
+    }
+
+    for(int row=col+1; row<n; row++){
+      double f = A[row*n+col]/A[col*n+col];
+      for(int k=col; k<n; k++)
+        A[row*n+k] -= f*A[col*n+k];
+      b[row] -= f*b[col];
+    }
+  }
+
+  for(int row=n-1; row>=0; row--){
+    for(int k=row+1; k<n; k++)
+      b[row] -= A[row*n+k]*b[k];
+    b[row] /= A[row*n+row];
+  }
+
+  return true;
+}
+//------------------------------------------------------------------
+/// Variable projection step. For given decay constants calculates the
+/// amplitudes from weighted linear least squares, weighted residuals
+/// and, optionally, Jacobian of the residuals over logarithms of the
+/// decay constants (Kaufman approximation). Returns chi2 or -1 if the
+/// linear problem is singular.
+/// \param tau - decay constants
+/// \param amp - amplitudes (returned)
+/// \param resid - weighted residuals (returned)
+/// \param jac - Jacobian, n*K elements, row-major (returned if not nullptr)
+double SFDecayFitter::Project(const std::vector <double> &tau, std::vector <double> &amp,
+                              std::vector <double> &resid, std::vector <double> *jac){
+
+  const int n = fX.size();
+  const int K = tau.size();
+
+  std::vector <double> phi(n*K);
+  double G[4] = {0};
+  double b[2] = {0};
+
+  //----- weighted basis functions and normal equations
+  for(int i=0; i<n; i++){
+    for(int k=0; k<K; k++)
+      phi[i*K+k] = fW[i]*std::exp(-(fX[i]-fT0)/tau[k]);
+    for(int k=0; k<K; k++){
+      b[k] += phi[i*K+k]*fW[i]*fY[i];
+      for(int l=0; l<K; l++)
+        G[k*K+l] += phi[i*K+k]*phi[i*K+l];
+    }
+  }
+
+  double Gcopy[4];
+  std::copy(G, G+4, Gcopy);
+
+  if(!Solve(K, Gcopy, b))
+    return -1;
+
+  amp.assign(b, b+K);
+  resid.resize(n);
+
+  double chi2 = 0;
+
+  for(int i=0; i<n; i++){
+    double model = 0;
+    for(int k=0; k<K; k++)
+      model += phi[i*K+k]*amp[k];
+    resid[i] = fW[i]*fY[i] - model;
+    chi2 += resid[i]*resid[i];
+  }
+
+  if(jac==nullptr)
+    return chi2;
+
+  //----- Kaufman Jacobian: J_k = -P(D_k), where D_k is the derivative
+  //----- of the model over ln(tau_k) and P is the projection on the
+  //----- orthogonal complement of the basis functions
+  jac->assign(n*K, 0);
+  std::vector <double> D(n);
+
+  for(int k=0; k<K; k++){
+    double c[2] = {0};
+
+    for(int i=0; i<n; i++){
+      D[i] = phi[i*K+k]*amp[k]*(fX[i]-fT0)/tau[k];
+      for(int l=0; l<K; l++)
+        c[l] += phi[i*K+l]*D[i];
+    }
+
+    std::copy(G, G+4, Gcopy);
+    if(!Solve(K, Gcopy, c))
+      return -1;
+
+    for(int i=0; i<n; i++){
+      double proj = 0;
+      for(int l=0; l<K; l++)
+        proj += phi[i*K+l]*c[l];
+      (*jac)[i*K+k] = -(D[i]-proj);
+    }
+  }
+
+  return chi2;
+}
+//------------------------------------------------------------------
+/// Calculates uncertainties of amplitudes and decay constants from the
+/// inverse of J^T*J, where J is the full analytic Jacobian of the weighted
+/// model over all fitted parameters. Returns false if the matrix is singular.
+bool SFDecayFitter::Errors(void){
+
+  const int n = fX.size();
+  const int K = fTau.size();
+  const int m = 2*K;
+
+  double H[16] = {0};
+  double grad[4];
+
+  for(int i=0; i<n; i++){
+    for(int k=0; k<K; k++){
+      double e = fW[i]*std::exp(-(fX[i]-fT0)/fTau[k]);
+      grad[k]   = e;
+      grad[K+k] = fAmp[k]*e*(fX[i]-fT0)/(fTau[k]*fTau[k]);
+    }
+    for(int k=0; k<m; k++){
+      for(int l=0; l<m; l++)
+        H[k*m+l] += grad[k]*grad[l];
+    }
+  }
+
+  fAmpErr.assign(K, 0);
+  fTauErr.assign(K, 0);
+
+  for(int k=0; k<m; k++){
+    double Hcopy[16];
+    double unit[4] = {0};
+    std::copy(H, H+16, Hcopy);
+    unit[k] = 1;
+
+    if(!Solve(m, Hcopy, unit) || unit[k]<0)
+      return false;
+
+    if(k<K) fAmpErr[k]   = std::sqrt(unit[k]);
+    else    fTauErr[k-K] = std::sqrt(unit[k]);
+  }
+
+  return true;
+}
+//------------------------------------------------------------------
+/// Performs the fit with Levenberg-Marquardt iterations in logarithms
+/// of the decay constants, with amplitudes eliminated by Project().
+/// Data must be set with SetData() first. Returns 0 if the fit converged
+/// and uncertainties are valid, 1 if the maximum number of iterations
+/// was reached and -1 if the fit failed.
+/// \param tau - starting values of the decay constants, 1 or 2 elements
+int SFDecayFitter::Fit(std::vector <double> tau){
+
+  const int K = tau.size();
+  const int n = fX.size();
+  const int maxIter = 200;
+
+  fTau = tau;
+  fNiter = 0;
+  fChi2 = -1;
+
+  if(K<1 || K>2 || n<=2*K){
+    std::cerr << "##### Error in SFDecayFitter::Fit()!" << std::endl;
+    std::cerr << "Incorrect number of components or too few data points!" << std::endl;
+    return -1;
+  }
+
+  for(int k=0; k<K; k++){
+    if(tau[k]<=0){
+      std::cerr << "##### Error in SFDecayFitter::Fit()! Decay constants must be positive!" << std::endl;
+      return -1;
+    }
+  }
+
+  std::vector <double> amp, resid, jac;
+  std::vector <double> trialTau(K), trialAmp, trialResid, trialJac;
+
+  double chi2 = Project(tau, amp, resid, &jac);
+  if(chi2<0)
+    return -1;
+
+  double lambda = 1E-3;
+  int status = 1;
+
+  for(fNiter=0; fNiter<maxIter; fNiter++){
+
+    //----- J^T*J and J^T*r
+    double JTJ[4] = {0};
+    double JTr[2] = {0};
+
+    for(int i=0; i<n; i++){
+      for(int k=0; k<K; k++){
+        JTr[k] += jac[i*K+k]*resid[i];
+        for(int l=0; l<K; l++)
+          JTJ[k*K+l] += jac[i*K+k]*jac[i*K+l];
+      }
+    }
+
+    //----- damped step, repeated with larger damping until chi2 decreases
+    bool accepted = false;
+    double maxStep = 0;
+
+    while(lambda<1E10){
+      double A[4];
+      double delta[2];
+
+      std::copy(JTJ, JTJ+4, A);
+      for(int k=0; k<K; k++){
+        A[k*K+k] += lambda*std::max(JTJ[k*K+k], 1E-12);
+        delta[k] = -JTr[k];
+      }
+
+      if(Solve(K, A, delta)){
+        maxStep = 0;
+        for(int k=0; k<K; k++){
+          delta[k] = std::max(-1., std::min(1., delta[k]));
+          trialTau[k] = tau[k]*std::exp(delta[k]);
+          maxStep = std::max(maxStep, std::fabs(delta[k]));
+        }
+
+        double trialChi2 = Project(trialTau, trialAmp, trialResid, &trialJac);
+
+        if(trialChi2>=0 && trialChi2<=chi2){
+          double decrease = chi2-trialChi2;
+          tau.swap(trialTau);
+          amp.swap(trialAmp);
+          resid.swap(trialResid);
+          jac.swap(trialJac);
+          chi2 = trialChi2;
+          lambda = std::max(lambda/10., 1E-12);
+          accepted = true;
+          if(decrease<=1E-10*chi2 || maxStep<1E-9) status = 0;
+          break;
+        }
+      }
+
+      lambda *= 10;
+    }
+
+    //----- no step decreases chi2, i.e. we are at the minimum
+    if(!accepted) status = 0;
+    if(status==0) break;
+  }
+
+  fTau = tau;
+  fAmp = amp;
+  fChi2 = chi2;
+
+  if(!Errors()){
+    std::cerr << "##### Warning in SFDecayFitter::Fit()! Singular covariance matrix!" << std::endl;
+    return -1;
+  }
+
+  return status;
+}
+//------------------------------------------------------------------
+/// Returns summary of the last fit: decay constants and amplitudes with
+/// their uncertainties, chi2/NDF and number of iterations. Summary is
+/// returned instead of printed, so that fits performed in parallel can
+/// be reported in a fixed order.
+TString SFDecayFitter::GetSummary(void){
+
+  TString summary = "";
+
+  for(size_t k=0; k<fTau.size(); k++){
+    summary += Form("\ttau_%i = %.3f +/- %.3f ns, A_%i = %.4g +/- %.4g\n", (int)k,
+                    fTau[k], fTauErr.size()>k ? fTauErr[k] : 0., (int)k,
+                    fAmp.size()>k ? fAmp[k] : 0., fAmpErr.size()>k ? fAmpErr[k] : 0.);
+  }
+
+  int ndf = GetNDF();
+  summary += Form("\tchi2/NDF = %.3f / %i = %.3f, iterations: %i\n",
+                  fChi2, ndf, ndf>0 ? fChi2/ndf : -1., fNiter);
+
+  return summary;
+}
+//------------------------------------------------------------------
+/// Fits single or double decay function to the signal, in the range of
+/// the function. Supported functions have parameters (A, t0, tau, const)
+/// or (A_fast, t0, tau_fast, A_slow, tau_slow, const), see SFTimeConst.
+/// t0 and const are fixed to their current values, current decay constants
+/// are the starting values. Fitted parameters, their errors, chi2 and NDF
+/// are written to the function. Returns fit status, see Fit().
+/// \param signal - averaged signal
+/// \param fun - single or double decay function
+/// \param summary - if not nullptr, summary of the fit is returned here (see GetSummary())
+int SFDecayFitter::FitSignal(TProfile *signal, TF1 *fun, TString *summary){
+
+  if(signal==nullptr || fun==nullptr ||
+     (fun->GetNpar()!=4 && fun->GetNpar()!=6)){
+    std::cerr << "##### Error in SFDecayFitter::FitSignal()!" << std::endl;
+    std::cerr << "Null pointer or unknown function!" << std::endl;
+    return -1;
+  }
+
+  int npar = fun->GetNpar();
+  std::vector <int> iamp = (npar==4) ? std::vector <int>{0} : std::vector <int>{0, 3};
+  std::vector <int> itau = (npar==4) ? std::vector <int>{2} : std::vector <int>{2, 4};
+  int K = iamp.size();
+
+  double xmin, xmax;
+  fun->GetRange(xmin, xmax);
+
+  SFDecayFitter fitter;
+  fitter.SetData(signal, xmin, xmax, fun->GetParameter(1), fun->GetParameter(npar-1));
+
+  std::vector <double> tau(K);
+  for(int k=0; k<K; k++)
+    tau[k] = fun->GetParameter(itau[k]);
+
+  int status = fitter.Fit(tau);
+
+  if(summary!=nullptr)
+    *summary = fitter.GetSummary();
+
+  if(fitter.GetChi2()<0)
+    return -1;
+
+  std::vector <double> amp    = fitter.GetAmplitudes();
+  std::vector <double> ampErr = fitter.GetAmplitudesErr();
+  tau = fitter.GetDecayTimes();
+  std::vector <double> tauErr = fitter.GetDecayTimesErr();
+
+  for(int i=0; i<npar; i++)
+    fun->SetParError(i, 0);
+
+  for(int k=0; k<K; k++){
+    fun->SetParameter(iamp[k], amp[k]);
+    fun->SetParError(iamp[k], ampErr[k]);
+    fun->SetParameter(itau[k], tau[k]);
+    fun->SetParError(itau[k], tauErr[k]);
+  }
+
+  fun->SetChisquare(fitter.GetChi2());
+  fun->SetNDF(fitter.GetNDF());
+  fun->SetNumberFitPoints(fitter.GetNDF()+2*K);
+
+  return status;
+}
+//------------------------------------------------------------------
+/// Returns baseline of the signal, i.e. weighted mean of the bins in the
+/// given range (same as the fit of pol0). Returns 0 if there are no
+/// filled bins in the range.
+/// \param signal - averaged signal
+/// \param xmin - lower limit of the range
+/// \param xmax - upper limit of the range
+double SFDecayFitter::GetBaseline(TProfile *signal, double xmin, double xmax){
+
+  double sum = 0;
+  double sumW = 0;
+  int nbins = signal->GetNbinsX();
+
+  for(int i=1; i<=nbins; i++){
+    double x = signal->GetBinCenter(i);
+    double err = signal->GetBinError(i);
+    if(x<xmin || x>xmax || err<=0) continue;
+    sum  += signal->GetBinContent(i)/(err*err);
+    sumW += 1./(err*err);
+  }
+
+  return sumW>0 ? sum/sumW : 0;
+}
+//------------------------------------------------------------------
+/// Returns estimate of the decay constant in the given range, from the
+/// weighted linear regression of the logarithm of the baseline-subtracted
+/// signal. Used as starting value of the fit. If the estimate is not
+/// possible (too few positive bins or non-falling slope) the default
+/// value is returned.
+/// \param signal - averaged signal
+/// \param xmin - lower limit of the range
+/// \param xmax - upper limit of the range
+/// \param baseline - baseline of the signal
+/// \param defaultTau - default decay constant
+double SFDecayFitter::EstimateDecayTime(TProfile *signal, double xmin, double xmax,
+                                        double baseline, double defaultTau){
+
+  double S = 0, Sx = 0, Sy = 0, Sxx = 0, Sxy = 0;
+  int npoints = 0;
+  int nbins = signal->GetNbinsX();
+
+  for(int i=1; i<=nbins; i++){
+    double x = signal->GetBinCenter(i);
+    double y = signal->GetBinContent(i)-baseline;
+    double err = signal->GetBinError(i);
+    if(x<xmin || x>xmax || err<=0 || y<=0) continue;
+    double w = (y/err)*(y/err);
+    double ly = std::log(y);
+    S   += w;
+    Sx  += w*x;
+    Sy  += w*ly;
+    Sxx += w*x*x;
+    Sxy += w*x*ly;
+    npoints++;
+  }
+
+  double denom = S*Sxx - Sx*Sx;
+
+  if(npoints<3 || denom<=0)
+    return defaultTau;
+
+  double slope = (S*Sxy - Sx*Sy)/denom;
+
+  if(slope>=0)
+    return defaultTau;
+
+  return -1./slope;
+}
+//------------------------------------------------------------------
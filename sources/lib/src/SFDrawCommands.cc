@@ -9,9 +9,16 @@
 // ***************************************** 
 
 #include "SFDrawCommands.hh"
+#include "SFKernels.hh"
+#include <json/json.h>
+#include <fstream>
 
 ClassImp(SFDrawCommands);
 
+std::map <TString, SFSelection> SFDrawCommands::fOverrides;
+std::map <TString, SFSelection> SFDrawCommands::fRegistry;
+TString                         SFDrawCommands::fConfigFile = "";
+
 //------------------------------------------------------------------
 /// Checks whether returned selection or selection name is not an 
 /// empty string. 
@@ -92,101 +99,506 @@ TString SFDrawCommands::GetSelectionName(SFSelectionType selection){
     return selectionName;
 }
 //------------------------------------------------------------------
-/// Returns selection as a TString for ROOT's TTree type object. 
+/// Returns typed description of the single-channel selection.
 /// \param selection - selection type
-/// \param unique - unique histogram ID
 /// \param ch - channel number
 /// \param customNum - standard vector containing values to be inserted in the selection.
-TString SFDrawCommands::GetSelection(SFSelectionType selection, int unique, int ch,
-                                     std::vector <double> customNum){
-    
-  TString selectionString = "";
-   
+/// For PEvsPEch2Correlation it contains number of the reference channel (default: 2).
+SFSelection SFDrawCommands::GetDescriptor(SFSelectionType selection, int ch,
+                                          std::vector <double> customNum){
+  
+  SFSelection desc;
+  desc.fType = selection;
+  desc.fChannels = {ch};
+  desc.fCustomNum = customNum;
+  
   switch(selection){
       case SFSelectionType::PE:
-          selectionString = Form("ch_%i.fPE>>htemp%i(2200,-150,1500)", ch, unique);
+          desc.fExpression = Form("ch_%i.fPE", ch);
+          desc.fNbinsX = 2200; desc.fXmin = -150; desc.fXmax = 1500;
           break;
       case SFSelectionType::Charge:
-          selectionString = Form("ch_%i.fCharge>>htemp%i(1000,-1E4,2.5E5)", ch, unique);
+          desc.fExpression = Form("ch_%i.fCharge", ch);
+          desc.fNbinsX = 1000; desc.fXmin = -1E4; desc.fXmax = 2.5E5;
           break;
       case SFSelectionType::Amplitude:
-          selectionString = Form("ch_%i.fAmp>>htemp%i(1000,0,800)", ch, unique);
+          desc.fExpression = Form("ch_%i.fAmp", ch);
+          desc.fNbinsX = 1000; desc.fXmin = 0; desc.fXmax = 800;
           break;
       case SFSelectionType::T0:
-          selectionString = Form("ch_%i.fT0>>htemp%.i(1210,-110,1100)", ch, unique);
+          desc.fExpression = Form("ch_%i.fT0", ch);
+          desc.fNbinsX = 1210; desc.fXmin = -110; desc.fXmax = 1100;
           break;
       case SFSelectionType::TOT:
-          selectionString = Form("ch_%i.fTOT>>htemp%.i(1210,-110,1100)", ch, unique);
+          desc.fExpression = Form("ch_%i.fTOT", ch);
+          desc.fNbinsX = 1210; desc.fXmin = -110; desc.fXmax = 1100;
           break;
       case SFSelectionType::PEAttCorrected:
-          selectionString = Form("ch_%i.fPE/exp(%f/%f)>>htemp%i(1300,-150,1600)", ch,
-                            customNum[0], customNum[1], unique);
+          desc.fExpression = Form("ch_%i.fPE/exp(%f/%f)", ch, customNum[0], customNum[1]);
+          desc.fNbinsX = 1300; desc.fXmin = -150; desc.fXmax = 1600;
           break;
       case SFSelectionType::AmpPECorrelation:
-          selectionString = Form("ch_%i.fAmp:ch_%i.fPE>>htemp%i(2200,-150,1500,1000,-10,800)", 
-                            ch, ch, unique);
+          desc.fExpression = Form("ch_%i.fAmp:ch_%i.fPE", ch, ch);
+          desc.fNbinsX = 2200; desc.fXmin = -150; desc.fXmax = 1500;
+          desc.fNbinsY = 1000; desc.fYmin = -10;  desc.fYmax = 800;
           break;
       case SFSelectionType::PEvsPEch2Correlation:
-          selectionString = Form("ch_%i.fPE:ch_2.fPE>>htemp%i(1000,-100,15E4,2200,-150,1500)",
-                            ch, unique);
+          desc.fChannels.push_back(customNum.empty() ? 2 : (int)customNum[0]);
+          desc.fExpression = Form("ch_%i.fPE:ch_%i.fPE", ch, desc.fChannels[1]);
+          desc.fNbinsX = 1000; desc.fXmin = -100; desc.fXmax = 15E4;
+          desc.fNbinsY = 2200; desc.fYmin = -150; desc.fYmax = 1500;
           break;
       default:
-          std::cerr << "##### Error in SFDrawCommands::GetSelection()!" << std::endl;
+          std::cerr << "##### Error in SFDrawCommands::GetDescriptor()!" << std::endl;
           std::cerr << "Unknown selection type! Please check!" << std::endl;
           break;
   }
-    
-  CheckSelection(selectionString);
-  return selectionString;
+  
+  CheckSelection(desc.fExpression);
+  ApplyConfig(desc);
+  return desc;
 }
 //------------------------------------------------------------------
-/// Returns selection as a TString for ROOT's TTree type object. 
+/// Returns typed description of the selection combining two channels, 
+/// e.g. two ends of the same fiber in the fiber array. 
 /// \param selection - selection type
-/// \param unique - unique histogram ID
+/// \param chL - channel number of the left end of the fiber (closer to position 0)
+/// \param chR - channel number of the right end of the fiber
 /// \param customNum - standard vector containing values to be inserted in the selection.
-TString SFDrawCommands::GetSelection(SFSelectionType selection, int unique,
-                                     std::vector <double> customNum){
-    
-  TString selectionString = "";
-  TString LogSqrtQ1Q0 = "log(sqrt(ch_1.fPE/ch_0.fPE))";
-
+///
+/// If chL and chR are two ends of the same fiber, i.e. chL is even and chR = chL+1, 
+/// expressions refer to the quantities precalculated in the derived tree (see SFData), 
+/// e.g. fLnMLR[chL/2] instead of log(sqrt(ch_1.fPE/ch_0.fPE)). For PEAttCorrectedSum 
+/// this is done only if customNum is empty, i.e. attenuation length of the series is used.
+SFSelection SFDrawCommands::GetDescriptor(SFSelectionType selection, int chL, int chR,
+                                          std::vector <double> customNum){
+  
+  SFSelection desc;
+  desc.fType = selection;
+  desc.fChannels = {chL, chR};
+  desc.fCustomNum = customNum;
+  
+  bool derived = (chL%2==0 && chR==chL+1);
+  int  pair    = chL/2;
+  
   switch(selection){
       case SFSelectionType::LogSqrtPERatio:
-          selectionString = Form("log(sqrt(ch_1.fPE/ch_0.fPE))>>htemp%i(500, -2, 2)", unique);
+          if(derived)
+            desc.fExpression = Form("fLnMLR[%i]", pair);
+          else
+            desc.fExpression = Form("log(sqrt(ch_%i.fPE/ch_%i.fPE))", chR, chL);
+          desc.fNbinsX = 500; desc.fXmin = -2; desc.fXmax = 2;
           break;
       case SFSelectionType::T0Difference:
-          selectionString = Form("(ch_0.fT0-ch_1.fT0)>>htemp%i(2500,-50,50)", unique);
+          if(derived)
+            desc.fExpression = Form("fT0Diff[%i]", pair);
+          else
+            desc.fExpression = Form("(ch_%i.fT0-ch_%i.fT0)", chL, chR);
+          desc.fNbinsX = 2500; desc.fXmin = -50; desc.fXmax = 50;
           break;
       case SFSelectionType::PEAverage:
-          selectionString = Form("sqrt(ch_0.fPE*ch_1.fPE)>>htemp%i(1350,-150,1200)", unique);
+          if(derived)
+            desc.fExpression = Form("fPEAverage[%i]", pair);
+          else
+            desc.fExpression = Form("sqrt(ch_%i.fPE*ch_%i.fPE)", chL, chR);
+          desc.fNbinsX = 1350; desc.fXmin = -150; desc.fXmax = 1200;
           break;
       case SFSelectionType::AmplitudeAverage:
-          selectionString = Form("sqrt(ch_0.fAmp*ch_1.fAmp)>>htemp%i(1000,0,800)",unique);
+          desc.fExpression = Form("sqrt(ch_%i.fAmp*ch_%i.fAmp)", chL, chR);
+          desc.fNbinsX = 1000; desc.fXmin = 0; desc.fXmax = 800;
           break;
       case SFSelectionType::PECorrelation:
-          selectionString = Form("ch_0.fPE:ch_1.fPE>>htemp%i(3300,-150,1500,3300,-150,1500)", unique);
+          desc.fExpression = Form("ch_%i.fPE:ch_%i.fPE", chL, chR);
+          desc.fNbinsX = 3300; desc.fXmin = -150; desc.fXmax = 1500;
+          desc.fNbinsY = 3300; desc.fYmin = -150; desc.fYmax = 1500;
           break;
       case SFSelectionType::AmplitudeCorrelation:
-          selectionString = Form("ch_0.fAmp:ch_1.fAmp>>htemp%i(1000,0,800,1000,0,800)", unique);
+          desc.fExpression = Form("ch_%i.fAmp:ch_%i.fAmp", chL, chR);
+          desc.fNbinsX = 1000; desc.fXmin = 0; desc.fXmax = 800;
+          desc.fNbinsY = 1000; desc.fYmin = 0; desc.fYmax = 800;
           break;
       case SFSelectionType::T0Correlation:
-          selectionString = Form("ch_0.fT0:ch_1.fT0>>htemp%i(2420,-110,1100,2420,-110,1100", unique);
+          desc.fExpression = Form("ch_%i.fT0:ch_%i.fT0", chL, chR);
+          desc.fNbinsX = 2420; desc.fXmin = -110; desc.fXmax = 1100;
+          desc.fNbinsY = 2420; desc.fYmin = -110; desc.fYmax = 1100;
           break;
       case SFSelectionType::PEAttCorrectedSum:
-          selectionString = Form("ch_0.fPE/exp(%f/%f) + ch_1.fPE/exp(%f/%f)>>htemp%i(1500,-150,4000)",
-                            customNum[0], customNum[1], customNum[2], customNum[3],
-                            unique);
+          if(derived && customNum.empty())
+            desc.fExpression = Form("fPEAttCorr[%i]", pair);
+          else
+            desc.fExpression = Form("ch_%i.fPE/exp(%f/%f) + ch_%i.fPE/exp(%f/%f)",
+                               chL, customNum[0], customNum[1], chR, customNum[2], customNum[3]);
+          desc.fNbinsX = 1500; desc.fXmin = -150; desc.fXmax = 4000;
           break;
       default:
-          std::cerr << "##### Error in SFDrawCommands::GetSelection()!" << std::endl;
+          std::cerr << "##### Error in SFDrawCommands::GetDescriptor()!" << std::endl;
           std::cerr << "Unknown selection type! Please check!" << std::endl;
           break;
   }
-    
+  
+  CheckSelection(desc.fExpression);
+  ApplyConfig(desc);
+  return desc;
+}
+//------------------------------------------------------------------
+/// Returns selection described by the descriptor as a TString for ROOT's 
+/// TTree type object.
+/// \param descriptor - typed description of the selection
+/// \param unique - unique histogram ID
+TString SFDrawCommands::GetSelection(const SFSelection &descriptor, int unique){
+  
+  TString selectionString;
+  
+  if(descriptor.fNbinsY>0)
+    selectionString = descriptor.fExpression + 
+                      Form(">>htemp%i(%i,%g,%g,%i,%g,%g)", unique, 
+                           descriptor.fNbinsX, descriptor.fXmin, descriptor.fXmax,
+                           descriptor.fNbinsY, descriptor.fYmin, descriptor.fYmax);
+  else
+    selectionString = descriptor.fExpression + 
+                      Form(">>htemp%i(%i,%g,%g)", unique, 
+                           descriptor.fNbinsX, descriptor.fXmin, descriptor.fXmax);
+  
   CheckSelection(selectionString);
   return selectionString;
 }
 //------------------------------------------------------------------
+/// Returns selection as a TString for ROOT's TTree type object. 
+/// \param selection - selection type
+/// \param unique - unique histogram ID
+/// \param ch - channel number
+/// \param customNum - standard vector containing values to be inserted in the selection.
+/// For PEvsPEch2Correlation it contains number of the reference channel (default: 2).
+TString SFDrawCommands::GetSelection(SFSelectionType selection, int unique, int ch,
+                                     std::vector <double> customNum){
+    
+  return GetSelection(GetDescriptor(selection, ch, customNum), unique);
+}
+//------------------------------------------------------------------
+/// Returns selection as a TString for ROOT's TTree type object. This 
+/// function is used for selections combining two channels. Channels
+/// 0 and 1 are used, i.e. two ends of the fiber in the standard setup.
+/// \param selection - selection type
+/// \param unique - unique histogram ID
+/// \param customNum - standard vector containing values to be inserted in the selection.
+TString SFDrawCommands::GetSelection(SFSelectionType selection, int unique,
+                                     std::vector <double> customNum){
+  
+  return GetSelection(selection, unique, 0, 1, customNum);
+}
+//------------------------------------------------------------------
+/// Returns selection as a TString for ROOT's TTree type object. This
+/// function is used for selections combining two channels, e.g. two ends
+/// of the same fiber in the fiber array. See GetDescriptor().
+/// \param selection - selection type
+/// \param unique - unique histogram ID
+/// \param chL - channel number of the left end of the fiber (closer to position 0)
+/// \param chR - channel number of the right end of the fiber
+/// \param customNum - standard vector containing values to be inserted in the selection.
+TString SFDrawCommands::GetSelection(SFSelectionType selection, int unique,
+                                     int chL, int chR, std::vector <double> customNum){
+    
+  return GetSelection(GetDescriptor(selection, chL, chR, customNum), unique);
+}
+//------------------------------------------------------------------
+/// Finds selection type of the given name, i.e. inverse of GetSelectionName().
+/// Returns false if there is no such selection type.
+/// \param name - name of the selection type, e.g. "PEAverage"
+/// \param selection - found selection type
+bool SFDrawCommands::GetSelectionType(TString name, SFSelectionType &selection){
+  
+  for(int i=0; i<=(int)SFSelectionType::PEAttCorrectedSum; i++){
+    if(GetSelectionName((SFSelectionType)i)==name){
+      selection = (SFSelectionType)i;
+      return true;
+    }
+  }
+  
+  return false;
+}
+//------------------------------------------------------------------
+/// Returns true for selections of a single channel (optionally combined 
+/// with the reference channel), false for selections combining two channels.
+/// \param selection - selection type
+bool SFDrawCommands::IsSingleChannel(SFSelectionType selection){
+  
+  switch(selection){
+      case SFSelectionType::PE:
+      case SFSelectionType::Charge:
+      case SFSelectionType::Amplitude:
+      case SFSelectionType::T0:
+      case SFSelectionType::TOT:
+      case SFSelectionType::PEAttCorrected:
+      case SFSelectionType::AmpPECorrelation:
+      case SFSelectionType::PEvsPEch2Correlation:
+          return true;
+      default:
+          return false;
+  }
+}
+//------------------------------------------------------------------
+/// Applies binning and default cut configured for the built-in selection
+/// (see LoadConfig()). In the cut "$chL", "$chR" and "$ch" are replaced 
+/// with the channel numbers of the selection.
+/// \param desc - selection descriptor
+void SFDrawCommands::ApplyConfig(SFSelection &desc){
+  
+  auto it = fOverrides.find(GetSelectionName(desc.fType));
+  if(it==fOverrides.end())
+    return;
+  
+  const SFSelection &conf = it->second;
+  
+  if(conf.fNbinsX>0){
+    desc.fNbinsX = conf.fNbinsX; desc.fXmin = conf.fXmin; desc.fXmax = conf.fXmax;
+  }
+  if(conf.fNbinsY>0){
+    desc.fNbinsY = conf.fNbinsY; desc.fYmin = conf.fYmin; desc.fYmax = conf.fYmax;
+  }
+  
+  TString cut = conf.fCut;
+  cut.ReplaceAll("$chL", Form("%i", desc.fChannels[0]));
+  cut.ReplaceAll("$chR", Form("%i", desc.fChannels.back()));
+  cut.ReplaceAll("$ch", Form("%i", desc.fChannels[0]));
+  desc.fCut = cut;
+  
+  return;
+}
+//------------------------------------------------------------------
+/// Loads selection configuration from the "SFSelections" section of 
+/// the JSON file. The section contains objects, whose names are either 
+/// names of the built-in selections (see GetSelectionName()) or new 
+/// selection names:
+///
+///     "SFSelections" : {
+///       "T0"          : { "binning" : [1210, -110, 1100], "cut" : "ch_$ch.fT0>0" },
+///       "PEAvgNarrow" : { "variable" : "PEAverage", "channels" : [0, 1],
+///                         "binning" : [600, 0, 600], "cut" : "ch_0.fPE>0 && ch_1.fPE>0" }
+///     }
+///
+/// For the built-in selections binning (3 numbers for 1D, 6 for 2D) 
+/// and default cut are replaced. New selections must name the built-in
+/// selection computing their variable, and give channels (1 or 2) and 
+/// binning. Optional "custom" array is passed as customNum to 
+/// GetDescriptor(). Thus new selections are evaluated with the same
+/// compiled kernels as the built-in ones (see SFKernel). The whole 
+/// section is validated before it is applied. If the file doesn't 
+/// contain the section nothing is changed. The file is loaded only
+/// once, subsequent calls with the same name do nothing.
+/// \param fileName - name of the JSON file, e.g. .configAG1.json
+bool SFDrawCommands::LoadConfig(TString fileName){
+  
+  if(fileName==fConfigFile)
+    return true;
+  
+  std::ifstream input(fileName.Data());
+  
+  if(!input.is_open()){
+    std::cerr << "##### Error in SFDrawCommands::LoadConfig()!" << std::endl;
+    std::cerr << "Cannot open file: " << fileName << std::endl;
+    return false;
+  }
+  
+  Json::Value root;
+  Json::CharReaderBuilder builder;
+  std::string errors;
+  
+  if(!Json::parseFromStream(builder, input, &root, &errors)){
+    std::cerr << "##### Error in SFDrawCommands::LoadConfig()!" << std::endl;
+    std::cerr << "Cannot parse file " << fileName << ": " << errors << std::endl;
+    return false;
+  }
+  
+  std::map <TString, SFSelection> overrides;
+  std::map <TString, SFSelection> registry;
+  
+  const Json::Value &section = root["SFSelections"];
+  
+  if(!section.isNull() && !section.isObject()){
+    std::cerr << "##### Error in SFDrawCommands::LoadConfig()!" << std::endl;
+    std::cerr << "Section SFSelections must be an object!" << std::endl;
+    return false;
+  }
+  
+  std::vector <std::string> names = section.isNull() ? std::vector <std::string>() 
+                                                     : section.getMemberNames();
+  
+  for(size_t i=0; i<names.size(); i++){
+    
+    TString name = names[i];
+    const Json::Value &entry = section[names[i]];
+    SFSelectionType type;
+    bool builtIn = GetSelectionType(name, type);
+    
+    if(!entry.isObject()){
+      std::cerr << "##### Error in SFDrawCommands::LoadConfig()!" << std::endl;
+      std::cerr << "Selection " << name << " must be an object!" << std::endl;
+      return false;
+    }
+    
+    if(builtIn && entry.isMember("variable")){
+      std::cerr << "##### Error in SFDrawCommands::LoadConfig()!" << std::endl;
+      std::cerr << "Name of the built-in selection can't be used for new selection: " << name << std::endl;
+      return false;
+    }
+    
+    //----- variable and channels of new selections
+    std::vector <int>    channels = {0};
+    std::vector <double> customNum;
+    
+    if(!builtIn){
+      if(!entry["variable"].isString() || 
+         !GetSelectionType(entry["variable"].asString(), type)){
+        std::cerr << "##### Error in SFDrawCommands::LoadConfig()!" << std::endl;
+        std::cerr << "Unknown variable of the selection " << name << std::endl;
+        return false;
+      }
+      
+      const Json::Value &ch = entry["channels"];
+      int nch = IsSingleChannel(type) ? 1 : 2;
+      
+      if(!ch.isArray() || ((int)ch.size()!=nch && 
+         !(type==SFSelectionType::PEvsPEch2Correlation && ch.size()==2))){
+        std::cerr << "##### Error in SFDrawCommands::LoadConfig()!" << std::endl;
+        std::cerr << "Selection " << name << " requires " << nch << " channel(s)!" << std::endl;
+        return false;
+      }
+      
+      channels.clear();
+      for(Json::ArrayIndex c=0; c<ch.size(); c++){
+        if(!ch[c].isInt() || ch[c].asInt()<0){
+          std::cerr << "##### Error in SFDrawCommands::LoadConfig()!" << std::endl;
+          std::cerr << "Incorrect channel number in selection " << name << std::endl;
+          return false;
+        }
+        channels.push_back(ch[c].asInt());
+      }
+      
+      const Json::Value &custom = entry["custom"];
+      for(Json::ArrayIndex c=0; custom.isArray() && c<custom.size(); c++)
+        customNum.push_back(custom[c].asDouble());
+      
+      if(type==SFSelectionType::PEvsPEch2Correlation && channels.size()==2)
+        customNum = {(double)channels[1]};
+      
+      if((type==SFSelectionType::PEAttCorrected && customNum.size()!=2) ||
+         (type==SFSelectionType::PEAttCorrectedSum && !customNum.empty() && customNum.size()!=4)){
+        std::cerr << "##### Error in SFDrawCommands::LoadConfig()!" << std::endl;
+        std::cerr << "Incorrect number of custom values in selection " << name << std::endl;
+        return false;
+      }
+      
+      if(!entry.isMember("binning")){
+        std::cerr << "##### Error in SFDrawCommands::LoadConfig()!" << std::endl;
+        std::cerr << "Binning of the selection " << name << " is missing!" << std::endl;
+        return false;
+      }
+    }
+    
+    //----- binning and default cut
+    SFSelection desc;
+    desc.fType = type;
+    desc.fChannels = channels;
+    desc.fCustomNum = customNum;
+    
+    bool is2D = (SFKernels::GetDimension(type)==2);
+    
+    if(entry.isMember("binning")){
+      const Json::Value &bins = entry["binning"];
+      if(!bins.isArray() || bins.size()!=(is2D ? 6u : 3u)){
+        std::cerr << "##### Error in SFDrawCommands::LoadConfig()!" << std::endl;
+        std::cerr << "Selection " << name << " requires " << (is2D ? 6 : 3) 
+                  << " binning values!" << std::endl;
+        return false;
+      }
+      for(Json::ArrayIndex b=0; b<bins.size(); b++){
+        if(!bins[b].isNumeric()){
+          std::cerr << "##### Error in SFDrawCommands::LoadConfig()!" << std::endl;
+          std::cerr << "Binning of the selection " << name << " must be numeric!" << std::endl;
+          return false;
+        }
+      }
+      desc.fNbinsX = bins[0].asInt(); desc.fXmin = bins[1].asDouble(); desc.fXmax = bins[2].asDouble();
+      if(is2D){
+        desc.fNbinsY = bins[3].asInt(); desc.fYmin = bins[4].asDouble(); desc.fYmax = bins[5].asDouble();
+      }
+      if(desc.fNbinsX<1 || desc.fXmin>=desc.fXmax || 
+         (is2D && (desc.fNbinsY<1 || desc.fYmin>=desc.fYmax))){
+        std::cerr << "##### Error in SFDrawCommands::LoadConfig()!" << std::endl;
+        std::cerr << "Incorrect binning of the selection " << name << std::endl;
+        return false;
+      }
+    }
+    
+    if(entry.isMember("cut")){
+      if(!entry["cut"].isString()){
+        std::cerr << "##### Error in SFDrawCommands::LoadConfig()!" << std::endl;
+        std::cerr << "Cut of the selection " << name << " must be a string!" << std::endl;
+        return false;
+      }
+      desc.fCut = entry["cut"].asString();
+    }
+    
+    if(builtIn)
+      overrides[name] = desc;
+    else
+      registry[name] = desc;
+  }
+  
+  fOverrides  = overrides;
+  fRegistry   = registry;
+  fConfigFile = fileName;
+  
+  return true;
+}
+//------------------------------------------------------------------
+/// Returns descriptor of the selection defined in the configuration 
+/// file (see LoadConfig()).
+/// \param name - name of the selection
+SFSelection SFDrawCommands::GetDescriptor(TString name){
+  
+  auto it = fRegistry.find(name);
+  
+  if(it==fRegistry.end()){
+    std::cerr << "##### Error in SFDrawCommands::GetDescriptor()!" << std::endl;
+    std::cerr << "Selection " << name << " is not defined! Please check configuration file!" << std::endl;
+    std::abort();
+  }
+  
+  const SFSelection &conf = it->second;
+  SFSelection desc;
+  
+  if(IsSingleChannel(conf.fType))
+    desc = GetDescriptor(conf.fType, conf.fChannels[0], conf.fCustomNum);
+  else
+    desc = GetDescriptor(conf.fType, conf.fChannels[0], conf.fChannels[1], conf.fCustomNum);
+  
+  desc.fNbinsX = conf.fNbinsX; desc.fXmin = conf.fXmin; desc.fXmax = conf.fXmax;
+  desc.fNbinsY = conf.fNbinsY; desc.fYmin = conf.fYmin; desc.fYmax = conf.fYmax;
+  if(conf.fCut!="") desc.fCut = conf.fCut;
+  
+  return desc;
+}
+//------------------------------------------------------------------
+/// Returns true if the selection of the given name is defined in the
+/// configuration file.
+/// \param name - name of the selection
+bool SFDrawCommands::IsRegistered(TString name){
+  
+  return fRegistry.find(name)!=fRegistry.end();
+}
+//------------------------------------------------------------------
+/// Returns names of all selections defined in the configuration file.
+std::vector <TString> SFDrawCommands::GetRegisteredNames(void){
+  
+  std::vector <TString> names;
+  
+  for(auto it=fRegistry.begin(); it!=fRegistry.end(); it++)
+    names.push_back(it->first);
+  
+  return names;
+}
+//------------------------------------------------------------------
 /// Prints details of the SFDrawCommands class object.
 void SFDrawCommands::Print(void){
   std::cout << "\n------------------------------------------------" << std::endl;
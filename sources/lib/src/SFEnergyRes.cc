@@ -20,8 +20,7 @@ ClassImp(SFEnergyRes);
 /// \param seriesNo is number of experimental series to be analyzed. 
 SFEnergyRes::SFEnergyRes(int seriesNo): fSeriesNo(seriesNo),
                                         fData(nullptr),
-                                        fEnergyResGraphCh0(nullptr),
-                                        fEnergyResGraphCh1(nullptr),
+                                        fNchannels(2),
                                         fEnergyResGraphAve(nullptr) {
 
   try{
@@ -38,11 +37,28 @@ SFEnergyRes::SFEnergyRes(int seriesNo): fSeriesNo(seriesNo),
     std::cout << "Calculating energy resolution with non-regular series!" << std::endl;
   }
   
-  //--- getting necessary PE spectra
-  TString cut_ch0 = "ch_0.fT0>0 && ch_0.fT0<590 && ch_0.fPE>0";
-  TString cut_ch1 = "ch_1.fT0>0 && ch_1.fT0<590 && ch_1.fPE>0";
-  fSpectraCh0 = fData->GetSpectra(0, SFSelectionType::PE, cut_ch0);
-  fSpectraCh1 = fData->GetSpectra(1, SFSelectionType::PE, cut_ch1);
+  fNchannels = fData->GetNchannels();
+  fEnergyResGraphCh.resize(fNchannels, nullptr);
+  fSpectraCh.resize(fNchannels);
+  fPeaksCh.resize(fNchannels);
+  fResults.fEnergyResCh.resize(fNchannels, -1);
+  fResults.fEnergyResChErr.resize(fNchannels, -1);
+  
+  //--- getting necessary PE spectra, all channels filled in one pass
+  int npoints = fData->GetNpoints();
+  std::vector <int> measIDs = fData->GetMeasurementsIDs();
+  std::vector <TString> cuts(fNchannels);
+  std::vector <TH1D*> tmp;
+  
+  for(int ch=0; ch<fNchannels; ch++)
+    cuts[ch] = Form("ch_%i.fT0>0 && ch_%i.fT0<590 && ch_%i.fPE>0", ch, ch, ch);
+  
+  for(int i=0; i<npoints; i++){
+    tmp = fData->GetChannelSpectra(SFSelectionType::PE, cuts, measIDs[i]);
+    for(int ch=0; ch<fNchannels; ch++)
+      fSpectraCh[ch].push_back(tmp[ch]);
+  }
+  
   fSpectraAve = fData->GetCustomHistograms(SFSelectionType::PEAverage, 
                                            "ch_0.fT0>0 && ch_1.fT0>0 && ch_0.fPE>0 && ch_1.fPE>0");
    
@@ -57,9 +73,8 @@ SFEnergyRes::~SFEnergyRes(){
 //------------------------------------------------------------------
 /// Calculates energy resolution based on charge spectra of requested channel 
 /// for all measurements in analyzed measurement series. In this function
-/// fEnergyResGrapCh0 and fEnergyResGraphCh1 graphs are filled and values of
-/// fResults.fEnergyResCh0, fEnergyResCh0Err, fResults.fEnergyResCh1 and
-/// fResults.fEnergyResAveCh1Err are assigned. 
+/// graph fEnergyResGraphCh[ch] is filled and values of fResults.fEnergyResCh[ch]
+/// and fResults.fEnergyResChErr[ch] are assigned. 
 /// \param ch - channel number
 bool SFEnergyRes::CalculateEnergyRes(int ch){
     
@@ -67,24 +82,21 @@ bool SFEnergyRes::CalculateEnergyRes(int ch){
   std::cout << "----- Analyzing series: " << fSeriesNo << std::endl;
   std::cout << "----- Analyzing channel: " << ch << std::endl; 
   
+  if(ch<0 || ch>=fNchannels){
+    std::cerr << "##### Error in SFEnergyRes::CalculateEnergyRes() for ch"
+              <<  ch << std::endl;
+    std::cerr << "Incorrect channel number!" << std::endl;
+    return false;
+  }
+  
   int npoints = fData->GetNpoints();
   TString collimator = fData->GetCollimator();
   TString testBench = fData->GetTestBench();
   std::vector <double> positions = fData->GetPositions();
   std::vector <SFPeakFinder*> peakFin;
   
-  for(int i=0; i<npoints; i++){
-    if(ch==0)
-      peakFin.push_back(new SFPeakFinder(fSpectraCh0[i], 0));
-    else if(ch==1)
-      peakFin.push_back(new SFPeakFinder(fSpectraCh1[i], 0));
-    else{
-      std::cerr << "##### Error in SFEnergyRes::CalculateEnergyRes() for ch"
-                <<  ch << std::endl;
-      std::cerr << "Incorrect channel number!" << std::endl;
-      return false;
-    }
-  }
+  for(int i=0; i<npoints; i++)
+    peakFin.push_back(new SFPeakFinder(fSpectraCh[ch][i], 0));
   
   TString gname = Form("ER_s%i_ch%i", fSeriesNo, ch);
   TGraphErrors *graph = new TGraphErrors(npoints);
@@ -100,8 +112,9 @@ bool SFEnergyRes::CalculateEnergyRes(int ch){
   double enResAve = 0;
   double enResAveErr = 0;
   
+  SFPeakFinder::FindPeakFitsSeries(peakFin, positions);
+  
   for(int i=0; i<npoints; i++){
-    peakFin[i]->FindPeakFit();
     parameters = peakFin[i]->GetParameters();
     enRes = parameters.fSigma/parameters.fPosition;
     enResErr = enRes * sqrt(pow(parameters.fPositionErr, 2)/pow(parameters.fPosition, 2) +
@@ -120,16 +133,9 @@ bool SFEnergyRes::CalculateEnergyRes(int ch){
   std::cout << "Average energy resolution for channel " << ch 
             << ": " << enResAve << " +/- " << enResAveErr << " % \n" << std::endl; 
  
-  if(ch==0){
-      fEnergyResGraphCh0 = graph;
-      fResults.fEnergyResCh0 = enResAve;
-      fResults.fEnergyResCh0Err = enResAveErr;
-  }
-  else if(ch==1){
-      fEnergyResGraphCh1 = graph;
-      fResults.fEnergyResCh1 = enResAve;
-      fResults.fEnergyResCh1Err = enResAveErr;
-  }
+  fEnergyResGraphCh[ch] = graph;
+  fResults.fEnergyResCh[ch] = enResAve;
+  fResults.fEnergyResChErr[ch] = enResAveErr;
             
   return true;
 }
@@ -162,9 +168,12 @@ bool SFEnergyRes::CalculateEnergyRes(void){
   double enRes, enResErr;
   double enResAve, enResAveErr;
   
-  for(int i=0; i<npoints; i++){    
+  for(int i=0; i<npoints; i++)
     peakFin.push_back(new SFPeakFinder(fSpectraAve[i], 0));
-    peakFin[i]->FindPeakFit();
+  
+  SFPeakFinder::FindPeakFitsSeries(peakFin, positions);
+  
+  for(int i=0; i<npoints; i++){    
     parameters = peakFin[i]->GetParameters();
     
     enRes = parameters.fSigma/parameters.fPosition;
@@ -201,24 +210,21 @@ bool SFEnergyRes::CalculateEnergyRes(void){
 /// \param ch - channel number
 TGraphErrors* SFEnergyRes::GetEnergyResolutionGraph(int ch){
     
-  if((ch==0 && fEnergyResGraphCh0==nullptr) || 
-     (ch==1 && fEnergyResGraphCh1==nullptr)) {
+  if(ch<0 || ch>=fNchannels){
+    std::cerr << "##### Error in SFEnergyRes::GetEnergyResolutionGraph() for ch" 
+              << ch << std::endl;
+    std::cerr << "Incorrect channel number!" << std::endl;
+    std::abort();
+  }
+  
+  if(fEnergyResGraphCh[ch]==nullptr) {
       std::cerr << "##### Error in SFEnergyRes::GetEnergyResolutionGraph() for ch" 
                 << ch << std::endl;
       std::cerr << "Requested graph doesnt exist!" << std::endl;
       std::abort();
   }
   
-  if(ch==0)
-    return fEnergyResGraphCh0;
-  else if(ch==1) 
-    return fEnergyResGraphCh1;
-  else{
-    std::cerr << "##### Error in SFEnergyRes::GetEnergyResolutionGraph() for ch" 
-              << ch << std::endl;
-    std::cerr << "Incorrect channel number!" << std::endl;
-    std::abort();
-  }
+  return fEnergyResGraphCh[ch];
 }
 //------------------------------------------------------------------
 /// Returns energy resolution graph for averaged channels. Energy resolution 
@@ -239,22 +245,19 @@ TGraphErrors* SFEnergyRes::GetEnergyResolutionGraph(void){
 /// \par ch - channel number 
 std::vector <TH1D*> SFEnergyRes::GetSpectra(int ch){
     
-  if((ch==0 && fSpectraCh0.empty()) ||
-     (ch==1 && fSpectraCh1.empty())) {
+  if(ch<0 || ch>=fNchannels){
+    std::cerr << "##### Error in SFEnergyRes::GetSpectra for ch" << ch << std::endl;
+    std::cerr << "Incorrect channel number!" << std::endl;
+    std::abort();
+  }
+  
+  if(fSpectraCh[ch].empty()) {
       std::cerr << "##### Error in SFEnergyRes::GetSpectra() fo ch" << ch << std::endl; 
       std::cerr << "No spectra available!" << std::endl; 
       std::abort();
   }
 
-  if(ch==0)
-    return fSpectraCh0;
-  else if(ch==1)
-    return fSpectraCh1;
-  else{
-    std::cerr << "##### Error in SFEnergyRes::GetSpectra for ch" << ch << std::endl;
-    std::cerr << "Incorrect channel number!" << std::endl;
-    std::abort();
-  }
+  return fSpectraCh[ch];
 }
 //------------------------------------------------------------------
 /// Returns vector containing averaged charge spectra.
@@ -286,24 +289,21 @@ std::vector <TH1D*> SFEnergyRes::GetPeaks(void){
 /// \param ch - channel number
 std::vector <TH1D*> SFEnergyRes::GetPeaks(int ch){
     
-  if((ch==0 && fPeaksCh0.empty()) ||
-     (ch==1 && fPeaksCh1.empty())) {
+  if(ch<0 || ch>=fNchannels){
+    std::cerr << "##### Error in SFEnergyRes::GetPeaks() for ch" 
+              << ch << std::endl;
+    std::cerr << "Incorrect channel number!" << std::endl;
+    std::abort();
+  }
+  
+  if(fPeaksCh[ch].empty()) {
       std::cerr << "##### Error in SFEnergyRes::GetPeaks() for ch" 
                 << ch << std::endl; 
       std::cerr << "No spectra available!" << std::endl; 
       std::abort();
   }
 
-  if(ch==0)
-    return fPeaksCh0;
-  else if(ch==1)
-    return fPeaksCh1;
-  else{
-    std::cerr << "##### Error in SFEnergyRes::GetPeaks() for ch" 
-              << ch << std::endl;
-    std::cerr << "Incorrect channel number!" << std::endl;
-    std::abort();
-  }
+  return fPeaksCh[ch];
 }
 //------------------------------------------------------------------
 /// Prints details of the SFEnergyResolution class object.
@@ -0,0 +1,273 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *            SFEventMask.cc             *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#include "SFEventMask.hh"
+
+ClassImp(SFEventMask);
+
+//------------------------------------------------------------------
+/// Standard constructor. Creates empty mask.
+/// \param nentries - number of entries of the tree
+SFEventMask::SFEventMask(Long64_t nentries) : fNentries(nentries) {
+}
+//------------------------------------------------------------------
+/// Default destructor.
+SFEventMask::~SFEventMask(){
+}
+//------------------------------------------------------------------
+/// Returns index of the container with the given key or -1 if there
+/// is no such container.
+/// \param key - container key, i.e. entry>>16
+int SFEventMask::FindContainer(Long64_t key) const {
+
+  auto it = std::lower_bound(fKeys.begin(), fKeys.end(), key);
+
+  if(it==fKeys.end() || *it!=key)
+    return -1;
+
+  return it - fKeys.begin();
+}
+//------------------------------------------------------------------
+/// Returns content of the container as a bitmap.
+/// \param container - index of the container, -1 gives empty bitmap
+std::vector <ULong64_t> SFEventMask::GetBitmap(int container) const {
+
+  if(container<0)
+    return std::vector <ULong64_t>(kWords, 0);
+
+  if(!fBitmaps[container].empty())
+    return fBitmaps[container];
+
+  std::vector <ULong64_t> bitmap(kWords, 0);
+  const std::vector <UShort_t> &array = fArrays[container];
+
+  for(size_t i=0; i<array.size(); i++)
+    bitmap[array[i]>>6] |= (ULong64_t)1<<(array[i]&63);
+
+  return bitmap;
+}
+//------------------------------------------------------------------
+/// Appends container given as a bitmap. Sparse containers are converted
+/// to arrays, empty containers are skipped. Keys must be added in
+/// increasing order.
+/// \param key - container key
+/// \param bitmap - content of the container
+void SFEventMask::AddContainer(Long64_t key, const std::vector <ULong64_t> &bitmap){
+
+  int count = 0;
+  for(int w=0; w<kWords; w++)
+    count += __builtin_popcountll(bitmap[w]);
+
+  if(count==0)
+    return;
+
+  fKeys.push_back(key);
+
+  if(count>kArrayMax){
+    fArrays.push_back(std::vector <UShort_t>());
+    fBitmaps.push_back(bitmap);
+    return;
+  }
+
+  std::vector <UShort_t> array;
+  array.reserve(count);
+
+  for(int w=0; w<kWords; w++){
+    ULong64_t word = bitmap[w];
+    while(word!=0){
+      array.push_back((w<<6) + __builtin_ctzll(word));
+      word &= word-1;
+    }
+  }
+
+  fArrays.push_back(array);
+  fBitmaps.push_back(std::vector <ULong64_t>());
+
+  return;
+}
+//------------------------------------------------------------------
+/// Adds entry to the mask. Adding entries in increasing order is the
+/// fastest, but any order is accepted.
+/// \param entry - tree entry
+void SFEventMask::Add(Long64_t entry){
+
+  Long64_t key    = entry>>16;
+  UShort_t offset = entry & 0xFFFF;
+  int container;
+
+  if(!fKeys.empty() && fKeys.back()==key){
+    container = fKeys.size()-1;
+  }
+  else{
+    container = FindContainer(key);
+    if(container<0){
+      auto it = std::lower_bound(fKeys.begin(), fKeys.end(), key);
+      container = it - fKeys.begin();
+      fKeys.insert(it, key);
+      fArrays.insert(fArrays.begin()+container, std::vector <UShort_t>());
+      fBitmaps.insert(fBitmaps.begin()+container, std::vector <ULong64_t>());
+    }
+  }
+
+  if(!fBitmaps[container].empty()){
+    fBitmaps[container][offset>>6] |= (ULong64_t)1<<(offset&63);
+    return;
+  }
+
+  std::vector <UShort_t> &array = fArrays[container];
+
+  if(array.empty() || array.back()<offset){
+    array.push_back(offset);
+  }
+  else{
+    auto it = std::lower_bound(array.begin(), array.end(), offset);
+    if(*it==offset) return;
+    array.insert(it, offset);
+  }
+
+  //----- conversion of the full sparse container to bitmap
+  if((int)array.size()>kArrayMax){
+    fBitmaps[container] = GetBitmap(container);
+    array.clear();
+    array.shrink_to_fit();
+  }
+
+  return;
+}
+//------------------------------------------------------------------
+/// Returns true if the entry is in the mask.
+/// \param entry - tree entry
+bool SFEventMask::Contains(Long64_t entry) const {
+
+  int container = FindContainer(entry>>16);
+
+  if(container<0)
+    return false;
+
+  UShort_t offset = entry & 0xFFFF;
+
+  if(!fBitmaps[container].empty())
+    return (fBitmaps[container][offset>>6]>>(offset&63)) & 1;
+
+  return std::binary_search(fArrays[container].begin(), fArrays[container].end(), offset);
+}
+//------------------------------------------------------------------
+/// Returns number of entries in the mask.
+Long64_t SFEventMask::GetCount(void) const {
+
+  Long64_t count = 0;
+
+  for(size_t c=0; c<fKeys.size(); c++){
+    if(fBitmaps[c].empty()){
+      count += fArrays[c].size();
+      continue;
+    }
+    for(int w=0; w<kWords; w++)
+      count += __builtin_popcountll(fBitmaps[c][w]);
+  }
+
+  return count;
+}
+//------------------------------------------------------------------
+/// Combines two masks container by container.
+/// \param mask - second mask
+/// \param isAnd - true for intersection, false for union
+SFEventMask SFEventMask::Combine(const SFEventMask &mask, bool isAnd) const {
+
+  SFEventMask result(std::max(fNentries, mask.fNentries));
+  size_t i = 0, j = 0;
+
+  while(i<fKeys.size() || j<mask.fKeys.size()){
+
+    Long64_t keyThis  = i<fKeys.size()      ? fKeys[i]      : -1;
+    Long64_t keyOther = j<mask.fKeys.size() ? mask.fKeys[j] : -1;
+    Long64_t key;
+    int ci = -1, cj = -1;
+
+    if(keyOther<0 || (keyThis>=0 && keyThis<keyOther)){
+      key = keyThis; ci = i++;
+    }
+    else if(keyThis<0 || keyOther<keyThis){
+      key = keyOther; cj = j++;
+    }
+    else{
+      key = keyThis; ci = i++; cj = j++;
+    }
+
+    if(isAnd && (ci<0 || cj<0))
+      continue;
+
+    std::vector <ULong64_t> a = GetBitmap(ci);
+    std::vector <ULong64_t> b = mask.GetBitmap(cj);
+
+    for(int w=0; w<kWords; w++)
+      a[w] = isAnd ? (a[w] & b[w]) : (a[w] | b[w]);
+
+    result.AddContainer(key, a);
+  }
+
+  return result;
+}
+//------------------------------------------------------------------
+/// Returns intersection of the masks, i.e. entries passing both cuts.
+/// \param mask - second mask
+SFEventMask SFEventMask::And(const SFEventMask &mask) const {
+  return Combine(mask, true);
+}
+//------------------------------------------------------------------
+/// Returns union of the masks, i.e. entries passing any of the cuts.
+/// \param mask - second mask
+SFEventMask SFEventMask::Or(const SFEventMask &mask) const {
+  return Combine(mask, false);
+}
+//------------------------------------------------------------------
+/// Returns entries of the mask in the given range, in increasing order.
+/// \param first - first entry of the range
+/// \param last - entry after the last entry of the range
+std::vector <Long64_t> SFEventMask::GetEntries(Long64_t first, Long64_t last) const {
+
+  std::vector <Long64_t> entries;
+
+  auto it = std::lower_bound(fKeys.begin(), fKeys.end(), first>>16);
+
+  for(size_t c=it-fKeys.begin(); c<fKeys.size() && (fKeys[c]<<16)<last; c++){
+    Long64_t base = fKeys[c]<<16;
+    if(fBitmaps[c].empty()){
+      for(size_t k=0; k<fArrays[c].size(); k++){
+        Long64_t entry = base + fArrays[c][k];
+        if(entry>=first && entry<last) entries.push_back(entry);
+      }
+      continue;
+    }
+    for(int w=0; w<kWords; w++){
+      ULong64_t word = fBitmaps[c][w];
+      while(word!=0){
+        Long64_t entry = base + (w<<6) + __builtin_ctzll(word);
+        if(entry>=first && entry<last) entries.push_back(entry);
+        word &= word-1;
+      }
+    }
+  }
+
+  return entries;
+}
+//------------------------------------------------------------------
+/// Prints details of the SFEventMask class object.
+void SFEventMask::Print(void){
+  int ndense = 0;
+  for(size_t c=0; c<fKeys.size(); c++)
+    if(!fBitmaps[c].empty()) ndense++;
+  std::cout << "\n-------------------------------------------" << std::endl;
+  std::cout << "This is Print() for SFEventMask class object" << std::endl;
+  std::cout << "Number of entries in the mask: " << GetCount() << " of " << fNentries << std::endl;
+  std::cout << "Number of containers: " << fKeys.size() << " (" << ndense << " dense)" << std::endl;
+  std::cout << "-------------------------------------------\n" << std::endl;
+}
+//------------------------------------------------------------------
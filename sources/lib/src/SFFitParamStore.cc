@@ -0,0 +1,220 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *          SFFitParamStore.cc           *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#include "SFFitParamStore.hh"
+
+ClassImp(SFFitParamStore);
+
+TString SFFitParamStore::fDefaultDatabase = "";
+std::map <int, SFFitParamStore*> SFFitParamStore::fStores;
+
+//------------------------------------------------------------------
+/// Standard constructor. Loads entries of the requested series from the
+/// data base, if the FIT_PARAMS table exists. It is recommended to access
+/// stores via GetStore(), so that all peak finders of one series share
+/// the same store.
+/// \param database - results data base
+/// \param seriesNo - number of the experimental series
+SFFitParamStore::SFFitParamStore(TString database, int seriesNo): fDatabase(database),
+                                                                  fSeriesNo(seriesNo),
+                                                                  fNseeded(0) {
+  bool stat = Load();
+  if(!stat){
+    throw "##### Exception in SFFitParamStore constructor!";
+  }
+}
+//------------------------------------------------------------------
+/// Default destructor.
+SFFitParamStore::~SFFitParamStore(){
+}
+//------------------------------------------------------------------
+/// Enables the store. Fitting parameters of all series are kept in
+/// the given data base. Stores opened earlier are dropped.
+/// \param database - results data base
+void SFFitParamStore::SetDatabase(TString database){
+
+  fDefaultDatabase = database;
+
+  for(auto it=fStores.begin(); it!=fStores.end(); it++)
+    delete it->second;
+
+  fStores.clear();
+
+  return;
+}
+//------------------------------------------------------------------
+/// Returns store of the requested series. Stores are created once per
+/// series and shared by all peak finders. If the store is not enabled
+/// nullptr is returned.
+/// \param seriesNo - number of the experimental series
+SFFitParamStore* SFFitParamStore::GetStore(int seriesNo){
+
+  if(!IsEnabled())
+    return nullptr;
+
+  std::map <int, SFFitParamStore*>::iterator it = fStores.find(seriesNo);
+  if(it!=fStores.end())
+    return it->second;
+
+  SFFitParamStore *store = new SFFitParamStore(fDefaultDatabase, seriesNo);
+  fStores[seriesNo] = store;
+
+  return store;
+}
+//------------------------------------------------------------------
+/// Reads all entries of the series from the FIT_PARAMS table. Missing
+/// data base or table is not an error, the store is empty then.
+bool SFFitParamStore::Load(void){
+
+  fEntries.clear();
+  fModified.clear();
+
+  if(gSystem->AccessPathName(fDatabase))
+    return true;
+
+  sqlite3 *database;
+  sqlite3_stmt *statement;
+
+  int status = sqlite3_open_v2(fDatabase, &database, SQLITE_OPEN_READONLY, nullptr);
+
+  if(status!=SQLITE_OK){
+    std::cerr << "##### Error in SFFitParamStore::Load()! Cannot open data base!" << std::endl;
+    std::cerr << fDatabase << std::endl;
+    sqlite3_close(database);
+    return false;
+  }
+
+  TString query = Form("SELECT HIST_NAME, ENTRY FROM FIT_PARAMS WHERE SERIES_ID = %i", fSeriesNo);
+  status = sqlite3_prepare_v2(database, query, -1, &statement, nullptr);
+
+  //----- no table yet
+  if(status!=SQLITE_OK){
+    sqlite3_close(database);
+    return true;
+  }
+
+  while(sqlite3_step(statement)==SQLITE_ROW){
+    const unsigned char *hname = sqlite3_column_text(statement, 0);
+    const unsigned char *entry = sqlite3_column_text(statement, 1);
+    if(hname!=nullptr && entry!=nullptr)
+      fEntries[TString((const char*)hname)] = TString((const char*)entry);
+  }
+
+  sqlite3_finalize(statement);
+  sqlite3_close(database);
+
+  return true;
+}
+//------------------------------------------------------------------
+/// Writes all entries modified since the last call to the FIT_PARAMS
+/// table, in a single transaction. Table is created if necessary. If any
+/// step fails the transaction is rolled back and entries stay marked as
+/// modified, so they are written with the next Save().
+bool SFFitParamStore::Save(void){
+
+  if(fModified.empty())
+    return true;
+
+  sqlite3 *database;
+  sqlite3_stmt *statement;
+  long long now = (long long) time(nullptr);
+
+  int status = sqlite3_open(fDatabase, &database);
+
+  if(status!=SQLITE_OK){
+    std::cerr << "##### Error in SFFitParamStore::Save()! Cannot open data base!" << std::endl;
+    std::cerr << fDatabase << std::endl;
+    sqlite3_close(database);
+    return false;
+  }
+
+  status = sqlite3_exec(database, "CREATE TABLE IF NOT EXISTS 'FIT_PARAMS' ('SERIES_ID' INTEGER, 'HIST_NAME' TEXT, 'ENTRY' TEXT, 'DATE' INTEGER, PRIMARY KEY ('SERIES_ID', 'HIST_NAME'))", nullptr, nullptr, nullptr);
+
+  if(status==SQLITE_OK)
+    status = sqlite3_exec(database, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+
+  if(status!=SQLITE_OK){
+    std::cerr << "##### Error in SFFitParamStore::Save()! " << sqlite3_errmsg(database) << std::endl;
+    sqlite3_close(database);
+    return false;
+  }
+
+  status = sqlite3_prepare_v2(database, "INSERT OR REPLACE INTO FIT_PARAMS (SERIES_ID, HIST_NAME, ENTRY, DATE) VALUES (?, ?, ?, ?)", -1, &statement, nullptr);
+
+  bool ok = (status==SQLITE_OK);
+
+  for(auto it=fModified.begin(); ok && it!=fModified.end(); it++){
+    sqlite3_bind_int(statement, 1, fSeriesNo);
+    sqlite3_bind_text(statement, 2, it->Data(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(statement, 3, fEntries[*it].Data(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(statement, 4, now);
+    ok = (sqlite3_step(statement)==SQLITE_DONE);
+    sqlite3_reset(statement);
+  }
+
+  sqlite3_finalize(statement);
+
+  if(ok)
+    ok = (sqlite3_exec(database, "COMMIT", nullptr, nullptr, nullptr)==SQLITE_OK);
+
+  if(!ok){
+    std::cerr << "##### Error in SFFitParamStore::Save()! " << sqlite3_errmsg(database) << std::endl;
+    sqlite3_exec(database, "ROLLBACK", nullptr, nullptr, nullptr);
+    sqlite3_close(database);
+    return false;
+  }
+
+  sqlite3_close(database);
+
+  fModified.clear();
+
+  return true;
+}
+//------------------------------------------------------------------
+/// Returns FitterFactory entry of the histogram or empty string if
+/// there is none.
+/// \param hname - histogram name
+TString SFFitParamStore::GetEntry(TString hname){
+
+  std::map <TString, TString>::iterator it = fEntries.find(hname);
+  if(it==fEntries.end())
+    return "";
+
+  return it->second;
+}
+//------------------------------------------------------------------
+/// Sets FitterFactory entry of the histogram. Entry is written to the
+/// data base with the next Save().
+/// \param hname - histogram name
+/// \param entry - FitterFactory entry
+/// \param seeded - true if entry is a new initial guess, false if it
+/// is updated after the fit
+void SFFitParamStore::SetEntry(TString hname, TString entry, bool seeded){
+
+  fEntries[hname] = entry;
+  fModified.insert(hname);
+
+  if(seeded) fNseeded++;
+
+  return;
+}
+//------------------------------------------------------------------
+/// Prints details of the SFFitParamStore class object.
+void SFFitParamStore::Print(void){
+  std::cout << "\n-------------------------------------------" << std::endl;
+  std::cout << "This is Print() for SFFitParamStore class object" << std::endl;
+  std::cout << "Data base: " << fDatabase << std::endl;
+  std::cout << "Series number: " << fSeriesNo << std::endl;
+  std::cout << "Number of entries: " << fEntries.size() << std::endl;
+  std::cout << "Entries seeded in this session: " << fNseeded << std::endl;
+  std::cout << "Entries not saved yet: " << fModified.size() << std::endl;
+  std::cout << "-------------------------------------------\n" << std::endl;
+}
+//------------------------------------------------------------------
@@ -39,6 +39,7 @@ SFFitResults::SFFitResults(): fComponents(-1),
                               fFitXmin(-1),
                               fFitXmax(-1),
                               fFormula("dummy"),
+                              fStatMessage(""),
                               fName("dummy"),
                               fFunction(nullptr) {
                                   
@@ -72,6 +73,7 @@ SFFitResults::SFFitResults(TString name): fComponents(-1),
                                           fFitXmin(-1),
                                           fFitXmax(-1),
                                           fFormula("dummy"),
+                                          fStatMessage(""),
                                           fName(name),
                                           fFunction(nullptr) {
 
@@ -103,6 +105,7 @@ SFFitResults::SFFitResults(TString name, TF1 *fun): fComponents(-1),
                                                     fFitXmin(-1),
                                                     fFitXmax(-1),
                                                     fFormula("dummy"),
+                                                    fStatMessage(""),
                                                     fName(name),
                                                     fFunction(fun) {
 
@@ -187,40 +190,30 @@ bool SFFitResults::SetFromFunction(TF1 *fun){
   }
   
   //----- Determining fit validity
+  //----- Nothing is printed here, since fits of different signals may be
+  //----- performed in parallel. Reason of the failure is kept in fStatMessage.
+  fStat = 0;
+  fStatMessage = "";
+  
   if(fComponents==1){
-    if(fAmp<0){
-      std::cout << "##### Warning in SFFitResults::SetFromFunction()!" << std::endl;
-      std::cout << "\t Negative amplitude!" << std::endl;
-      fStat = -1;
-    }
-    else if(fDecTime<0 || fDecTime>1E2){
-      std::cout << "##### Warning in SFFitResults::SetFromFunction()!" << std::endl;
-      std::cout << "\t Decay time out of range!" << std::endl;
-      fStat = -1;
-    }
-    else fStat = 0;
+    if(fAmp<0)
+      fStatMessage = "Negative amplitude!";
+    else if(fDecTime<0 || fDecTime>1E2)
+      fStatMessage = "Decay time out of range!";
   }
   
   if(fComponents==2){
-    if(fAmpFast<0 || fAmpSlow<0){
-      std::cout << "##### Warning in SFFitResults::SetFromFunction()!" << std::endl;
-      std::cout << "\t Negative amplitude!" << std::endl;
-      fStat = -1;
-    }
-    else if(fFastDecTime<0 || fFastDecTime>1E3){
-      std::cout << "##### Warning in SFFitResults::SetFromFunction()!" << std::endl;
-      std::cout << "\t Fast decay time out of range!" << std::endl;
-      fStat = -1;
-    }
-    else if(fSlowDecTime<0 || fSlowDecTime>1E4){
-      std::cout << "##### Warning in SFFitResults::SetFromFunction()!" << std::endl;
-      std::cout << "\t Slow decay time out of range!" << std::endl;
-      fStat = -1;
-    }
-    else
-      fStat = 0;
+    if(fAmpFast<0 || fAmpSlow<0)
+      fStatMessage = "Negative amplitude!";
+    else if(fFastDecTime<0 || fFastDecTime>1E3)
+      fStatMessage = "Fast decay time out of range!";
+    else if(fSlowDecTime<0 || fSlowDecTime>1E4)
+      fStatMessage = "Slow decay time out of range!";
   }
   
+  if(fStatMessage!="")
+    fStat = -1;
+  
   return true;
 }
 //------------------------------------------------------------------
@@ -531,6 +524,8 @@ void SFFitResults::Print(void){
   std::cout << "This is Print of SFFitResults class object " << fName << std::endl;
   std::cout << "Fitted function: " << fFormula << std::endl;
   std::cout << "Fit status: " << fStat << std::endl;
+  if(fStatMessage!="")
+    std::cout << "Fit invalid: " << fStatMessage << std::endl;
   std::cout << "Number of parameters: " << fNpar << std::endl;
   std::cout << "Chi2 = " << fChi2 << std::endl;
   std::cout << "Chi2/NDF = " << fChi2/fNDF << std::endl;
@@ -0,0 +1,282 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *           SFHistPyramid.cc            *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#include "SFHistPyramid.hh"
+#include "SFSpectrumInfo.hh"
+
+ClassImp(SFHistPyramid);
+
+//------------------------------------------------------------------
+/// Default constructor.
+SFHistPyramid::SFHistPyramid() : fFine(nullptr),
+                                 fNbins(-1) {
+}
+//------------------------------------------------------------------
+/// Standard constructor. Pyramid is not attached to the histogram,
+/// use GetPyramid() for this.
+/// \param fine - histogram with the finest binning
+SFHistPyramid::SFHistPyramid(TH1D *fine) : fFine(fine),
+                                           fNbins(-1) {
+  Update();
+}
+//------------------------------------------------------------------
+/// Default destructor. Histograms of the coarser levels are deleted.
+SFHistPyramid::~SFHistPyramid(){
+  DeleteLevels();
+}
+//------------------------------------------------------------------
+/// Returns pyramid attached to the histogram. If there is none, new
+/// pyramid is created and attached, histogram takes its ownership.
+/// Pyramid read from the file or cloned together with the histogram
+/// is bound to the histogram again.
+/// \param hist - histogram with the finest binning
+SFHistPyramid* SFHistPyramid::GetPyramid(TH1D *hist){
+
+  if(hist==nullptr)
+    return nullptr;
+
+  SFHistPyramid *pyramid = (SFHistPyramid*)hist->GetListOfFunctions()->FindObject("SFHistPyramid");
+
+  if(pyramid==nullptr){
+    pyramid = new SFHistPyramid(hist);
+    hist->GetListOfFunctions()->Add(pyramid);
+  }
+  else if(pyramid->fFine!=hist){
+    pyramid->fFine = hist;
+    pyramid->Update();
+  }
+
+  return pyramid;
+}
+//------------------------------------------------------------------
+/// Recalculates cumulative sums of the fine histogram and drops histograms
+/// of the coarser levels. Should be called if the fine histogram was
+/// refilled. Change of the number of fine bins is detected automatically.
+void SFHistPyramid::Update(void){
+
+  DeleteLevels();
+
+  if(fFine!=nullptr)
+    Build();
+
+  return;
+}
+//------------------------------------------------------------------
+/// Calculates cumulative sums of contents and squared errors of the
+/// fine bins.
+void SFHistPyramid::Build(void){
+
+  fNbins = fFine->GetNbinsX();
+  fSumW.assign(fNbins+1, 0);
+  fSumW2.assign(fNbins+1, 0);
+
+  for(int bin=1; bin<=fNbins; bin++){
+    double error = fFine->GetBinError(bin);
+    fSumW[bin]  = fSumW[bin-1] + fFine->GetBinContent(bin);
+    fSumW2[bin] = fSumW2[bin-1] + error*error;
+  }
+
+  return;
+}
+//------------------------------------------------------------------
+/// Deletes histograms of the coarser levels.
+void SFHistPyramid::DeleteLevels(void){
+
+  for(size_t i=0; i<fLevels.size(); i++)
+    delete fLevels[i];
+
+  fLevels.assign(kMaxLevel+1, nullptr);
+
+  return;
+}
+//------------------------------------------------------------------
+/// Checks whether the level is available and sums are up to date.
+/// \param level - level of the pyramid
+/// \param function - name of the calling function, for error messages
+bool SFHistPyramid::Check(int level, TString function){
+
+  if(fFine==nullptr){
+    std::cerr << "##### Error in SFHistPyramid::" << function << "()!" << std::endl;
+    std::cerr << "Pyramid is not bound to any histogram!" << std::endl;
+    return false;
+  }
+
+  if(level<0 || level>kMaxLevel){
+    std::cerr << "##### Error in SFHistPyramid::" << function << "()!" << std::endl;
+    std::cerr << "Incorrect level: " << level << ", available levels: 0-" << kMaxLevel << std::endl;
+    return false;
+  }
+
+  if(fFine->GetNbinsX()!=fNbins)
+    Update();
+
+  return true;
+}
+//------------------------------------------------------------------
+/// Returns number of bins of the level.
+/// \param level - level of the pyramid, bins are merged by 2^level
+int SFHistPyramid::GetNbins(int level){
+
+  if(!Check(level, "GetNbins"))
+    return 0;
+
+  return fNbins >> level;
+}
+//------------------------------------------------------------------
+/// Returns bin content of the level. Bin 0 is underflow, bin
+/// GetNbins(level)+1 is overflow, which includes leftover fine bins.
+/// \param level - level of the pyramid, bins are merged by 2^level
+/// \param bin - bin number at the level
+double SFHistPyramid::GetBinContent(int level, int bin){
+
+  if(!Check(level, "GetBinContent"))
+    return 0;
+
+  int group = 1 << level;
+  int nbins = fNbins >> level;
+
+  if(bin<=0)
+    return fFine->GetBinContent(0);
+
+  if(bin>nbins)
+    return fFine->GetBinContent(fNbins+1) + fSumW[fNbins] - fSumW[nbins*group];
+
+  return fSumW[bin*group] - fSumW[(bin-1)*group];
+}
+//------------------------------------------------------------------
+/// Returns bin error of the level, i.e. fine errors added in quadrature.
+/// \param level - level of the pyramid, bins are merged by 2^level
+/// \param bin - bin number at the level
+double SFHistPyramid::GetBinError(int level, int bin){
+
+  if(!Check(level, "GetBinError"))
+    return 0;
+
+  int group = 1 << level;
+  int nbins = fNbins >> level;
+  double error;
+
+  if(bin<=0)
+    return fFine->GetBinError(0);
+
+  if(bin>nbins){
+    error = fFine->GetBinError(fNbins+1);
+    return sqrt(error*error + fSumW2[fNbins] - fSumW2[nbins*group]);
+  }
+
+  return sqrt(fSumW2[bin*group] - fSumW2[(bin-1)*group]);
+}
+//------------------------------------------------------------------
+/// Returns sum of the bin contents of the level in the given range of
+/// bins. Range is limited to the bins of the level (without underflow
+/// and overflow).
+/// \param level - level of the pyramid, bins are merged by 2^level
+/// \param binLow - first bin of the range
+/// \param binHigh - last bin of the range
+double SFHistPyramid::GetIntegral(int level, int binLow, int binHigh){
+
+  if(!Check(level, "GetIntegral"))
+    return 0;
+
+  int group = 1 << level;
+  int nbins = fNbins >> level;
+
+  binLow  = std::max(binLow, 1);
+  binHigh = std::min(binHigh, nbins);
+
+  if(binHigh<binLow)
+    return 0;
+
+  return fSumW[binHigh*group] - fSumW[(binLow-1)*group];
+}
+//------------------------------------------------------------------
+/// Returns histogram of the level, level 0 is the fine histogram itself.
+/// Histogram is built on the first request and kept by the pyramid,
+/// thus it must not be deleted. It has the same name and title as the
+/// fine histogram and is equivalent to the result of TH1::Rebin(2^level).
+/// Copy of the metadata record of the fine histogram (see SFSpectrumInfo),
+/// if any, is attached, so the level can replace the fine histogram.
+/// \param level - level of the pyramid, bins are merged by 2^level
+TH1D* SFHistPyramid::GetLevel(int level){
+
+  if(!Check(level, "GetLevel"))
+    return nullptr;
+
+  if(level==0)
+    return fFine;
+
+  if(fLevels[level]!=nullptr)
+    return fLevels[level];
+
+  int group = 1 << level;
+  int nbins = fNbins >> level;
+
+  if(nbins<1){
+    std::cerr << "##### Error in SFHistPyramid::GetLevel()!" << std::endl;
+    std::cerr << "Too few bins of the fine histogram: " << fNbins << std::endl;
+    return nullptr;
+  }
+
+  TH1D *hist = nullptr;
+
+  if(fFine->GetXaxis()->GetXbins()->GetSize()>0){
+    std::vector <double> edges(nbins+1);
+    for(int i=0; i<=nbins; i++)
+      edges[i] = fFine->GetBinLowEdge(i*group+1);
+    hist = new TH1D(fFine->GetName(), fFine->GetTitle(), nbins, edges.data());
+  }
+  else{
+    hist = new TH1D(fFine->GetName(), fFine->GetTitle(), nbins,
+                    fFine->GetBinLowEdge(1), fFine->GetBinLowEdge(nbins*group+1));
+  }
+
+  hist->SetDirectory(nullptr);
+  hist->GetXaxis()->SetTitle(fFine->GetXaxis()->GetTitle());
+  hist->GetYaxis()->SetTitle(fFine->GetYaxis()->GetTitle());
+
+  bool sumw2 = fFine->GetSumw2N()>0;
+  if(sumw2) hist->Sumw2();
+
+  for(int bin=0; bin<=nbins+1; bin++){
+    hist->SetBinContent(bin, GetBinContent(level, bin));
+    if(sumw2) hist->SetBinError(bin, GetBinError(level, bin));
+  }
+
+  //----- statistics of the fine histogram, like in TH1::Rebin()
+  double stats[TH1::kNstat];
+  fFine->GetStats(stats);
+  hist->SetEntries(fFine->GetEntries());
+  hist->PutStats(stats);
+
+  SFSpectrumInfo *info = SFSpectrumInfo::GetInfo(fFine);
+  if(info!=nullptr)
+    ((SFSpectrumInfo*)info->Clone())->Attach(hist);
+
+  fLevels[level] = hist;
+
+  return hist;
+}
+//------------------------------------------------------------------
+/// Prints details of the SFHistPyramid class object.
+void SFHistPyramid::Print(void){
+  std::cout << "\n-------------------------------------------" << std::endl;
+  std::cout << "This is Print() for SFHistPyramid class object" << std::endl;
+  if(fFine==nullptr){
+    std::cout << "Pyramid is not bound to any histogram" << std::endl;
+  }
+  else{
+    std::cout << "Fine histogram: " << fFine->GetName() << std::endl;
+    for(int level=0; level<=kMaxLevel; level++)
+      std::cout << "Level " << level << ": " << (fNbins >> level) << " bins"
+                << (level>0 && fLevels[level]!=nullptr ? " (histogram built)" : "") << std::endl;
+  }
+  std::cout << "-------------------------------------------\n" << std::endl;
+}
+//------------------------------------------------------------------
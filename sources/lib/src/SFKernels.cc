@@ -0,0 +1,108 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *             SFKernels.cc              *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#include "SFKernels.hh"
+
+//------------------------------------------------------------------
+/// Dispatches selection to its compile-time kernel (see SFKernel),
+/// computes it for the whole block and fills histogram with events
+/// which passed the cut. If nullptr is passed as histogram, only the 
+/// x and y buffers are filled. Returns false for unknown selection type.
+/// \param desc - typed selection descriptor
+/// \param block - block of events
+/// \param x - buffer for values along X axis (SFEventBlock::kCapacity elements)
+/// \param y - buffer for values along Y axis (SFEventBlock::kCapacity elements)
+/// \param pass - flags of events which passed the cut
+/// \param hist - histogram to be filled or nullptr
+bool SFKernels::Process(const SFSelection &desc, const SFEventBlock &block,
+                        double *x, double *y, const char *pass, TH1 *hist){
+
+  switch(desc.fType){
+      case SFSelectionType::PE:
+          Run<SFSelectionType::PE>(desc, block, x, y, pass, hist);
+          return true;
+      case SFSelectionType::Charge:
+          Run<SFSelectionType::Charge>(desc, block, x, y, pass, hist);
+          return true;
+      case SFSelectionType::Amplitude:
+          Run<SFSelectionType::Amplitude>(desc, block, x, y, pass, hist);
+          return true;
+      case SFSelectionType::T0:
+          Run<SFSelectionType::T0>(desc, block, x, y, pass, hist);
+          return true;
+      case SFSelectionType::TOT:
+          Run<SFSelectionType::TOT>(desc, block, x, y, pass, hist);
+          return true;
+      case SFSelectionType::LogSqrtPERatio:
+          Run<SFSelectionType::LogSqrtPERatio>(desc, block, x, y, pass, hist);
+          return true;
+      case SFSelectionType::T0Difference:
+          Run<SFSelectionType::T0Difference>(desc, block, x, y, pass, hist);
+          return true;
+      case SFSelectionType::PEAverage:
+          Run<SFSelectionType::PEAverage>(desc, block, x, y, pass, hist);
+          return true;
+      case SFSelectionType::AmplitudeAverage:
+          Run<SFSelectionType::AmplitudeAverage>(desc, block, x, y, pass, hist);
+          return true;
+      case SFSelectionType::PECorrelation:
+          Run<SFSelectionType::PECorrelation>(desc, block, x, y, pass, hist);
+          return true;
+      case SFSelectionType::AmplitudeCorrelation:
+          Run<SFSelectionType::AmplitudeCorrelation>(desc, block, x, y, pass, hist);
+          return true;
+      case SFSelectionType::T0Correlation:
+          Run<SFSelectionType::T0Correlation>(desc, block, x, y, pass, hist);
+          return true;
+      case SFSelectionType::AmpPECorrelation:
+          Run<SFSelectionType::AmpPECorrelation>(desc, block, x, y, pass, hist);
+          return true;
+      case SFSelectionType::PEvsPEch2Correlation:
+          Run<SFSelectionType::PEvsPEch2Correlation>(desc, block, x, y, pass, hist);
+          return true;
+      case SFSelectionType::PEAttCorrected:
+          Run<SFSelectionType::PEAttCorrected>(desc, block, x, y, pass, hist);
+          return true;
+      case SFSelectionType::PEAttCorrectedSum:
+          Run<SFSelectionType::PEAttCorrectedSum>(desc, block, x, y, pass, hist);
+          return true;
+      default:
+          std::cerr << "##### Error in SFKernels::Process()!" << std::endl;
+          std::cerr << "Unknown selection type! Please check!" << std::endl;
+          return false;
+  }
+}
+//------------------------------------------------------------------
+/// Returns dimension of the histogram filled with the kernel of the
+/// given selection type, 0 for unknown selection type.
+/// \param selection - selection type
+int SFKernels::GetDimension(SFSelectionType selection){
+
+  switch(selection){
+      case SFSelectionType::PE:                   return SFKernel<SFSelectionType::PE>::kDim;
+      case SFSelectionType::Charge:               return SFKernel<SFSelectionType::Charge>::kDim;
+      case SFSelectionType::Amplitude:            return SFKernel<SFSelectionType::Amplitude>::kDim;
+      case SFSelectionType::T0:                   return SFKernel<SFSelectionType::T0>::kDim;
+      case SFSelectionType::TOT:                  return SFKernel<SFSelectionType::TOT>::kDim;
+      case SFSelectionType::LogSqrtPERatio:       return SFKernel<SFSelectionType::LogSqrtPERatio>::kDim;
+      case SFSelectionType::T0Difference:         return SFKernel<SFSelectionType::T0Difference>::kDim;
+      case SFSelectionType::PEAverage:            return SFKernel<SFSelectionType::PEAverage>::kDim;
+      case SFSelectionType::AmplitudeAverage:     return SFKernel<SFSelectionType::AmplitudeAverage>::kDim;
+      case SFSelectionType::PECorrelation:        return SFKernel<SFSelectionType::PECorrelation>::kDim;
+      case SFSelectionType::AmplitudeCorrelation: return SFKernel<SFSelectionType::AmplitudeCorrelation>::kDim;
+      case SFSelectionType::T0Correlation:        return SFKernel<SFSelectionType::T0Correlation>::kDim;
+      case SFSelectionType::AmpPECorrelation:     return SFKernel<SFSelectionType::AmpPECorrelation>::kDim;
+      case SFSelectionType::PEvsPEch2Correlation: return SFKernel<SFSelectionType::PEvsPEch2Correlation>::kDim;
+      case SFSelectionType::PEAttCorrected:       return SFKernel<SFSelectionType::PEAttCorrected>::kDim;
+      case SFSelectionType::PEAttCorrectedSum:    return SFKernel<SFSelectionType::PEAttCorrectedSum>::kDim;
+      default:                                    return 0;
+  }
+}
+//------------------------------------------------------------------
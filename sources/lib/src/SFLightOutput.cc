@@ -18,12 +18,8 @@ ClassImp(SFLightOutput);
 SFLightOutput::SFLightOutput(int seriesNo): fSeriesNo(seriesNo),
                                             fPDE(-1), 
                                             fCrossTalk(-1),
-                                            fLightOutGraph(nullptr),
-                                            fLightOutCh0Graph(nullptr),
-                                            fLightOutCh1Graph(nullptr),
-                                            fLightColGraph(nullptr),
-                                            fLightColCh0Graph(nullptr),
-                                            fLightColCh1Graph(nullptr),
+                                            fNchannels(2),
+                                            fNfibers(1),
                                             fData(nullptr),
                                             fAtt(nullptr) {
                                                 
@@ -43,14 +39,36 @@ SFLightOutput::SFLightOutput(int seriesNo): fSeriesNo(seriesNo),
     std::cout << "Calculating light output for non-regular series!" << std::endl;
   }
   
-  TString cutCh0 = "ch_0.fT0>0 && ch_0.fT0<590 && ch_0.fPE>0";
-  TString cutCh1 = "ch_1.fT0>0 && ch_1.fT0<590 && ch_1.fPE>0";
-  fSpectraCh0 = fData->GetSpectra(0, SFSelectionType::PE, cutCh0);
-  fSpectraCh1 = fData->GetSpectra(1, SFSelectionType::PE, cutCh1);
-
+  fNchannels = fData->GetNchannels();
+  fNfibers = fNchannels/2;
+  fLightOutGraph.resize(fNfibers, nullptr);
+  fLightColGraph.resize(fNfibers, nullptr);
+  fLightOutResults.fResFib.resize(fNfibers, -1);
+  fLightOutResults.fResFibErr.resize(fNfibers, -1);
+  fLightColResults.fResFib.resize(fNfibers, -1);
+  fLightColResults.fResFibErr.resize(fNfibers, -1);
+  fLightOutChGraph.resize(fNchannels, nullptr);
+  fLightColChGraph.resize(fNchannels, nullptr);
+  fSpectraCh.resize(fNchannels);
+  fPFCh.resize(fNchannels);
+  fLightOutResults.fResCh.resize(fNchannels, -1);
+  fLightOutResults.fResChErr.resize(fNchannels, -1);
+  fLightColResults.fResCh.resize(fNchannels, -1);
+  fLightColResults.fResChErr.resize(fNchannels, -1);
+  
+  std::vector <int> measIDs = fData->GetMeasurementsIDs();
+  std::vector <TString> cuts(fNchannels);
+  std::vector <TH1D*> tmp;
+  
+  for(int ch=0; ch<fNchannels; ch++)
+    cuts[ch] = Form("ch_%i.fT0>0 && ch_%i.fT0<590 && ch_%i.fPE>0", ch, ch, ch);
+  
   for(int i=0; i<npoints; i++){
-      fPFCh0.push_back(new SFPeakFinder(fSpectraCh0[i], 0));
-      fPFCh1.push_back(new SFPeakFinder(fSpectraCh1[i], 0));
+    tmp = fData->GetChannelSpectra(SFSelectionType::PE, cuts, measIDs[i]);
+    for(int ch=0; ch<fNchannels; ch++){
+      fSpectraCh[ch].push_back(tmp[ch]);
+      fPFCh[ch].push_back(new SFPeakFinder(tmp[ch], 0));
+    }
   }
   
   fCrossTalk = GetCrossTalk();
@@ -203,55 +221,41 @@ SFLightOutput::~SFLightOutput(){
     delete fAtt;
 }
 //------------------------------------------------------------------
+/// Sums light output of both ends of every fiber, i.e. of channels 2k and
+/// 2k+1, for which light output of single channels was calculated with 
+/// CalculateLightOut(int). Averaged results are stored per fiber, result of
+/// the first fiber is also stored as the result of the series.
 bool SFLightOutput::CalculateLightOut(void){
     
   std::cout << "\n----- Inside SFLightOutput::CalculateLightOut()" << std::endl;
   std::cout << "----- Series: " << fSeriesNo << std::endl;
   
-  if(fLightOutCh0Graph==nullptr || 
-     fLightOutCh1Graph==nullptr){
+  int nsummed = 0;
+  
+  for(int k=0; k<fNfibers; k++){
+    TString gname = Form("LightOutSum_S%i_fib%i", fSeriesNo, k);
+    TGraphErrors *graph = SumChannels(fLightOutChGraph, k, gname, "light output [PE/MeV]",
+                                      fLightOutResults.fResFib[k], fLightOutResults.fResFibErr[k]);
+    if(graph==nullptr) continue;
+    
+    fLightOutGraph[k] = graph;
+    nsummed++;
+    
+    std::cout << "Averaged and summed light output, fiber " << k << ": " << fLightOutResults.fResFib[k]
+              << " +/- " << fLightOutResults.fResFibErr[k] << " ph/MeV" << std::endl;
+  }
+  
+  if(nsummed==0){
     std::cerr << "##### Error in SFLightOutput::CalculateLightOut()" << std::endl;
-    std::cerr << "fLightOutCh0Graph and fLightOutCh1Graph don't exist!" << std::endl;
-    std::cerr << "Run analysis for channels 0 and 1 first!" << std::endl;
+    std::cerr << "fLightOutChGraph for channel pairs don't exist!" << std::endl;
+    std::cerr << "Run analysis for single channels first!" << std::endl;
     return false;
   }
   
-  int npoints = fData->GetNpoints();
-  TString collimator = fData->GetCollimator();
-  TString testBench = fData->GetTestBench();
-  std::vector <double> positions = fData->GetPositions();
-  
-  TString gname = Form("LightOutSum_S%i", fSeriesNo);
-  TGraphErrors *graph = new TGraphErrors(npoints);
-  graph->GetXaxis()->SetTitle("source position [mm]");
-  graph->GetYaxis()->SetTitle("light output [PE/MeV]");
-  graph->SetName(gname);
-  graph->SetTitle(gname);
-  graph->SetMarkerStyle(4);
-  
-  double lightOut      = 0;
-  double lightOutErr   = 0;
-  double lightOutAv    = 0;
-  double lightOutAvErr = 0;
-  double x, yCh0, yCh1;
-  
-  for(int i=0; i<npoints; i++){
-    fLightOutCh0Graph->GetPoint(i, x, yCh0);
-    fLightOutCh1Graph->GetPoint(i, x, yCh1);
-    lightOut = yCh0+yCh1;
-    lightOutErr = sqrt(pow(fLightOutCh0Graph->GetErrorY(i),2) + pow(fLightOutCh1Graph->GetErrorY(i),2));
-    graph->SetPoint(i, positions[i], lightOut);
-    graph->SetPointError(i, SFTools::GetPosError(collimator, testBench), lightOutErr);
-    lightOutAv += lightOut*(1./pow(lightOutErr, 2));
-    lightOutAvErr += 1./pow(lightOutErr, 2);
+  if(fNfibers>0){
+    fLightOutResults.fRes    = fLightOutResults.fResFib[0];
+    fLightOutResults.fResErr = fLightOutResults.fResFibErr[0];
   }
-  
-  fLightOutResults.fRes    = lightOutAv/lightOutAvErr;
-  fLightOutResults.fResErr = sqrt(1./lightOutAvErr);
-  fLightOutGraph = graph;
-  
-  std::cout << "Averaged and summed light output: " << fLightOutResults.fRes
-            <<" +/- " << fLightOutResults.fResErr << " ph/MeV" << std::endl;
 
   return true;  
 }
@@ -283,18 +287,14 @@ bool SFLightOutput::CalculateLightOut(int ch){
   
   AttenuationResults results = att->GetResults();
   
-  for(int i=0; i<npoints; i++){
-    if(ch==0)
-      peakFin = fPFCh0; 
-    else if(ch==1)
-      peakFin = fPFCh1; 
-    else{
-      std::cerr << "##### Error in SFLightOutput::CalculateLightOut!" << std::endl;
-      std::cerr << "Incorrect channel number" << std::endl;
-      return false;
-    }
+  if(ch<0 || ch>=fNchannels){
+    std::cerr << "##### Error in SFLightOutput::CalculateLightOut!" << std::endl;
+    std::cerr << "Incorrect channel number" << std::endl;
+    return false;
   }
   
+  peakFin = fPFCh[ch];
+  
   TString gname = Form("LightOut_S%i_Ch%i", fSeriesNo, ch);
 
   TGraphErrors *graph = new TGraphErrors(npoints);
@@ -311,11 +311,13 @@ bool SFLightOutput::CalculateLightOut(int ch){
   double lightOutAvErr = 0;
   double distance = 0;
   
+  SFPeakFinder::FindPeakFitsSeries(peakFin, positions);
+  
   for(int i=0; i<npoints; i++){
     
-    peakFin[i]->FindPeakFit();
-    if(ch==0) distance = positions[i];
-    if(ch==1) distance = fiberLen - positions[i];
+    //--- even channels read out the fiber end at position 0, odd ones the opposite end
+    if(ch%2==0) distance = positions[i];
+    else        distance = fiberLen - positions[i];
     parameters = peakFin[i]->GetParameters();
     
     lightOut = parameters.fPosition*(1-fCrossTalk)/fPDE/0.511/TMath::Exp(-distance/results.fAttCombPol1);
@@ -330,16 +332,9 @@ bool SFLightOutput::CalculateLightOut(int ch){
   lightOutAv = lightOutAv/lightOutAvErr;
   lightOutAvErr = sqrt(1./lightOutAvErr);
   
-  if(ch==0){
-    fLightOutResults.fResCh0    = lightOutAv;
-    fLightOutResults.fResCh0Err = lightOutAvErr;
-    fLightOutCh0Graph = graph;
-  }
-  else if(ch==1){
-    fLightOutResults.fResCh1    = lightOutAv;
-    fLightOutResults.fResCh1Err = lightOutAvErr;
-    fLightOutCh1Graph = graph;
-  }
+  fLightOutResults.fResCh[ch]    = lightOutAv;
+  fLightOutResults.fResChErr[ch] = lightOutAvErr;
+  fLightOutChGraph[ch] = graph;
   
   std::cout << "Average light output for channel " << ch << ": " << lightOutAv 
             << " +/- " << lightOutAvErr << " ph/MeV \n" << std::endl;
@@ -347,55 +342,41 @@ bool SFLightOutput::CalculateLightOut(int ch){
   return true;  
 }
 //------------------------------------------------------------------
+/// Sums collected light of both ends of every fiber, i.e. of channels 2k 
+/// and 2k+1, for which light collection of single channels was calculated
+/// with CalculateLightCol(int). Averaged results are stored per fiber, result
+/// of the first fiber is also stored as the result of the series.
 bool SFLightOutput::CalculateLightCol(void){
   
   std::cout << "\n----- Inside SFLightOutput::CalculateLCol()" << std::endl;
   std::cout << "----- Series: " << fSeriesNo << std::endl;
   
-  if(fLightColCh0Graph==nullptr || 
-     fLightColCh1Graph==nullptr){
+  int nsummed = 0;
+  
+  for(int k=0; k<fNfibers; k++){
+    TString gname = Form("LCol_s%i_sum_fib%i", fSeriesNo, k);
+    TGraphErrors *graph = SumChannels(fLightColChGraph, k, gname, "collected light [PE/MeV]",
+                                      fLightColResults.fResFib[k], fLightColResults.fResFibErr[k]);
+    if(graph==nullptr) continue;
+    
+    fLightColGraph[k] = graph;
+    nsummed++;
+    
+    std::cout << "Average light collection, fiber " << k << ": " << fLightColResults.fResFib[k]
+              << " +/- " << fLightColResults.fResFibErr[k] << " ph/MeV" << std::endl;
+  }
+  
+  if(nsummed==0){
     std::cerr << "##### Error in SFLightOutput::CalculateLightCol()" << std::endl;
-    std::cerr << "fLightColCh0Graph and fLightColCh1Graph don't exist!" << std::endl;
-    std::cerr << "Run analysis for channels 0 and 1 first!" << std::endl;
+    std::cerr << "fLightColChGraph for channel pairs don't exist!" << std::endl;
+    std::cerr << "Run analysis for single channels first!" << std::endl;
     return false;
   }
   
-  int npoints = fData->GetNpoints();
-  TString collimator = fData->GetCollimator();
-  TString testBench = fData->GetTestBench();
-  std::vector <double> positions = fData->GetPositions();
-  
-  TString gname = Form("LCol_s%i_sum",fSeriesNo);
-  TGraphErrors* graph = new TGraphErrors(npoints);
-  graph->GetXaxis()->SetTitle("source position [mm]");
-  graph->GetYaxis()->SetTitle("collected light [PE/MeV]");
-  graph->SetTitle(gname);
-  graph->SetName(gname);
-  graph->SetMarkerStyle(4);
-  
-  double lightCol      = 0;
-  double lightColErr   = 0;
-  double lightColAv    = 0;
-  double lightColAvErr = 0;
-  double x, yCh0, yCh1;
-  
-  for(int i=0; i<npoints; i++){
-    fLightColCh0Graph->GetPoint(i, x, yCh0);
-    fLightColCh1Graph->GetPoint(i, x, yCh1);
-    lightCol = yCh0+yCh1;
-    lightColErr = sqrt(pow(fLightColCh0Graph->GetErrorY(i), 2) + pow(fLightColCh1Graph->GetErrorY(i),2));
-    graph->SetPoint(i, positions[i], lightCol);
-    graph->SetPointError(i, SFTools::GetPosError(collimator, testBench), lightColErr);
-    lightColAv += lightCol*(1./pow(lightColErr, 2));
-    lightColAvErr += 1./pow(lightColErr, 2);
+  if(fNfibers>0){
+    fLightColResults.fRes    = fLightColResults.fResFib[0];
+    fLightColResults.fResErr = fLightColResults.fResFibErr[0];
   }
-  
-  fLightColResults.fRes    = lightColAv/lightColAvErr;
-  fLightColResults.fResErr = sqrt(1./lightColAvErr);
-  fLightColGraph = graph;
-  
-  std::cout << "Average light collection for this series: " << fLightColResults.fRes
-            << " +/- " << fLightColResults.fResErr << " ph/MeV" << std::endl;
  
   return true;
 }
@@ -425,17 +406,15 @@ bool SFLightOutput::CalculateLightCol(int ch){
   double lightColAv = 0;
   double lightColAvErr = 0;
   
+  if(ch<0 || ch>=fNchannels){
+    std::cerr << "##### Error in SFLightOutput::CalculateLightCol()!" << std::endl;
+    std::cerr << "Incorrect channel number! Please check!" << std::endl;
+    return false;
+  }
+  
+  tempPF = fPFCh[ch];
+  
   for(int i=0; i<npoints; i++){
-    if(ch==0)  
-      tempPF = fPFCh0; 
-    else if(ch==1)
-      tempPF = fPFCh1;
-    else{
-      std::cerr << "##### Error in SFLightOutput::CalculateLightCol()!" << std::endl;
-      std::cerr << "Incorrect channel number! Please check!" << std::endl;
-      return false;
-    }
-    
     peak_par = tempPF[i]->GetParameters();
     lightCol = peak_par.fPosition/0.511;
     lightColErr = peak_par.fSigma/0.511;
@@ -449,16 +428,9 @@ bool SFLightOutput::CalculateLightCol(int ch){
   lightColAv = lightColAv/lightColAvErr;
   lightColAvErr = sqrt(1./lightColAvErr);
   
-  if(ch==0){
-    fLightColCh0Graph = graph;
-    fLightColResults.fResCh0    = lightColAv;
-    fLightColResults.fResCh0Err = lightColAvErr;
-  }
-  else if(ch==1){
-    fLightColCh1Graph = graph;
-    fLightColResults.fResCh1    = lightColAv;
-    fLightColResults.fResCh1Err = lightColAvErr;
-  }
+  fLightColChGraph[ch] = graph;
+  fLightColResults.fResCh[ch]    = lightColAv;
+  fLightColResults.fResChErr[ch] = lightColAvErr;
  
   std::cout << "Average light collection for this series and channel " << ch 
             << ": " << lightColAv << " +/- " << lightColAvErr << " ph/MeV" << std::endl;
@@ -466,84 +438,150 @@ bool SFLightOutput::CalculateLightCol(int ch){
   return true;
 }
 //------------------------------------------------------------------
+/// Returns graph of the sum of channels 2*fiber and 2*fiber+1 vs. source 
+/// position and its weighted average. If graph of any of the channels 
+/// doesn't exist, warning is printed and nullptr is returned.
+/// \param graphsCh - graphs of single channels
+/// \param fiber - fiber number
+/// \param gname - name of the returned graph
+/// \param ytitle - title of the Y axis
+/// \param av - weighted average (returned)
+/// \param avErr - uncertainty of the weighted average (returned)
+TGraphErrors* SFLightOutput::SumChannels(std::vector <TGraphErrors*> &graphsCh, int fiber,
+                                         TString gname, TString ytitle, double &av, double &avErr){
+  
+  int chL = 2*fiber;
+  int chR = 2*fiber+1;
+  
+  if(graphsCh[chL]==nullptr || graphsCh[chR]==nullptr){
+    std::cout << "##### Warning in SFLightOutput::SumChannels()!" << std::endl;
+    std::cout << "Graphs for channels " << chL << " and " << chR 
+              << " don't exist, fiber " << fiber << " skipped!" << std::endl;
+    return nullptr;
+  }
+  
+  int npoints = fData->GetNpoints();
+  TString collimator = fData->GetCollimator();
+  TString testBench = fData->GetTestBench();
+  std::vector <double> positions = fData->GetPositions();
+  
+  TGraphErrors *graph = new TGraphErrors(npoints);
+  graph->GetXaxis()->SetTitle("source position [mm]");
+  graph->GetYaxis()->SetTitle(ytitle);
+  graph->SetName(gname);
+  graph->SetTitle(gname);
+  graph->SetMarkerStyle(4);
+  
+  double sum      = 0;
+  double sumErr   = 0;
+  double sumAv    = 0;
+  double sumAvErr = 0;
+  double x, yL, yR;
+  
+  for(int i=0; i<npoints; i++){
+    graphsCh[chL]->GetPoint(i, x, yL);
+    graphsCh[chR]->GetPoint(i, x, yR);
+    sum = yL+yR;
+    sumErr = sqrt(pow(graphsCh[chL]->GetErrorY(i), 2) + pow(graphsCh[chR]->GetErrorY(i), 2));
+    graph->SetPoint(i, positions[i], sum);
+    graph->SetPointError(i, SFTools::GetPosError(collimator, testBench), sumErr);
+    sumAv += sum*(1./pow(sumErr, 2));
+    sumAvErr += 1./pow(sumErr, 2);
+  }
+  
+  av    = sumAv/sumAvErr;
+  avErr = sqrt(1./sumAvErr);
+  
+  return graph;
+}
+//------------------------------------------------------------------
 std::vector <TH1D*> SFLightOutput::GetSpectra(int ch){
     
-  if((ch==0 && fSpectraCh0.empty()) ||
-     (ch==1 && fSpectraCh1.empty())) {
+  if(ch<0 || ch>=fNchannels){
+    std::cerr << "##### Error in SFLightOutput::GetSpectra for ch" << ch << std::endl;
+    std::cerr << "Incorrect channel number!" << std::endl;
+    std::abort();
+  }
+  
+  if(fSpectraCh[ch].empty()) {
       std::cerr << "##### Error in SFLightOutput::GetSpectra() fo ch" << ch << std::endl; 
       std::cerr << "No spectra available!" << std::endl; 
       std::abort();
   }
 
-  if(ch==0)
-    return fSpectraCh0;
-  else if(ch==1)
-    return fSpectraCh1;
-  else{
-    std::cerr << "##### Error in SFLightOutput::GetSpectra for ch" << ch << std::endl;
-    std::cerr << "Incorrect channel number!" << std::endl;
-    std::abort();
-  }
+  return fSpectraCh[ch];
 }
 //------------------------------------------------------------------
+/// Returns summed light output graph of the first fiber (channels 0 and 1).
 TGraphErrors* SFLightOutput::GetLightOutputGraph(void){
     
-  if(fLightOutGraph==nullptr){
-    std::cerr << "##### Error in SFLightOut::GetLightOutputGraph()" << std::endl;
+  return GetLightOutputFiberGraph(0);
+}
+//------------------------------------------------------------------
+/// Returns summed light output graph of the fiber, i.e. of channels
+/// 2*fiber and 2*fiber+1.
+/// \param fiber - fiber number
+TGraphErrors* SFLightOutput::GetLightOutputFiberGraph(int fiber){
+    
+  if(fiber<0 || fiber>=fNfibers || fLightOutGraph[fiber]==nullptr){
+    std::cerr << "##### Error in SFLightOut::GetLightOutputFiberGraph() for fiber " << fiber << std::endl;
     std::cerr << "Requested graph doesn't exist!" << std::endl;
     std::abort();
   }
   
-  return fLightOutGraph;
+  return fLightOutGraph[fiber];
 }
 //------------------------------------------------------------------
 TGraphErrors* SFLightOutput::GetLightOutputGraph(int ch){
   
-  if((ch==0 && fLightOutCh0Graph==nullptr) ||
-     (ch==1 && fLightOutCh1Graph==nullptr)){
-    std::cerr << "##### Error in SFLightOutput::GetLightOutputGraph() for ch " << ch << std::endl;
-    std::cerr << "Requested graph doesn't exist!" << std::endl;
-  }
-    
-  if(ch==0)
-    return fLightOutCh0Graph;
-  else if(ch==1)
-    return fLightOutCh1Graph;
-  else{
+  if(ch<0 || ch>=fNchannels){
     std::cerr << "##### Error in SFLightOutput::GetLightOutputGraph() for ch " << ch << std::endl;
     std::cerr << "Incorrect channel number!" << std::endl;
     std::abort();
   }
+  
+  if(fLightOutChGraph[ch]==nullptr){
+    std::cerr << "##### Error in SFLightOutput::GetLightOutputGraph() for ch " << ch << std::endl;
+    std::cerr << "Requested graph doesn't exist!" << std::endl;
+  }
+    
+  return fLightOutChGraph[ch];
 }
 //------------------------------------------------------------------
+/// Returns summed light collection graph of the first fiber (channels 0 and 1).
 TGraphErrors* SFLightOutput::GetLightColGraph(void){
     
-  if(fLightColGraph==nullptr){
-    std::cerr << "##### Error in SFLightOUtput::GetLightColGraph()" << std::endl;
+  return GetLightColFiberGraph(0);
+}
+//------------------------------------------------------------------
+/// Returns summed light collection graph of the fiber, i.e. of channels
+/// 2*fiber and 2*fiber+1.
+/// \param fiber - fiber number
+TGraphErrors* SFLightOutput::GetLightColFiberGraph(int fiber){
+    
+  if(fiber<0 || fiber>=fNfibers || fLightColGraph[fiber]==nullptr){
+    std::cerr << "##### Error in SFLightOutput::GetLightColFiberGraph() for fiber " << fiber << std::endl;
     std::cerr << "Requested graph doesn't exist!" << std::endl;
     std::abort();
   }
   
-  return fLightColGraph;
+  return fLightColGraph[fiber];
 }
 //------------------------------------------------------------------
 TGraphErrors* SFLightOutput::GetLightColGraph(int ch){
     
-  if((ch==0 && fLightColCh0Graph==nullptr) ||
-     (ch==1 && fLightColCh1Graph==nullptr)){
-    std::cerr << "##### Error in SFLightOutput::GetLightColGraph() for ch " << ch << std::endl;
-    std::cerr << "Requested graph doesn't exist!" << std::endl;
-  }
-    
-  if(ch==0)
-    return fLightColCh0Graph;
-  else if(ch==1)
-    return fLightColCh1Graph;
-  else{
+  if(ch<0 || ch>=fNchannels){
     std::cerr << "##### Error in SFLightOutput::GetLightColGraph() for ch " << ch << std::endl;
     std::cerr << "Incorrect channel number!" << std::endl;
     std::abort();
   }
+  
+  if(fLightColChGraph[ch]==nullptr){
+    std::cerr << "##### Error in SFLightOutput::GetLightColGraph() for ch " << ch << std::endl;
+    std::cerr << "Requested graph doesn't exist!" << std::endl;
+  }
+    
+  return fLightColChGraph[ch];
 }
 //------------------------------------------------------------------
 /// Prints details of the SFLightOutput class object.
@@ -0,0 +1,379 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *            SFManifest.cc              *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#include "SFManifest.hh"
+
+ClassImp(SFManifest);
+
+std::map <std::pair <TString, int>, SFManifest*> SFManifest::fManifests;
+
+//------------------------------------------------------------------
+/// Standard constructor. Loads the manifest of the requested series from
+/// the cache directory, if it exists. If the manifest contains superseded
+/// entries, it is rewritten once. If the cache directory doesn't exist
+/// it is created. It is recommended to access manifests via GetManifest(),
+/// so that all SFData objects of one series share the same manifest.
+/// \param directory - cache directory
+/// \param seriesNo - number of the experimental series
+SFManifest::SFManifest(TString directory, int seriesNo): fDirectory(directory),
+                                                         fSeriesNo(seriesNo),
+                                                         fNreused(0),
+                                                         fNupdated(0),
+                                                         fNlines(0),
+                                                         fFile(nullptr) {
+
+  if(gSystem->AccessPathName(fDirectory)){
+    int stat = gSystem->mkdir(fDirectory, true);
+    if(stat==-1){
+      std::cerr << "##### Error in SFManifest constructor! Unable to create cache directory!" << std::endl;
+      std::cerr << fDirectory << std::endl;
+      throw "##### Exception in SFManifest constructor!";
+    }
+  }
+
+  bool stat = Load();
+  if(stat && fNlines>(int)fEntries.size())
+    stat = Save();
+  if(!stat){
+    throw "##### Exception in SFManifest constructor!";
+  }
+}
+//------------------------------------------------------------------
+/// Default destructor. Products file is closed.
+SFManifest::~SFManifest(){
+
+  if(fFile!=nullptr){
+    fFile->Close();
+    delete fFile;
+  }
+}
+//------------------------------------------------------------------
+/// Returns manifest of the requested series. Manifests are created once
+/// per cache directory and series and shared by all objects analyzing this
+/// series, so that entries stored by one of them are visible for the others.
+/// \param directory - cache directory
+/// \param seriesNo - number of the experimental series
+SFManifest* SFManifest::GetManifest(TString directory, int seriesNo){
+
+  std::pair <TString, int> id(directory, seriesNo);
+  std::map <std::pair <TString, int>, SFManifest*>::iterator it = fManifests.find(id);
+  if(it!=fManifests.end())
+    return it->second;
+
+  SFManifest *manifest = new SFManifest(directory, seriesNo);
+  fManifests[id] = manifest;
+
+  return manifest;
+}
+//------------------------------------------------------------------
+/// Calculates fingerprint of the product, i.e. MD5 checksum of the
+/// names, sizes and modification times of all input files and of the
+/// parameters used to build the product. Missing input files are
+/// marked as such, so that the product is recalculated once they appear.
+/// \param inputs - list of input files
+/// \param params - parameters of the product (selection, cut, etc.)
+TString SFManifest::Fingerprint(std::vector <TString> inputs, TString params){
+
+  TString summary = params;
+  FileStat_t stat;
+
+  for(size_t i=0; i<inputs.size(); i++){
+    if(gSystem->GetPathInfo(inputs[i], stat)==0)
+      summary += Form(";%s:%lld:%ld", inputs[i].Data(), stat.fSize, stat.fMtime);
+    else
+      summary += Form(";%s:missing", inputs[i].Data());
+  }
+
+  TMD5 md5;
+  md5.Update(reinterpret_cast<const UChar_t*>(summary.Data()), summary.Length());
+  md5.Final();
+
+  return TString(md5.AsString());
+}
+//------------------------------------------------------------------
+/// Returns name of the text file containing the manifest.
+TString SFManifest::GetManifestName(void){
+  return fDirectory + Form("/manifest_S%i.txt", fSeriesNo);
+}
+//------------------------------------------------------------------
+/// Returns name of the ROOT file containing stored products.
+TString SFManifest::GetProductsName(void){
+  return fDirectory + Form("/products_S%i.root", fSeriesNo);
+}
+//------------------------------------------------------------------
+/// Returns name under which product is stored in the ROOT file. Keys
+/// contain cuts, which can't be used as names of objects, therefore
+/// MD5 checksum of the key is used instead.
+/// \param key - product key
+TString SFManifest::GetObjectName(TString key){
+
+  TMD5 md5;
+  md5.Update(reinterpret_cast<const UChar_t*>(key.Data()), key.Length());
+  md5.Final();
+
+  return TString("P") + md5.AsString();
+}
+//------------------------------------------------------------------
+/// Returns products file, opened once and kept open. If the file can't 
+/// be opened nullptr is returned.
+/// \param create - if false and the file doesn't exist yet it is not 
+/// created, e.g. when products are only read
+TFile* SFManifest::GetFile(bool create){
+
+  if(fFile!=nullptr)
+    return fFile;
+
+  if(!create && gSystem->AccessPathName(GetProductsName()))
+    return nullptr;
+
+  TDirectory *dir = gDirectory;
+  TFile *file = new TFile(GetProductsName(), "UPDATE");
+  dir->cd();
+
+  if(!file->IsOpen() || file->IsZombie()){
+    std::cerr << "##### Error in SFManifest::GetFile()! Cannot open products file!" << std::endl;
+    std::cerr << GetProductsName() << std::endl;
+    delete file;
+    return nullptr;
+  }
+
+  fFile = file;
+
+  return fFile;
+}
+//------------------------------------------------------------------
+/// Escapes backslashes, tabulators and new lines of the manifest field.
+/// \param field - field of the manifest (key or inputs)
+TString SFManifest::Escape(TString field){
+
+  TString escaped = "";
+
+  for(int i=0; i<field.Length(); i++){
+    switch(field[i]){
+      case '\\': escaped += "\\\\"; break;
+      case '\t': escaped += "\\t";  break;
+      case '\n': escaped += "\\n";  break;
+      case '\r': escaped += "\\r";  break;
+      default:   escaped += field[i];
+    }
+  }
+
+  return escaped;
+}
+//------------------------------------------------------------------
+/// Reverts Escape().
+/// \param field - escaped field of the manifest
+TString SFManifest::Unescape(std::string field){
+
+  TString unescaped = "";
+
+  for(size_t i=0; i<field.size(); i++){
+    if(field[i]!='\\' || i+1==field.size()){
+      unescaped += field[i];
+      continue;
+    }
+    i++;
+    switch(field[i]){
+      case 't': unescaped += '\t'; break;
+      case 'n': unescaped += '\n'; break;
+      case 'r': unescaped += '\r'; break;
+      default:  unescaped += field[i];
+    }
+  }
+
+  return unescaped;
+}
+//------------------------------------------------------------------
+/// Reads the manifest from the text file. Every line of the manifest
+/// contains product key, fingerprint and list of inputs, separated with
+/// tabulators and escaped (see Escape()). Lines starting with '#' are 
+/// comments. If the product is
+/// recorded more than once, the last line is valid (see Append()).
+bool SFManifest::Load(void){
+
+  fEntries.clear();
+  fNlines = 0;
+
+  std::ifstream input(GetManifestName());
+  if(!input.is_open())
+    return true;
+
+  std::string line;
+
+  while(std::getline(input, line)){
+    if(line.empty() || line[0]=='#') continue;
+    size_t first = line.find('\t');
+    size_t second = line.find('\t', first+1);
+    if(first==std::string::npos || second==std::string::npos){
+      std::cerr << "##### Error in SFManifest::Load()! Incorrect manifest syntax!" << std::endl;
+      std::cerr << GetManifestName() << std::endl;
+      input.close();
+      return false;
+    }
+    ManifestEntry entry;
+    entry.fFingerprint = line.substr(first+1, second-first-1);
+    entry.fInputs = Unescape(line.substr(second+1));
+    fEntries[Unescape(line.substr(0, first))] = entry;
+    fNlines++;
+  }
+
+  input.close();
+
+  return true;
+}
+//------------------------------------------------------------------
+/// Writes the whole manifest to the text file.
+bool SFManifest::Save(void){
+
+  std::ofstream output(GetManifestName(), std::ios::trunc);
+
+  if(!output.is_open()){
+    std::cerr << "##### Error in SFManifest::Save()! Cannot write manifest!" << std::endl;
+    std::cerr << GetManifestName() << std::endl;
+    return false;
+  }
+
+  output << "# Manifest of series " << fSeriesNo << std::endl;
+  output << "# product\tfingerprint\tinputs" << std::endl;
+
+  std::map <TString, ManifestEntry>::iterator it;
+  for(it=fEntries.begin(); it!=fEntries.end(); it++){
+    output << Escape(it->first) << "\t" << it->second.fFingerprint
+           << "\t" << Escape(it->second.fInputs) << std::endl;
+  }
+
+  output.close();
+  
+  fNlines = fEntries.size();
+
+  return true;
+}
+//------------------------------------------------------------------
+/// Appends entry of the product to the text file, so that storing N 
+/// products doesn't rewrite the manifest N times. Previous entry of the 
+/// same product, if any, is superseded.
+/// \param key - product key
+bool SFManifest::Append(TString key){
+
+  if(gSystem->AccessPathName(GetManifestName()))
+    return Save();
+
+  std::ofstream output(GetManifestName(), std::ios::app);
+
+  if(!output.is_open()){
+    std::cerr << "##### Error in SFManifest::Append()! Cannot write manifest!" << std::endl;
+    std::cerr << GetManifestName() << std::endl;
+    return false;
+  }
+
+  ManifestEntry &entry = fEntries[key];
+  output << Escape(key) << "\t" << entry.fFingerprint << "\t" 
+         << Escape(entry.fInputs) << std::endl;
+  output.close();
+  
+  fNlines++;
+
+  return true;
+}
+//------------------------------------------------------------------
+/// Checks whether the stored product is up to date, i.e. whether it
+/// was built from the same inputs and with the same parameters.
+/// \param key - product key
+/// \param fingerprint - current fingerprint of the product (see Fingerprint())
+bool SFManifest::IsCurrent(TString key, TString fingerprint){
+
+  std::map <TString, ManifestEntry>::iterator it = fEntries.find(key);
+  if(it==fEntries.end())
+    return false;
+
+  return it->second.fFingerprint==fingerprint;
+}
+//------------------------------------------------------------------
+/// Returns copy of the stored product, read from the products file. 
+/// Returned object is not attached to any file and it is owned by the
+/// caller. If product cannot be found nullptr is returned.
+/// \param key - product key
+TObject* SFManifest::GetProduct(TString key){
+
+  TFile *file = GetFile(false);
+
+  if(file==nullptr)
+    return nullptr;
+
+  TDirectory *dir = gDirectory;
+  TObject *obj = file->Get(GetObjectName(key));
+
+  if(obj!=nullptr){
+    if(obj->InheritsFrom("TH1"))
+      ((TH1*)obj)->SetDirectory(nullptr);
+    fNreused++;
+  }
+
+  dir->cd();
+
+  return obj;
+}
+//------------------------------------------------------------------
+/// Stores the product in the ROOT file and records it in the manifest.
+/// If product with the same key was stored before it is overwritten.
+/// \param key - product key
+/// \param fingerprint - fingerprint of the product (see Fingerprint())
+/// \param inputs - list of input files
+/// \param obj - product to be stored
+bool SFManifest::StoreProduct(TString key, TString fingerprint,
+                              std::vector <TString> inputs, TObject *obj){
+
+  if(obj==nullptr){
+    std::cerr << "##### Error in SFManifest::StoreProduct()! Empty product!" << std::endl;
+    std::cerr << key << std::endl;
+    return false;
+  }
+
+  TFile *file = GetFile(true);
+
+  if(file==nullptr){
+    std::cerr << "##### Error in SFManifest::StoreProduct()! Product not stored!" << std::endl;
+    std::cerr << key << std::endl;
+    return false;
+  }
+
+  //----- keys list and header are written at once, so that the file is
+  //----- consistent on disk although it is kept open
+  TDirectory *dir = gDirectory;
+  file->WriteTObject(obj, GetObjectName(key), "WriteDelete");
+  file->Write();
+  dir->cd();
+
+  ManifestEntry entry;
+  entry.fFingerprint = fingerprint;
+  for(size_t i=0; i<inputs.size(); i++){
+    if(i>0) entry.fInputs += ";";
+    entry.fInputs += inputs[i];
+  }
+
+  fEntries[key] = entry;
+  fNupdated++;
+
+  return Append(key);
+}
+//------------------------------------------------------------------
+/// Prints details of the manifest.
+void SFManifest::Print(void){
+
+  std::cout << "\n-------------------------------------------" << std::endl;
+  std::cout << "This is Print() for SFManifest class object" << std::endl;
+  std::cout << "Experimental series number " << fSeriesNo << std::endl;
+  std::cout << "Cache directory: " << fDirectory << std::endl;
+  std::cout << "Number of recorded products: " << fEntries.size() << std::endl;
+  std::cout << "Products taken from cache: " << fNreused << std::endl;
+  std::cout << "Products (re)calculated: " << fNupdated << std::endl;
+  std::cout << "-------------------------------------------\n" << std::endl;
+}
+//------------------------------------------------------------------
@@ -12,6 +12,9 @@
 
 ClassImp(SFPeakFinder);
 
+static std::mutex gConfigMutex;   // guards fitting configs (fitconfig.txt, fitparams.out, SFFitParamStore)
+static std::mutex gFitterMutex;   // serializes fits using the global default minimizer
+
 //------------------------------------------------------------------
 /// Default constructor.
 SFPeakFinder::SFPeakFinder(): fSpectrum(nullptr),
@@ -77,10 +80,73 @@ void SFPeakFinder::SetSpectrum(TH1D *spectrum){
 }
 //------------------------------------------------------------------
 TString SFPeakFinder::Init(void){
+  
+  int seriesNo, ID;
+  double position;
+  TString full_path;
+  
+  GetMeasurement(seriesNo, ID, position, full_path);
+  
+  TString conf_name = "/fitconfig.txt";
+  TString hname = fSpectrum->GetName();
+  bool found = false;
+  
+  std::fstream test(full_path+conf_name, std::ios::in);
+  
+  if(test.fail()){
+    std::cout << "Fitting config for " << full_path << " doesn't exist..." << std::endl;
+    std::cout << "Creating new config file..." << std::endl;
+  }
+  else{
+    std::string line, name;
+    while(!found && std::getline(test, line)){
+      std::istringstream words(line);
+      found = (words >> name) && hname==name.c_str();
+    }
+    test.close();
+  }
+  
+  //----- seeding parameters of spectra missing in the config
+  if(!found){
+    std::map <TString, TString> entries = SeedParams(seriesNo, position, ID);
     
+    std::fstream config(full_path+conf_name, std::ios::out | std::ios::app);
+      for(auto it=entries.begin(); it!=entries.end(); it++)
+        config << it->second << "\n";
+    config.close();
+  }
+  else{
+    std::cout << "Fitting config for " << hname << " exists!" << std::endl;
+  }
+  
+  return full_path;  
+}
+//------------------------------------------------------------------
+/// Returns series number, measurement ID, source position and data
+/// directory of the analyzed spectrum. They are taken from the metadata
+/// record attached by SFData or, if there is none, from the histogram
+/// name and the data base.
+/// \param seriesNo - series number (returned)
+/// \param ID - measurement ID (returned)
+/// \param position - source position [mm] (returned)
+/// \param path - data directory of the measurement (returned)
+void SFPeakFinder::GetMeasurement(int &seriesNo, int &ID, double &position, TString &path){
+  
+  SFSpectrumInfo *info = SFSpectrumInfo::GetInfo(fSpectrum);
+  
+  if(info!=nullptr){
+    //----- metadata record attached by SFData
+    ID       = info->GetMeasurementID();
+    seriesNo = info->GetSeriesNo();
+    position = info->GetPosition();
+    path     = info->GetDataPath();
+    return;
+  }
+  
+  //----- no record, e.g. spectrum read from file
   TString hname = fSpectrum->GetName();
-  int ID = SFTools::GetMeasurementID(hname);  
-  int seriesNo = SFTools::GetSeriesNo(hname);
+  ID = SFTools::GetMeasurementID(hname);  
+  seriesNo = SFTools::GetSeriesNo(hname);
   
   SFData *data;
   try{
@@ -88,74 +154,229 @@ TString SFPeakFinder::Init(void){
   }
   catch(const char *message){
     std::cerr << message << std::endl;
-    std::cerr << "##### Error in SFPeakFinder::Init()!" << std::endl;
+    std::cerr << "##### Error in SFPeakFinder::GetMeasurement()!" << std::endl;
+    std::abort();
   }
   
   std::vector <TString> names = data->GetNames();
   std::vector <int> measureID = data->GetMeasurementsIDs();
   std::vector <double> positions = data->GetPositions();
   int index = SFTools::GetIndex(measureID, ID);
-  TString dir_name = names[index];
-  TString full_path = SFTools::FindData(dir_name);
+  position = positions[index];
+  path = SFTools::FindData(names[index]);
+  delete data;
   
-  TString conf_name = "/fitconfig.txt";
+  return;
+}
+//------------------------------------------------------------------
+/// Calculates initial parameters of the fit from the analyzed spectrum:
+/// peak is located with LocatePeak() and exponential background is 
+/// estimated from the contents below the peak, without any fits. Returns FitterFactory entry (line of the
+/// fitconfig.txt format) for the analyzed spectrum, indexed by its name, so
+/// that spectra of any channel and selection type are seeded.
+/// \param seriesNo - series number
+/// \param position - source position [mm]
+/// \param ID - measurement ID
+std::map <TString, TString> SFPeakFinder::SeedParams(int seriesNo, double position, int ID){
   
   TString functions = "gaus(0) pol0(3)+[4]*TMath::Exp((x-[5])*[6])";
-  TString hnames[3] = {Form("S%i_ch0_pos%.1f_ID%i_PE", seriesNo, positions[index], ID),
-                       Form("S%i_ch1_pos%.1f_ID%i_PE", seriesNo, positions[index], ID),
-                       Form("S%i_pos%.1f_ID%i_PEAverage", seriesNo, positions[index], ID)};
-
-  std::fstream test(full_path+conf_name, std::ios::in);
-  
-  if(test.fail()){
-    std::cout << "Fitting config for " << full_path << " doesn't exist..." << std::endl;
-    std::cout << "Creating new config file..." << std::endl;
-    
-    TSpectrum *spec = new TSpectrum(10);
-    int npeaks = spec->Search(fSpectrum, 10, "goff", 0.1);
-    double *peaksX = spec->GetPositionX();
-    double peak = TMath::MaxElement(npeaks, peaksX);
-    
-    TString opt;
-    if(fVerbose) opt = "0R";
-    else opt = "Q0R";  
-    
-    TF1 *fun_gaus = new TF1("fun_gaus", "gaus", peak-100, peak+100);
-    fSpectrum->Fit("fun_gaus", opt);
-    
-    double par0 = fun_gaus->GetParameter(0);
-    double par1 = fun_gaus->GetParameter(1);
-    double par2 = fun_gaus->GetParameter(2);
-    double par2_min = 0; 
-    double par2_max = 300;
-    double par3 = 30.;
-    
-    TF1 *fun_expo = new TF1("fun_expo", "[0]*TMath::Exp((x-[1])*[2])", par1-5*par2, par1-4*par2);
-    fSpectrum->Fit("fun_expo", opt);
-    
-    double par4 = fun_expo->GetParameter(0);
-    double par5 = fun_expo->GetParameter(1);
-    double par6 = fun_expo->GetParameter(2);
-    
-    double xmin = par1 - par2*2;
-    double xmax = par1 + par2*3;
+  TString hname = fSpectrum->GetName();
     
-    std::fstream config(full_path+conf_name, std::ios::out);
-      for(int i=0; i<3; i++){
-        config << " " << hnames[i] << " " << functions << " " 
-               << 0 << " " << xmin << " " << xmax << " " 
-               << par0 << " " << par1 << " " << par2 << " : " 
-               << par2_min << " " << par2_max << " " << par3 
-               << " " << par4 << " " << par5 << " " << par6 << "\n";
+  PeakParams peak = LocatePeak(fSpectrum);
+  
+  if(peak.fPosition<0){
+    std::cerr << "##### Warning in SFPeakFinder::SeedParams()! Peak not found, using maximum of the spectrum!" << std::endl;
+    peak.fConst    = fSpectrum->GetMaximum();
+    peak.fPosition = fSpectrum->GetBinCenter(fSpectrum->GetMaximumBin());
+    peak.fSigma    = 0.1*peak.fPosition;
+  }
+  
+  double par0 = peak.fConst;
+  double par1 = peak.fPosition;
+  double par2 = peak.fSigma;
+  double par2_min = 0; 
+  double par2_max = 300;
+  double par3 = 30.;
+  
+  //----- exponential background from the mean contents of two windows
+  //----- between 5 and 4 sigma below the peak
+  SFPrefixSum sums(fSpectrum);
+  TAxis *axis = fSpectrum->GetXaxis();
+  double x1 = par1 - 4.75*par2;
+  double x2 = par1 - 4.25*par2;
+  int b1 = axis->FindFixBin(par1-5*par2);
+  int b2 = axis->FindFixBin(par1-4.5*par2);
+  int b3 = axis->FindFixBin(par1-4*par2);
+  double y1 = sums.GetIntegral(b1, b2)/std::max(b2-b1+1, 1);
+  double y2 = sums.GetIntegral(b2+1, b3)/std::max(b3-b2, 1);
+  
+  double par4 = y1;
+  double par5 = x1;
+  double par6 = (y1>0 && y2>0) ? log(y2/y1)/(x2-x1) : 0;
+  
+  double xmin = par1 - par2*2;
+  double xmax = par1 + par2*3;
+  
+  std::map <TString, TString> entries;
+  
+  std::ostringstream entry;
+  entry << " " << hname << " " << functions << " " 
+        << 0 << " " << xmin << " " << xmax << " " 
+        << par0 << " " << par1 << " " << par2 << " : " 
+        << par2_min << " " << par2_max << " " << par3 
+        << " " << par4 << " " << par5 << " " << par6;
+  entries[hname] = entry.str();
+  
+  return entries;
+}
+//------------------------------------------------------------------
+/// Fast estimate of the 511 keV peak parameters, without any fit, working
+/// directly on the bin contents:
+/// - spectrum is smoothed with quadratic Savitzky-Golay filter, which also
+///   gives its first derivative,
+/// - the right-most significant maximum (derivative crossing zero, above 10%
+///   of the highest maximum, highest in the range of +/- 4 filter widths)
+///   is taken as the 511 keV peak and refined with parabolic interpolation,
+/// - half width is found on the right side of the peak, where there is no
+///   Compton continuum,
+/// - position and sigma are the first two moments in +/- FWHM around the
+///   maximum, above linear baseline, with sigma corrected for the truncation.
+/// Uncertainties are statistical only. Precision is sufficient for seeding
+/// of the fits and for quick-look analyses. If the peak can't be found
+/// all parameters are set to -1.
+/// \param spectrum - analyzed spectrum
+PeakParams SFPeakFinder::LocatePeak(TH1D *spectrum){
+  
+  PeakParams params;
+  
+  if(spectrum==nullptr)
+    return params;
+  
+  int nbins = spectrum->GetNbinsX();
+  int m = std::max(2, nbins/200);       // half-width of the smoothing window
+  
+  if(nbins<2*m+3)
+    return params;
+  
+  std::vector <double> x(nbins), y(nbins), s(nbins), d(nbins, 0);
+  
+  for(int i=0; i<nbins; i++){
+    x[i] = spectrum->GetBinCenter(i+1);
+    y[i] = spectrum->GetBinContent(i+1);
+  }
+  
+  //----- Savitzky-Golay (quadratic) smoothing and first derivative
+  double norm_s = (2*m-1)*(2*m+1)*(2*m+3)/3.;
+  double norm_d = m*(m+1)*(2*m+1)/3.;
+  
+  for(int i=0; i<nbins; i++){
+    if(i<m || i>=nbins-m){
+      s[i] = y[i];
+      continue;
+    }
+    double sum_s = 0;
+    double sum_d = 0;
+    for(int j=-m; j<=m; j++){
+      sum_s += (3*m*m+3*m-1-5*j*j)*y[i+j];
+      sum_d += j*y[i+j];
+    }
+    s[i] = sum_s/norm_s;
+    d[i] = sum_d/norm_d;
+  }
+  
+  //----- the right-most significant maximum: derivative crossing zero from + to -
+  double smax = *std::max_element(s.begin()+m, s.end()-m);
+  int peak = -1;
+  
+  for(int i=nbins-m-1; i>m; i--){
+    if(d[i-1]>0 && d[i]<=0 && s[i]>=0.1*smax){
+      int candidate = s[i-1]>s[i] ? i-1 : i;
+      //----- noise wiggles on the slopes are not maxima in the wider range
+      int from = std::max(0, candidate-4*m);
+      int to   = std::min(nbins, candidate+4*m+1);
+      if(std::max_element(s.begin()+from, s.begin()+to)-s.begin()==candidate){
+        peak = candidate;
+        break;
       }
-    config.close();
+    }
   }
-  else{
-    std::cout << "Fitting config for " << full_path << " exists!" << std::endl;
-    test.close();
+  
+  if(peak<1 || peak>nbins-2)
+    return params;
+  
+  //----- parabolic sub-bin interpolation
+  double width = x[peak+1]-x[peak];
+  double curv  = s[peak-1] - 2*s[peak] + s[peak+1];
+  double delta = curv<0 ? 0.5*(s[peak-1]-s[peak+1])/curv : 0;
+  double mean  = x[peak] + std::min(std::max(delta, -0.5), 0.5)*width;
+  double height = s[peak] - 0.25*(s[peak-1]-s[peak+1])*delta;
+  
+  //----- half maximum crossing on the right side of the peak, where there
+  //----- is no Compton continuum; baseline is the minimum on this side
+  double base = *std::min_element(s.begin()+peak, s.end()-m);
+  int right = peak;
+  while(right<nbins-m-1 && s[right]-base>0.5*(height-base)) right++;
+  
+  double hwhm = right>peak ? x[right]-mean : width;
+  
+  //----- moments in +/- FWHM around the maximum, above linear baseline 
+  //----- through the window edges
+  int low  = std::max(0, (int)std::floor((mean-2*hwhm-x[0])/width + 0.5));
+  int high = std::min(nbins-1, (int)std::floor((mean+2*hwhm-x[0])/width + 0.5));
+  
+  if(high-low<2)
+    return params;
+  
+  double slope = (s[high]-s[low])/(x[high]-x[low]);
+  double sum = 0, sum_x = 0, sum_x2 = 0;
+  
+  for(int i=low; i<=high; i++){
+    double w = y[i] - (s[low] + slope*(x[i]-x[low]));
+    if(w<=0) continue;
+    sum    += w;
+    sum_x  += w*x[i];
+    sum_x2 += w*x[i]*x[i];
   }
   
-  return full_path;  
+  if(sum<=0)
+    return params;
+  
+  double m1  = sum_x/sum;
+  double var = sum_x2/sum - m1*m1;
+  
+  //----- correction for truncation at +/- a sigma and for subtracted baseline, 
+  //----- for gaussian peak: var = sigma^2 * R(a)
+  const double a = 2*sqrt(2*log(2));
+  double erf_a = std::erf(a/sqrt(2));
+  double g_a   = std::exp(-0.5*a*a);
+  double R = (sqrt(2*M_PI)*erf_a - 2*a*g_a - 2*a*a*a*g_a/3) / 
+             (sqrt(2*M_PI)*erf_a - 2*a*g_a);
+  
+  double sigma = var>0 ? sqrt(var/R) : hwhm/sqrt(2*log(2));
+  
+  params.fConst       = height - (s[low] + slope*(mean-x[low]));
+  params.fConstErr    = sqrt(std::max(height, 0.)/(2*m+1));
+  params.fPosition    = m1;
+  params.fPositionErr = sigma/sqrt(sum);
+  params.fSigma       = sigma;
+  params.fSigmaErr    = sigma/sqrt(2*sum);
+  
+  return params;
+}
+//------------------------------------------------------------------
+/// Estimate-only mode: sets parameters of the 511 keV peak with LocatePeak()
+/// instead of the fit. fFittedFun is not set. Returns false if the peak
+/// couldn't be found.
+bool SFPeakFinder::FindPeakEstimate(void){
+  
+  fParams = LocatePeak(fSpectrum);
+  
+  if(fParams.fPosition<0 || fParams.fSigma<0){
+    std::cerr << "##### Error in SFPeakFinder::FindPeakEstimate()! Peak not found!" << std::endl;
+    return false;
+  }
+  
+  return true;
 }
 //------------------------------------------------------------------
 /// Finds range of the 511 keV peak. Range is returned as references.
@@ -165,21 +386,29 @@ TString SFPeakFinder::Init(void){
 bool SFPeakFinder::FindPeakRange(double &min, double &max){
   
   // Getting series attributes
-  int seriesNo = SFTools::GetSeriesNo(fSpectrum->GetName());
-  SFData *data;
+  TString type;
+  SFSpectrumInfo *info = SFSpectrumInfo::GetInfo(fSpectrum);
   
-  try{
-    data = new SFData(seriesNo);
+  if(info!=nullptr){
+    type = info->GetCollimator();
   }
-  catch(const char *message){
-    std::cerr << message << std::endl;
-    std::cerr << "##### Exception in SFPeakFinder::FindPeakRange()!" << std::endl;
-    std::abort();
+  else{
+    int seriesNo = SFTools::GetSeriesNo(fSpectrum->GetName());
+    SFData *data;
+    
+    try{
+      data = new SFData(seriesNo);
+    }
+    catch(const char *message){
+      std::cerr << message << std::endl;
+      std::cerr << "##### Exception in SFPeakFinder::FindPeakRange()!" << std::endl;
+      std::abort();
+    }
+    
+    type = data->GetCollimator();
+    delete data;
   }
   
-  TString type = data->GetCollimator();
-  delete data;
-  
   // Calculating peak range
   const double delta = 1E-8;
   
@@ -212,24 +441,373 @@ bool SFPeakFinder::FindPeakRange(double &min, double &max){
 /// defined getters. fPeak histogram is not filled.
 bool SFPeakFinder::FindPeakFit(void){
   
-  TString data_path = Init();
-
-  FitterFactory fitter;
-  fitter.initFactoryFromFile((data_path+"/fitconfig.txt").Data(), 
-                             (data_path+"/fitparams.out").Data());
-  HistFitParams histFP;
-  FitterFactory::FIND_FLAGS fl = fitter.findParams(fSpectrum->GetName(), histFP);
-  printf("fl = %d for %s\n", fl, fSpectrum->GetName());
-  fitter.fit(histFP, fSpectrum);
-  fitter.updateParams(fSpectrum, histFP);
-  fitter.exportFactoryToFile();
-  fFittedFun = (TF1*)histFP.funSum->Clone();
-  fFittedFun->Print();
+  return FindPeakFits(std::vector <SFPeakFinder*>(1, this));
+}
+//------------------------------------------------------------------
+/// Fits peaks of many spectra at once, e.g. ch0, ch1 and average spectra
+/// of all positions of the series. Equivalent to calling FindPeakFit()
+/// for each finder, but fits run concurrently on SFTools::ParallelFor().
+/// Every fit starts from the parameters of the fitting config. Returns
+/// true if all fits were successful (see FitBatch()).
+/// \param finders - peak finders with spectra to be fitted
+bool SFPeakFinder::FindPeakFits(std::vector <SFPeakFinder*> finders){
   
-  if(fFittedFun == nullptr){
+  return FitBatch(finders, std::vector <double>());
+}
+//------------------------------------------------------------------
+/// Fits peaks of spectra of one type (e.g. ch0) measured at different 
+/// source positions of the series, with warm start. The central position
+/// is fitted first, starting from the fitting config. Then positions are
+/// fitted outwards, towards both fiber ends (both directions run in
+/// parallel). Starting parameters of each position are predicted from
+/// the converged fits of the two previous positions (see PredictParams()).
+/// If the fit started in this way fails, it is repeated starting from
+/// the fitting config. Returns true if all fits were successful.
+/// \param finders - peak finders with spectra to be fitted
+/// \param positions - source positions of the spectra [mm]
+bool SFPeakFinder::FindPeakFitsSeries(std::vector <SFPeakFinder*> finders,
+                                      std::vector <double> positions){
+  
+  if(positions.size()!=finders.size()){
+    std::cerr << "##### Error in SFPeakFinder::FindPeakFitsSeries()!" << std::endl;
+    std::cerr << "Number of positions doesn't match number of spectra!" << std::endl;
+    return false;
+  }
+  
+  return FitBatch(finders, positions);
+}
+//------------------------------------------------------------------
+/// Performs fits for FindPeakFits() and FindPeakFitsSeries(). Fitting
+/// config of each measurement (or fit parameters store of each series,
+/// see SFFitParamStore) is read once before and the fitted parameters
+/// are written once after the fits, in the calling thread. Only reading
+/// and writing of the configs is done under a lock, the fits themselves
+/// run without it. Every fit has its own FitterFactory and HistFitParams. In 
+/// parallel mode Minuit2 is used as the minimizer, since TMinuit is not
+/// reentrant. Returns true if all fits were successful.
+/// \param finders - peak finders with spectra to be fitted
+/// \param positions - source positions for the warm start, empty for
+/// independent fits
+bool SFPeakFinder::FitBatch(std::vector <SFPeakFinder*> finders,
+                            std::vector <double> positions){
+  
+  int nfits = finders.size();
+  
+  for(int i=0; i<nfits; i++){
+    if(finders[i]==nullptr || finders[i]->fSpectrum==nullptr){
+      std::cerr << "##### Error in SFPeakFinder::FitBatch()!" << std::endl;
+      std::cerr << "Peak finder or its spectrum is a null pointer!" << std::endl;
+      return false;
+    }
+  }
+  
+  //----- reading fitting configs, once per measurement or series, under lock
+  std::map <TString, FitterFactory*> fitters;
+  std::map <TString, SFFitParamStore*> stores;
+  std::vector <TString> keys(nfits);
+  std::vector <HistFitParams> histFP(nfits);
+  
+  {
+    std::lock_guard <std::mutex> lock(gConfigMutex);
+    
+    for(int i=0; i<nfits; i++){
+      
+      TString hname = finders[i]->fSpectrum->GetName();
+      SFFitParamStore *store = nullptr;
+      
+      if(SFFitParamStore::IsEnabled()){
+        int seriesNo, ID;
+        double position;
+        TString path;
+        finders[i]->GetMeasurement(seriesNo, ID, position, path);
+        
+        try{
+          store = SFFitParamStore::GetStore(seriesNo);
+        }
+        catch(const char *message){
+          std::cerr << message << std::endl;
+          std::cerr << "##### Exception in SFPeakFinder::FitBatch()!" << std::endl;
+          std::abort();
+        }
+        
+        if(store->GetEntry(hname)==""){
+          std::map <TString, TString> entries = finders[i]->SeedParams(seriesNo, position, ID);
+          for(auto it=entries.begin(); it!=entries.end(); it++){
+            if(store->GetEntry(it->first)=="")
+              store->SetEntry(it->first, it->second, true);
+          }
+        }
+        
+        keys[i] = Form("S%i", seriesNo);
+      }
+      else{
+        keys[i] = finders[i]->Init();
+      }
+      
+      if(fitters.find(keys[i])==fitters.end()){
+        FitterFactory *fitter = new FitterFactory();
+        if(store==nullptr)
+          fitter->initFactoryFromFile((keys[i]+"/fitconfig.txt").Data(),
+                                      (keys[i]+"/fitparams.out").Data());
+        fitters[keys[i]] = fitter;
+        stores[keys[i]] = store;
+      }
+      
+      if(store!=nullptr && store->GetEntry(hname)!=""){
+        HistFitParams *params = HistFitParams::parseEntryFromFile(store->GetEntry(hname));
+        if(params!=nullptr)
+          fitters[keys[i]]->insertParameters(params);
+      }
+      
+      FitterFactory::FIND_FLAGS fl = fitters[keys[i]]->findParams(hname, histFP[i]);
+      
+      if(fl==FitterFactory::NOT_FOUND || histFP[i].funSum==nullptr){
+        std::cerr << "##### Error in SFPeakFinder::FitBatch()!" << std::endl;
+        std::cerr << "Fit parameters of " << hname << " not found, spectrum skipped!" << std::endl;
+        histFP[i].funSum = nullptr;
+      }
+    }
+  }
+  
+  //----- fitting, outside the lock
+  //----- SFPeakModel selects thread-safe Minuit2 in the config of every fit,
+  //----- fits with FitterFactory use the global default minimizer, so
+  //----- batches containing them are fitted serially, one batch at a time
+  bool parallel = true;
+  
+  for(int i=0; i<nfits && parallel; i++)
+    parallel = histFP[i].funSum==nullptr || 
+               (histFP[i].rebin==0 && SFPeakModel::Matches(histFP[i].funSum));
+  
+  std::unique_lock <std::mutex> serial(gFitterMutex, std::defer_lock);
+  if(!parallel) serial.lock();
+  
+  if(positions.empty()){
+    if(parallel){
+      SFTools::ParallelFor(nfits, [&](int i){
+        FitSpectrum(finders[i]->fSpectrum, histFP[i]);
+      });
+    }
+    else{
+      for(int i=0; i<nfits; i++)
+        FitSpectrum(finders[i]->fSpectrum, histFP[i]);
+    }
+  }
+  else{
+    FitWarmStart(finders, positions, histFP, parallel);
+  }
+  
+  if(!parallel) serial.unlock();
+  
+  //----- writing fitted parameters, once per measurement or series, under
+  //----- lock; config files are read again, since other batches might have
+  //----- updated them in the meantime
+  {
+    std::lock_guard <std::mutex> lock(gConfigMutex);
+    
+    for(auto it=fitters.begin(); it!=fitters.end(); ++it){
+      if(stores[it->first]!=nullptr) continue;
+      delete it->second;
+      it->second = new FitterFactory();
+      it->second->initFactoryFromFile((it->first+"/fitconfig.txt").Data(),
+                                      (it->first+"/fitparams.out").Data());
+    }
+    
+    for(int i=0; i<nfits; i++){
+      if(histFP[i].funSum==nullptr) continue;
+      fitters[keys[i]]->updateParams(finders[i]->fSpectrum, histFP[i]);
+      if(stores[keys[i]]!=nullptr)
+        stores[keys[i]]->SetEntry(finders[i]->fSpectrum->GetName(), histFP[i].exportEntry());
+    }
+    
+    for(auto it=fitters.begin(); it!=fitters.end(); ++it){
+      if(stores[it->first]!=nullptr)
+        stores[it->first]->Save();
+      else
+        it->second->exportFactoryToFile();
+      delete it->second;
+    }
+  }
+  
+  bool status = true;
+  
+  for(int i=0; i<nfits; i++){
+    if(histFP[i].funSum==nullptr)
+      status = false;
+    else
+      status = finders[i]->SetFitResults(histFP[i]) && status;
+  }
+  
+  return status;
+}
+//------------------------------------------------------------------
+/// Fits the spectrum starting from the current parameters of histFP.funSum.
+/// Spectra fitted with the standard peak model are fitted with SFPeakModel,
+/// other functions of the fitting config with FitterFactory. Returns true
+/// if the fit converged and the peak lies inside the fit range. Spectra
+/// without fit parameters (see FitBatch()) are not fitted.
+/// \param spectrum - fitted spectrum
+/// \param histFP - fit parameters of the spectrum
+bool SFPeakFinder::FitSpectrum(TH1D *spectrum, HistFitParams &histFP){
+  
+  if(histFP.funSum==nullptr)
+    return false;
+  
+  bool converged = true;
+  
+  //----- standard peak model: compiled, with analytic gradient
+  if(histFP.rebin==0 && SFPeakModel::Matches(histFP.funSum)){
+    converged = SFPeakModel::Fit(spectrum, histFP.funSum)==0;
+    for(int p=0; p<histFP.funSig->GetNpar(); p++)
+      histFP.funSig->SetParameter(p, histFP.funSum->GetParameter(p));
+    for(int p=0; p<histFP.funBkg->GetNpar(); p++)
+      histFP.funBkg->SetParameter(p, histFP.funSum->GetParameter(p));
+  }
+  //----- other functions from the config: FitterFactory
+  else{
+    FitterFactory fitter;
+    converged = fitter.fit(histFP, spectrum);
+  }
+  
+  double xmin, xmax;
+  histFP.funSum->GetRange(xmin, xmax);
+  double mean  = histFP.funSum->GetParameter(1);
+  double sigma = histFP.funSum->GetParameter(2);
+  
+  return converged && sigma>0 && mean>xmin && mean<xmax;
+}
+//------------------------------------------------------------------
+/// Predicts starting parameters of the fit at the given position from
+/// the converged fits at the previous positions. Amplitude and position
+/// of the peak are extrapolated exponentially (i.e. along the attenuation
+/// trend), sigma linearly. Background parameters are taken from the 
+/// nearest fit. If only one previous fit is available (or extrapolation
+/// gives unphysical values) its parameters are copied. Predicted values
+/// are limited to the parameter limits of the function.
+/// \param fun - function to be fitted, starting parameters are set here
+/// \param near - fitted function at the previous position
+/// \param far - fitted function at the position before the previous one, can be nullptr
+/// \param x - position of the fitted spectrum
+/// \param xNear - position of near
+/// \param xFar - position of far
+void SFPeakFinder::PredictParams(TF1 *fun, TF1 *near, TF1 *far, double x, 
+                                 double xNear, double xFar){
+  
+  int npar = fun->GetNpar();
+  
+  for(int p=0; p<npar; p++)
+    fun->SetParameter(p, near->GetParameter(p));
+  
+  if(far!=nullptr && fabs(xNear-xFar)>1E-10){
+    double step = (x-xNear)/(xNear-xFar);
+    
+    for(int p=0; p<3; p++){
+      double pNear = near->GetParameter(p);
+      double pFar  = far->GetParameter(p);
+      double pred  = -1;
+      
+      if(p<2 && pNear>0 && pFar>0)
+        pred = pNear*pow(pNear/pFar, step);
+      else if(p==2)
+        pred = pNear + (pNear-pFar)*step;
+      
+      //----- extrapolation by more than factor 2 is not trusted
+      if(pred>0.5*pNear && pred<2*pNear)
+        fun->SetParameter(p, pred);
+    }
+  }
+  
+  for(int p=0; p<npar; p++){
+    double low, up;
+    fun->GetParLimits(p, low, up);
+    if(low<up)
+      fun->SetParameter(p, std::min(std::max(fun->GetParameter(p), low), up));
+  }
+  
+  return;
+}
+//------------------------------------------------------------------
+/// Performs series-ordered fits for FindPeakFitsSeries(), starting from
+/// the central position outwards.
+/// \param finders - peak finders with spectra to be fitted
+/// \param positions - source positions of the spectra
+/// \param histFP - fit parameters of the spectra, from the fitting config
+/// \param parallel - if true, both sides of the series are fitted in parallel
+void SFPeakFinder::FitWarmStart(std::vector <SFPeakFinder*> &finders,
+                                std::vector <double> &positions,
+                                std::vector <HistFitParams> &histFP, bool parallel){
+  
+  int nfits = finders.size();
+  
+  if(nfits==0)
+    return;
+  
+  std::vector <int> order(nfits);
+  for(int i=0; i<nfits; i++) order[i] = i;
+  std::sort(order.begin(), order.end(), [&](int a, int b){
+    return positions[a]<positions[b];
+  });
+  
+  std::vector <char> converged(nfits, false);  // char, not bool: written from both threads
+  int center = nfits/2;
+  
+  int ic = order[center];
+  converged[ic] = FitSpectrum(finders[ic]->fSpectrum, histFP[ic]);
+  
+  auto fitSide = [&](int side){
+    
+    int dir = side==0 ? -1 : 1;
+    
+    for(int k=center+dir; k>=0 && k<nfits; k+=dir){
+      
+      int i     = order[k];
+      int iNear = order[k-dir];
+      int iFar  = (k-2*dir>=0 && k-2*dir<nfits) ? order[k-2*dir] : -1;
+      TF1 *fun  = histFP[i].funSum;
+      
+      if(fun==nullptr) continue;
+      
+      //----- parameters from the config, for the fallback
+      std::vector <double> config(fun->GetParameters(), fun->GetParameters()+fun->GetNpar());
+      
+      if(converged[iNear]){
+        TF1 *far = (iFar>=0 && converged[iFar]) ? histFP[iFar].funSum : nullptr;
+        PredictParams(fun, histFP[iNear].funSum, far, positions[i],
+                      positions[iNear], iFar>=0 ? positions[iFar] : 0);
+        converged[i] = FitSpectrum(finders[i]->fSpectrum, histFP[i]);
+      }
+      
+      if(!converged[i]){
+        fun->SetParameters(config.data());
+        converged[i] = FitSpectrum(finders[i]->fSpectrum, histFP[i]);
+      }
+    }
+  };
+  
+  if(parallel){
+    SFTools::ParallelFor(2, fitSide);
+  }
+  else{
+    fitSide(0);
+    fitSide(1);
+  }
+  
+  return;
+}
+//------------------------------------------------------------------
+/// Reads parameters of the 511 keV peak from the fitted function and, 
+/// in testing mode, draws signal and background components on the 
+/// spectrum.
+/// \param histFP - fit parameters of the spectrum after the fit
+bool SFPeakFinder::SetFitResults(HistFitParams &histFP){
+  
+  if(histFP.funSum == nullptr){
     std::cerr << "##### Error in SFPeakFinder::FindPeak()! Function is null pointer" << std::endl;
     std::abort();
   }
+  
+  fFittedFun = (TF1*)histFP.funSum->Clone();
+  fFittedFun->Print();
 
   fParams.fConst       = fFittedFun->GetParameter(0);
   fParams.fConstErr    = fFittedFun->GetParError(0);
@@ -0,0 +1,196 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *            SFPeakModel.cc             *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#include "SFPeakModel.hh"
+
+//------------------------------------------------------------------
+/// Default constructor. All parameters are set to 0.
+SFPeakModel::SFPeakModel() : fParams(kNpar, 0) {
+}
+//------------------------------------------------------------------
+/// Default destructor.
+SFPeakModel::~SFPeakModel(){
+}
+//------------------------------------------------------------------
+/// Returns copy of the model, as required by ROOT::Math interfaces.
+ROOT::Math::IBaseFunctionOneDim* SFPeakModel::Clone(void) const {
+
+  SFPeakModel *model = new SFPeakModel();
+  model->SetParameters(Parameters());
+
+  return model;
+}
+//------------------------------------------------------------------
+/// Returns value of the model.
+/// \param x - charge
+/// \param p - parameters
+double SFPeakModel::Evaluate(double x, const double *p){
+
+  double gauss = 0;
+
+  if(p[2]!=0){
+    double t = (x-p[1])/p[2];
+    gauss = p[0]*std::exp(-0.5*t*t);
+  }
+
+  return gauss + p[3] + p[4]*std::exp((x-p[5])*p[6]);
+}
+//------------------------------------------------------------------
+/// Calculates derivatives of the model over all parameters at once,
+/// sharing the exponentials.
+/// \param x - charge
+/// \param p - parameters
+/// \param grad - derivatives (returned), array of kNpar elements
+void SFPeakModel::Gradient(double x, const double *p, double *grad){
+
+  if(p[2]!=0){
+    double t = (x-p[1])/p[2];
+    double g = std::exp(-0.5*t*t);
+    grad[0] = g;
+    grad[1] = p[0]*g*t/p[2];
+    grad[2] = p[0]*g*t*t/p[2];
+  }
+  else{
+    grad[0] = grad[1] = grad[2] = 0;
+  }
+
+  double e = std::exp((x-p[5])*p[6]);
+  grad[3] = 1;
+  grad[4] = e;
+  grad[5] = -p[4]*p[6]*e;
+  grad[6] = p[4]*(x-p[5])*e;
+
+  return;
+}
+//------------------------------------------------------------------
+double SFPeakModel::DoEvalPar(double x, const double *p) const {
+  return Evaluate(x, p);
+}
+//------------------------------------------------------------------
+double SFPeakModel::DoParameterDerivative(double x, const double *p, unsigned int ipar) const {
+
+  double grad[kNpar];
+  Gradient(x, p, grad);
+
+  return grad[ipar];
+}
+//------------------------------------------------------------------
+void SFPeakModel::ParameterGradient(double x, const double *p, double *grad) const {
+  Gradient(x, p, grad);
+}
+//------------------------------------------------------------------
+/// Checks whether the function is the peak model, i.e. whether it has
+/// kNpar parameters and gives the same values as the compiled model in
+/// its range. In this way fitting configs with other functions are
+/// recognized without parsing the formula.
+/// \param fun - function, e.g. from the fitting config
+bool SFPeakModel::Matches(TF1 *fun){
+
+  if(fun==nullptr || fun->GetNpar()!=kNpar)
+    return false;
+
+  double xmin, xmax;
+  fun->GetRange(xmin, xmax);
+
+  const double *p = fun->GetParameters();
+  const int npoints = 5;
+
+  for(int i=0; i<npoints; i++){
+    double x = xmin + (i+0.5)*(xmax-xmin)/npoints;
+    double expected = fun->Eval(x);
+    if(std::fabs(Evaluate(x, p)-expected) > 1E-9*(1+std::fabs(expected)))
+      return false;
+  }
+
+  return true;
+}
+//------------------------------------------------------------------
+/// Performs chi2 fit of the peak model to the histogram in the range of
+/// the function, like TH1::Fit() with "B" option: empty bins are skipped,
+/// parameters limits and fixed parameters of the function are respected.
+/// Starting values are taken from the function, fitted values, errors,
+/// chi2 and NDF are written back to it. Copy of the fitted function is
+/// stored in the list of functions of the histogram, replacing previously
+/// fitted ones. Returns status of the minimization (0 if successful).
+/// If the fit fails, nonzero status is returned and neither the function
+/// nor the histogram is modified.
+/// \param hist - fitted histogram
+/// \param fun - function with starting parameters (see Matches())
+int SFPeakModel::Fit(TH1D *hist, TF1 *fun){
+
+  if(hist==nullptr || !Matches(fun)){
+    std::cerr << "##### Error in SFPeakModel::Fit()!" << std::endl;
+    std::cerr << "Histogram is a null pointer or function is not the peak model!" << std::endl;
+    return -1;
+  }
+
+  double xmin, xmax;
+  fun->GetRange(xmin, xmax);
+
+  ROOT::Fit::DataOptions options;
+  ROOT::Fit::DataRange range(xmin, xmax);
+  ROOT::Fit::BinData data(options, range);
+  ROOT::Fit::FillData(data, hist);
+
+  SFPeakModel model;
+  model.SetParameters(fun->GetParameters());
+
+  ROOT::Fit::Fitter fitter;
+  fitter.SetFunction(model, true);
+  fitter.Config().SetMinimizer("Minuit2", "Fumili");
+
+  for(int i=0; i<kNpar; i++){
+    double par = fun->GetParameter(i);
+    double err = fun->GetParError(i);
+    double low, up;
+    fun->GetParLimits(i, low, up);
+
+    ROOT::Fit::ParameterSettings &settings = fitter.Config().ParSettings(i);
+    settings.SetValue(par);
+    settings.SetStepSize(err>0 ? err : (par!=0 ? 0.1*std::fabs(par) : 0.01));
+
+    if(low*up!=0 && low>=up)
+      settings.Fix();
+    else if(low<up)
+      settings.SetLimits(low, up);
+  }
+
+  bool ok = fitter.Fit(data);
+
+  const ROOT::Fit::FitResult &result = fitter.Result();
+
+  if(!ok || !result.IsValid()){
+    int status = result.Status();
+    return status!=0 ? status : -1;
+  }
+
+  fun->SetParameters(result.Parameters().data());
+  fun->SetParErrors(result.Errors().data());
+  fun->SetChisquare(result.Chi2());
+  fun->SetNDF(result.Ndf());
+  fun->SetNumberFitPoints(data.Size());
+
+  //----- storing fitted function, like TH1::Fit()
+  TList *functions = hist->GetListOfFunctions();
+  TObject *obj;
+
+  for(int i=functions->GetSize()-1; i>=0; i--){
+    obj = functions->At(i);
+    if(obj->InheritsFrom("TF1")){
+      functions->Remove(obj);
+      delete obj;
+    }
+  }
+
+  functions->Add(fun->Clone());
+
+  return result.Status();
+}
+//------------------------------------------------------------------
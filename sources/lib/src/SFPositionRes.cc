@@ -132,15 +132,21 @@ bool SFPositionRes::AnalyzePositionRes(void){
   DDSignal *sig_ch0 = new DDSignal();
   DDSignal *sig_ch1 = new DDSignal();
   
+  int npairs = std::max(fData->GetNchannels()/2, 1);
+  std::vector <double> lnMLR(npairs);
+  std::vector <double> peAverage(npairs);
+  
   for(int i=0; i<npoints; i++){ 
     
     std::cout << "\t Analyzing position " << positions[i] << " mm..." << std::endl;  
       
     //----- geting tree
-    trees.push_back(fData->GetTree(measurementsIDs[i]));
+    trees.push_back(fData->GetTree(measurementsIDs[i], true));
     nentries = trees[i]->GetEntries();
     trees[i]->SetBranchAddress("ch_0", &sig_ch0);
     trees[i]->SetBranchAddress("ch_1", &sig_ch1);
+    trees[i]->SetBranchAddress("fLnMLR", lnMLR.data());
+    trees[i]->SetBranchAddress("fPEAverage", peAverage.data());
 
     //----- setting energy cut
     peakFinAv.push_back(new SFPeakFinder(fSpecAv[i], false));
@@ -154,9 +160,8 @@ bool SFPositionRes::AnalyzePositionRes(void){
     for(int ii=0; ii<nentries; ii++){
       trees[i]->GetEntry(ii);
       if(sig_ch0->GetT0()>0 && sig_ch1->GetT0()>0 &&
-         sqrt(sig_ch0->GetPE()*sig_ch1->GetPE())>xmin &&
-         sqrt(sig_ch0->GetPE()*sig_ch1->GetPE())<xmax){  
-        MLR = log(sqrt(sig_ch1->GetPE()/sig_ch0->GetPE()));
+         peAverage[0]>xmin && peAverage[0]<xmax){  
+        MLR = lnMLR[0];
         pos = funPol3->Eval(MLR);
         fPosRecoDist[i]->Fill(pos);
       }
@@ -169,7 +174,7 @@ bool SFPositionRes::AnalyzePositionRes(void){
     funGaus.push_back(new TF1("funGaus", "gaus", xmin, 200));
     
     //if(collimator.Contains("Electronic") && sipm.Contains("SensL")){
-        fPosRecoDist[i]->Fit(funGaus[i], "QR");
+        SFTools::FitHistogram(fPosRecoDist[i], funGaus[i], "QR");
         mean = funGaus[i]->GetParameter(1);
         meanErr  = funGaus[i]->GetParError(1);
         if(i==0) FWHM.resize(2);
@@ -0,0 +1,299 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *            SFPrefixSum.cc             *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#include "SFPrefixSum.hh"
+
+ClassImp(SFPrefixSum);
+
+//------------------------------------------------------------------
+/// Default constructor.
+SFPrefixSum::SFPrefixSum() : fHist(nullptr),
+                             fNbins(-1),
+                             fEntries(-1) {
+}
+//------------------------------------------------------------------
+/// Standard constructor. Table is not attached to the histogram, use
+/// GetPrefixSum() for this.
+/// \param hist - histogram
+SFPrefixSum::SFPrefixSum(TH1D *hist) : fHist(hist),
+                                       fNbins(-1),
+                                       fEntries(-1) {
+  Update();
+}
+//------------------------------------------------------------------
+/// Default destructor.
+SFPrefixSum::~SFPrefixSum(){
+}
+//------------------------------------------------------------------
+/// Returns table attached to the histogram. If there is none, new table
+/// is built and attached, histogram takes its ownership. Table read
+/// from the file or cloned together with the histogram is bound to the
+/// histogram again.
+/// \param hist - histogram
+SFPrefixSum* SFPrefixSum::GetPrefixSum(TH1D *hist){
+
+  if(hist==nullptr)
+    return nullptr;
+
+  SFPrefixSum *table = (SFPrefixSum*)hist->GetListOfFunctions()->FindObject("SFPrefixSum");
+
+  if(table==nullptr){
+    table = new SFPrefixSum(hist);
+    hist->GetListOfFunctions()->Add(table);
+  }
+  else if(table->fHist!=hist){
+    table->fHist = hist;
+    table->Update();
+  }
+
+  return table;
+}
+//------------------------------------------------------------------
+/// Rebuilds the table. Should be called if the histogram was modified
+/// without change of the number of entries, e.g. scaled.
+void SFPrefixSum::Update(void){
+
+  if(fHist!=nullptr)
+    Build();
+
+  return;
+}
+//------------------------------------------------------------------
+/// Calculates cumulative sums and sparse tables of extreme values.
+void SFPrefixSum::Build(void){
+
+  fNbins   = fHist->GetNbinsX();
+  fEntries = fHist->GetEntries();
+  fSum.assign(fNbins+1, 0);
+  fSumX.assign(fNbins+1, 0);
+
+  int nlevels = 1;
+  while((1<<nlevels)<=fNbins) nlevels++;
+
+  fMax.assign(nlevels, std::vector <double>(fNbins+1, 0));
+  fMin.assign(nlevels, std::vector <double>(fNbins+1, 0));
+
+  for(int bin=1; bin<=fNbins; bin++){
+    double content = fHist->GetBinContent(bin);
+    fSum[bin]    = fSum[bin-1] + content;
+    fSumX[bin]   = fSumX[bin-1] + content*fHist->GetBinCenter(bin);
+    fMax[0][bin] = content;
+    fMin[0][bin] = content;
+  }
+
+  for(int k=1; k<nlevels; k++){
+    int half = 1<<(k-1);
+    for(int bin=1; bin+(1<<k)-1<=fNbins; bin++){
+      fMax[k][bin] = std::max(fMax[k-1][bin], fMax[k-1][bin+half]);
+      fMin[k][bin] = std::min(fMin[k-1][bin], fMin[k-1][bin+half]);
+    }
+  }
+
+  return;
+}
+//------------------------------------------------------------------
+/// Checks whether the table is bound to the histogram and up to date.
+/// \param function - name of the calling function, for error messages
+bool SFPrefixSum::Check(TString function){
+
+  if(fHist==nullptr){
+    std::cerr << "##### Error in SFPrefixSum::" << function << "()!" << std::endl;
+    std::cerr << "Table is not bound to any histogram!" << std::endl;
+    return false;
+  }
+
+  if(fHist->GetNbinsX()!=fNbins || fHist->GetEntries()!=fEntries)
+    Build();
+
+  return true;
+}
+//------------------------------------------------------------------
+/// Returns sum of the bin contents in the given range of bins. Range
+/// is limited to [1, nbins].
+/// \param binLow - first bin of the range
+/// \param binHigh - last bin of the range
+double SFPrefixSum::GetIntegral(int binLow, int binHigh){
+
+  if(!Check("GetIntegral"))
+    return 0;
+
+  binLow  = std::max(binLow, 1);
+  binHigh = std::min(binHigh, fNbins);
+
+  if(binHigh<binLow)
+    return 0;
+
+  return fSum[binHigh] - fSum[binLow-1];
+}
+//------------------------------------------------------------------
+/// Returns sum of the bin contents of the bins containing given range
+/// of x, like TH1::Integral() with bins found by TAxis::FindFixBin().
+/// \param xmin - lower limit of the range
+/// \param xmax - upper limit of the range
+double SFPrefixSum::GetIntegral(double xmin, double xmax){
+
+  if(!Check("GetIntegral"))
+    return 0;
+
+  return GetIntegral(fHist->GetXaxis()->FindFixBin(xmin),
+                     fHist->GetXaxis()->FindFixBin(xmax));
+}
+//------------------------------------------------------------------
+/// Returns mean of the histogram in the given range of bins. For empty
+/// range NaN is returned.
+/// \param binLow - first bin of the range
+/// \param binHigh - last bin of the range
+double SFPrefixSum::GetMean(int binLow, int binHigh){
+
+  double integral = GetIntegral(binLow, binHigh);
+
+  if(integral==0)
+    return NAN;
+
+  binLow  = std::max(binLow, 1);
+  binHigh = std::min(binHigh, fNbins);
+
+  return (fSumX[binHigh] - fSumX[binLow-1])/integral;
+}
+//------------------------------------------------------------------
+/// Returns quantile of the histogram, interpolated linearly inside
+/// the bin. For empty histogram NaN is returned.
+/// \param q - probability, in the range [0, 1]
+double SFPrefixSum::GetQuantile(double q){
+
+  if(!Check("GetQuantile") || fNbins<1 || fSum[fNbins]<=0)
+    return NAN;
+
+  double rank = std::min(std::max(q, 0.), 1.)*fSum[fNbins];
+  int bin = std::lower_bound(fSum.begin()+1, fSum.end(), rank) - fSum.begin();
+  bin = std::min(bin, fNbins);
+
+  double content  = fSum[bin] - fSum[bin-1];
+  double fraction = content>0 ? (rank - fSum[bin-1])/content : 0;
+
+  return fHist->GetBinLowEdge(bin) + fraction*fHist->GetBinWidth(bin);
+}
+//------------------------------------------------------------------
+/// Returns maximal or minimal bin content in the given range of bins,
+/// from two overlapping entries of the sparse table.
+/// \param binLow - first bin of the range
+/// \param binHigh - last bin of the range
+/// \param isMax - true for maximum, false for minimum
+double SFPrefixSum::GetExtreme(int binLow, int binHigh, bool isMax){
+
+  int k = 0;
+  while((2<<k)<=binHigh-binLow+1) k++;
+
+  int second = binHigh - (1<<k) + 1;
+
+  if(isMax)
+    return std::max(fMax[k][binLow], fMax[k][second]);
+
+  return std::min(fMin[k][binLow], fMin[k][second]);
+}
+//------------------------------------------------------------------
+/// Returns maximal bin content in the given range of bins. Range is
+/// limited to [1, nbins], for empty range NaN is returned.
+/// \param binLow - first bin of the range
+/// \param binHigh - last bin of the range
+double SFPrefixSum::GetMaximum(int binLow, int binHigh){
+
+  if(!Check("GetMaximum"))
+    return NAN;
+
+  binLow  = std::max(binLow, 1);
+  binHigh = std::min(binHigh, fNbins);
+
+  if(binHigh<binLow)
+    return NAN;
+
+  return GetExtreme(binLow, binHigh, true);
+}
+//------------------------------------------------------------------
+/// Returns minimal bin content in the given range of bins. Range is
+/// limited to [1, nbins], for empty range NaN is returned.
+/// \param binLow - first bin of the range
+/// \param binHigh - last bin of the range
+double SFPrefixSum::GetMinimum(int binLow, int binHigh){
+
+  if(!Check("GetMinimum"))
+    return NAN;
+
+  binLow  = std::max(binLow, 1);
+  binHigh = std::min(binHigh, fNbins);
+
+  if(binHigh<binLow)
+    return NAN;
+
+  return GetExtreme(binLow, binHigh, false);
+}
+//------------------------------------------------------------------
+/// Returns the first bin, going from bin "from" towards bin "to" (in any
+/// direction), whose content is at least (above = true) or at most
+/// (above = false) the given level. Equivalent to the loop over bins,
+/// but done with binary search on the range extremes. If there is no
+/// such bin -1 is returned. Range is limited to [1, nbins].
+/// \param level - threshold, e.g. half maximum of the peak
+/// \param from - first bin of the search
+/// \param to - last bin of the search
+/// \param above - true to find content >= level, false to find content <= level
+int SFPrefixSum::FindCrossing(double level, int from, int to, bool above){
+
+  if(!Check("FindCrossing") || fNbins<1)
+    return -1;
+
+  bool forward = to>=from;
+  from = std::min(std::max(from, 1), fNbins);
+  to   = std::min(std::max(to, 1), fNbins);
+
+  if(forward ? to<from : to>from)
+    return -1;
+
+  auto found = [&](int a, int b){
+    int low  = std::min(a, b);
+    int high = std::max(a, b);
+    return above ? GetExtreme(low, high, true)>=level :
+                   GetExtreme(low, high, false)<=level;
+  };
+
+  if(!found(from, to))
+    return -1;
+
+  //----- the shortest range [from, bin] containing the crossing
+  int near = from;
+  int far  = to;
+
+  while(near!=far){
+    int middle = forward ? near + (far-near)/2 : near - (near-far)/2;
+    if(found(from, middle))
+      far = middle;
+    else
+      near = forward ? middle+1 : middle-1;
+  }
+
+  return near;
+}
+//------------------------------------------------------------------
+/// Prints details of the SFPrefixSum class object.
+void SFPrefixSum::Print(void){
+  std::cout << "\n-------------------------------------------" << std::endl;
+  std::cout << "This is Print() for SFPrefixSum class object" << std::endl;
+  if(fHist==nullptr){
+    std::cout << "Table is not bound to any histogram" << std::endl;
+  }
+  else{
+    std::cout << "Histogram: " << fHist->GetName() << std::endl;
+    std::cout << "Number of bins: " << fNbins << std::endl;
+    std::cout << "Integral: " << (fNbins>0 ? fSum[fNbins] : 0) << std::endl;
+    std::cout << "Number of levels of sparse tables: " << fMax.size() << std::endl;
+  }
+  std::cout << "-------------------------------------------\n" << std::endl;
+}
+//------------------------------------------------------------------
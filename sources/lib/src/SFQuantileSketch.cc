@@ -0,0 +1,170 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *          SFQuantileSketch.cc          *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#include "SFQuantileSketch.hh"
+
+ClassImp(SFQuantileSketch);
+
+//------------------------------------------------------------------
+/// Standard constructor.
+/// \param k - accuracy parameter, rank error is of the order of 1/k
+SFQuantileSketch::SFQuantileSketch(int k) : fK(std::max(k, 8)),
+                                            fCount(0),
+                                            fOffset(false) {
+  fCompactors.resize(1);
+}
+//------------------------------------------------------------------
+/// Default destructor.
+SFQuantileSketch::~SFQuantileSketch(){
+}
+//------------------------------------------------------------------
+/// Returns capacity of the compactor at the given level. The top
+/// compactor has capacity k, lower ones shrink geometrically by 2/3.
+/// \param level - compactor level
+int SFQuantileSketch::GetCapacity(int level){
+
+  int depth = fCompactors.size() - level - 1;
+  return std::max((int)ceil(fK*pow(2./3., depth)), 2);
+}
+//------------------------------------------------------------------
+/// Returns number of values stored in all compactors.
+int SFQuantileSketch::GetSize(void){
+
+  int size = 0;
+
+  for(size_t h=0; h<fCompactors.size(); h++)
+    size += fCompactors[h].size();
+
+  return size;
+}
+//------------------------------------------------------------------
+/// Compacts the lowest compactor exceeding its capacity, until the
+/// total size of the sketch fits in the total capacity.
+void SFQuantileSketch::Compress(void){
+
+  int capacity = 0;
+  for(size_t h=0; h<fCompactors.size(); h++)
+    capacity += GetCapacity(h);
+
+  if(GetSize()<capacity)
+    return;
+
+  for(size_t h=0; h<fCompactors.size(); h++){
+
+    if((int)fCompactors[h].size()<GetCapacity(h))
+      continue;
+
+    if(h+1==fCompactors.size())
+      fCompactors.push_back(std::vector <double>());
+
+    std::vector <double> &level = fCompactors[h];
+    std::sort(level.begin(), level.end());
+
+    //----- odd value stays at this level
+    double last = 0;
+    bool   odd  = level.size()%2==1;
+    if(odd){
+      last = level.back();
+      level.pop_back();
+    }
+
+    for(size_t i=fOffset; i<level.size(); i+=2)
+      fCompactors[h+1].push_back(level[i]);
+
+    fOffset = !fOffset;
+    level.clear();
+    if(odd) level.push_back(last);
+
+    break;
+  }
+
+  return;
+}
+//------------------------------------------------------------------
+/// Adds value to the sketch.
+/// \param value - value
+void SFQuantileSketch::Fill(double value){
+
+  if(!std::isfinite(value))
+    return;
+
+  fCompactors[0].push_back(value);
+  fCount++;
+  Compress();
+
+  return;
+}
+//------------------------------------------------------------------
+/// Adds content of another sketch, e.g. filled with another part of
+/// the data.
+/// \param sketch - sketch to be merged
+void SFQuantileSketch::Merge(const SFQuantileSketch &sketch){
+
+  while(fCompactors.size()<sketch.fCompactors.size())
+    fCompactors.push_back(std::vector <double>());
+
+  for(size_t h=0; h<sketch.fCompactors.size(); h++)
+    fCompactors[h].insert(fCompactors[h].end(), sketch.fCompactors[h].begin(),
+                          sketch.fCompactors[h].end());
+
+  fCount += sketch.fCount;
+
+  int size = GetSize();
+  Compress();
+  while(GetSize()<size){
+    size = GetSize();
+    Compress();
+  }
+
+  return;
+}
+//------------------------------------------------------------------
+/// Returns estimated quantile. For empty sketch NaN is returned.
+/// \param q - probability, in the range [0, 1]
+double SFQuantileSketch::GetQuantile(double q){
+
+  std::vector <std::pair <double, Long64_t>> items;
+  Long64_t total = 0;
+
+  for(size_t h=0; h<fCompactors.size(); h++){
+    for(size_t i=0; i<fCompactors[h].size(); i++){
+      items.push_back(std::make_pair(fCompactors[h][i], (Long64_t)1<<h));
+      total += (Long64_t)1<<h;
+    }
+  }
+
+  if(items.empty())
+    return NAN;
+
+  std::sort(items.begin(), items.end());
+
+  double   rank = std::min(std::max(q, 0.), 1.)*total;
+  Long64_t cumulative = 0;
+
+  for(size_t i=0; i<items.size(); i++){
+    cumulative += items[i].second;
+    if(cumulative>=rank)
+      return items[i].first;
+  }
+
+  return items.back().first;
+}
+//------------------------------------------------------------------
+/// Prints details of the SFQuantileSketch class object.
+void SFQuantileSketch::Print(void){
+  std::cout << "\n-------------------------------------------" << std::endl;
+  std::cout << "This is Print() for SFQuantileSketch class object" << std::endl;
+  std::cout << "Accuracy parameter k: " << fK << std::endl;
+  std::cout << "Number of values: " << fCount << std::endl;
+  std::cout << "Number of compactors: " << fCompactors.size() << std::endl;
+  std::cout << "Number of stored values: " << GetSize() << std::endl;
+  std::cout << "-------------------------------------------\n" << std::endl;
+}
+//------------------------------------------------------------------
@@ -0,0 +1,433 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *           SFSimulation.cc             *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#include "SFSimulation.hh"
+#include "SFTools.hh"
+
+ClassImp(SFSimulation);
+
+//------------------------------------------------------------------
+// constants
+static const int    gSamples     = 1024;     // number of samples in the waveform (1 sample = 1 ns)
+static const int    gValues      = 5;        // number of values describing signal: PE, charge, amplitude, T0, TOT
+static const int    gChannels    = 3;        // number of channels: two fiber ends and reference detector
+static const double gEnergy      = 0.511;    // energy of the annihilation gamma [MeV]
+static const double gComptonEdge = 0.3407;   // Compton edge for 511 keV gamma [MeV]
+static const double gNoSignal    = -100;     // T0 and TOT of signals below threshold
+//------------------------------------------------------------------
+int      SFSimulation::fDefaultNevents = 100000;
+unsigned SFSimulation::fDefaultSeed    = 4357;
+//------------------------------------------------------------------
+/// Default constructor.
+SFSimulation::SFSimulation(): fFiber("dummy"),
+                              fFiberLength(100),
+                              fSeriesNo(-1),
+                              fNevents(fDefaultNevents),
+                              fSeed(fDefaultSeed),
+                              fDirectory(gSystem->TempDirectory()) {
+}
+//------------------------------------------------------------------
+/// Standard constructor. Parameters of the fiber model are set to the
+/// default values for the given fiber type. They can be changed with
+/// SetParams().
+/// \param fiber - fiber type, as in the data base
+/// \param fiberLength - length of the fiber [mm]
+/// \param seriesNo - number of the experimental series
+SFSimulation::SFSimulation(TString fiber, double fiberLength, int seriesNo):
+                           fFiber(fiber),
+                           fFiberLength(fiberLength),
+                           fSeriesNo(seriesNo),
+                           fNevents(fDefaultNevents),
+                           fSeed(fDefaultSeed),
+                           fDirectory(gSystem->TempDirectory()) {
+
+  if(fFiber.Contains("LuAG")){
+    fParams.fLightYield   = 20000;
+    fParams.fDecayFast    = 60;
+    fParams.fDecaySlow    = 500;
+    fParams.fFastFraction = 0.8;
+  }
+  else if(fFiber.Contains("LYSO")){
+    fParams.fLightYield   = 30000;
+    fParams.fDecayFast    = 40;
+    fParams.fDecaySlow    = 40;
+    fParams.fFastFraction = 1;
+  }
+  else if(fFiber.Contains("GAGG")){
+    fParams.fLightYield   = 40000;
+    fParams.fDecayFast    = 90;
+    fParams.fDecaySlow    = 200;
+    fParams.fFastFraction = 0.7;
+  }
+  else{
+    std::cout << "##### Warning in SFSimulation constructor!" << std::endl;
+    std::cout << "Unknown fiber type: " << fFiber << ". Default parameters used." << std::endl;
+  }
+}
+//------------------------------------------------------------------
+/// Default destructor.
+SFSimulation::~SFSimulation(){
+}
+//------------------------------------------------------------------
+/// Sets number of events per measurement and global seed for all 
+/// SFSimulation objects created afterwards, e.g. by SFData objects
+/// of the analysis classes.
+/// \param nevents - number of events per measurement
+/// \param seed - global seed
+void SFSimulation::SetDefaults(int nevents, unsigned seed){
+  fDefaultNevents = nevents;
+  fDefaultSeed = seed;
+}
+//------------------------------------------------------------------
+/// Combines global seed with three integers into a seed for the random
+/// number generator of a single event or a single waveform.
+unsigned SFSimulation::Hash(unsigned seed, int a, int b, int c){
+
+  unsigned long long h = seed;
+  unsigned long long values[3] = {(unsigned long long)a, (unsigned long long)b,
+                                  (unsigned long long)c};
+
+  for(int i=0; i<3; i++){
+    h ^= values[i] + 0x9E3779B97F4A7C15ULL + (h<<6) + (h>>2);
+    h = (h ^ (h>>30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h>>27)) * 0x94D049BB133111EBULL;
+    h = h ^ (h>>31);
+  }
+
+  unsigned result = (unsigned)(h & 0xFFFFFFFF);
+
+  // seed 0 means random seed for TRandom3
+  return result==0 ? 1 : result;
+}
+//------------------------------------------------------------------
+/// Returns MD5 checksum of all parameters of the simulated measurement.
+/// It is used to identify files with generated measurements. Parameters
+/// of the fiber model are listed by name, so that reordering or extending
+/// the SimParams structure changes the checksum. Version tag should be 
+/// increased whenever the generation algorithm changes.
+TString SFSimulation::GetFingerprint(int ID, double position){
+
+  TString summary = Form("v2_%s_%.2f_%i_%i_%.2f_%i_%u", fFiber.Data(), fFiberLength,
+                         fSeriesNo, ID, position, fNevents, fSeed);
+  
+  summary += Form("_att%g_ly%g_trap%g_pde%g_ct%g", fParams.fAttLength,
+                  fParams.fLightYield, fParams.fTrapping, fParams.fPDE,
+                  fParams.fCrosstalk);
+  summary += Form("_fast%g_slow%g_frac%g_rise%g_photo%g", fParams.fDecayFast,
+                  fParams.fDecaySlow, fParams.fFastFraction, fParams.fRiseTime,
+                  fParams.fPhotoFraction);
+  summary += Form("_gain%g_gspread%g_spe%g_srise%g_sfall%g", fParams.fGain,
+                  fParams.fGainSpread, fParams.fSPEAmplitude, fParams.fSiPMRise,
+                  fParams.fSiPMFall);
+  summary += Form("_noise%g_bl%g_thr%g_trig%g_jitter%g", fParams.fNoise,
+                  fParams.fBaseline, fParams.fThreshold, fParams.fTrigger,
+                  fParams.fTimeJitter);
+  summary += Form("_speed%g_refpe%g_refsigma%g", fParams.fLightSpeed,
+                  fParams.fRefPE, fParams.fRefSigma);
+
+  TMD5 md5;
+  md5.Update(reinterpret_cast<const UChar_t*>(summary.Data()), summary.Length());
+  md5.Final();
+
+  return TString(md5.AsString());
+}
+//------------------------------------------------------------------
+/// Calculates properties of the signal (PE, charge, amplitude, T0 and TOT)
+/// for the given number of detected photoelectrons.
+/// \param rand - random number generator
+/// \param npe - number of photoelectrons, including crosstalk
+/// \param t0 - arrival time of the first photon [ns]
+/// \param values - array where signal properties are written
+void SFSimulation::SetValues(TRandom3 &rand, double npe, double t0, float *values){
+
+  double pe = npe>0 ? npe*(1+rand.Gaus(0, fParams.fGainSpread/sqrt(npe))) :
+                      rand.Gaus(0, fParams.fGainSpread);
+
+  // Peak of the convolution of exponential light emission with single
+  // photoelectron signal, relative to the single photoelectron amplitude.
+  double tauFall = fParams.fSiPMFall;
+  double tau[2]  = {fParams.fDecayFast, fParams.fDecaySlow};
+  double frac[2] = {fParams.fFastFraction, 1-fParams.fFastFraction};
+  double shape   = 0;
+
+  for(int i=0; i<2; i++){
+    double ratio = tauFall/tau[i];
+    if(fabs(ratio-1)<1E-3) shape += frac[i]*TMath::Exp(-1);
+    else shape += frac[i]*TMath::Power(ratio, ratio/(1-ratio));
+  }
+
+  double amp = pe*fParams.fSPEAmplitude*shape + rand.Gaus(0, fParams.fNoise);
+  double tot = gNoSignal;
+
+  if(amp>fParams.fThreshold){
+    double tauTail = std::max(std::max(tau[0], tauFall), frac[1]>0 ? tau[1] : 0);
+    tot = tauTail*TMath::Log(amp/fParams.fThreshold);
+  }
+  else{
+    t0 = gNoSignal;
+  }
+
+  values[0] = pe;
+  values[1] = pe*fParams.fGain;
+  values[2] = amp;
+  values[3] = t0;
+  values[4] = tot;
+}
+//------------------------------------------------------------------
+/// Generates single event: energy deposition in the fiber, light
+/// propagation to both fiber ends, detection of photons in SiPMs
+/// (including crosstalk) and signal in the reference detector.
+/// \param rand - random number generator
+/// \param position - source position [mm]
+/// \param values - array where properties of signals in all channels are written
+void SFSimulation::GenerateEvent(TRandom3 &rand, double position, float *values){
+
+  double energy = rand.Rndm()<fParams.fPhotoFraction ? gEnergy :
+                                                       rand.Uniform(0, gComptonEdge);
+  double nphotons = energy*fParams.fLightYield;
+
+  for(int ch=0; ch<2; ch++){
+    double distance = (ch==0) ? position : fFiberLength-position;
+    double mean = nphotons*fParams.fTrapping*fParams.fPDE*
+                  TMath::Exp(-distance/fParams.fAttLength);
+
+    int npe = rand.Poisson(mean);
+    int ncross = npe;
+    while(ncross>0){
+      ncross = rand.Poisson(ncross*fParams.fCrosstalk);
+      npe += ncross;
+    }
+
+    double t0 = fParams.fTrigger + distance/fParams.fLightSpeed +
+                rand.Exp(fParams.fRiseTime + fParams.fDecayFast/std::max(npe, 1)) +
+                rand.Gaus(0, fParams.fTimeJitter);
+
+    SetValues(rand, npe, t0, &values[ch*gValues]);
+  }
+
+  double refPE = rand.Gaus(fParams.fRefPE, fParams.fRefSigma);
+  double refT0 = fParams.fTrigger + rand.Gaus(0, fParams.fTimeJitter);
+  SetValues(rand, refPE, refT0, &values[2*gValues]);
+}
+//------------------------------------------------------------------
+/// Generates properties of signals of the event with the given number 
+/// (see GetEvent()).
+/// \param ID - measurement ID
+/// \param position - source position [mm]
+/// \param entry - event number
+/// \param values - array where properties of signals in all channels are written
+void SFSimulation::GetValues(int ID, double position, Long64_t entry, float *values){
+  TRandom3 rand(Hash(fSeed, ID, (int)entry, 0));
+  GenerateEvent(rand, position, values);
+}
+//------------------------------------------------------------------
+/// Generates event with the given number. Each event has its own random 
+/// number generator seeded with a combination of the global seed, 
+/// measurement ID and event number, therefore events can be generated 
+/// in any order, also lazily while reading (see SFData::FillKernel()), 
+/// and they are always the same as the ones stored by GetResultsFile().
+/// \param ID - measurement ID
+/// \param position - source position [mm]
+/// \param entry - event number
+/// \param sig - array of gChannels signals (see GetNchannels()), where 
+/// generated event is written
+void SFSimulation::GetEvent(int ID, double position, Long64_t entry, DDSignal **sig){
+
+  float values[gChannels*gValues];
+  GetValues(ID, position, entry, values);
+
+  for(int ch=0; ch<gChannels; ch++){
+    sig[ch]->SetPE(values[ch*gValues]);
+    sig[ch]->SetCharge(values[ch*gValues+1]);
+    sig[ch]->SetAmplitude(values[ch*gValues+2]);
+    sig[ch]->SetT0(values[ch*gValues+3]);
+    sig[ch]->SetTOT(values[ch*gValues+4]);
+  }
+}
+//------------------------------------------------------------------
+/// Returns number of channels in the simulated events: two fiber ends 
+/// and the reference detector.
+int SFSimulation::GetNchannels(void){
+  return gChannels;
+}
+//------------------------------------------------------------------
+/// Returns path of the ROOT file for the simulated measurement. The file
+/// is not generated (see GetResultsFile()).
+/// \param ID - measurement ID
+/// \param position - source position [mm]
+TString SFSimulation::GetFileName(int ID, double position){
+  return fDirectory + Form("/sim_S%i_ID%i_%s.root", fSeriesNo, ID,
+                           GetFingerprint(ID, position).Data());
+}
+//------------------------------------------------------------------
+/// Returns name identifying the simulated measurement, e.g. as an input
+/// of cached products (see SFManifest). Unlike GetFileName() it doesn't
+/// point to a file, so it doesn't change when the file is generated.
+/// \param ID - measurement ID
+/// \param position - source position [mm]
+TString SFSimulation::GetSourceName(int ID, double position){
+  return Form("simulation:S%i_ID%i_%s", fSeriesNo, ID,
+              GetFingerprint(ID, position).Data());
+}
+//------------------------------------------------------------------
+/// Returns path to the ROOT file containing simulated measurement. If
+/// the measurement with the same parameters was already generated the
+/// existing file is used. Otherwise events are generated (see GetEvent())
+/// in parallel and saved in the tree "tree_ft", in the same format as
+/// experimental data. The file is needed only where the whole tree is required, i.e.
+/// for TTree::Draw(), derived quantities and event masks. Spectra filled 
+/// with the compiled kernels read the events directly from GetEvent().
+/// \param ID - measurement ID
+/// \param position - source position [mm]
+TString SFSimulation::GetResultsFile(int ID, double position){
+
+  TString fname = GetFileName(ID, position);
+
+  if(!gSystem->AccessPathName(fname))
+    return fname;
+
+  std::cout << "Generating " << fNevents << " events for measurement ID " << ID
+            << ", position " << position << " mm..." << std::endl;
+
+  TDirectory *dir = gDirectory;
+  TString tmpname = fname + Form(".%i.tmp", gSystem->GetPid());
+  TFile *file = new TFile(tmpname, "RECREATE");
+
+  if(!file->IsOpen() || file->IsZombie()){
+    std::cerr << "##### Error in SFSimulation::GetResultsFile()! Cannot create file!" << std::endl;
+    std::cerr << tmpname << std::endl;
+    std::abort();
+  }
+
+  TTree *tree = new TTree("tree_ft", "tree_ft");
+  DDSignal *sig[gChannels];
+
+  for(int ch=0; ch<gChannels; ch++){
+    sig[ch] = new DDSignal();
+    tree->Branch(Form("ch_%i", ch), &sig[ch]);
+  }
+
+  int nblock  = 10000;
+  int nvalues = gChannels*gValues;
+  std::vector <float> values((size_t)nblock*nvalues);
+
+  for(int first=0; first<fNevents; first+=nblock){
+
+    int nev = std::min(nblock, fNevents-first);
+
+    SFTools::ParallelFor(nev, [&](int ev){
+      GetValues(ID, position, first+ev, &values[(size_t)ev*nvalues]);
+    });
+
+    for(int ev=0; ev<nev; ev++){
+      float *v = &values[(size_t)ev*nvalues];
+      for(int ch=0; ch<gChannels; ch++){
+        sig[ch]->SetPE(v[ch*gValues]);
+        sig[ch]->SetCharge(v[ch*gValues+1]);
+        sig[ch]->SetAmplitude(v[ch*gValues+2]);
+        sig[ch]->SetT0(v[ch*gValues+3]);
+        sig[ch]->SetTOT(v[ch*gValues+4]);
+      }
+      tree->Fill();
+    }
+  }
+
+  file->cd();
+  tree->Write();
+  file->Close();
+  delete file;
+  dir->cd();
+
+  for(int ch=0; ch<gChannels; ch++)
+    delete sig[ch];
+
+  gSystem->Rename(tmpname, fname);
+
+  return fname;
+}
+//------------------------------------------------------------------
+/// Returns simulated waveform of the chosen signal. Photoelectrons are
+/// distributed in time according to the scintillation rise and decay
+/// times, starting from the signal T0. Each photoelectron contributes
+/// with single photoelectron signal. Electronic noise is added. Waveform
+/// of the given event is always the same, irrespectively of the order
+/// in which waveforms are requested.
+/// \param ID - measurement ID
+/// \param event - event number in the tree
+/// \param ch - channel number
+/// \param pe - signal PE, as stored in the tree
+/// \param t0 - signal T0, as stored in the tree
+/// \param bl - flag for base line subtraction. If false base line is added to the waveform.
+std::vector <double> SFSimulation::GetWaveform(int ID, int event, int ch, double pe,
+                                               double t0, bool bl){
+
+  TRandom3 rand(Hash(fSeed, ID, event, gChannels+ch));
+
+  std::vector <double> counts(gSamples, 0);
+  int npe = std::max(0, TMath::Nint(pe));
+
+  if(t0<0) t0 = fParams.fTrigger;
+
+  for(int i=0; i<npe; i++){
+    double tau = rand.Rndm()<fParams.fFastFraction ? fParams.fDecayFast : fParams.fDecaySlow;
+    double time = t0 + rand.Exp(fParams.fRiseTime) + rand.Exp(tau);
+    int sample = (int)time;
+    if(sample<0 || sample>=gSamples) continue;
+    counts[sample] += 1 + rand.Gaus(0, fParams.fGainSpread);
+  }
+
+  //----- single photoelectron signal
+  double rise = fParams.fSiPMRise;
+  double fall = fParams.fSiPMFall;
+  double tpeak = TMath::Log(fall/rise)*rise*fall/(fall-rise);
+  double norm = fParams.fSPEAmplitude/(TMath::Exp(-tpeak/fall) - TMath::Exp(-tpeak/rise));
+  int ntemplate = std::min(gSamples, (int)(10*fall));
+  std::vector <double> spe(ntemplate);
+
+  for(int i=0; i<ntemplate; i++)
+    spe[i] = norm*(TMath::Exp(-i/fall) - TMath::Exp(-i/rise));
+
+  //----- waveform
+  std::vector <double> waveform(gSamples, 0);
+
+  for(int i=0; i<gSamples; i++){
+    if(counts[i]==0) continue;
+    int stop = std::min(gSamples, i+ntemplate);
+    for(int ii=i; ii<stop; ii++)
+      waveform[ii] += counts[i]*spe[ii-i];
+  }
+
+  for(int i=0; i<gSamples; i++){
+    waveform[i] += rand.Gaus(0, fParams.fNoise);
+    if(!bl) waveform[i] += fParams.fBaseline;
+  }
+
+  return waveform;
+}
+//------------------------------------------------------------------
+/// Prints details of the simulation.
+void SFSimulation::Print(void){
+
+  std::cout << "\n-------------------------------------------" << std::endl;
+  std::cout << "This is Print() for SFSimulation class object" << std::endl;
+  std::cout << "Fiber: " << fFiber << ", length: " << fFiberLength << " mm" << std::endl;
+  std::cout << "Number of events per measurement: " << fNevents << std::endl;
+  std::cout << "Seed: " << fSeed << std::endl;
+  std::cout << "Attenuation length: " << fParams.fAttLength << " mm" << std::endl;
+  std::cout << "Light yield: " << fParams.fLightYield << " ph/MeV" << std::endl;
+  std::cout << "Trapping efficiency: " << fParams.fTrapping << std::endl;
+  std::cout << "PDE: " << fParams.fPDE << std::endl;
+  std::cout << "Crosstalk: " << fParams.fCrosstalk << std::endl;
+  std::cout << "Decay constants: " << fParams.fDecayFast << " ns ("
+            << fParams.fFastFraction*100 << "%), " << fParams.fDecaySlow << " ns" << std::endl;
+  std::cout << "Output directory: " << fDirectory << std::endl;
+  std::cout << "-------------------------------------------\n" << std::endl;
+}
+//------------------------------------------------------------------
@@ -0,0 +1,97 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *           SFSpectrumInfo.cc           *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#include "SFSpectrumInfo.hh"
+
+ClassImp(SFSpectrumInfo);
+
+//------------------------------------------------------------------
+/// Default constructor.
+SFSpectrumInfo::SFSpectrumInfo() : fSeriesNo(-1),
+                                   fMeasureID(-1),
+                                   fPosition(-1),
+                                   fSelection("dummy"),
+                                   fCut(""),
+                                   fDataPath("dummy"),
+                                   fCollimator("dummy") {
+}
+//------------------------------------------------------------------
+/// Standard constructor.
+/// \param seriesNo - series number
+/// \param ID - measurement ID
+/// \param channels - channels used by the selection
+/// \param position - source position [mm]
+/// \param selection - selection name
+/// \param cut - cut
+/// \param dataPath - directory containing data of the measurement
+/// \param collimator - collimator type of the series
+SFSpectrumInfo::SFSpectrumInfo(int seriesNo, int ID, std::vector <int> channels,
+                               double position, TString selection, TString cut,
+                               TString dataPath, TString collimator) :
+                               fSeriesNo(seriesNo),
+                               fMeasureID(ID),
+                               fChannels(channels),
+                               fPosition(position),
+                               fSelection(selection),
+                               fCut(cut),
+                               fDataPath(dataPath),
+                               fCollimator(collimator) {
+}
+//------------------------------------------------------------------
+/// Default destructor.
+SFSpectrumInfo::~SFSpectrumInfo(){
+}
+//------------------------------------------------------------------
+/// Attaches the record to the histogram. Record previously attached
+/// to this histogram is replaced. Histogram takes ownership of the record.
+/// \param hist - histogram
+void SFSpectrumInfo::Attach(TH1 *hist){
+
+  SFSpectrumInfo *old = GetInfo(hist);
+
+  if(old!=nullptr){
+    hist->GetListOfFunctions()->Remove(old);
+    delete old;
+  }
+
+  hist->GetListOfFunctions()->Add(this);
+
+  return;
+}
+//------------------------------------------------------------------
+/// Returns record attached to the histogram or nullptr if there is none,
+/// e.g. for histograms not produced by SFData.
+/// \param hist - histogram
+SFSpectrumInfo* SFSpectrumInfo::GetInfo(TH1 *hist){
+
+  if(hist==nullptr)
+    return nullptr;
+
+  return (SFSpectrumInfo*)hist->GetListOfFunctions()->FindObject("SFSpectrumInfo");
+}
+//------------------------------------------------------------------
+/// Prints details of the SFSpectrumInfo class object.
+void SFSpectrumInfo::Print(void){
+  std::cout << "\n-------------------------------------------" << std::endl;
+  std::cout << "This is Print() for SFSpectrumInfo class object" << std::endl;
+  std::cout << "Series number: " << fSeriesNo << std::endl;
+  std::cout << "Measurement ID: " << fMeasureID << std::endl;
+  std::cout << "Channels: ";
+  for(size_t i=0; i<fChannels.size(); i++)
+    std::cout << fChannels[i] << " ";
+  std::cout << std::endl;
+  std::cout << "Source position: " << fPosition << " mm" << std::endl;
+  std::cout << "Selection: " << fSelection << std::endl;
+  std::cout << "Cut: " << fCut << std::endl;
+  std::cout << "Data path: " << fDataPath << std::endl;
+  std::cout << "Collimator: " << fCollimator << std::endl;
+  std::cout << "-------------------------------------------\n" << std::endl;
+}
+//------------------------------------------------------------------
@@ -0,0 +1,447 @@
+// *****************************************
+// *                                       *
+// *          ScintillatingFibers          *
+// *          SFSpectrumMatrix.cc          *
+// *          Katarzyna Rusiecka           *
+// * katarzyna.rusiecka@doctoral.uj.edu.pl *
+// *          Created in 2019              *
+// *                                       *
+// *****************************************
+
+#include "SFSpectrumMatrix.hh"
+
+ClassImp(SFSpectrumMatrix);
+
+//------------------------------------------------------------------
+// constants
+static const int gMaxBins = 100000;   // maximal number of bins of the common axis
+
+//------------------------------------------------------------------
+/// Default constructor.
+SFSpectrumMatrix::SFSpectrumMatrix() : fName("dummy"),
+                                       fNpositions(0),
+                                       fNbins(0),
+                                       fXmin(0),
+                                       fXmax(0),
+                                       fStride(0) {
+}
+//------------------------------------------------------------------
+/// Standard constructor. Creates matrix with empty spectra.
+/// \param name - name of the matrix
+/// \param positions - source positions [mm], one per spectrum
+/// \param nbins - number of bins
+/// \param xmin - lower edge of the first bin
+/// \param xmax - upper edge of the last bin
+SFSpectrumMatrix::SFSpectrumMatrix(TString name, std::vector <double> positions,
+                                   int nbins, double xmin, double xmax) :
+                                   fName(name),
+                                   fNpositions(positions.size()),
+                                   fNbins(nbins),
+                                   fXmin(xmin),
+                                   fXmax(xmax),
+                                   fPositions(positions) {
+
+  if(nbins<1 || xmax<=xmin){
+    std::cerr << "##### Error in SFSpectrumMatrix constructor!" << std::endl;
+    std::cerr << "Incorrect binning: " << nbins << " bins, " << xmin << " - " << xmax << std::endl;
+    std::abort();
+  }
+
+  fStride = ((fNbins+2+7)/8)*8;
+  fTitles.resize(fNpositions);
+  fContents.assign((size_t)fNpositions*fStride, 0);
+  fErrors2.assign((size_t)fNpositions*fStride, 0);
+  fViews.assign(fNpositions, nullptr);
+}
+//------------------------------------------------------------------
+/// Default destructor. Views are deleted.
+SFSpectrumMatrix::~SFSpectrumMatrix(){
+  DeleteViews();
+}
+//------------------------------------------------------------------
+/// Creates matrix from the spectra of the series, e.g. returned by
+/// SFData::GetSpectra(). If all spectra have the same fixed binning they
+/// are copied as they are. Otherwise, e.g. with adaptive binning (see 
+/// SFData::SetAdaptiveBinning()), they are resampled to a common axis, 
+/// covering ranges of all spectra with the finest bin width (see 
+/// ResampleRow()). Spectra are copied, so they can be deleted afterwards.
+/// If spectra are missing nullptr is returned.
+/// \param name - name of the matrix
+/// \param spectra - spectra, one per position
+/// \param positions - source positions [mm]
+SFSpectrumMatrix* SFSpectrumMatrix::FromSpectra(TString name, std::vector <TH1D*> spectra,
+                                                std::vector <double> positions){
+
+  if(spectra.empty() || spectra.size()!=positions.size()){
+    std::cerr << "##### Error in SFSpectrumMatrix::FromSpectra()!" << std::endl;
+    std::cerr << "Number of spectra doesn't match number of positions!" << std::endl;
+    return nullptr;
+  }
+
+  //----- common axis
+  TAxis *first = nullptr;
+  double xmin  = 0;
+  double xmax  = 0;
+  double width = 0;
+  bool common  = true;
+
+  for(size_t pos=0; pos<spectra.size(); pos++){
+
+    if(spectra[pos]==nullptr){
+      std::cerr << "##### Error in SFSpectrumMatrix::FromSpectra()!" << std::endl;
+      std::cerr << "Spectrum of position " << positions[pos] << " is null pointer!" << std::endl;
+      return nullptr;
+    }
+
+    TAxis *axis = spectra[pos]->GetXaxis();
+
+    if(first==nullptr){
+      first = axis;
+      xmin  = axis->GetXmin();
+      xmax  = axis->GetXmax();
+      width = axis->GetBinWidth(1);
+    }
+
+    double tolerance = 1E-6*first->GetBinWidth(1);
+    common = common && axis->GetNbins()==first->GetNbins() &&
+             axis->GetXbins()->GetSize()==0 && first->GetXbins()->GetSize()==0 &&
+             fabs(axis->GetXmin()-first->GetXmin())<tolerance &&
+             fabs(axis->GetXmax()-first->GetXmax())<tolerance;
+
+    xmin = std::min(xmin, axis->GetXmin());
+    xmax = std::max(xmax, axis->GetXmax());
+    for(int bin=1; bin<=axis->GetNbins(); bin++)
+      width = std::min(width, axis->GetBinWidth(bin));
+  }
+
+  int nbins = common ? first->GetNbins() :
+                       std::min((int)ceil((xmax-xmin)/width-1E-6), gMaxBins);
+
+  SFSpectrumMatrix *matrix = new SFSpectrumMatrix(name, positions, nbins, xmin, xmax);
+
+  for(int pos=0; pos<matrix->fNpositions; pos++){
+    bool set = common ? matrix->SetRow(pos, spectra[pos]) :
+                        matrix->ResampleRow(pos, spectra[pos]);
+    if(!set){
+      delete matrix;
+      return nullptr;
+    }
+  }
+
+  return matrix;
+}
+//------------------------------------------------------------------
+/// Checks whether the position index is correct.
+/// \param pos - position index
+/// \param function - name of the calling function, for error messages
+bool SFSpectrumMatrix::CheckPosition(int pos, TString function) const {
+
+  if(pos<0 || pos>=fNpositions){
+    std::cerr << "##### Error in SFSpectrumMatrix::" << function << "()!" << std::endl;
+    std::cerr << "Incorrect position index: " << pos << std::endl;
+    return false;
+  }
+
+  return true;
+}
+//------------------------------------------------------------------
+/// Deletes views of single positions.
+void SFSpectrumMatrix::DeleteViews(void){
+
+  for(size_t i=0; i<fViews.size(); i++)
+    delete fViews[i];
+
+  fViews.assign(fNpositions, nullptr);
+}
+//------------------------------------------------------------------
+/// Copies spectrum into the row of the position. Spectrum must have
+/// the binning of the matrix.
+/// \param pos - position index
+/// \param spectrum - spectrum
+bool SFSpectrumMatrix::SetRow(int pos, TH1D *spectrum){
+
+  if(!CheckPosition(pos, "SetRow"))
+    return false;
+
+  TAxis *axis = spectrum->GetXaxis();
+  double width = (fXmax-fXmin)/fNbins;
+
+  if(axis->GetNbins()!=fNbins || axis->GetXbins()->GetSize()>0 ||
+     fabs(axis->GetXmin()-fXmin)>1E-6*width || fabs(axis->GetXmax()-fXmax)>1E-6*width){
+    std::cerr << "##### Error in SFSpectrumMatrix::SetRow()!" << std::endl;
+    std::cerr << "Binning of the spectrum " << spectrum->GetName()
+              << " doesn't match binning of the matrix!" << std::endl;
+    return false;
+  }
+
+  double *row  = GetRow(pos);
+  double *err2 = fErrors2.data() + pos*fStride;
+
+  for(int bin=0; bin<=fNbins+1; bin++){
+    double error = spectrum->GetBinError(bin);
+    row[bin]  = spectrum->GetBinContent(bin);
+    err2[bin] = error*error;
+  }
+
+  fTitles[pos] = spectrum->GetTitle();
+
+  return true;
+}
+//------------------------------------------------------------------
+/// Resamples spectrum with any binning into the row of the position. 
+/// Content of every bin of the spectrum is shared between the bins of 
+/// the matrix in proportion to their overlap, squared errors are shared 
+/// with squared fractions. Underflow and overflow are copied to the 
+/// underflow and overflow of the row.
+/// \param pos - position index
+/// \param spectrum - spectrum
+bool SFSpectrumMatrix::ResampleRow(int pos, TH1D *spectrum){
+
+  if(!CheckPosition(pos, "ResampleRow"))
+    return false;
+
+  TAxis *axis  = spectrum->GetXaxis();
+  double width = (fXmax-fXmin)/fNbins;
+  double *row  = GetRow(pos);
+  double *err2 = fErrors2.data() + pos*fStride;
+
+  std::fill(row, row+fStride, 0);
+  std::fill(err2, err2+fStride, 0);
+
+  row[0]         = spectrum->GetBinContent(0);
+  err2[0]        = pow(spectrum->GetBinError(0), 2);
+  row[fNbins+1]  = spectrum->GetBinContent(axis->GetNbins()+1);
+  err2[fNbins+1] = pow(spectrum->GetBinError(axis->GetNbins()+1), 2);
+
+  for(int bin=1; bin<=axis->GetNbins(); bin++){
+
+    double low     = axis->GetBinLowEdge(bin);
+    double up      = axis->GetBinUpEdge(bin);
+    double content = spectrum->GetBinContent(bin);
+    double error2  = pow(spectrum->GetBinError(bin), 2);
+    int firstBin   = std::max(1, (int)floor((low-fXmin)/width)+1);
+    int lastBin    = std::min(fNbins, (int)ceil((up-fXmin)/width));
+
+    for(int b=firstBin; b<=lastBin; b++){
+      double edge     = fXmin + (b-1)*width;
+      double fraction = (std::min(up, edge+width) - std::max(low, edge))/(up-low);
+      if(fraction<=0) continue;
+      row[b]  += fraction*content;
+      err2[b] += fraction*fraction*error2;
+    }
+  }
+
+  fTitles[pos] = spectrum->GetTitle();
+
+  return true;
+}
+//------------------------------------------------------------------
+/// Returns center of the bin, common for all positions.
+/// \param bin - bin number
+double SFSpectrumMatrix::GetBinCenter(int bin) const {
+
+  return fXmin + (bin-0.5)*(fXmax-fXmin)/fNbins;
+}
+//------------------------------------------------------------------
+/// Returns sum of the bin contents of the position (without underflow
+/// and overflow).
+/// \param pos - position index
+double SFSpectrumMatrix::GetIntegral(int pos) const {
+
+  if(!CheckPosition(pos, "GetIntegral"))
+    return 0;
+
+  const double *row = GetRow(pos);
+  double integral = 0;
+
+  for(int bin=1; bin<=fNbins; bin++)
+    integral += row[bin];
+
+  return integral;
+}
+//------------------------------------------------------------------
+/// Scales spectrum of the position, errors are scaled accordingly.
+/// \param pos - position index
+/// \param factor - scaling factor
+void SFSpectrumMatrix::Scale(int pos, double factor){
+
+  if(!CheckPosition(pos, "Scale"))
+    return;
+
+  double *row  = GetRow(pos);
+  double *err2 = fErrors2.data() + pos*fStride;
+
+  for(int bin=0; bin<=fNbins+1; bin++){
+    row[bin]  *= factor;
+    err2[bin] *= factor*factor;
+  }
+
+  return;
+}
+//------------------------------------------------------------------
+/// Normalizes spectra of all positions to unit integral. Empty spectra
+/// are not changed.
+void SFSpectrumMatrix::Normalize(void){
+
+  for(int pos=0; pos<fNpositions; pos++){
+    double integral = GetIntegral(pos);
+    if(integral>0) Scale(pos, 1./integral);
+  }
+
+  return;
+}
+//------------------------------------------------------------------
+/// Subtracts scaled background spectra from all positions, row by row.
+/// Errors of the background are added in quadrature.
+/// \param background - background spectra, same shape as this matrix
+/// \param factors - scaling factors of the background, one per position
+bool SFSpectrumMatrix::Subtract(const SFSpectrumMatrix &background, std::vector <double> factors){
+
+  if(background.fNpositions!=fNpositions || background.fNbins!=fNbins ||
+     factors.size()!=(size_t)fNpositions){
+    std::cerr << "##### Error in SFSpectrumMatrix::Subtract()!" << std::endl;
+    std::cerr << "Shape of the background doesn't match shape of the matrix!" << std::endl;
+    return false;
+  }
+
+  for(int pos=0; pos<fNpositions; pos++){
+    double *row   = GetRow(pos);
+    double *err2  = fErrors2.data() + pos*fStride;
+    const double *bg     = background.GetRow(pos);
+    const double *bgErr2 = background.fErrors2.data() + pos*fStride;
+    double f = factors[pos];
+    for(int bin=0; bin<=fNbins+1; bin++){
+      row[bin]  -= f*bg[bin];
+      err2[bin] += f*f*bgErr2[bin];
+    }
+  }
+
+  return true;
+}
+//------------------------------------------------------------------
+/// Subtracts function, e.g. fitted background, evaluated in bin centers
+/// from the spectrum of the position.
+/// \param pos - position index
+/// \param fun - function to be subtracted
+bool SFSpectrumMatrix::Subtract(int pos, TF1 *fun){
+
+  if(!CheckPosition(pos, "Subtract"))
+    return false;
+
+  if(fun==nullptr){
+    std::cerr << "##### Error in SFSpectrumMatrix::Subtract()!" << std::endl;
+    std::cerr << "Function is null pointer!" << std::endl;
+    return false;
+  }
+
+  double *row = GetRow(pos);
+
+  for(int bin=1; bin<=fNbins; bin++)
+    row[bin] -= fun->Eval(GetBinCenter(bin));
+
+  return true;
+}
+//------------------------------------------------------------------
+/// Returns bins with the maximal content in the given range of x, one
+/// per position, e.g. as seeds for peak fitting.
+/// \param xmin - lower limit of the range
+/// \param xmax - upper limit of the range
+std::vector <int> SFSpectrumMatrix::GetMaximumBins(double xmin, double xmax) const {
+
+  double width = (fXmax-fXmin)/fNbins;
+  int first = std::max(1, (int)floor((xmin-fXmin)/width)+1);
+  int last  = std::min(fNbins, (int)floor((xmax-fXmin)/width)+1);
+
+  std::vector <int> maxBins(fNpositions, -1);
+
+  if(last<first)
+    return maxBins;
+
+  for(int pos=0; pos<fNpositions; pos++){
+    const double *row = GetRow(pos);
+    maxBins[pos] = std::max_element(row+first, row+last+1) - row;
+  }
+
+  return maxBins;
+}
+//------------------------------------------------------------------
+/// Returns maximal bin contents in the given range of x, one per position.
+/// \param xmin - lower limit of the range
+/// \param xmax - upper limit of the range
+std::vector <double> SFSpectrumMatrix::GetMaxima(double xmin, double xmax) const {
+
+  std::vector <int>    maxBins = GetMaximumBins(xmin, xmax);
+  std::vector <double> maxima(fNpositions, 0);
+
+  for(int pos=0; pos<fNpositions; pos++)
+    if(maxBins[pos]>0) maxima[pos] = GetRow(pos)[maxBins[pos]];
+
+  return maxima;
+}
+//------------------------------------------------------------------
+/// Returns histogram of the position with the current content of the
+/// matrix. Histogram is a copy of the row, kept by the matrix and 
+/// refreshed on every call, thus it must not be deleted. Changes of the
+/// histogram are not propagated back to the matrix.
+/// \param pos - position index
+TH1D* SFSpectrumMatrix::GetView(int pos){
+
+  if(!CheckPosition(pos, "GetView"))
+    return nullptr;
+
+  if(fViews.size()!=(size_t)fNpositions)
+    fViews.assign(fNpositions, nullptr);
+
+  if(fViews[pos]==nullptr){
+    fViews[pos] = new TH1D(Form("%s_pos%.1f", fName.Data(), fPositions[pos]),
+                           fTitles[pos], fNbins, fXmin, fXmax);
+    fViews[pos]->SetDirectory(nullptr);
+    fViews[pos]->Sumw2();
+  }
+
+  TH1D *view = fViews[pos];
+  const double *row  = GetRow(pos);
+  const double *err2 = fErrors2.data() + pos*fStride;
+
+  std::copy(row, row+fNbins+2, view->GetArray());
+
+  for(int bin=0; bin<=fNbins+1; bin++)
+    view->SetBinError(bin, sqrt(err2[bin]));
+
+  view->SetEntries(GetIntegral(pos));
+  view->ResetStats();
+
+  return view;
+}
+//------------------------------------------------------------------
+/// Returns 2D histogram of all spectra: x of the spectra on X axis,
+/// position index on Y axis. Histogram is owned by the caller.
+TH2D* SFSpectrumMatrix::GetHistogram2D(void) const {
+
+  TH2D *hist = new TH2D(fName + "_2D", fName, fNbins, fXmin, fXmax,
+                        fNpositions, -0.5, fNpositions-0.5);
+  hist->SetDirectory(nullptr);
+  hist->GetYaxis()->SetTitle("position index");
+
+  for(int pos=0; pos<fNpositions; pos++){
+    const double *row = GetRow(pos);
+    for(int bin=1; bin<=fNbins; bin++)
+      hist->SetBinContent(bin, pos+1, row[bin]);
+  }
+
+  return hist;
+}
+//------------------------------------------------------------------
+/// Prints details of the SFSpectrumMatrix class object.
+void SFSpectrumMatrix::Print(void){
+  std::cout << "\n-------------------------------------------" << std::endl;
+  std::cout << "This is Print() for SFSpectrumMatrix class object" << std::endl;
+  std::cout << "Name: " << fName << std::endl;
+  std::cout << "Number of positions: " << fNpositions << std::endl;
+  std::cout << "Binning: " << fNbins << " bins, " << fXmin << " - " << fXmax << std::endl;
+  std::cout << "Positions [mm]: ";
+  for(int pos=0; pos<fNpositions; pos++)
+    std::cout << fPositions[pos] << "\t";
+  std::cout << "\n-------------------------------------------\n" << std::endl;
+}
+//------------------------------------------------------------------
@@ -14,11 +14,8 @@ ClassImp(SFStabilityMon);
 
 //------------------------------------------------------------------
 SFStabilityMon::SFStabilityMon(int seriesNo): fSeriesNo(seriesNo),
-                                              fData(nullptr),
-                                              fCh0Graph(nullptr),
-                                              fCh1Graph(nullptr),
-                                              fCh0ResGraph(nullptr),
-                                              fCh1ResGraph(nullptr) {
+                                              fNchannels(2),
+                                              fData(nullptr) {
   
   try{
     fData = new SFData(fSeriesNo);
@@ -36,8 +33,26 @@ SFStabilityMon::SFStabilityMon(int seriesNo): fSeriesNo(seriesNo),
     throw "##### Exception in SFStabilityMon constructor!";
   }
   
-  fSpecCh0 = fData->GetSpectra(0, SFSelectionType::PE, "ch_0.fPE>0 && ch_0.fT0>0");
-  fSpecCh1 = fData->GetSpectra(1, SFSelectionType::PE, "ch_1.fPE>0 && ch_1.fT0>0");
+  fNchannels = fData->GetNchannels();
+  fChGraph.resize(fNchannels, nullptr);
+  fChResGraph.resize(fNchannels, nullptr);
+  fSpecCh.resize(fNchannels);
+  fResults.fChMean.resize(fNchannels, -1);
+  fResults.fChStdDev.resize(fNchannels, -1);
+  
+  int npoints = fData->GetNpoints();
+  std::vector <int> measIDs = fData->GetMeasurementsIDs();
+  std::vector <TString> cuts(fNchannels);
+  std::vector <TH1D*> tmp;
+  
+  for(int ch=0; ch<fNchannels; ch++)
+    cuts[ch] = Form("ch_%i.fPE>0 && ch_%i.fT0>0", ch, ch);
+  
+  for(int i=0; i<npoints; i++){
+    tmp = fData->GetChannelSpectra(SFSelectionType::PE, cuts, measIDs[i]);
+    for(int ch=0; ch<fNchannels; ch++)
+      fSpecCh[ch].push_back(tmp[ch]);
+  }
                                                   
 }
 //------------------------------------------------------------------
@@ -58,16 +73,14 @@ bool SFStabilityMon::AnalyzeStability(int ch){
   PeakParams  peakParams;
   std::vector <double> peakPositions;
   
-  if(ch==0)
-    spec = fSpecCh0;
-  else if(ch==1)
-    spec = fSpecCh1;
-  else{
+  if(ch<0 || ch>=fNchannels){
     std::cerr << "##### Error in SFStabilityMon::AnalyzeStability()!" << std::endl;  
     std::cerr << "Incorrect channel number! Please check!" << std::endl;  
     return false;
   }
   
+  spec = fSpecCh[ch];
+  
   TGraphErrors *gPeakPos = new TGraphErrors(npoints);
   gPeakPos->SetName(Form("511PeakPosition_S%i_ch%i", fSeriesNo, ch));
   gPeakPos->SetTitle(Form("511PeakPosition_S%i_ch%i", fSeriesNo, ch));
@@ -82,9 +95,12 @@ bool SFStabilityMon::AnalyzeStability(int ch){
   gResiduals->GetYaxis()->SetTitle("residual [PE]");
   gResiduals->SetMarkerStyle(4);
   
-  for(int i=0; i<npoints; i++){
+  for(int i=0; i<npoints; i++)
     peakFin.push_back(new SFPeakFinder(spec[i], false));
-    peakFin[i]->FindPeakFit();
+  
+  SFPeakFinder::FindPeakFitsSeries(peakFin, fData->GetPositions());
+  
+  for(int i=0; i<npoints; i++){
     peakParams = peakFin[i]->GetParameters();
     gPeakPos->SetPoint(i, i, peakParams.fPosition);
     gPeakPos->SetPointError(i, 0, peakParams.fPositionErr);
@@ -109,18 +125,10 @@ bool SFStabilityMon::AnalyzeStability(int ch){
     gResiduals->SetPoint(i, i, res);
   }
   
-  if(ch==0){
-    fCh0Graph           = gPeakPos;
-    fCh0ResGraph        = gResiduals;
-    fResults.fCh0Mean   = mean;
-    fResults.fCh0StdDev = stdDev;
-  }
-  else if(ch==1){
-    fCh1Graph           = gPeakPos;
-    fCh1ResGraph        = gResiduals;
-    fResults.fCh1Mean   = mean;
-    fResults.fCh1StdDev = stdDev;
-  }
+  fChGraph[ch]             = gPeakPos;
+  fChResGraph[ch]          = gResiduals;
+  fResults.fChMean[ch]     = mean;
+  fResults.fChStdDev[ch]   = stdDev;
     
   return true;  
 }
@@ -129,16 +137,14 @@ TGraphErrors *SFStabilityMon::GetPeakPosGraph(int ch){
     
   TGraphErrors *g;
 
-  if(ch==0)
-    g = fCh0Graph;
-  else if(ch==1)
-    g = fCh1Graph;
-  else{
+  if(ch<0 || ch>=fNchannels){
     std::cerr << "##### Error in SFStabilityMon::GetPeakPosGraph()" << std::endl;  
     std::cerr << "Incorrect channel number! Please check!" << std::endl;  
     std::abort();
   }
   
+  g = fChGraph[ch];
+  
   if(g==nullptr){
     std::cerr << "##### Error in SFStabilityMon::GetPeakPosGraph()" << std::endl;  
     std::cerr << "Requested graph doesn't exist! Please check!" << std::endl;  
@@ -152,16 +158,14 @@ TGraphErrors *SFStabilityMon::GetResidualsGraph(int ch){
     
   TGraphErrors *g;
 
-  if(ch==0)
-    g = fCh0ResGraph;
-  else if(ch==1)
-    g = fCh1ResGraph;
-  else{
+  if(ch<0 || ch>=fNchannels){
     std::cerr << "##### Error in SFStabilityMon::GetResidualsGraph()" << std::endl;  
     std::cerr << "Incorrect channel number! Please check!" << std::endl;  
     std::abort();
   }
   
+  g = fChResGraph[ch];
+  
   if(g==nullptr){
     std::cerr << "##### Error in SFStabilityMon::GetResidualsGraph()" << std::endl;  
     std::cerr << "Requested graph doesn't exist! Please check!" << std::endl;  
@@ -175,16 +179,14 @@ std::vector <TH1D*> SFStabilityMon::GetSpectra(int ch){
     
   std::vector <TH1D*> tmp;
     
-  if(ch==0)
-    tmp = fSpecCh0;
-  else if(ch==1)
-    tmp = fSpecCh1;
-  else{
+  if(ch<0 || ch>=fNchannels){
     std::cerr << "##### Error in SFStabilityMon::GetSpectra()! " << std::endl;
     std::cerr << "Incorrect channel number! Please check!" << std::endl;  
     std::abort();
   }
   
+  tmp = fSpecCh[ch];
+  
   if(tmp.empty()){
     std::cerr << "##### Error in SFStabilityMon::GetSpectra()! " << std::endl;
     std::cerr << "Requested spectra don't exist!" << std::endl; 
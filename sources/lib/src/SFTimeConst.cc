@@ -18,7 +18,8 @@ ClassImp(SFTimeConst);
 SFTimeConst::SFTimeConst(): fSeriesNo(-1),
                             fData(nullptr),
                             fPE(-1),
-                            fVerb(false) {
+                            fVerb(false),
+                            fNchannels(2) {
                                 
   std::cout << "##### Warning in SFTimeConst constructor! You are using default constructor!" << std::endl;
   std::cout << "Set object attributes via SetDetails()" << std::endl;
@@ -30,7 +31,8 @@ SFTimeConst::SFTimeConst(): fSeriesNo(-1),
 /// \param verb - verbose level
 SFTimeConst::SFTimeConst(int seriesNo, double PE, bool verb): fSeriesNo(seriesNo),
                                                               fPE(PE),
-                                                              fVerb(verb) {
+                                                              fVerb(verb),
+                                                              fNchannels(2) {
                                                                   
   bool stat = SetDetails(seriesNo, PE, verb);
   if(stat==false){
@@ -47,7 +49,9 @@ SFTimeConst::~SFTimeConst(){
 //------------------------------------------------------------------
 /// Sets values to private members of the calss. Loads TProfile histograms
 /// of average signals for requested PE vlaue. Creates vectors of SFFitResults
-/// objects.
+/// objects. Signals of all channels are loaded in a single scan per measurement
+/// (see SFData::GetSignalAverages()). Signals of each channel are selected based
+/// on their own PE value.
 /// \param seriesNo - number of the series
 /// \param PE - PE value
 /// \param verb - verbose level
@@ -71,9 +75,12 @@ bool SFTimeConst::SetDetails(int seriesNo, double PE, bool verb){
   int     npoints = fData->GetNpoints();
   TString fiber   = fData->GetFiber();
   std::vector <int> measurementsIDs = fData->GetMeasurementsIDs();
-  TString selection = Form("ch_0.fPE>%.1f && ch_0.fPE<%.1f", fPE-0.5, fPE+0.5);
   TString results_name;
   
+  fNchannels = fData->GetNchannels();
+  fSignalsCh.resize(fNchannels);
+  fResults.fResultsCh.resize(fNchannels);
+  
   int nsig = 0;
   if(fiber.Contains("LuAG")) 
     nsig = 50;
@@ -86,21 +93,53 @@ bool SFTimeConst::SetDetails(int seriesNo, double PE, bool verb){
     return false;
   }
   
+  std::vector <SFSignalRequest> requests;
+  for(int ch=0; ch<fNchannels; ch++)
+    requests.push_back({ch, fPE-0.5, fPE+0.5, nsig});
+  
   for(int i=0; i<npoints; i++){
-   fSignalsCh0.push_back(fData->GetSignalAverage(0, measurementsIDs[i], selection, nsig, true));
-   results_name = fSignalsCh0[i]->GetName();
-   fResults.fResultsCh0.push_back(new SFFitResults(results_name));
-   
-   fSignalsCh1.push_back(fData->GetSignalAverage(1, measurementsIDs[i], selection, nsig, true));
-   results_name = fSignalsCh1[i]->GetName();
-   fResults.fResultsCh1.push_back(new SFFitResults(results_name));
+    std::vector <TProfile*> signals = fData->GetSignalAverages(requests, measurementsIDs[i], true);
+    for(int ch=0; ch<fNchannels; ch++){
+      fSignalsCh[ch].push_back(signals[ch]);
+      results_name = fSignalsCh[ch][i]->GetName();
+      fResults.fResultsCh[ch].push_back(new SFFitResults(results_name));
+    }
   }
   
-  ROOT::Math::MinimizerOptions::SetDefaultMaxFunctionCalls(100000);
-  
   return true;
 }
 //------------------------------------------------------------------
+/// Returns channel number of the signal histogram. It is taken from the
+/// metadata record attached by SFData::GetSignalAverage() or, if there is
+/// none, from the histogram name. If the name can't be interpreted 
+/// -1 is returned.
+/// \param signal - signal histogram
+int SFTimeConst::GetChannel(TProfile *signal){
+  
+  SFSpectrumInfo *info = SFSpectrumInfo::GetInfo(signal);
+  if(info!=nullptr && info->GetChannel()>=0 && info->GetChannel()<fNchannels)
+    return info->GetChannel();
+  
+  TString hname = signal->GetName();
+  int index = hname.Index("_ch");
+  if(index==kNPOS)
+    return -1;
+  
+  index += 3;
+  int length = 0;
+  while(index+length<hname.Length() && isdigit(hname[index+length]))
+    length++;
+  
+  if(length==0)
+    return -1;
+  
+  int ch = TString(hname(index, length)).Atoi();
+  if(ch>=fNchannels)
+    return -1;
+  
+  return ch;
+}
+//------------------------------------------------------------------
 /// Double decay function describing falling slope of the signal.
 double funDecayDouble(double *x, double *par){
  double fast_dec = par[0]*TMath::Exp(-(x[0]-par[1])/par[2]); 
@@ -115,19 +154,66 @@ double funDecaySingle(double *x, double *par){
  return dec + constant;
 }
 //------------------------------------------------------------------
-bool SFTimeConst::FitDecayTimeSingle(TProfile *signal, int ID){
-    
-  TString opt;
-  if(fVerb) opt = "R0";
-  else opt = "QR0";
+/// Fits single or double decay function to the signal and stores the
+/// results in the given SFFitResults object.
+/// Fits of different signals are independent: fitted functions have unique
+/// names and are not added to the global list of functions, no global
+/// fitting options are used. Therefore this function can be called for
+/// different signals in parallel. Returns fit status (see SFDecayFitter::Fit()).
+/// \param signal - averaged signal
+/// \param results - fit results (returned)
+/// \param doubleDecay - true for double decay function, false for single
+/// \param summary - if not nullptr, summary of the fit is returned here, to be
+/// printed in verbose mode (see SFDecayFitter::GetSummary())
+int SFTimeConst::FitSignal(TProfile *signal, SFFitResults *results, bool doubleDecay,
+                           TString *summary){
   
-  int ch = -1;
-  TString hname = signal->GetName();
-  if(hname.Contains("ch0"))      
-    ch = 0;
-  else if(hname.Contains("ch1")) 
-    ch = 1;
+  double xmin = signal->GetBinCenter(signal->GetMaximumBin())+20.;
+  double xmax = signal->GetBinCenter(signal->GetNbinsX());
+  double baseline = SFDecayFitter::GetBaseline(signal, 0, 50);
+  TString fname = TString("fall_") + signal->GetName();
+  
+  TF1 *fun_all;
+  
+  if(doubleDecay){
+    double tau_fast = SFDecayFitter::EstimateDecayTime(signal, xmin, xmin+130, baseline, 10.);
+    double tau_slow = SFDecayFitter::EstimateDecayTime(signal, 400, xmax, baseline, 400.);
+    
+    fun_all = new TF1(fname, funDecayDouble, xmin, xmax, 6, 1, TF1::EAddToList::kNo);
+    fun_all->SetParNames("A_fast", "t0", "tau_fast", "A_slow", "tau_slow", "const");
+    fun_all->SetParameter(0, 0);
+    fun_all->FixParameter(1, xmin-20);
+    fun_all->SetParameter(2, tau_fast);
+    fun_all->SetParameter(3, 0);
+    fun_all->SetParameter(4, tau_slow);
+    fun_all->FixParameter(5, baseline);
+  }
   else{
+    double tau = SFDecayFitter::EstimateDecayTime(signal, xmin, xmin+100, baseline, 10.);
+    
+    fun_all = new TF1(fname, funDecaySingle, xmin, xmax, 4, 1, TF1::EAddToList::kNo);
+    fun_all->SetParNames("A", "t0", "tau", "const");
+    fun_all->SetParameter(0, 0);
+    fun_all->FixParameter(1, xmin-20);
+    fun_all->SetParameter(2, tau);
+    fun_all->FixParameter(3, baseline);
+  }
+  
+  int fitStat = SFDecayFitter::FitSignal(signal, fun_all, summary);
+  
+  if(summary!=nullptr)
+    *summary = TString("Decay fit of ") + signal->GetName() + ":\n" + *summary;
+  
+  results->SetFromFunction(fun_all);
+  if(fitStat!=0) results->SetStat(-1);
+  
+  return fitStat;
+}
+//------------------------------------------------------------------
+bool SFTimeConst::FitDecayTimeSingle(TProfile *signal, int ID){
+  
+  int ch = GetChannel(signal);
+  if(ch==-1){
     std::cerr << "Error in SFTimeConst::FitDecayTimeSingle()!" << std::endl;
     std::cerr << "Could not interpret signal name!" << std::endl;
     return false;
@@ -135,41 +221,18 @@ bool SFTimeConst::FitDecayTimeSingle(TProfile *signal, int ID){
   
   std::vector <int> measurementsIDs = fData->GetMeasurementsIDs();
   int index = SFTools::GetIndex(measurementsIDs, ID);
-  double xmin = signal->GetBinCenter(signal->GetMaximumBin())+20.;
-  double xmax = signal->GetBinCenter(signal->GetNbinsX());
-  
-  TF1 *fun_BL = new TF1("fun_BL", "pol0", 0, 50);
-  signal->Fit(fun_BL, opt);
-  
-  TF1 *fun_dec = new TF1("fun_dec", "[0]*exp(-(x-[1])/[2])", xmin, xmin+100);
-  fun_dec->SetParameters(100., 100., 10.);
-  fun_dec->SetParNames("A", "t0", "tau");
-  signal->Fit(fun_dec, opt);
+  TString summary;
+  int fitStat = FitSignal(signal, fResults.fResultsCh[ch][index], false, &summary);
   
-  TF1 *fun_all = new TF1("fall", funDecaySingle, xmin, xmax, 4);
-  
-  fun_all->SetParNames("A", "t0", "tau", "const");
-  fun_all->SetParameter(0, fun_dec->GetParameter(0));
-  fun_all->SetParameter(1, fun_dec->GetParameter(1));
-  fun_all->SetParameter(2, fun_dec->GetParameter(2));
-  fun_all->FixParameter(3, fun_BL->GetParameter(0));
-  int fitStat = signal->Fit(fun_all, opt);
+  if(fVerb)
+    std::cout << summary;
     
   if(fitStat!=0){
     std::cerr << "##### Warning in SFTimeConst::FitDecayTimeSingle()" << std::endl;
     std::cerr << "\t fit status: " << fitStat << std::endl;
   }
   
-  if(ch==0){
-    fResults.fResultsCh0[index]->SetFromFunction(fun_all);
-    if(fitStat!=0) fResults.fResultsCh0[index]->SetStat(-1);
-    fResults.fResultsCh0[index]->Print();
-  }
-  else if(ch==1){
-    fResults.fResultsCh1[index]->SetFromFunction(fun_all);
-    if(fitStat!=0) fResults.fResultsCh1[index]->SetStat(-1);
-    fResults.fResultsCh1[index]->Print();
-  }
+  fResults.fResultsCh[ch][index]->Print();
   
   return true;
 }
@@ -181,17 +244,8 @@ bool SFTimeConst::FitDecayTimeSingle(TProfile *signal, int ID){
 /// fit results are valid.
 bool SFTimeConst::FitDecayTimeDouble(TProfile *signal, int ID){
   
-  TString opt;
-  if(fVerb) opt = "R0";
-  else opt = "QR0";
-   
-  int ch = -1;
-  TString hname = signal->GetName();
-  if(hname.Contains("ch0"))      
-    ch = 0;
-  else if(hname.Contains("ch1")) 
-    ch = 1;
-  else{
+  int ch = GetChannel(signal);
+  if(ch==-1){
     std::cerr << "##### Error in SFTimeConst::FitDecayTimeDouble()!" << std::endl;
     std::cerr << "Could not interpret signal name!" << std::endl;
     return false;
@@ -199,74 +253,79 @@ bool SFTimeConst::FitDecayTimeDouble(TProfile *signal, int ID){
   
   std::vector <int> measurementsIDs = fData->GetMeasurementsIDs();
   int index = SFTools::GetIndex(measurementsIDs, ID);
-  double xmin = signal->GetBinCenter(signal->GetMaximumBin())+20;
-  double xmax = signal->GetBinCenter(signal->GetNbinsX());
-
-  TF1 *fun_BL = new TF1("fun_BL", "pol0", 0, 50);
-  signal->Fit(fun_BL, opt);
+  TString summary;
+  int fitStat = FitSignal(signal, fResults.fResultsCh[ch][index], true, &summary);
   
-  TF1 *fun_fast = new TF1("fun_fast", "[0]*exp(-(x-[1])/[2])", xmin, xmin+130);
-  fun_fast->SetParameters(100., 100., 10.);
-  fun_fast->SetParNames("A", "t0", "tau");
-  signal->Fit(fun_fast, opt);
-
-  TF1 *fun_slow = new TF1("fun_slow", "[0]*exp(-(x-[1])/[2])", 400, xmax);
-  fun_slow->SetParameters(100., 100., 400.);
-  fun_slow->SetParNames("A", "t0", "tau");
-  fun_slow->FixParameter(1, fun_fast->GetParameter(1));
-  signal->Fit(fun_slow, opt);
-
-  TF1* fun_all = new TF1("fall", funDecayDouble, xmin, xmax, 6);
-
-  fun_all->SetParNames("A_fast", "t0", "tau_fast", "A_slow", "tau_slow", "const");
-  fun_all->SetParameter(0, fun_fast->GetParameter(0));
-  fun_all->FixParameter(1, fun_fast->GetParameter(1));
-  fun_all->SetParameter(2, fun_fast->GetParameter(2));
-  fun_all->SetParameter(3, fun_slow->GetParameter(0));
-  fun_all->SetParameter(4, fun_slow->GetParameter(2));
-  fun_all->FixParameter(5, fun_BL->GetParameter(0));
-  fun_all->FixParameter(1, xmin-20);
-  int fitStat = signal->Fit(fun_all, opt);
+  if(fVerb)
+    std::cout << summary;
   
   if(fitStat!=0){
     std::cerr << "##### Warning in SFTimeConst::FitDecayTimeDouble()" << std::endl;
     std::cerr << "\t fit status: " << fitStat << std::endl;
   }
   
-  if(ch==0){
-    fResults.fResultsCh0[index]->SetFromFunction(fun_all);
-    if(fitStat!=0) fResults.fResultsCh0[index]->SetStat(-1);
-    fResults.fResultsCh0[index]->Print();
-  }
-  else if(ch==1){
-    fResults.fResultsCh1[index]->SetFromFunction(fun_all);
-    if(fitStat!=0) fResults.fResultsCh1[index]->SetStat(-1);
-    fResults.fResultsCh1[index]->Print();
-  }
+  fResults.fResultsCh[ch][index]->Print();
   
   return true;
 }
 //------------------------------------------------------------------
-/// Fits all signals of the analyzed series from both channels.
+/// Fits all given signals in parallel (see SFTools::ParallelFor()). 
+/// Fit results are printed afterwards, in the order of channels and 
+/// measurements, so that the output does not depend on the number of 
+/// threads.
+/// \param channels - channels to be fitted
+/// \param doubleDecay - true for double decay function, false for single
+void SFTimeConst::FitSignals(std::vector <int> channels, bool doubleDecay){
+  
+  int n = fData->GetNpoints();
+  int nch = channels.size();
+  std::vector <int> fitStat(n*nch, 0);
+  std::vector <TString> summary(n*nch, "");
+  
+  SFTools::ParallelFor(n*nch, [&](int task){
+    int ch = channels[task%nch];
+    int i  = task/nch;
+    fitStat[task] = FitSignal(fSignalsCh[ch][i], fResults.fResultsCh[ch][i], doubleDecay,
+                              fVerb ? &summary[task] : nullptr);
+  });
+  
+  for(int task=0; task<n*nch; task++){
+    int ch = channels[task%nch];
+    int i  = task/nch;
+    if(fVerb)
+      std::cout << summary[task];
+    if(fitStat[task]!=0){
+      std::cerr << "##### Warning in SFTimeConst::FitSignals()" << std::endl;
+      std::cerr << "\t" << fSignalsCh[ch][i]->GetName() << " fit status: " << fitStat[task] << std::endl;
+    }
+    if(fResults.fResultsCh[ch][i]->GetStatMessage()!=""){
+      std::cout << "##### Warning in SFTimeConst::FitSignals()" << std::endl;
+      std::cout << "\t" << fSignalsCh[ch][i]->GetName() << ": " 
+                << fResults.fResultsCh[ch][i]->GetStatMessage() << std::endl;
+    }
+    fResults.fResultsCh[ch][i]->Print();
+  }
+  
+  return;
+}
+//------------------------------------------------------------------
+/// Fits all signals of the analyzed series from all channels.
 /// This function also calculates average time constants with their
 /// uncertainties.
 bool SFTimeConst::FitAllSignals(void){
  
   int n = fData->GetNpoints();
-  std::vector <int> measurementsIDs = fData->GetMeasurementsIDs();
   TString fiber = fData->GetFiber();
   
+  std::vector <int> channels;
+  for(int ch=0; ch<fNchannels; ch++)
+    channels.push_back(ch);
+  
   if(fiber.Contains("LuAG") || fiber.Contains("GAGG")){
-    for(int i=0; i<n; i++){
-     FitDecayTimeDouble(fSignalsCh0[i], measurementsIDs[i]);
-     FitDecayTimeDouble(fSignalsCh1[i], measurementsIDs[i]);
-    }
+    FitSignals(channels, true);
   }
   else if(fiber.Contains("LYSO")){
-    for(int i=0; i<n; i++){
-     FitDecayTimeSingle(fSignalsCh0[i], measurementsIDs[i]);
-     FitDecayTimeSingle(fSignalsCh1[i], measurementsIDs[i]);
-    } 
+    FitSignals(channels, false);
   }
   else{
     std::cerr << "##### Error in SFTimeConst::FitAllSignals()!" << std::endl;
@@ -276,7 +335,7 @@ bool SFTimeConst::FitAllSignals(void){
   
   //----- Calculating average time constants
   //----- and intensities
-  double statCh0, statCh1;
+  double stat;
   int counter = 0;
   
   //----- double decay 
@@ -297,43 +356,26 @@ bool SFTimeConst::FitAllSignals(void){
   if(fiber.Contains("LuAG") || fiber.Contains("GAGG")){
   
     for(int i=0; i<n; i++){
-      statCh0 = fResults.fResultsCh0[i]->GetStat();
-      statCh1 = fResults.fResultsCh1[i]->GetStat();
-    
-      if(statCh0==0){
-        fResults.fResultsCh0[i]->GetFastDecTime(fastDec, fastDecErr);
-        fResults.fResultsCh0[i]->GetSlowDecTime(slowDec, slowDecErr);
-        fastDecSum += fastDec*(1./pow(fastDecErr,2));
-        slowDecSum += slowDec*(1./pow(slowDecErr,2));
-        fastDecSumErr += 1./pow(fastDecErr,2);
-        slowDecSumErr += 1./pow(slowDecErr,2);
-      
-        fResults.fResultsCh0[i]->GetAmpFast(fastAmp, fastAmpErr);
-        fResults.fResultsCh0[i]->GetAmpSlow(slowAmp, slowAmpErr);
-        fastAmpSum += fastAmp*(1./pow(fastAmpErr,2));
-        slowAmpSum += slowAmp*(1./pow(slowAmpErr,2));
-        fastAmpSumErr += 1./pow(fastAmpErr,2);
-        slowAmpSumErr += 1./pow(slowAmpErr,2);
-      
-        counter++;
-      }
-    
-      if(statCh1==0){
-        fResults.fResultsCh1[i]->GetFastDecTime(fastDec,fastDecErr);
-        fResults.fResultsCh1[i]->GetSlowDecTime(slowDec,slowDecErr);
-        fastDecSum += fastDec*(1./pow(fastDecErr,2));
-        slowDecSum += slowDec*(1./pow(slowDecErr,2));
-        fastDecSumErr += 1./pow(fastDecErr,2);
-        slowDecSumErr += 1./pow(slowDecErr,2);
+      for(int ch=0; ch<fNchannels; ch++){
+        stat = fResults.fResultsCh[ch][i]->GetStat();
+        
+        if(stat==0){
+          fResults.fResultsCh[ch][i]->GetFastDecTime(fastDec, fastDecErr);
+          fResults.fResultsCh[ch][i]->GetSlowDecTime(slowDec, slowDecErr);
+          fastDecSum += fastDec*(1./pow(fastDecErr,2));
+          slowDecSum += slowDec*(1./pow(slowDecErr,2));
+          fastDecSumErr += 1./pow(fastDecErr,2);
+          slowDecSumErr += 1./pow(slowDecErr,2);
+        
+          fResults.fResultsCh[ch][i]->GetAmpFast(fastAmp, fastAmpErr);
+          fResults.fResultsCh[ch][i]->GetAmpSlow(slowAmp, slowAmpErr);
+          fastAmpSum += fastAmp*(1./pow(fastAmpErr,2));
+          slowAmpSum += slowAmp*(1./pow(slowAmpErr,2));
+          fastAmpSumErr += 1./pow(fastAmpErr,2);
+          slowAmpSumErr += 1./pow(slowAmpErr,2);
         
-        fResults.fResultsCh1[i]->GetAmpFast(fastAmp,fastAmpErr);
-        fResults.fResultsCh1[i]->GetAmpSlow(slowAmp,slowAmpErr);
-        fastAmpSum += fastAmp*(1./pow(fastAmpErr,2));
-        slowAmpSum += slowAmp*(1./pow(slowAmpErr,2));
-        fastAmpSumErr += 1./pow(fastAmpErr,2);
-        slowAmpSumErr += 1./pow(slowAmpErr,2);
-      
-        counter++;
+          counter++;
+        }
       }
     }
   
@@ -369,21 +411,15 @@ bool SFTimeConst::FitAllSignals(void){
   if(fiber.Contains("LYSO")){
     
     for(int i=0; i<n; i++){
-      statCh0 = fResults.fResultsCh0[i]->GetStat();
-      statCh1 = fResults.fResultsCh1[i]->GetStat();
-      
-      if(statCh0==0){
-        fResults.fResultsCh0[i]->GetDecTime(dec, decErr);
-        decSum += dec*(1./pow(decErr,2));
-        decSumErr += 1./pow(decErr,2);
-        counter++;
-      }
-      
-      if(statCh1==0){
-        fResults.fResultsCh1[i]->GetDecTime(dec, decErr);
-        decSum += dec*(1./pow(decErr,2));
-        decSumErr += 1./pow(decErr,2);
-        counter++;
+      for(int ch=0; ch<fNchannels; ch++){
+        stat = fResults.fResultsCh[ch][i]->GetStat();
+        
+        if(stat==0){
+          fResults.fResultsCh[ch][i]->GetDecTime(dec, decErr);
+          decSum += dec*(1./pow(decErr,2));
+          decSumErr += 1./pow(decErr,2);
+          counter++;
+        }
       }
     }
     
@@ -409,31 +445,19 @@ bool SFTimeConst::FitAllSignals(void){
 /// \param ch - channel number.
 bool SFTimeConst::FitAllSignals(int ch){
  
-  int n = fData->GetNpoints();
-  std::vector <int> measurementsIDs = fData->GetMeasurementsIDs();
   TString fiber = fData->GetFiber();
   
-  if(ch!=0 || ch!=1){
+  if(ch<0 || ch>=fNchannels){
     std::cerr << "##### Error in SFTimeConst::FitAllSignals()!" << std::endl;
-    std::cerr << "Incorrect channel number. Possible options: 0 or 1" << std::endl;
+    std::cerr << "Incorrect channel number. Possible options: 0 - " << fNchannels-1 << std::endl;
     return false;
   }
   
   if(fiber.Contains("LuAG") || fiber.Contains("GAGG")){
-    for(int i=0; i<n; i++){
-     if(ch==0)       
-       FitDecayTimeDouble(fSignalsCh0[i], measurementsIDs[i]);
-     else if(ch==1) 
-       FitDecayTimeDouble(fSignalsCh1[i], measurementsIDs[i]);
-    }
+    FitSignals({ch}, true);
   }
   else if(fiber.Contains("LYSO")){
-    for(int i=0; i<n; i++){
-     if(ch==0)       
-       FitDecayTimeSingle(fSignalsCh0[i], measurementsIDs[i]);
-     else if(ch==1) 
-       FitDecayTimeSingle(fSignalsCh1[i], measurementsIDs[i]);
-    } 
+    FitSignals({ch}, false);
   }
   else{
     std::cerr << "##### Error in SFTimeConst::FitAllSignal()!" << std::endl;
@@ -449,22 +473,230 @@ bool SFTimeConst::FitAllSignals(int ch){
 ///\param ch - channel number
 std::vector <TProfile*> SFTimeConst::GetSignals(int ch){
     
-  if((ch==0 && fSignalsCh0.empty()) || 
-     (ch==1 && fSignalsCh1.empty())){
+  if(ch<0 || ch>=fNchannels || fSignalsCh[ch].empty()){
     std::cerr << "##### Error in SFTimeConst::GetSignals()!" << std::endl;
     std::cerr << "No signals available!" << std::endl;
     std::abort();
   }
   
-  if(ch==0)      
-    return fSignalsCh0;
-  else if(ch==1) 
-    return fSignalsCh1;
+  return fSignalsCh[ch];
+}
+//------------------------------------------------------------------
+/// Scans dependence of the decay constants on the signal size. For every 
+/// measurement signals of all channels are averaged in nbins PE bins in a 
+/// single pass (see SFData::GetSignalAverages()), then all averaged signals
+/// with at least gMinScanSignals signals are fitted in parallel, like in 
+/// FitAllSignals(). Results are available via GetScanGraph() and GetScanMap().
+/// \param PEmin - lower edge of the scanned PE range
+/// \param PEmax - upper edge of the scanned PE range
+/// \param nbins - number of PE bins
+/// \param number - maximum number of averaged signals per bin
+bool SFTimeConst::ScanPE(double PEmin, double PEmax, int nbins, int number){
+  
+  if(nbins<1 || PEmin>=PEmax || number<1){
+    std::cerr << "##### Error in SFTimeConst::ScanPE()!" << std::endl;
+    std::cerr << "Incorrect PE range, number of bins or number of signals!" << std::endl;
+    return false;
+  }
+  
+  TString fiber = fData->GetFiber();
+  bool doubleDecay;
+  
+  if(fiber.Contains("LuAG") || fiber.Contains("GAGG"))
+    doubleDecay = true;
+  else if(fiber.Contains("LYSO"))
+    doubleDecay = false;
   else{
-    std::cerr << "##### Error in SFTimeConst::GetSignals()!" << std::endl;
-    std::cerr << "No signals available!" << std::endl;
+    std::cerr << "##### Error in SFTimeConst::ScanPE()!" << std::endl;
+    std::cerr << "Unknown fiber material!" << std::endl;
+    return false;
+  }
+  
+  const int gMinScanSignals = 5;
+  int npoints = fData->GetNpoints();
+  std::vector <int> measurementsIDs = fData->GetMeasurementsIDs();
+  
+  fScanEdges.resize(nbins+1);
+  for(int b=0; b<=nbins; b++)
+    fScanEdges[b] = PEmin + b*(PEmax-PEmin)/nbins;
+  
+  std::vector <SFSignalRequest> requests;
+  for(int ch=0; ch<fNchannels; ch++){
+    for(int b=0; b<nbins; b++)
+      requests.push_back({ch, fScanEdges[b], fScanEdges[b+1], number});
+  }
+  
+  //----- averaging, single pass per measurement
+  std::vector <TProfile*> signals;
+  std::vector <SFFitResults*> results;
+  
+  fScanResultsCh.assign(fNchannels, std::vector <std::vector <SFFitResults*>> 
+                        (npoints, std::vector <SFFitResults*>(nbins, nullptr)));
+  
+  for(int i=0; i<npoints; i++){
+    std::vector <TProfile*> profiles = fData->GetSignalAverages(requests, measurementsIDs[i], true);
+    for(size_t r=0; r<requests.size(); r++){
+      int ch = requests[r].fChannel;
+      int b  = r%nbins;
+      fScanResultsCh[ch][i][b] = new SFFitResults(profiles[r]->GetName());
+      fScanResultsCh[ch][i][b]->SetStat(-1);
+      int nsig = profiles[r]->GetEntries()/profiles[r]->GetNbinsX();
+      if(nsig<gMinScanSignals) continue;
+      signals.push_back(profiles[r]);
+      results.push_back(fScanResultsCh[ch][i][b]);
+    }
+  }
+  
+  //----- fitting in parallel
+  int nfits = signals.size();
+  std::vector <int> fitStat(nfits, 0);
+  std::vector <TString> summary(nfits, "");
+  
+  SFTools::ParallelFor(nfits, [&](int task){
+    fitStat[task] = FitSignal(signals[task], results[task], doubleDecay,
+                              fVerb ? &summary[task] : nullptr);
+  });
+  
+  int nvalid = 0;
+  for(int task=0; task<nfits; task++){
+    if(fVerb)
+      std::cout << summary[task];
+    if(results[task]->GetStat()==0) nvalid++;
+    if(results[task]->GetStatMessage()!=""){
+      std::cout << "##### Warning in SFTimeConst::ScanPE()" << std::endl;
+      std::cout << "\t" << signals[task]->GetName() << ": " 
+                << results[task]->GetStatMessage() << std::endl;
+    }
+  }
+  
+  std::cout << "\n\n----------------------------------" << std::endl;
+  std::cout << "PE scan of decay constants: " << nbins << " bins, " 
+            << PEmin << " - " << PEmax << " PE" << std::endl;
+  std::cout << "Fitted signals: " << nfits << " out of " << requests.size()*npoints << std::endl;
+  std::cout << "Valid fits: " << nvalid << std::endl;
+  std::cout << "----------------------------------" << std::endl;
+  
+  return true;
+}
+//------------------------------------------------------------------
+/// Returns decay constant of the valid fit from the PE scan. For single
+/// decay only the fast constant is available.
+/// \param results - fit results
+/// \param fast - true for fast, false for slow decay constant
+/// \param tau - decay constant (returned)
+/// \param err - uncertainty (returned)
+bool SFTimeConst::GetScanValue(SFFitResults *results, bool fast, double &tau, double &err){
+  
+  if(results==nullptr || results->GetStat()!=0)
+    return false;
+  
+  if(results->GetNcomponents()==1){
+    if(!fast) return false;
+    return results->GetDecTime(tau, err);
+  }
+  
+  if(fast)
+    return results->GetFastDecTime(tau, err);
+  else
+    return results->GetSlowDecTime(tau, err);
+}
+//------------------------------------------------------------------
+/// Returns graph of the decay constant vs. PE from the PE scan (see ScanPE()). 
+/// In every PE bin weighted average over all source positions is taken.
+/// \param ch - channel number
+/// \param fast - true for fast, false for slow decay constant
+TGraphErrors* SFTimeConst::GetScanGraph(int ch, bool fast){
+  
+  if(ch<0 || ch>=fNchannels || fScanResultsCh.empty()){
+    std::cerr << "##### Error in SFTimeConst::GetScanGraph()!" << std::endl;
+    std::cerr << "Incorrect channel number or no PE scan performed!" << std::endl;
     std::abort();
   }
+  
+  int npoints = fData->GetNpoints();
+  int nbins = fScanEdges.size()-1;
+  double tau, err;
+  
+  TGraphErrors *graph = new TGraphErrors();
+  graph->SetName(Form("S%i_ch%i_%s_vs_PE", fSeriesNo, ch, fast ? "tau_fast" : "tau_slow"));
+  graph->SetTitle(Form("%s decay constant vs. PE, channel %i;PE;decay constant [ns]", 
+                       fast ? "Fast" : "Slow", ch));
+  graph->SetMarkerStyle(4);
+  
+  int ipoint = 0;
+  
+  for(int b=0; b<nbins; b++){
+    double sum = 0;
+    double sumW = 0;
+    for(int i=0; i<npoints; i++){
+      if(!GetScanValue(fScanResultsCh[ch][i][b], fast, tau, err) || err<=0) continue;
+      sum  += tau/(err*err);
+      sumW += 1./(err*err);
+    }
+    if(sumW==0) continue;
+    graph->SetPoint(ipoint, (fScanEdges[b]+fScanEdges[b+1])/2., sum/sumW);
+    graph->SetPointError(ipoint, (fScanEdges[b+1]-fScanEdges[b])/2., sqrt(1./sumW));
+    ipoint++;
+  }
+  
+  return graph;
+}
+//------------------------------------------------------------------
+/// Returns map of the decay constant vs. source position and PE from the 
+/// PE scan (see ScanPE()). Bins without valid fit are left empty.
+/// \param ch - channel number
+/// \param fast - true for fast, false for slow decay constant
+TH2D* SFTimeConst::GetScanMap(int ch, bool fast){
+  
+  if(ch<0 || ch>=fNchannels || fScanResultsCh.empty()){
+    std::cerr << "##### Error in SFTimeConst::GetScanMap()!" << std::endl;
+    std::cerr << "Incorrect channel number or no PE scan performed!" << std::endl;
+    std::abort();
+  }
+  
+  int npoints = fData->GetNpoints();
+  int nbins = fScanEdges.size()-1;
+  std::vector <double> positions = fData->GetPositions();
+  
+  //----- position bins centered at source positions
+  std::vector <double> sorted = positions;
+  std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+  
+  int npos = sorted.size();
+  std::vector <double> posEdges(npos+1);
+  
+  if(npos==1){
+    posEdges[0] = sorted[0]-1;
+    posEdges[1] = sorted[0]+1;
+  }
+  else{
+    for(int i=1; i<npos; i++)
+      posEdges[i] = (sorted[i-1]+sorted[i])/2.;
+    posEdges[0]    = sorted[0] - (posEdges[1]-sorted[0]);
+    posEdges[npos] = sorted[npos-1] + (sorted[npos-1]-posEdges[npos-1]);
+  }
+  
+  TString hname = Form("S%i_ch%i_%s_map", fSeriesNo, ch, fast ? "tau_fast" : "tau_slow");
+  TH2D *map = new TH2D(hname, hname, npos, posEdges.data(), nbins, fScanEdges.data());
+  map->SetDirectory(nullptr);
+  map->GetXaxis()->SetTitle("source position [mm]");
+  map->GetYaxis()->SetTitle("PE");
+  map->GetZaxis()->SetTitle("decay constant [ns]");
+  map->SetStats(false);
+  
+  double tau, err;
+  
+  for(int i=0; i<npoints; i++){
+    int binX = map->GetXaxis()->FindBin(positions[i]);
+    for(int b=0; b<nbins; b++){
+      if(!GetScanValue(fScanResultsCh[ch][i][b], fast, tau, err)) continue;
+      map->SetBinContent(binX, b+1, tau);
+      map->SetBinError(binX, b+1, err);
+    }
+  }
+  
+  return map;
 }
 //------------------------------------------------------------------
 /// Prints details of the SFTimeConst class ojbect.
@@ -48,34 +48,52 @@ bool SFTimingRes::LoadRatios(void){
   TString cut = "ch_0.fT0>0 && ch_0.fT0<590 && ch_0.fPE>0 && ch_1.fT0>0 && ch_1.fT0<590 && ch_1.fPE>0"; 
   fRatios = fData->GetCustomHistograms(SFSelectionType::LogSqrtPERatio, cut);
   
+  //----- peak seeds of all positions from the series matrix of ratios
+  SFSpectrumMatrix *ratios = SFSpectrumMatrix::FromSpectra(Form("ratios_S%i", fSeriesNo),
+                                                           fRatios, fData->GetPositions());
+  if(ratios==nullptr){
+    std::cerr << "##### Error in SFTimingRes::LoadRatios()!" << std::endl;
+    std::cerr << "Ratio histograms couldn't be collected!" << std::endl;
+    return false;
+  }
+  
+  std::vector <int>    maxBins = ratios->GetMaximumBins(ratios->GetXmin(), ratios->GetXmax());
+  std::vector <double> maxima  = ratios->GetMaxima(ratios->GetXmin(), ratios->GetXmax());
+  std::vector <double> centers(npoints);
+  
+  for(int i=0; i<npoints; i++)
+    centers[i] = ratios->GetBinCenter(maxBins[i]);
+  
+  delete ratios;
+  
   std::vector <TF1*> fun;
   double min, max;
   
   for(int i=0; i<npoints; i++){
     if(collimator.Contains("Lead")){
       fun.push_back(new TF1("fun", "gaus(0)+gaus(3)", -1, 1));
-      fun[i]->SetParameter(0, fRatios[i]->GetBinContent(fRatios[i]->GetMaximumBin()));   //thin gauss
-      fun[i]->SetParameter(1, fRatios[i]->GetBinCenter(fRatios[i]->GetMaximumBin()));
+      fun[i]->SetParameter(0, maxima[i]);   //thin gauss
+      fun[i]->SetParameter(1, centers[i]);
       fun[i]->SetParameter(2, 6E-2);
-      fun[i]->SetParameter(3, 0.5*fRatios[i]->GetBinContent(fRatios[i]->GetMaximumBin()));   //thick gauss
+      fun[i]->SetParameter(3, 0.5*maxima[i]);   //thick gauss
       if(i<npoints/2)
-        fun[i]->SetParameter(4, fRatios[i]->GetBinCenter(fRatios[i]->GetMaximumBin())+0.2);
+        fun[i]->SetParameter(4, centers[i]+0.2);
       else
-	fun[i]->SetParameter(4, fRatios[i]->GetBinCenter(fRatios[i]->GetMaximumBin())-0.2);
+	fun[i]->SetParameter(4, centers[i]-0.2);
       fun[i]->SetParameter(5, 2E-1);
-      fRatios[i]->Fit(fun[i], "QR");
+      SFTools::FitHistogram(fRatios[i], fun[i], "QR");
     }
     else if(collimator.Contains("Electronic") && sipm.Contains("SensL")){
       min = fRatios[i]->GetMean()-2*fRatios[i]->GetRMS();
       max = fRatios[i]->GetMean()+2*fRatios[i]->GetRMS();
       fun.push_back(new TF1("fun", "gaus(0)+gaus(3)", min, max)); 
-      fun[i]->SetParameter(0, fRatios[i]->GetBinContent(fRatios[i]->GetMaximumBin()));
-      fun[i]->SetParameter(1, fRatios[i]->GetBinCenter(fRatios[i]->GetMaximumBin()));
+      fun[i]->SetParameter(0, maxima[i]);
+      fun[i]->SetParameter(1, centers[i]);
       fun[i]->SetParameter(2, 6E-2);
-      fun[i]->SetParameter(3, fRatios[i]->GetBinContent(fRatios[i]->GetMaximumBin())/10.);
-      fun[i]->SetParameter(4, fRatios[i]->GetBinCenter(fRatios[i]->GetMaximumBin()));
+      fun[i]->SetParameter(3, maxima[i]/10.);
+      fun[i]->SetParameter(4, centers[i]);
       fun[i]->SetParameter(5, 6E-1);
-      fRatios[i]->Fit(fun[i], "QR");
+      SFTools::FitHistogram(fRatios[i], fun[i], "QR");
     }
     else if(collimator.Contains("Electronic") && sipm.Contains("Hamamatsu")){
 //       min = fRatios[i]->GetMean()-2*fRatios[i]->GetRMS();
@@ -84,24 +102,24 @@ bool SFTimingRes::LoadRatios(void){
       min = fRatios[i]->GetMean()-1*fRatios[i]->GetRMS();
       max = fRatios[i]->GetMean()+1*fRatios[i]->GetRMS();
       /*fun.push_back(new TF1("fun", "gaus(0)+gaus(3)", min, max));
-      fun[i]->SetParameter(0, fRatios[i]->GetBinContent(fRatios[i]->GetMaximumBin()));
+      fun[i]->SetParameter(0, maxima[i]);
       fun[i]->SetParLimits(0, 0, 1E6);
-      fun[i]->SetParameter(1, fRatios[i]->GetBinCenter(fRatios[i]->GetMaximumBin()));
+      fun[i]->SetParameter(1, centers[i]);
       fun[i]->SetParameter(2, 5E-2);
       fun[i]->SetParLimits(2, 0, 50);
-      fun[i]->SetParameter(3, fRatios[i]->GetBinContent(fRatios[i]->GetMaximumBin())/20.);
+      fun[i]->SetParameter(3, maxima[i]/20.);
       fun[i]->SetParLimits(3, 0, 1E6);
-      fun[i]->SetParameter(4, fRatios[i]->GetBinCenter(fRatios[i]->GetMaximumBin()));
+      fun[i]->SetParameter(4, centers[i]);
       fun[i]->SetParameter(5, 1E-1);
       fun[i]->SetParLimits(5, 0, 50);*/
       fun.push_back(new TF1("fun", "gaus", min, max));
-      fun[i]->SetParameter(0, fRatios[i]->GetBinContent(fRatios[i]->GetMaximumBin()));
+      fun[i]->SetParameter(0, maxima[i]);
       fun[i]->SetParLimits(0, 0, 1E6);
-      fun[i]->SetParameter(1, fRatios[i]->GetBinCenter(fRatios[i]->GetMaximumBin()));
+      fun[i]->SetParameter(1, centers[i]);
       fun[i]->SetParameter(2, 5E-2);
       fun[i]->SetParLimits(2, 0, 50);
       
-      fRatios[i]->Fit(fun[i], "QR");
+      SFTools::FitHistogram(fRatios[i], fun[i], "QR");
     }
   }
 
@@ -168,7 +186,7 @@ bool SFTimingRes::AnalyzeNoECut(void){
       sigma = fRatios[i]->GetFunction("fun")->GetParameter(parNum+1);
     
       //cut = Form("ch_0.fT0>0 && ch_1.fT0>0 && ch_0.fT0<590 && ch_1.fT0<590 && ch_0.fPE>0 && ch_1.fPE>0 && log(sqrt(ch_1.fPE/ch_0.fPE))>%f && log(sqrt(ch_1.fPE/ch_0.fPE))<%f", mean-0.5*sigma, mean+0.5*sigma);
-      cut = Form("ch_0.fT0>0 && ch_1.fT0>0 && ch_0.fT0<590 && ch_1.fT0<590 && ch_0.fPE>15 && ch_1.fPE>15 && log(sqrt(ch_1.fPE/ch_0.fPE))>%f && log(sqrt(ch_1.fPE/ch_0.fPE))<%f", mean-0.5*sigma, mean+0.5*sigma);
+      cut = Form("ch_0.fT0>0 && ch_1.fT0>0 && ch_0.fT0<590 && ch_1.fT0<590 && ch_0.fPE>15 && ch_1.fPE>15 && fLnMLR[0]>%f && fLnMLR[0]<%f", mean-0.5*sigma, mean+0.5*sigma);
       fT0Diff.push_back(fData->GetCustomHistogram(SFSelectionType::T0Difference, cut, measIDs[i]));
     
       fun.push_back(new TF1("fun", "gaus(0)+gaus(3)", -100, 100));
@@ -181,7 +199,7 @@ bool SFTimingRes::AnalyzeNoECut(void){
       else
         fun[i]->SetParameter(4,fT0Diff[i]->GetMean()+5);
       fun[i]->SetParameter(5,fT0Diff[i]->GetRMS()*2);
-      fT0Diff[i]->Fit(fun[i],"QR");
+      SFTools::FitHistogram(fT0Diff[i], fun[i], "QR");
     }
     else if(collimator.Contains("Electronic") && sipm.Contains("SensL")){
       
@@ -195,9 +213,9 @@ bool SFTimingRes::AnalyzeNoECut(void){
       sigma = fRatios[i]->GetFunction("fun")->GetParameter(parNum+1);
       
       //cut = Form("ch_0.fT0>0 && ch_1.fT0>0 && ch_0.fT0<590 && ch_1.fT0<590 && ch_0.fPE>0 && ch_1.fPE>0 && log(sqrt(ch_1.fPE/ch_0.fPE))>%f && log(sqrt(ch_1.fPE/ch_0.fPE))<%f", mean-2*sigma,  mean+2*sigma);
-      cut = Form("ch_0.fT0>0 && ch_1.fT0>0 && ch_0.fT0<590 && ch_1.fT0<590 && ch_0.fPE>20 && ch_1.fPE>20 && log(sqrt(ch_1.fPE/ch_0.fPE))>%f && log(sqrt(ch_1.fPE/ch_0.fPE))<%f", mean-2*sigma,  mean+2*sigma);
+      cut = Form("ch_0.fT0>0 && ch_1.fT0>0 && ch_0.fT0<590 && ch_1.fT0<590 && ch_0.fPE>20 && ch_1.fPE>20 && fLnMLR[0]>%f && fLnMLR[0]<%f", mean-2*sigma,  mean+2*sigma);
       fT0Diff.push_back(fData->GetCustomHistogram(SFSelectionType::T0Difference, cut, measIDs[i]));
-      fT0Diff.back()->Rebin(2);
+      fT0Diff.back() = SFHistPyramid::GetPyramid(fT0Diff.back())->GetLevel(1);
       fun.push_back(new TF1("fun", "gaus(0)+gaus(3)", -30, 30));
       
       fun[i]->SetParameter(0, fT0Diff[i]->GetBinContent(fT0Diff[i]->GetMaximumBin()));
@@ -208,15 +226,15 @@ bool SFTimingRes::AnalyzeNoECut(void){
       fun[i]->SetParameter(4, fT0Diff[i]->GetMean());
       fun[i]->SetParameter(5, fT0Diff[i]->GetRMS()*10);
       fun[i]->SetParLimits(5, 0, 20);
-      fT0Diff[i]->Fit(fun[i], "R");
+      SFTools::FitHistogram(fT0Diff[i], fun[i], "R");
     }
     else if(collimator.Contains("Electronic") && sipm.Contains("Hamamatsu")){
     
       mean = fRatios[i]->GetFunction("fun")->GetParameter(1);
       sigma = fRatios[i]->GetFunction("fun")->GetParameter(2);
-      cut = Form("ch_0.fT0>0 && ch_1.fT0>0 && ch_0.fT0<590 && ch_1.fT0<590 && ch_0.fPE>0 && ch_1.fPE>0 && log(sqrt(ch_1.fPE/ch_0.fPE))>%f && log(sqrt(ch_1.fPE/ch_0.fPE))<%f", mean-3*sigma,  mean+3*sigma);
+      cut = Form("ch_0.fT0>0 && ch_1.fT0>0 && ch_0.fT0<590 && ch_1.fT0<590 && ch_0.fPE>0 && ch_1.fPE>0 && fLnMLR[0]>%f && fLnMLR[0]<%f", mean-3*sigma,  mean+3*sigma);
       fT0Diff.push_back(fData->GetCustomHistogram(SFSelectionType::T0Difference, cut, measIDs[i]));
-      fT0Diff.back()->Rebin(2);
+      fT0Diff.back() = SFHistPyramid::GetPyramid(fT0Diff.back())->GetLevel(1);
       
       fun.push_back(new TF1("fun", "gaus(0)+gaus(3)", -50, 50));
       fun[i]->SetParameter(0, fT0Diff[i]->GetBinContent(fT0Diff[i]->GetMaximumBin()));
@@ -246,7 +264,7 @@ bool SFTimingRes::AnalyzeNoECut(void){
         fun[i]->SetParameter(5, fT0Diff[i]->GetRMS()*2);
         fun[i]->SetParLimits(5, 0, 50);
       }
-      fT0Diff[i]->Fit(fun[i], "QR");
+      SFTools::FitHistogram(fT0Diff[i], fun[i], "QR");
     }
 
     parNum=0;
@@ -298,8 +316,9 @@ bool SFTimingRes::AnalyzeWithECut(void){
   
   if(fRatios.empty()) LoadRatios();
   
-  fSpecCh0 = fData->GetSpectra(0, SFSelectionType::PE, "ch_0.fT0>0 && ch_0.fT0<590 && ch_0.fPE>0");
-  fSpecCh1 = fData->GetSpectra(1, SFSelectionType::PE, "ch_1.fT0>0 && ch_1.fT0<590 && ch_1.fPE>0");
+  fSpecCh.resize(2);
+  fSpecCh[0] = fData->GetSpectra(0, SFSelectionType::PE, "ch_0.fT0>0 && ch_0.fT0<590 && ch_0.fPE>0");
+  fSpecCh[1] = fData->GetSpectra(1, SFSelectionType::PE, "ch_1.fT0>0 && ch_1.fT0<590 && ch_1.fPE>0");
   std::vector <SFPeakFinder*> peakFin_ch0;
   std::vector <SFPeakFinder*> peakFin_ch1;
   TF1* fun = new TF1("fun", "gaus", -200, 200);
@@ -325,8 +344,8 @@ bool SFTimingRes::AnalyzeWithECut(void){
   graph->SetMarkerStyle(4);
   
   for(int i=0; i<npoints; i++){
-    peakFin_ch0.push_back(new SFPeakFinder(fSpecCh0[i],false));
-    peakFin_ch1.push_back(new SFPeakFinder(fSpecCh1[i],false));
+    peakFin_ch0.push_back(new SFPeakFinder(fSpecCh[0][i],false));
+    peakFin_ch1.push_back(new SFPeakFinder(fSpecCh[1][i],false));
     peakFin_ch0[i]->FindPeakRange(xmin_ch0, xmax_ch0);
     peakFin_ch1[i]->FindPeakRange(xmin_ch1, xmax_ch1);
     
@@ -338,16 +357,16 @@ bool SFTimingRes::AnalyzeWithECut(void){
     sigma_ratio = fRatios[i]->GetFunction("fun")->GetParameter(2);
     
     if(collimator.Contains("Lead"))
-      cut = Form("ch_0.fT0>0 && ch_1.fT0>0 && ch_0.fT0<590 && ch_1.fT0<590 && ch_0.fPE>%f && ch_0.fPE<%f && ch_1.fPE>%f && ch_1.fPE<%f && log(sqrt(ch_1.fPE/ch_0.fPE))>%f && log(sqrt(ch_1.fPE/ch_0.fPE))<%f", center_ch0-delta_ch0, center_ch0+delta_ch0, center_ch1-delta_ch1, center_ch1+delta_ch1, mean_ratio-0.5*sigma_ratio, mean_ratio+0.5*sigma_ratio);   //changed here for smaller cut
+      cut = Form("ch_0.fT0>0 && ch_1.fT0>0 && ch_0.fT0<590 && ch_1.fT0<590 && ch_0.fPE>%f && ch_0.fPE<%f && ch_1.fPE>%f && ch_1.fPE<%f && fLnMLR[0]>%f && fLnMLR[0]<%f", center_ch0-delta_ch0, center_ch0+delta_ch0, center_ch1-delta_ch1, center_ch1+delta_ch1, mean_ratio-0.5*sigma_ratio, mean_ratio+0.5*sigma_ratio);   //changed here for smaller cut
     else if(collimator.Contains("Electronic") && sipm.Contains("Hamamatsu"))
-      cut = Form("ch_0.fT0>0 && ch_1.fT0>0 && ch_0.fT0<590 && ch_1.fT0<590 && ch_0.fPE>%f && ch_0.fPE<%f && ch_1.fPE>%f && ch_1.fPE<%f && log(sqrt(ch_1.fPE/ch_0.fPE))>%f && log(sqrt(ch_1.fPE/ch_0.fPE))<%f",  center_ch0-3*delta_ch0, center_ch0+3*delta_ch0, center_ch1-3*delta_ch1, center_ch1+3*delta_ch1, mean_ratio-3*sigma_ratio, mean_ratio+3*sigma_ratio);   //changed here for smaller cut
+      cut = Form("ch_0.fT0>0 && ch_1.fT0>0 && ch_0.fT0<590 && ch_1.fT0<590 && ch_0.fPE>%f && ch_0.fPE<%f && ch_1.fPE>%f && ch_1.fPE<%f && fLnMLR[0]>%f && fLnMLR[0]<%f",  center_ch0-3*delta_ch0, center_ch0+3*delta_ch0, center_ch1-3*delta_ch1, center_ch1+3*delta_ch1, mean_ratio-3*sigma_ratio, mean_ratio+3*sigma_ratio);   //changed here for smaller cut
     else if(collimator.Contains("Electronic") && sipm.Contains("SensL"))
-      cut = Form("ch_0.fT0>0 && ch_1.fT0>0 && ch_0.fT0<590 && ch_1.fT0<590 && ch_0.fPE>%f && ch_0.fPE<%f && ch_1.fPE>%f && ch_1.fPE<%f && log(sqrt(ch_1.fPE/ch_0.fPE))>%f && log(sqrt(ch_1.fPE/ch_0.fPE))<%f",  center_ch0-3*delta_ch0, center_ch0+3*delta_ch0, center_ch1-3*delta_ch1, center_ch1+3*delta_ch1, mean_ratio-2*sigma_ratio, mean_ratio+2*sigma_ratio);
+      cut = Form("ch_0.fT0>0 && ch_1.fT0>0 && ch_0.fT0<590 && ch_1.fT0<590 && ch_0.fPE>%f && ch_0.fPE<%f && ch_1.fPE>%f && ch_1.fPE<%f && fLnMLR[0]>%f && fLnMLR[0]<%f",  center_ch0-3*delta_ch0, center_ch0+3*delta_ch0, center_ch1-3*delta_ch1, center_ch1+3*delta_ch1, mean_ratio-2*sigma_ratio, mean_ratio+2*sigma_ratio);
       
     fT0DiffECut.push_back(fData->GetCustomHistogram(SFSelectionType::T0Difference, cut, measIDs[i]));
     mean = fT0DiffECut[i]->GetMean();
     sigma = fT0DiffECut[i]->GetRMS();
-    fT0DiffECut[i]->Fit(fun, "Q", "", mean-5*sigma, mean+5*sigma);
+    SFTools::FitHistogram(fT0DiffECut[i], fun, "Q", mean-5*sigma, mean+5*sigma);
     fResults.fTimeResECutAll.push_back(fun->GetParameter(2));   //Timing resolution as sigma, if FWHM needed multiply by f
     fResults.fTimeResECutAllErr.push_back(fun->GetParError(2)); //FWHM - multiply by f
     
@@ -416,22 +435,19 @@ std::vector <TH1D*> SFTimingRes::GetRatios(void){
 /// \param ch - channel number (0 or 1).
 std::vector <TH1D*> SFTimingRes::GetSpectra(int ch){
  
-  if((ch==0 && fSpecCh0.empty()) || 
-     (ch==1 && fSpecCh1.empty())){
+  if(ch<0 || ch>=(int)fSpecCh.size()){
+    std::cerr << "##### Error in SFTimingRes::GetSpectra()" << std::endl;
+    std::cerr << "Incorrect channel number!" << std::endl;
+    std::abort();
+  }
+  
+  if(fSpecCh[ch].empty()){
     std::cerr << "##### Error in SFTimingRes::GetSpectra()!" << std::endl; 
     std::cerr << "No spectra available!" << std::endl;
     std::abort();
   }
 
-  if(ch==0)       
-    return fSpecCh0; 
-  else if(ch==1) 
-    return fSpecCh1;
-  else{
-    std::cerr << "##### Error in SFTimingRes::GetSpectra()" << std::endl;
-    std::cerr << "Incorrect channel number!" << std::endl;
-    std::abort();
-  }
+  return fSpecCh[ch];
 }
 //------------------------------------------------------------------
 /// Prints details of SFTimingRes class object.
@@ -9,6 +9,18 @@
 // *****************************************
 
 #include "SFTools.hh"
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include "TROOT.h"
+#include "TList.h"
+#include "Math/Minimizer.h"
+#include "Math/Factory.h"
+#include "Math/Functor.h"
+
+//------------------------------------------------------------------
+static int  gNThreads = 0;        // number of worker threads, 0 - use all available cores
+static bool gLikelihood = false;  // binned Poisson likelihood in FitHistogram()
 
 //------------------------------------------------------------------
 int SFTools::GetIndex(std::vector <int> measurementsIDs, int id){
@@ -394,54 +406,25 @@ std::vector <double> SFTools::GetFWHM(TH1D *h){
     int    nbins = h->GetXaxis()->GetNbins();
     
     TF1* fgaus = new TF1("fgaus", "gaus", mean-sigma, mean+sigma);
-    h->Fit(fgaus, "RQ");
+    FitHistogram(h, fgaus, "RQ");
     
     double halfMax = fgaus->GetParameter(0)/2.;
     int maxbin = h->GetMaximumBin();
-    int bincont = 0;
-    
-    //----- determining xmin
-    int istart = -1;
-    int istop = -1;
     
-    for(int i=0; i<maxbin; i++){
-      bincont = h->GetBinContent(i);
-      if((bincont >= halfMax) && i>1){
-        istart = i;
-        break;
-      }
-    }
+    //----- crossings of the half maximum, found on the cumulative table;
+    //----- table is built locally, the histogram is not modified
+    SFPrefixSum table(h);
     
-    for(int i=maxbin; i>0; i--){
-      bincont = h->GetBinContent(i);
-      if(bincont <= halfMax){
-        istop = i;
-        break;
-      }
-    }
+    //----- determining xmin
+    int istart = maxbin>2 ? table.FindCrossing(halfMax, 2, maxbin-1, true) : -1;
+    int istop  = table.FindCrossing(halfMax, maxbin, 1, false);
     
     double xmin_err = fabs(h->GetBinCenter(istop) - h->GetBinCenter(istart))/2.;
     double xmin = h->GetBinCenter(istart) + xmin_err;
     
     //----- determining xmax
-    istart = -1;
-    istop = -1;
-    
-    for(int i=maxbin; i<nbins; i++){
-      bincont = h->GetBinContent(i);
-      if(bincont <= halfMax){
-          istart = i;
-          break;
-      }
-    }
-    
-    for(int i=nbins; i>maxbin; i--){
-      bincont = h->GetBinContent(i);
-      if(bincont >= halfMax){
-        istop = i;
-        break;
-      }
-    }
+    istart = maxbin<nbins ? table.FindCrossing(halfMax, maxbin, nbins-1, false) : -1;
+    istop  = maxbin<nbins ? table.FindCrossing(halfMax, nbins, maxbin+1, true) : -1;
     
     double xmax_err = fabs(h->GetBinCenter(istop) - h->GetBinCenter(istart))/2.;
     double xmax = h->GetBinCenter(istart) + xmax_err;
@@ -478,3 +461,224 @@ TString SFTools::FindData(TString directory){
   std::abort();
 }
 //------------------------------------------------------------------
+void SFTools::SetNThreads(int nthreads){
+    
+  gNThreads = nthreads;
+}
+//------------------------------------------------------------------
+int SFTools::GetNThreads(void){
+    
+  if(gNThreads>0)
+    return gNThreads;
+  
+  int ncores = std::thread::hardware_concurrency();
+  
+  return ncores>0 ? ncores : 1;
+}
+//------------------------------------------------------------------
+void SFTools::ParallelFor(int n, std::function<void(int)> func){
+    
+  int nthreads = std::min(GetNThreads(), n);
+  
+  if(nthreads<=1){
+    for(int i=0; i<n; i++)
+      func(i);
+    return;
+  }
+  
+  ROOT::EnableThreadSafety();
+  
+  std::atomic <int> next(0);
+  std::vector <std::thread> workers;
+  
+  for(int t=0; t<nthreads; t++){
+    workers.push_back(std::thread([&](){
+      int i;
+      while((i=next++)<n)
+        func(i);
+    }));
+  }
+  
+  for(int t=0; t<nthreads; t++)
+    workers[t].join();
+}
+//------------------------------------------------------------------
+void SFTools::SetLikelihood(bool likelihood){
+    
+  gLikelihood = likelihood;
+}
+//------------------------------------------------------------------
+bool SFTools::GetLikelihood(void){
+    
+  return gLikelihood;
+}
+//------------------------------------------------------------------
+/// Returns Poisson negative log-likelihood ratio (Baker-Cousins chi2) of
+/// the counts without the constant term, i.e. 2*sum(f - n*ln(f)). Model 
+/// values are passed as an array, evaluated once per call of the fitted
+/// function (see FitHistogram()), so the reduction is a single pass over
+/// contiguous arrays.
+/// \param n - number of bins
+/// \param counts - bin contents
+/// \param expected - expected contents (model values)
+double SFTools::PoissonNLL(int n, const double *counts, const double *expected){
+  
+  double sum = 0;
+  
+  for(int i=0; i<n; i++){
+    double f = std::max(expected[i], 1E-300);
+    sum += f - counts[i]*log(f);
+  }
+  
+  return 2*sum;
+}
+//------------------------------------------------------------------
+/// Fits function to the histogram. By default this is TH1::Fit() with
+/// given options, i.e. chi2 fit. If binned Poisson likelihood mode is set
+/// (see SetLikelihood()), parameters are found by minimization of the
+/// Baker-Cousins likelihood ratio with Minuit2, evaluated with PoissonNLL()
+/// over arrays of bin contents and model values. Empty bins are included,
+/// parameter limits and fixed parameters of the function are respected,
+/// fit results are written to the function and stored in the histogram 
+/// like in TH1::Fit(). Supported options: "Q", "R", "N", "+". Weighted
+/// histograms are always fitted with chi2. Returns fit status (0 if
+/// successful), like in TH1::Fit() it is increased by 100 if parameter
+/// errors couldn't be calculated with Hesse.
+/// \param h - histogram
+/// \param fun - fitted function
+/// \param opt - fitting options, as in TH1::Fit()
+/// \param xmin - lower limit of the fit range (if xmin<xmax and "R" not given)
+/// \param xmax - upper limit of the fit range
+int SFTools::FitHistogram(TH1 *h, TF1 *fun, TString opt, double xmin, double xmax){
+  
+  if(!gLikelihood)
+    return h->Fit(fun, opt, "", xmin, xmax);
+  
+  opt.ToUpper();
+  
+  //----- fit range
+  if(opt.Contains("R")){
+    fun->GetRange(xmin, xmax);
+  }
+  else if(xmin>=xmax){
+    xmin = h->GetXaxis()->GetXmin();
+    xmax = h->GetXaxis()->GetXmax();
+  }
+  
+  int binLow  = std::max(h->GetXaxis()->FindFixBin(xmin), 1);
+  int binHigh = std::min(h->GetXaxis()->FindFixBin(xmax), h->GetNbinsX());
+  
+  std::vector <double> x, counts;
+  bool weighted = false;
+  
+  for(int bin=binLow; bin<=binHigh; bin++){
+    double content = h->GetBinContent(bin);
+    double error = h->GetBinError(bin);
+    if(fabs(error*error-content)>1E-6*(1+fabs(content)))
+      weighted = true;
+    x.push_back(h->GetBinCenter(bin));
+    counts.push_back(content);
+  }
+  
+  int npar = fun->GetNpar();
+  int nbins = x.size();
+  
+  if(weighted || nbins<=npar){
+    std::cerr << "##### Warning in SFTools::FitHistogram()! Histogram " << h->GetName()
+              << " is weighted or has too few bins, chi2 fit is used!" << std::endl;
+    return h->Fit(fun, opt, "", xmin, xmax);
+  }
+  
+  //----- constant term, so that minimum is the Baker-Cousins chi2
+  double constant = 0;
+  for(int i=0; i<nbins; i++){
+    if(counts[i]>0)
+      constant += 2*(counts[i]*log(counts[i]) - counts[i]);
+  }
+  
+  std::vector <double> expected(nbins);
+  
+  auto nll = [&](const double *par){
+    for(int i=0; i<nbins; i++)
+      expected[i] = fun->EvalPar(&x[i], par);
+    return PoissonNLL(nbins, counts.data(), expected.data()) + constant;
+  };
+  
+  ROOT::Math::Functor functor(nll, npar);
+  ROOT::Math::Minimizer *minimizer = ROOT::Math::Factory::CreateMinimizer("Minuit2", "Migrad");
+  
+  if(minimizer==nullptr){
+    std::cerr << "##### Error in SFTools::FitHistogram()! Minuit2 not available, chi2 fit is used!" << std::endl;
+    return h->Fit(fun, opt, "", xmin, xmax);
+  }
+  
+  minimizer->SetFunction(functor);
+  minimizer->SetErrorDef(1);
+  minimizer->SetMaxFunctionCalls(100000);
+  minimizer->SetPrintLevel(0);
+  
+  int nfree = 0;
+  
+  for(int i=0; i<npar; i++){
+    double par = fun->GetParameter(i);
+    double err = fun->GetParError(i);
+    double step = err>0 ? err : (par!=0 ? 0.1*fabs(par) : 0.01);
+    double low, up;
+    fun->GetParLimits(i, low, up);
+    
+    if(low*up!=0 && low>=up){
+      minimizer->SetFixedVariable(i, Form("p%i", i), par);
+    }
+    else if(low<up){
+      minimizer->SetLimitedVariable(i, Form("p%i", i), par, step, low, up);
+      nfree++;
+    }
+    else{
+      minimizer->SetVariable(i, Form("p%i", i), par, step);
+      nfree++;
+    }
+  }
+  
+  bool minimized = minimizer->Minimize();
+  int status = minimizer->Status();
+  
+  if(!minimized && status==0)
+    status = 1;
+  
+  if(!minimizer->Hesse())
+    status += 100;
+  
+  fun->SetParameters(minimizer->X());
+  fun->SetParErrors(minimizer->Errors());
+  fun->SetChisquare(minimizer->MinValue());
+  fun->SetNDF(nbins-nfree);
+  fun->SetNumberFitPoints(nbins);
+  
+  delete minimizer;
+  
+  if(!opt.Contains("Q")){
+    std::cout << "----- Poisson likelihood fit of " << h->GetName() << ", status: " << status << std::endl;
+    for(int i=0; i<npar; i++)
+      std::cout << "\t" << fun->GetParName(i) << " = " << fun->GetParameter(i) 
+                << " +/- " << fun->GetParError(i) << std::endl;
+    std::cout << "\tchi2(BC)/NDF = " << fun->GetChisquare() << "/" << fun->GetNDF() << std::endl;
+  }
+  
+  //----- storing fitted function, like TH1::Fit()
+  if(!opt.Contains("N")){
+    TList *functions = h->GetListOfFunctions();
+    if(!opt.Contains("+")){
+      for(int i=functions->GetSize()-1; i>=0; i--){
+        TObject *obj = functions->At(i);
+        if(!obj->InheritsFrom("TF1")) continue;
+        functions->Remove(obj);
+        // fitted function itself may be in the list; it is still in use
+        if(obj!=fun) delete obj;
+      }
+    }
+    functions->Add(fun->Clone());
+  }
+  
+  return status;
+}
+//------------------------------------------------------------------